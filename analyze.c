@@ -0,0 +1,450 @@
+// chess_analyze: batch analysis of PGN game databases and EPD test suites.
+//
+//   chess_analyze <file.pgn|file.epd> [--depth N] [--threads N] [--hash MB]
+//                 [--net FILE] [--tb DIR] [--tb-cache MB] [--epd] [--out FILE]
+//
+// The input is memory-mapped and split into games on the calling thread;
+// workers replay them through the legal move generator and score every
+// position, statically at depth 0 (default) or with a search. Results are
+// written in input order, one line per game:
+//
+//   PGN  <game> <status> <result> <plies> <score after each move ...>
+//   EPD  <line> <status> <score> <best move> <id>
+//
+// Scores are centipawns from white's point of view; a '?' marks a move that
+// lost at least ANALYZE_BLUNDER_CP for the side that played it. Status is
+// "ok", "illegal <ply> <san>", "fen" for a bad start position, or "long" for
+// a game cut at ANALYZE_MAX_PLY; for EPD it is "ok" or "miss" against the bm
+// operation, "-" without one. Throughput goes to stderr at the end.
+//
+// With --tb the searches probe the endgame tablebases in DIR, sharing one
+// block cache of --tb-cache MB (default 16); probe counts and the cache hit
+// rate are added to the summary.
+
+#include "pgn.h"
+#include "search.h"
+#include "ring.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ANALYZE_MAX_WORKERS 64
+#define ANALYZE_QUEUE 64            // games in flight per worker, each way; power of two
+#define ANALYZE_MAX_PLY 1024
+#define ANALYZE_BLUNDER_CP 200
+
+#define STATUS_OK 0
+#define STATUS_ILLEGAL 1
+#define STATUS_BAD_FEN 2
+#define STATUS_TOO_LONG 3
+#define STATUS_MISS 4               // EPD: the best move differs from bm
+#define STATUS_NO_BM 5              // EPD: nothing to compare with
+
+typedef struct AnalyzeJob {
+    int64_t index;
+    const char *text;               // into the mapped file
+    size_t length;
+} AnalyzeJob;
+
+typedef struct AnalyzeResult {
+    int64_t index;
+    int status;
+    int plies;
+    bool blackFirst;                // the game starts with black to move
+    char result[8];
+    char san[PGN_MAX_SAN];          // illegal move, or the best move of an EPD line
+    char id[32];                    // EPD id operation
+    int16_t scores[ANALYZE_MAX_PLY];
+} AnalyzeResult;
+
+typedef struct AnalyzeOptions {
+    int depth;
+    bool epd;
+    size_t hashMb;
+    const Network *network;
+    Tablebases *tablebases;
+} AnalyzeOptions;
+
+// One worker thread with its own search state; jobs come in and results go
+// out through single-producer single-consumer rings shared with the main thread
+typedef struct AnalyzeWorker {
+    RingQueue jobs, results;
+    AnalyzeJob jobStorage[ANALYZE_QUEUE];
+    AnalyzeResult resultStorage[ANALYZE_QUEUE];
+    PlatformThread *thread;
+    PlatformSignal *wake;
+    PlatformSignal *progress;       // shared, set after every result
+    volatile int quit;
+
+    const AnalyzeOptions *options;
+    Searcher *searcher;             // heap, it is large
+    TranspositionTable tt;
+    Accumulator accumulators[2];
+    AnalyzeResult result;
+    int64_t moves;
+} AnalyzeWorker;
+
+// White's point of view. Depth 0 is the static evaluation; the network's
+// accumulator then follows the game move by move.
+static int ScorePosition(AnalyzeWorker *worker, const Position *pos, const Accumulator *acc, Move *best) {
+    Searcher *searcher = worker->searcher;
+    MoveList moves;
+    int score;
+
+    // Neither the search nor the evaluation knows the game is over
+    *best = MOVE_NONE;
+    GenerateLegalMoves(pos, &moves);
+    if (moves.count == 0) {
+        score = InCheck(pos) ? -32000 : 0;
+    } else if (worker->options->depth > 0) {
+        SearchLimits limits = { worker->options->depth, 0, 0, 0 };
+        SearchInfo info;
+        *best = Search(searcher, pos, &limits, &info);
+        score = info.score;
+    } else if (worker->options->network) {
+        score = NnueOutput(worker->options->network, acc, pos->sideToMove);
+    } else {
+        score = Evaluate(pos, &searcher->pawns);
+    }
+    if (score > 32000) score = 32000;
+    if (score < -32000) score = -32000;
+    return pos->sideToMove == SIDE_WHITE ? score : -score;
+}
+
+static void AnalyzeGame(AnalyzeWorker *worker, const AnalyzeJob *job, AnalyzeResult *result) {
+    const Network *network = worker->options->network;
+    PgnGame game = { job->text, job->length };
+    PgnMoveReader reader;
+    char fen[128];
+    Position pos;
+    uint64_t keys[ANALYZE_MAX_PLY];
+    Move best;
+    const char *san;
+    int current = 0;
+
+    if (!GetPgnTag(&game, "FEN", fen, sizeof(fen))) strcpy(fen, START_FEN);
+    if (!PositionFromFen(&pos, fen)) {
+        result->status = STATUS_BAD_FEN;
+        return;
+    }
+    if (network) NnueRefresh(network, &pos, &worker->accumulators[0]);
+    result->blackFirst = pos.sideToMove == SIDE_BLACK;
+
+    InitPgnMoveReader(&reader, &game);
+    while ((san = NextPgnMove(&reader)) != NULL) {
+        Move move = ParseSan(&pos, san);
+        UndoInfo undo;
+
+        if (move == MOVE_NONE) {
+            result->status = STATUS_ILLEGAL;
+            snprintf(result->san, sizeof(result->san), "%s", san);
+            break;
+        }
+        if (result->plies == ANALYZE_MAX_PLY) {
+            result->status = STATUS_TOO_LONG;
+            break;
+        }
+
+        keys[result->plies] = pos.key;
+        if (network) NnuePush(&worker->accumulators[current ^ 1], &pos, move);
+        MakeMove(&pos, move, &undo);
+        if (network) NnueUpdate(network, &worker->accumulators[current], &worker->accumulators[current ^ 1]);
+        current ^= 1;
+
+        // The search sees the game so far, for repetition draws
+        if (worker->options->depth > 0) SetSearchHistory(worker->searcher, keys, result->plies + 1);
+        result->scores[result->plies++] = (int16_t)ScorePosition(worker, &pos, &worker->accumulators[current], &best);
+    }
+    // The tag also holds when the movetext stopped early at an illegal move
+    if (!GetPgnTag(&game, "Result", result->result, sizeof(result->result)))
+        snprintf(result->result, sizeof(result->result), "%s", reader.result);
+    worker->moves += result->plies;
+}
+
+// EPD: four FEN fields, then operations such as bm Nf3; id "WAC.001";
+static void AnalyzeEpd(AnalyzeWorker *worker, const AnalyzeJob *job, AnalyzeResult *result) {
+    char line[512], fen[128];
+    size_t length = job->length < sizeof(line) - 1 ? job->length : sizeof(line) - 1;
+    const char *ops = line;
+    Position pos;
+    Move best;
+
+    memcpy(line, job->text, length);
+    line[length] = '\0';
+    line[strcspn(line, "\r\n")] = '\0';
+    for (int field = 0; field < 4 && *ops; field++) {
+        ops += strspn(ops, " \t");
+        ops += strcspn(ops, " \t");
+    }
+    snprintf(fen, sizeof(fen), "%.*s 0 1", (int)(ops - line), line);
+    if (!PositionFromFen(&pos, fen)) {
+        result->status = STATUS_BAD_FEN;
+        return;
+    }
+    if (worker->options->network) NnueRefresh(worker->options->network, &pos, &worker->accumulators[0]);
+
+    result->plies = 1;
+    result->scores[0] = (int16_t)ScorePosition(worker, &pos, &worker->accumulators[0], &best);
+    strcpy(result->san, "-");
+    if (best != MOVE_NONE) MoveToSan(&pos, best, result->san);
+
+    const char *id = strstr(ops, "id \"");
+    if (id) snprintf(result->id, sizeof(result->id), "%.*s", (int)strcspn(id + 4, "\""), id + 4);
+
+    // bm may list several moves; any of them counts
+    const char *bm = strstr(ops, "bm ");
+    result->status = STATUS_NO_BM;
+    if (!bm || best == MOVE_NONE) return;
+    result->status = STATUS_MISS;
+    for (const char *p = bm + 3; *p && *p != ';';) {
+        char san[PGN_MAX_SAN];
+        size_t n = strcspn(p, " ;");
+        if (n > 0 && n < sizeof(san)) {
+            memcpy(san, p, n);
+            san[n] = '\0';
+            if (ParseSan(&pos, san) == best) result->status = STATUS_OK;
+        }
+        p += n;
+        p += strspn(p, " ");
+    }
+}
+
+static void WorkerMain(void *arg) {
+    AnalyzeWorker *worker = arg;
+    AnalyzeJob job;
+
+    for (;;) {
+        if (!RingPop(&worker->jobs, &job)) {
+            if (AtomicLoad(&worker->quit)) break;
+            WaitSignal(worker->wake);
+            continue;
+        }
+
+        AnalyzeResult *result = &worker->result;
+        memset(result, 0, offsetof(AnalyzeResult, scores));
+        result->index = job.index;
+        if (worker->options->epd) AnalyzeEpd(worker, &job, result);
+        else AnalyzeGame(worker, &job, result);
+
+        // The main thread drains results in input order, so a full ring empties soon
+        while (!RingPush(&worker->results, result)) SleepMilliseconds(1);
+        SetSignal(worker->progress);
+    }
+}
+
+static bool StartWorker(AnalyzeWorker *worker, const AnalyzeOptions *options, PlatformSignal *progress) {
+    memset(worker, 0, sizeof(*worker));
+    InitRing(&worker->jobs, worker->jobStorage, sizeof(AnalyzeJob), ANALYZE_QUEUE);
+    InitRing(&worker->results, worker->resultStorage, sizeof(AnalyzeResult), ANALYZE_QUEUE);
+    worker->options = options;
+    worker->progress = progress;
+
+    worker->searcher = malloc(sizeof(Searcher));
+    if (!worker->searcher) return false;
+    InitSearcher(worker->searcher);
+    worker->searcher->network = options->network;
+    worker->searcher->tablebases = options->tablebases;
+    if (options->depth > 0 && TTInit(&worker->tt, options->hashMb)) worker->searcher->tt = &worker->tt;
+
+    worker->wake = CreateSignal();
+    if (worker->wake) worker->thread = StartThread(WorkerMain, worker);
+    return worker->thread != NULL;
+}
+
+static void StopWorker(AnalyzeWorker *worker) {
+    if (worker->thread) {
+        AtomicStore(&worker->quit, 1);
+        SetSignal(worker->wake);
+        JoinThread(worker->thread);
+    }
+    DestroySignal(worker->wake);
+    TTFree(&worker->tt);
+    free(worker->searcher);
+}
+
+static const char *StatusText(int status) {
+    static const char *texts[] = { "ok", "illegal", "fen", "long", "miss", "-" };
+    return texts[status];
+}
+
+static void WriteResult(FILE *out, const AnalyzeResult *result, bool epd) {
+    if (epd) {
+        fprintf(out, "%lld\t%s\t", (long long)result->index + 1, StatusText(result->status));
+        if (result->status == STATUS_BAD_FEN) fprintf(out, "-\t-\t-\n");
+        else fprintf(out, "%d\t%s\t%s\n", result->scores[0], result->san, result->id[0] ? result->id : "-");
+        return;
+    }
+
+    fprintf(out, "%lld\t%s", (long long)result->index + 1, StatusText(result->status));
+    if (result->status == STATUS_ILLEGAL) fprintf(out, " %d %s", result->plies + 1, result->san);
+    fprintf(out, "\t%s\t%d\t", result->status == STATUS_BAD_FEN ? "*" : result->result, result->plies);
+
+    // Ply i was played by white when i is even, unless black moved first
+    int previous = 0;
+    for (int i = 0; i < result->plies; i++) {
+        int score = result->scores[i];
+        bool white = (i % 2 == 0) != result->blackFirst;
+        int loss = white ? previous - score : score - previous;
+        fprintf(out, i ? " %d%s" : "%d%s", score, i > 0 && loss >= ANALYZE_BLUNDER_CP ? "?" : "");
+        previous = score;
+    }
+    fputc('\n', out);
+}
+
+// Next game or EPD line, false at the end of the input
+static bool NextJob(PgnScanner *scanner, bool epd, AnalyzeJob *job) {
+    if (!epd) {
+        PgnGame game;
+        if (!NextPgnGame(scanner, &game)) return false;
+        job->text = game.text;
+        job->length = game.length;
+        return true;
+    }
+
+    while (scanner->offset < scanner->size) {
+        const char *start = scanner->data + scanner->offset;
+        const char *end = memchr(start, '\n', scanner->size - scanner->offset);
+        size_t length = end ? (size_t)(end - start) : scanner->size - scanner->offset;
+
+        scanner->offset += length + (end ? 1 : 0);
+        if (length > 0 && start[strspn(start, " \t\r")] != '\n' && start + strspn(start, " \t\r") < start + length) {
+            job->text = start;
+            job->length = length;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void PrintUsage(void) {
+    fprintf(stderr, "usage: chess_analyze <file.pgn|file.epd> [--depth N] [--threads N] [--hash MB] [--net FILE] [--tb DIR] [--tb-cache MB] [--epd] [--out FILE]\n");
+}
+
+int main(int argc, char **argv) {
+    static AnalyzeWorker workers[ANALYZE_MAX_WORKERS];
+    static AnalyzeResult result;
+    static Tablebases tablebases;
+    AnalyzeOptions options = { 0, false, 16, NULL, NULL };
+    const char *path = NULL, *outPath = NULL, *netPath = NULL, *tbPath = NULL;
+    int threads = 0, tbCacheMb = TB_DEFAULT_CACHE_MB;
+    Network network;
+    MappedFile file;
+    FILE *out = stdout;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--depth") == 0 && i + 1 < argc) options.depth = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) threads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--hash") == 0 && i + 1 < argc) options.hashMb = (size_t)atoi(argv[++i]);
+        else if (strcmp(argv[i], "--net") == 0 && i + 1 < argc) netPath = argv[++i];
+        else if (strcmp(argv[i], "--tb") == 0 && i + 1 < argc) tbPath = argv[++i];
+        else if (strcmp(argv[i], "--tb-cache") == 0 && i + 1 < argc) tbCacheMb = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) outPath = argv[++i];
+        else if (strcmp(argv[i], "--epd") == 0) options.epd = true;
+        else if (argv[i][0] != '-' && !path) path = argv[i];
+        else {
+            PrintUsage();
+            return 2;
+        }
+    }
+    if (!path) {
+        PrintUsage();
+        return 2;
+    }
+    size_t pathLength = strlen(path);
+    if (pathLength > 4 && strcmp(path + pathLength - 4, ".epd") == 0) options.epd = true;
+
+    InitBitboards();
+    if (!MapFile(&file, path)) {
+        fprintf(stderr, "cannot read %s\n", path);
+        return 1;
+    }
+    if (netPath) {
+        if (!LoadNetwork(&network, netPath)) {
+            fprintf(stderr, "%s is not a usable network\n", netPath);
+            return 1;
+        }
+        options.network = &network;
+    }
+    if (tbPath) {
+        if (!LoadTablebases(&tablebases, tbPath, (size_t)(tbCacheMb > 0 ? tbCacheMb : 1))) {
+            fprintf(stderr, "no tablebases in %s\n", tbPath);
+            return 1;
+        }
+        options.tablebases = &tablebases;
+    }
+    if (outPath && !(out = fopen(outPath, "w"))) {
+        fprintf(stderr, "cannot write %s\n", outPath);
+        return 1;
+    }
+
+    // The main thread splits and writes, the workers analyze
+    if (threads <= 0) threads = GetProcessorCount() > 1 ? GetProcessorCount() - 1 : 1;
+    if (threads > ANALYZE_MAX_WORKERS) threads = ANALYZE_MAX_WORKERS;
+    PlatformSignal *progress = CreateSignal();
+    int workerCount = 0;
+    while (progress && workerCount < threads && StartWorker(&workers[workerCount], &options, progress)) workerCount++;
+    if (workerCount == 0) {
+        fprintf(stderr, "cannot start worker threads\n");
+        return 1;
+    }
+
+    // Game n always goes to worker n % workerCount, so reading the result
+    // rings round robin gives the results back in input order
+    PgnScanner scanner;
+    AnalyzeJob job;
+    bool pending = false, more = true;
+    int64_t dispatched = 0, written = 0, errors = 0, moves = 0;
+    int64_t start = GetMicroseconds();
+
+    InitPgnScanner(&scanner, (const char *)file.data, file.size);
+    for (;;) {
+        bool progressed = false;
+
+        while (more) {
+            if (!pending) {
+                more = NextJob(&scanner, options.epd, &job);
+                if (!more) break;
+                job.index = dispatched;
+                pending = true;
+            }
+            AnalyzeWorker *worker = &workers[dispatched % workerCount];
+            if (!RingPush(&worker->jobs, &job)) break;
+            SetSignal(worker->wake);
+            pending = false;
+            dispatched++;
+            progressed = true;
+        }
+
+        while (written < dispatched && RingPop(&workers[written % workerCount].results, &result)) {
+            WriteResult(out, &result, options.epd);
+            if (result.status != STATUS_OK && result.status != STATUS_MISS && result.status != STATUS_NO_BM) errors++;
+            moves += result.plies;
+            written++;
+            progressed = true;
+        }
+
+        if (!more && written == dispatched) break;
+        if (!progressed) WaitSignal(progress);
+    }
+
+    double seconds = (GetMicroseconds() - start) / 1e6;
+    if (seconds <= 0.0) seconds = 1e-6;
+    fprintf(stderr, "%lld %s, %lld positions, %lld errors in %.2f s: %.0f %s/s, %.0f positions/s, %d workers\n",
+            (long long)written, options.epd ? "lines" : "games", (long long)moves, (long long)errors, seconds,
+            written / seconds, options.epd ? "lines" : "games", moves / seconds, workerCount);
+    if (options.tablebases) {
+        TablebaseStats stats = GetTablebaseStats(&tablebases);
+        int64_t lookups = stats.blockHits + stats.blockMisses;
+        fprintf(stderr, "tablebases: %d tables, %lld probes, %.1f%% cache hits\n", tablebases.tableCount,
+                (long long)stats.probes, lookups ? stats.blockHits * 100.0 / (double)lookups : 0.0);
+    }
+
+    for (int i = 0; i < workerCount; i++) StopWorker(&workers[i]);
+    DestroySignal(progress);
+    if (out != stdout) fclose(out);
+    if (options.network) UnloadNetwork(&network);
+    if (options.tablebases) UnloadTablebases(&tablebases);
+    UnmapFile(&file);
+    return 0;
+}
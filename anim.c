@@ -0,0 +1,69 @@
+#include "anim.h"
+
+#include <string.h>
+
+// Swaps the last tween into the hole and zeroes the freed slot, so copies of
+// the pool compare equal whenever the same tweens are running
+static void RemoveTween(TweenPool *pool, int index) {
+    pool->tweens[index] = pool->tweens[--pool->count];
+    memset(&pool->tweens[pool->count], 0, sizeof(Tween));
+}
+
+bool StartTween(TweenPool *pool, int piece, int square, Vector3 from, Vector3 to, float duration, int event) {
+    if (pool->count == MAX_TWEENS || duration <= 0.0f) return false;
+
+    pool->tweens[pool->count++] = (Tween){ piece, square, from, to, 0.0f, duration, event };
+    return true;
+}
+
+bool TakeTween(TweenPool *pool, int square, Vector3 *position) {
+    for (int i = 0; i < pool->count; i++) {
+        if (pool->tweens[i].square != square) continue;
+
+        *position = TweenPosition(&pool->tweens[i]);
+        RemoveTween(pool, i);
+        return true;
+    }
+    return false;
+}
+
+int UpdateTweens(TweenPool *pool, float dt) {
+    int events = TWEEN_EVENT_NONE;
+
+    for (int i = 0; i < pool->count;) {
+        Tween *tween = &pool->tweens[i];
+
+        tween->elapsed += dt;
+        if (tween->elapsed < tween->duration) {
+            i++;
+            continue;
+        }
+        events |= tween->event;
+        RemoveTween(pool, i);
+    }
+    return events;
+}
+
+// Smoothstep: starts and lands gently instead of snapping to full speed
+Vector3 TweenPosition(const Tween *tween) {
+    float t = tween->elapsed / tween->duration;
+
+    if (t > 1.0f) t = 1.0f;
+    t = t * t * (3.0f - 2.0f * t);
+    return (Vector3){
+        tween->from.x + (tween->to.x - tween->from.x) * t,
+        tween->from.y + (tween->to.y - tween->from.y) * t,
+        tween->from.z + (tween->to.z - tween->from.z) * t
+    };
+}
+
+bool IsSquareTweened(const TweenPool *pool, int square) {
+    for (int i = 0; i < pool->count; i++) {
+        if (pool->tweens[i].square == square) return true;
+    }
+    return false;
+}
+
+void ClearTweens(TweenPool *pool) {
+    memset(pool, 0, sizeof(*pool));
+}
@@ -0,0 +1,45 @@
+#ifndef ANIM_H
+#define ANIM_H
+
+#include "raylib.h"
+
+#define MAX_TWEENS 16               // per game: a move needs up to three, replays overlap a few moves
+#define MAX_FRAME_SECONDS 0.1f      // longer frames (a stall, a wake-up from idle) advance only this far
+
+#define TWEEN_EVENT_NONE 0
+#define TWEEN_EVENT_MOVE 1          // a moved piece landed
+#define TWEEN_EVENT_CASTLE 2        // a castling king landed
+
+// One piece drawn away from where the board says it is. Positions are board
+// local, x the column and z the row of a square's center, so the owner maps
+// them to the world the same way as the pieces standing still.
+typedef struct Tween {
+    int piece;
+    int square;                     // row * 8 + col the piece is hidden from meanwhile, -1 if none
+    Vector3 from, to;
+    float elapsed, duration;        // seconds
+    int event;                      // TWEEN_EVENT_*, reported when the tween ends
+} Tween;
+
+// Fixed-capacity tween list, unordered. Time only advances in UpdateTweens,
+// so interpolation does not depend on how often anything is drawn.
+typedef struct TweenPool {
+    Tween tweens[MAX_TWEENS];
+    int count;
+} TweenPool;
+
+// False when the pool is full; the piece then simply shows up where the board has it
+bool StartTween(TweenPool *pool, int piece, int square, Vector3 from, Vector3 to, float duration, int event);
+
+// Removes the tween hiding square, if any, and returns where it had got to
+bool TakeTween(TweenPool *pool, int square, Vector3 *position);
+
+// Advances every tween by dt seconds, already clamped and scaled by the caller,
+// and drops the ones that ended. Returns the events of those, ORed together.
+int UpdateTweens(TweenPool *pool, float dt);
+
+Vector3 TweenPosition(const Tween *tween);
+bool IsSquareTweened(const TweenPool *pool, int square);
+void ClearTweens(TweenPool *pool);
+
+#endif
@@ -0,0 +1,514 @@
+#include "assets.h"
+#include "lod.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define PAGE_SIZE 4096
+#define MAX_LOADER_THREADS 8
+#define MATERIAL_MAP_COUNT (MATERIAL_MAP_BRDF + 1)
+
+const char *const pieceModelNames[NO_PIECE] = {
+    "WPawn", "WKnight", "WBishop", "WRook", "WQueen", "WKing",
+    "BPawn", "BKnight", "BBishop", "BRook", "BQueen", "BKing"
+};
+
+const char *const pieceTypeNames[PIECE_TYPE_COUNT] = {
+    "Pawn", "Knight", "Bishop", "Rook", "Queen", "King"
+};
+
+const int pieceLodCells[MAX_PIECE_LODS] = { 0, 64, 24 };
+
+uint64_t TextureDataSize(int width, int height, int format, int mipmaps) {
+    uint64_t size = 0;
+
+    for (int level = 0; level < mipmaps; level++) {
+        size += (uint64_t)GetPixelDataSize(width, height, format);
+        width = width > 1 ? width / 2 : 1;
+        height = height > 1 ? height / 2 : 1;
+    }
+    return size;
+}
+
+unsigned int DefaultTextureId(void) {
+    Material material = LoadMaterialDefault();
+    unsigned int id = material.maps[MATERIAL_MAP_DIFFUSE].texture.id;
+
+    MemFree(material.maps);
+    return id;
+}
+
+// Bounds-checked cursor over one payload; blocks start on ASSET_ALIGNMENT
+typedef struct PayloadReader {
+    const unsigned char *data;
+    uint64_t size;
+    uint64_t offset;
+} PayloadReader;
+
+static PayloadReader EntryReader(const MappedFile *file, const BundleEntry *entry) {
+    return (PayloadReader){ file->data + entry->offset, entry->size, 0 };
+}
+
+// Returns NULL if the payload is too short
+static const void *ReadBlock(PayloadReader *reader, uint64_t bytes) {
+    uint64_t start = (reader->offset + ASSET_ALIGNMENT - 1) & ~(uint64_t)(ASSET_ALIGNMENT - 1);
+
+    if (start > reader->size || bytes > reader->size - start) return NULL;
+    reader->offset = start + bytes;
+    return reader->data + start;
+}
+
+// raylib frees mesh arrays on unload, so they cannot point into the mapping
+static void *CopyBlock(PayloadReader *reader, uint64_t bytes) {
+    const void *source = ReadBlock(reader, bytes);
+    void *copy;
+
+    if (!source || bytes > 0xFFFFFFFFu) return NULL;
+    copy = MemAlloc((unsigned int)bytes);
+    if (copy) memcpy(copy, source, bytes);
+    return copy;
+}
+
+static void FreeMeshArrays(Mesh *mesh) {
+    MemFree(mesh->vertices);
+    MemFree(mesh->normals);
+    MemFree(mesh->texcoords);
+    MemFree(mesh->colors);
+    MemFree(mesh->indices);
+    memset(mesh, 0, sizeof(*mesh));
+}
+
+// Copies the arrays of an ASSET_MESH out of the mapping
+static bool ReadMesh(PayloadReader *reader, Mesh *mesh) {
+    const BundleMesh *header = ReadBlock(reader, sizeof(BundleMesh));
+
+    if (!header || header->vertexCount <= 0 || header->triangleCount <= 0) return false;
+
+    uint64_t vertices = (uint64_t)header->vertexCount;
+    uint64_t indices = (uint64_t)header->triangleCount * 3;
+
+    mesh->vertexCount = header->vertexCount;
+    mesh->triangleCount = header->triangleCount;
+
+    mesh->vertices = CopyBlock(reader, vertices * 3 * sizeof(float));
+    if (!mesh->vertices) return false;
+    if (header->arrays & BUNDLE_MESH_NORMALS) {
+        mesh->normals = CopyBlock(reader, vertices * 3 * sizeof(float));
+        if (!mesh->normals) return false;
+    }
+    if (header->arrays & BUNDLE_MESH_TEXCOORDS) {
+        mesh->texcoords = CopyBlock(reader, vertices * 2 * sizeof(float));
+        if (!mesh->texcoords) return false;
+    }
+    if (header->arrays & BUNDLE_MESH_COLORS) {
+        mesh->colors = CopyBlock(reader, vertices * 4);
+        if (!mesh->colors) return false;
+    }
+    if (header->arrays & BUNDLE_MESH_INDICES) {
+        mesh->indices = CopyBlock(reader, indices * sizeof(unsigned short));
+        if (!mesh->indices) return false;
+        for (uint64_t i = 0; i < indices; i++) {
+            if (mesh->indices[i] >= vertices) return false;
+        }
+    } else if (indices > vertices) {
+        return false;
+    }
+    return true;
+}
+
+// Levels of detail are built from level 0 at load time, so the bundle and the
+// loose files get the same ones
+static void GeneratePieceLods(PieceSet *set, int type) {
+    Mesh *levels = set->meshes[type];
+
+    set->extent[type] = MeshExtent(&levels[0]);
+    set->lodCount[type] = 1;
+
+    for (int lod = 1; lod < MAX_PIECE_LODS; lod++) {
+        Mesh simplified = SimplifyMesh(&levels[0], pieceLodCells[lod]);
+
+        // A level that saves less than a quarter of the triangles is not worth a draw call
+        if (simplified.triangleCount == 0 || simplified.triangleCount * 4 > levels[lod - 1].triangleCount * 3) {
+            FreeMeshArrays(&simplified);
+            break;
+        }
+        levels[lod] = simplified;
+        set->lodCount[type]++;
+    }
+}
+
+static void UploadPieceMeshes(PieceSet *set) {
+    for (int type = 0; type < PIECE_TYPE_COUNT; type++) {
+        for (int lod = 0; lod < set->lodCount[type]; lod++) {
+            if (set->meshes[type][lod].vaoId == 0) UploadMesh(&set->meshes[type][lod], false);
+        }
+    }
+}
+
+static Material SideMaterial(Color diffuse, Texture2D texture) {
+    Material material = LoadMaterialDefault();
+
+    material.maps[MATERIAL_MAP_DIFFUSE].color = diffuse;
+    if (texture.id != 0) material.maps[MATERIAL_MAP_DIFFUSE].texture = texture;
+    return material;
+}
+
+static void TouchPages(const unsigned char *data, uint64_t size) {
+    volatile unsigned char sink = 0;
+
+    for (uint64_t i = 0; i < size; i += PAGE_SIZE) sink ^= data[i];
+    (void)sink;
+}
+
+// Header, version and every entry's bounds; payloads are checked when read
+static bool ValidBundle(const MappedFile *file) {
+    const BundleHeader *header = (const BundleHeader *)file->data;
+    const BundleEntry *entries = (const BundleEntry *)(file->data + sizeof(BundleHeader));
+
+    if (file->size < sizeof(BundleHeader)) return false;
+    if (header->magic != ASSET_BUNDLE_MAGIC || header->version != ASSET_BUNDLE_VERSION) return false;
+    if (header->fileSize != file->size) return false;
+
+    uint64_t tableEnd = sizeof(BundleHeader) + (uint64_t)header->entryCount * sizeof(BundleEntry);
+    if (tableEnd > file->size) return false;
+
+    for (uint32_t i = 0; i < header->entryCount; i++) {
+        const BundleEntry *entry = &entries[i];
+        if (entry->offset % ASSET_ALIGNMENT != 0 || entry->offset < tableEnd || entry->offset > file->size) return false;
+        if (entry->size > file->size - entry->offset) return false;
+    }
+    return true;
+}
+
+static int FindEntry(const MappedFile *file, const char *name, uint32_t type) {
+    const BundleHeader *header = (const BundleHeader *)file->data;
+    const BundleEntry *entries = (const BundleEntry *)(file->data + sizeof(BundleHeader));
+
+    for (uint32_t i = 0; i < header->entryCount; i++) {
+        if (entries[i].type == type && strncmp(entries[i].name, name, ASSET_NAME_LENGTH) == 0) return (int)i;
+    }
+    return -1;
+}
+
+static bool ReadTexture(const MappedFile *file, const BundleEntry *entry, Image *image) {
+    PayloadReader reader = EntryReader(file, entry);
+    const BundleTexture *header = ReadBlock(&reader, sizeof(BundleTexture));
+
+    if (!header || header->width <= 0 || header->height <= 0 || header->mipmaps <= 0 || header->mipmaps > 16) return false;
+    uint64_t size = TextureDataSize(header->width, header->height, header->format, header->mipmaps);
+    const void *pixels = ReadBlock(&reader, size);
+    if (size == 0 || !pixels) return false;
+
+    // LoadTextureFromImage only reads the pixels, so they can stay in the mapping
+    *image = (Image){ (void *)pixels, header->width, header->height, header->mipmaps, header->format };
+    return true;
+}
+
+static bool ReadSound(const MappedFile *file, const BundleEntry *entry, Wave *wave) {
+    PayloadReader reader = EntryReader(file, entry);
+    const BundleSound *header = ReadBlock(&reader, sizeof(BundleSound));
+
+    if (!header || header->channels == 0 || header->sampleRate == 0) return false;
+    if (header->sampleSize != 8 && header->sampleSize != 16 && header->sampleSize != 32) return false;
+    const void *samples = ReadBlock(&reader, (uint64_t)header->frameCount * header->channels * header->sampleSize / 8);
+    if (!samples) return false;
+
+    *wave = (Wave){ header->frameCount, header->sampleRate, header->sampleSize, header->channels, (void *)samples };
+    return true;
+}
+
+static bool ReadMaterial(const MappedFile *file, const BundleEntry *entry, BundleMaterial *material) {
+    PayloadReader reader = EntryReader(file, entry);
+    const BundleMaterial *source = ReadBlock(&reader, sizeof(BundleMaterial));
+
+    if (!source) return false;
+    *material = *source;
+    return true;
+}
+
+static Music ReadMusic(const MappedFile *file, const BundleEntry *entry) {
+    PayloadReader reader = EntryReader(file, entry);
+    const BundleMusic *header = ReadBlock(&reader, sizeof(BundleMusic));
+    const unsigned char *data = header && header->size <= 0x7FFFFFFF ? ReadBlock(&reader, header->size) : NULL;
+    char fileType[sizeof(header->fileType) + 1] = { 0 };
+
+    if (!data) return (Music){ 0 };
+    memcpy(fileType, header->fileType, sizeof(header->fileType));
+
+    // Decoded while it plays, straight out of the mapping
+    return LoadMusicStreamFromMemory(fileType, data, (int)header->size);
+}
+
+// Parallel part of the load: everything except creating GPU and audio objects
+typedef struct BundleLoad {
+    const MappedFile *file;
+    const BundleEntry *entries;
+    int entryCount;
+    PieceSet *pieces;               // meshes and levels of detail are built here, CPU arrays only
+    PayloadReader meshes[PIECE_TYPE_COUNT];
+    bool meshReady[PIECE_TYPE_COUNT];
+    BundleMaterial materials[2];    // by side
+    Image *images;                  // by entry index, pixels still in the mapping
+    const BundleEntry **touch;      // payloads read ahead so uploads do not stall on page faults
+    int touchCount;
+    Wave moveWave, castleWave;
+    int music;                      // entry index, -1 if there is none
+    volatile int64_t next;          // next job, shared by the loader threads
+} BundleLoad;
+
+static void RunLoadJobs(void *arg) {
+    BundleLoad *load = arg;
+
+    for (;;) {
+        int job = (int)AtomicAdd64(&load->next, 1) - 1;
+
+        if (job < PIECE_TYPE_COUNT) {
+            load->meshReady[job] = ReadMesh(&load->meshes[job], &load->pieces->meshes[job][0]);
+            if (load->meshReady[job]) GeneratePieceLods(load->pieces, job);
+        } else if (job < PIECE_TYPE_COUNT + load->touchCount) {
+            const BundleEntry *entry = load->touch[job - PIECE_TYPE_COUNT];
+            TouchPages(load->file->data + entry->offset, entry->size);
+        } else {
+            break;
+        }
+    }
+}
+
+// Finds and checks every payload, copies the meshes and builds their levels
+// of detail, on every core; false if anything the game needs is missing or damaged
+static bool PrepareBundle(BundleLoad *load) {
+    const MappedFile *file = load->file;
+    PlatformThread *threads[MAX_LOADER_THREADS];
+    int threadCount = 0;
+    int moveSound = FindEntry(file, MOVE_SOUND_NAME, ASSET_SOUND);
+    int castleSound = FindEntry(file, CASTLE_SOUND_NAME, ASSET_SOUND);
+    int whiteMaterial = FindEntry(file, WHITE_MATERIAL_NAME, ASSET_MATERIAL);
+    int blackMaterial = FindEntry(file, BLACK_MATERIAL_NAME, ASSET_MATERIAL);
+
+    load->music = FindEntry(file, MUSIC_NAME, ASSET_MUSIC);
+    if (moveSound < 0 || castleSound < 0 || whiteMaterial < 0 || blackMaterial < 0) return false;
+    if (!ReadSound(file, &load->entries[moveSound], &load->moveWave)) return false;
+    if (!ReadSound(file, &load->entries[castleSound], &load->castleWave)) return false;
+    if (!ReadMaterial(file, &load->entries[whiteMaterial], &load->materials[SIDE_WHITE])) return false;
+    if (!ReadMaterial(file, &load->entries[blackMaterial], &load->materials[SIDE_BLACK])) return false;
+
+    load->images = calloc(load->entryCount, sizeof(Image));
+    load->touch = calloc(load->entryCount, sizeof(*load->touch));
+    if (!load->images || !load->touch) return false;
+
+    for (int i = 0; i < load->entryCount; i++) {
+        if (load->entries[i].type == ASSET_TEXTURE) {
+            if (!ReadTexture(file, &load->entries[i], &load->images[i])) return false;
+            load->touch[load->touchCount++] = &load->entries[i];
+        } else if (load->entries[i].type == ASSET_SOUND) {
+            load->touch[load->touchCount++] = &load->entries[i];
+        }
+    }
+    for (int side = SIDE_WHITE; side <= SIDE_BLACK; side++) {
+        int texture = load->materials[side].texture;
+        if (texture >= load->entryCount || (texture >= 0 && !load->images[texture].data)) return false;
+    }
+    for (int type = 0; type < PIECE_TYPE_COUNT; type++) {
+        int entry = FindEntry(file, pieceTypeNames[type], ASSET_MESH);
+        if (entry < 0) return false;
+        load->meshes[type] = EntryReader(file, &load->entries[entry]);
+    }
+
+    // This thread takes jobs too
+    int jobCount = PIECE_TYPE_COUNT + load->touchCount;
+    int helpers = (GetProcessorCount() < jobCount ? GetProcessorCount() : jobCount) - 1;
+    if (helpers > MAX_LOADER_THREADS) helpers = MAX_LOADER_THREADS;
+    for (int i = 0; i < helpers; i++) {
+        threads[threadCount] = StartThread(RunLoadJobs, load);
+        if (threads[threadCount]) threadCount++;
+    }
+    RunLoadJobs(load);
+    for (int i = 0; i < threadCount; i++) JoinThread(threads[i]);
+
+    for (int type = 0; type < PIECE_TYPE_COUNT; type++) {
+        if (!load->meshReady[type]) return false;
+    }
+    return true;
+}
+
+// Creates the GPU and audio objects; runs on the thread that owns the GL context
+static bool UploadBundle(GameAssets *assets, BundleLoad *load) {
+    assets->textures = calloc(load->entryCount, sizeof(Texture2D));
+    if (!assets->textures) return false;
+    assets->textureCount = load->entryCount;
+    for (int i = 0; i < load->entryCount; i++) {
+        if (load->images[i].data) assets->textures[i] = LoadTextureFromImage(load->images[i]);
+    }
+
+    for (int side = SIDE_WHITE; side <= SIDE_BLACK; side++) {
+        const BundleMaterial *material = &load->materials[side];
+        Texture2D texture = material->texture >= 0 ? assets->textures[material->texture] : (Texture2D){ 0 };
+        assets->pieces.materials[side] = SideMaterial(material->diffuse, texture);
+    }
+    UploadPieceMeshes(&assets->pieces);
+
+    assets->moveSound = LoadSoundFromWave(load->moveWave);
+    assets->castleSound = LoadSoundFromWave(load->castleWave);
+    if (load->music >= 0) assets->music = ReadMusic(load->file, &load->entries[load->music]);
+    return true;
+}
+
+static bool LoadFromBundle(GameAssets *assets, const char *path) {
+    MappedFile *file = &assets->bundle;
+    BundleLoad *load;
+    bool ok;
+
+    if (!MapFile(file, path)) return false;
+    if (!ValidBundle(file)) {
+        TraceLog(LOG_WARNING, "ASSETS: [%s] is not a valid asset bundle, run chess_pack to rebuild it", path);
+        UnmapFile(file);
+        return false;
+    }
+
+    load = calloc(1, sizeof(*load));
+    if (!load) {
+        UnmapFile(file);
+        return false;
+    }
+    load->file = file;
+    load->entries = (const BundleEntry *)(file->data + sizeof(BundleHeader));
+    load->entryCount = (int)((const BundleHeader *)file->data)->entryCount;
+    load->pieces = &assets->pieces;
+
+    ok = PrepareBundle(load) && UploadBundle(assets, load);
+
+    free(load->images);
+    free(load->touch);
+    free(load);
+
+    if (!ok) {
+        TraceLog(LOG_WARNING, "ASSETS: [%s] is incomplete or damaged, run chess_pack to rebuild it", path);
+        for (int type = 0; type < PIECE_TYPE_COUNT; type++) {
+            for (int lod = 0; lod < MAX_PIECE_LODS; lod++) FreeMeshArrays(&assets->pieces.meshes[type][lod]);
+        }
+        memset(&assets->pieces, 0, sizeof(assets->pieces));
+        UnmapFile(file);
+    }
+    return ok;
+}
+
+// Keeps the first mesh of a loaded model and releases the rest of it. The
+// diffuse map of that mesh's material is handed to the caller if asked for;
+// every other texture the glTF file brought along is unloaded.
+static Mesh ExtractMesh(Model model, MaterialMap *diffuse) {
+    unsigned int defaultTexture = DefaultTextureId();
+    Mesh mesh = model.meshes[0];
+    unsigned int kept = 0;
+
+    if (diffuse) {
+        *diffuse = model.materials[model.meshMaterial[0]].maps[MATERIAL_MAP_DIFFUSE];
+        kept = diffuse->texture.id;
+    }
+    for (int i = 1; i < model.meshCount; i++) UnloadMesh(model.meshes[i]);
+
+    for (int i = 0; i < model.materialCount; i++) {
+        for (int map = 0; map < MATERIAL_MAP_COUNT; map++) {
+            Texture2D texture = model.materials[i].maps[map].texture;
+            if (texture.id == 0 || texture.id == defaultTexture || texture.id == kept) continue;
+
+            // Several maps may share one texture; unload it once
+            UnloadTexture(texture);
+            for (int j = i; j < model.materialCount; j++) {
+                for (int other = 0; other < MATERIAL_MAP_COUNT; other++) {
+                    if (model.materials[j].maps[other].texture.id == texture.id) model.materials[j].maps[other].texture.id = 0;
+                }
+            }
+        }
+    }
+    for (int i = 0; i < model.materialCount; i++) MemFree(model.materials[i].maps);
+    MemFree(model.materials);
+    MemFree(model.meshes);
+    MemFree(model.meshMaterial);
+    MemFree(model.bones);
+    MemFree(model.bindPose);
+    return mesh;
+}
+
+// Both colors use the white model's geometry; the black pawn only provides
+// the black material
+static void LoadFromFiles(GameAssets *assets) {
+    PieceSet *pieces = &assets->pieces;
+    MaterialMap black = { 0 };
+
+    for (int type = 0; type < PIECE_TYPE_COUNT; type++) {
+        Model model = LoadModel(TextFormat(MODEL_PATH_FORMAT, pieceModelNames[MAKE_PIECE(SIDE_WHITE, type)]));
+        pieces->meshes[type][0] = ExtractMesh(model, NULL);
+        GeneratePieceLods(pieces, type);
+    }
+    UploadPieceMeshes(pieces);
+
+    Model blackPawn = LoadModel(TextFormat(MODEL_PATH_FORMAT, pieceModelNames[MAKE_PIECE(SIDE_BLACK, PIECE_PAWN)]));
+    UnloadMesh(ExtractMesh(blackPawn, &black));
+
+    Texture2D whiteTexture = LoadTexture(WHITE_TEXTURE_PATH);
+    pieces->materials[SIDE_WHITE] = SideMaterial(WHITE, whiteTexture);
+    pieces->materials[SIDE_BLACK] = SideMaterial(black.color, black.texture);
+
+    assets->textures = calloc(2, sizeof(Texture2D));
+    if (assets->textures) {
+        assets->textureCount = 2;
+        assets->textures[0] = whiteTexture;
+        if (black.texture.id != DefaultTextureId()) assets->textures[1] = black.texture;
+    }
+
+    assets->moveSound = LoadSound(MOVE_SOUND_PATH);
+    assets->castleSound = LoadSound(CASTLE_SOUND_PATH);
+    if (FileExists(MUSIC_PATH)) assets->music = LoadMusicStream(MUSIC_PATH);
+}
+
+void LoadGameAssets(GameAssets *assets, const char *bundlePath) {
+    int64_t start = GetMicroseconds();
+
+    memset(assets, 0, sizeof(*assets));
+    assets->fromBundle = LoadFromBundle(assets, bundlePath);
+    if (!assets->fromBundle) LoadFromFiles(assets);
+    assets->loadMs = (GetMicroseconds() - start) / 1000.0;
+}
+
+void ReportAssetMemory(const GameAssets *assets) {
+    const PieceSet *pieces = &assets->pieces;
+    uint64_t shared = 0, lods = 0, textures = 0;
+    int triangles[MAX_PIECE_LODS] = { 0 };
+
+    for (int type = 0; type < PIECE_TYPE_COUNT; type++) {
+        shared += MeshDataSize(&pieces->meshes[type][0]);
+        for (int lod = 1; lod < pieces->lodCount[type]; lod++) lods += MeshDataSize(&pieces->meshes[type][lod]);
+        for (int lod = 0; lod < pieces->lodCount[type]; lod++) triangles[lod] += pieces->meshes[type][lod].triangleCount;
+    }
+    for (int i = 0; i < assets->textureCount; i++) {
+        const Texture2D *texture = &assets->textures[i];
+        if (texture->id != 0) textures += TextureDataSize(texture->width, texture->height, texture->format, texture->mipmaps);
+    }
+
+    // Mesh bytes are held twice, in RAM and in video memory
+    TraceLog(LOG_INFO, "MEMORY: Piece meshes %.2f MB shared by both colors (%.2f MB as separate models), levels of detail %.2f MB",
+             shared / 1048576.0, 2 * shared / 1048576.0, lods / 1048576.0);
+    TraceLog(LOG_INFO, "MEMORY: Piece textures %.2f MB, triangles per piece set %d / %d / %d by level of detail",
+             textures / 1048576.0, triangles[0], triangles[1], triangles[2]);
+}
+
+void UnloadGameAssets(GameAssets *assets) {
+    PieceSet *pieces = &assets->pieces;
+
+    for (int type = 0; type < PIECE_TYPE_COUNT; type++) {
+        for (int lod = 0; lod < pieces->lodCount[type]; lod++) UnloadMesh(pieces->meshes[type][lod]);
+    }
+
+    // The textures are owned here, not by the materials
+    for (int side = SIDE_WHITE; side <= SIDE_BLACK; side++) MemFree(pieces->materials[side].maps);
+    for (int i = 0; i < assets->textureCount; i++) {
+        if (assets->textures[i].id != 0) UnloadTexture(assets->textures[i]);
+    }
+    free(assets->textures);
+
+    UnloadSound(assets->moveSound);
+    UnloadSound(assets->castleSound);
+    if (assets->music.ctxData) UnloadMusicStream(assets->music);
+    UnmapFile(&assets->bundle);
+    memset(assets, 0, sizeof(*assets));
+}
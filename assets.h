@@ -0,0 +1,132 @@
+#ifndef ASSETS_H
+#define ASSETS_H
+
+#include "raylib.h"
+#include "bitboard.h"
+#include "platform.h"
+
+// Loose source files, read by chess_pack and by the fallback loader
+#define MODEL_PATH_FORMAT "models_assets/%s.glb"
+#define WHITE_TEXTURE_PATH "models_assets/BetterWhiteTexture.png"
+#define MOVE_SOUND_PATH "sounds/move.mp3"
+#define CASTLE_SOUND_PATH "sounds/castle.mp3"
+#define MUSIC_PATH "sounds/music.mp3"
+
+#define ASSET_BUNDLE_PATH "chess_assets.pak"
+#define ASSET_BUNDLE_MAGIC 0x4B503343u      // "C3PK"
+#define ASSET_BUNDLE_VERSION 2
+#define ASSET_NAME_LENGTH 32
+#define ASSET_ALIGNMENT 16
+
+#define ASSET_MESH 1
+#define ASSET_TEXTURE 2
+#define ASSET_SOUND 3
+#define ASSET_MUSIC 4
+#define ASSET_MATERIAL 5
+
+// Bundle entry names; meshes are named by piece type (pieceTypeNames)
+#define WHITE_TEXTURE_NAME "BetterWhiteTexture"
+#define WHITE_MATERIAL_NAME "white"
+#define BLACK_MATERIAL_NAME "black"
+#define MOVE_SOUND_NAME "move"
+#define CASTLE_SOUND_NAME "castle"
+#define MUSIC_NAME "music"
+
+// A bundle is a BundleHeader, the entry table, then one payload per entry,
+// each starting on an ASSET_ALIGNMENT boundary. Payloads hold data in the form
+// raylib uploads it, so loading is a copy and an upload with no parsing.
+typedef struct BundleHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t entryCount;
+    uint32_t reserved;
+    uint64_t fileSize;
+} BundleHeader;
+
+typedef struct BundleEntry {
+    char name[ASSET_NAME_LENGTH];
+    uint32_t type;                  // ASSET_*
+    uint32_t reserved;
+    uint64_t offset;                // from the start of the file
+    uint64_t size;
+} BundleEntry;
+
+// ASSET_TEXTURE: header, then the pixels of every mip level
+typedef struct BundleTexture {
+    int32_t width, height, format, mipmaps;
+} BundleTexture;
+
+// ASSET_SOUND: header, then decoded interleaved samples
+typedef struct BundleSound {
+    uint32_t frameCount, sampleRate, sampleSize, channels;
+} BundleSound;
+
+// ASSET_MUSIC: header, then the encoded file, which is streamed while playing
+typedef struct BundleMusic {
+    char fileType[8];               // extension with the dot, e.g. ".mp3"
+    uint64_t size;
+} BundleMusic;
+
+// ASSET_MATERIAL: the diffuse map of one side's pieces
+typedef struct BundleMaterial {
+    Color diffuse;
+    int32_t texture;                // entry index of an ASSET_TEXTURE, -1 for raylib's default
+} BundleMaterial;
+
+#define BUNDLE_MESH_NORMALS 1
+#define BUNDLE_MESH_TEXCOORDS 2
+#define BUNDLE_MESH_COLORS 4
+#define BUNDLE_MESH_INDICES 8
+
+// ASSET_MESH: header, then the vertices and the flagged arrays in flag order, each aligned
+typedef struct BundleMesh {
+    int32_t vertexCount, triangleCount;
+    uint32_t arrays;                // BUNDLE_MESH_*
+    uint32_t reserved;
+} BundleMesh;
+
+// Model file names without extension, by piece code
+extern const char *const pieceModelNames[NO_PIECE];
+extern const char *const pieceTypeNames[PIECE_TYPE_COUNT];
+
+#define MAX_PIECE_LODS 3
+
+// Grid cells of each simplified level (see SimplifyMesh); level 0 is the full model
+extern const int pieceLodCells[MAX_PIECE_LODS];
+
+// Both colors of a piece type share one mesh and its levels of detail;
+// the side only picks the material
+typedef struct PieceSet {
+    Mesh meshes[PIECE_TYPE_COUNT][MAX_PIECE_LODS];
+    int lodCount[PIECE_TYPE_COUNT];
+    float extent[PIECE_TYPE_COUNT];         // longest side in model units, for LOD selection
+    Material materials[2];                  // by side
+} PieceSet;
+
+// Everything the game loads at startup
+typedef struct GameAssets {
+    PieceSet pieces;
+    Texture2D *textures;            // every texture the piece materials use
+    int textureCount;
+    Sound moveSound, castleSound;
+    Music music;                    // zeroed when there is no music
+    MappedFile bundle;              // stays mapped while the music streams from it
+    bool fromBundle;
+    double loadMs;
+} GameAssets;
+
+// Loads from the bundle when there is a valid one, otherwise from the loose
+// files. Call after InitWindow and InitAudioDevice.
+void LoadGameAssets(GameAssets *assets, const char *bundlePath);
+void UnloadGameAssets(GameAssets *assets);
+
+// Logs the vertex and texture bytes the pieces use
+void ReportAssetMemory(const GameAssets *assets);
+
+// Bytes of pixel data of a texture, all mip levels included
+uint64_t TextureDataSize(int width, int height, int format, int mipmaps);
+
+// Id of raylib's 1x1 white texture, which materials use when they have none
+unsigned int DefaultTextureId(void);
+
+#endif
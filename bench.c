@@ -0,0 +1,568 @@
+// chess_bench: headless engine benchmarks.
+//
+//   chess_bench smp [--depth N] [--threads N] [--hash MB]
+//       time-to-depth of the Lazy SMP search on a fixed position set, for
+//       1, 2, 4, ... threads up to --threads (default: every processor)
+//
+//   chess_bench eval [--positions N]
+//       evaluations per second over positions sampled from random games
+//       (default 100000), with and without the pawn hash
+//
+//   chess_bench nnue [--net FILE] [--positions N]
+//       network evaluation speed with every kernel set the processor supports,
+//       refreshed from scratch and updated incrementally along random games;
+//       without --net a network of random weights is written and used
+//
+//   chess_bench packed [--positions N]
+//       size and read speed of the binary position and game format against
+//       FEN and PGN text, over the same random games
+
+#include "smp.h"
+#include "psqt.h"
+#include "packed.h"
+#include "pgn.h"
+#include "random.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Middlegame and endgame positions with varied branching factors
+static const char *benchPositions[] = {
+    START_FEN,
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+    "r1bq1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N2N2/PP2BPPP/R2QKB1R w KQ - 0 8",
+    "2rq1rk1/pb1nbppp/1p2pn2/2pp4/2PP4/1PN1PN2/PBQ1BPPP/R4RK1 w - - 0 11",
+    "r2q1rk1/1b2bppp/p2ppn2/1p6/3NP3/1BN1B3/PPP2PPP/R2Q1RK1 w - - 0 12",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "6k1/5ppp/1p6/p1pP4/P1P2P2/1P3K2/6PP/8 w - - 0 30",
+};
+
+#define BENCH_POSITION_COUNT ((int)(sizeof(benchPositions) / sizeof(benchPositions[0])))
+
+typedef struct SmpResult {
+    int threads;
+    int64_t micros;
+    uint64_t nodes;
+} SmpResult;
+
+static SmpResult RunSmpRound(SearchPool *pool, int threads, int depth) {
+    SmpResult result = { threads, 0, 0 };
+    SearchLimits limits = { depth, 0, 0, 0 };
+    SearchInfo info;
+
+    SetPoolThreads(pool, threads);
+    for (int i = 0; i < BENCH_POSITION_COUNT; i++) {
+        Position pos;
+        PositionFromFen(&pos, benchPositions[i]);
+
+        // Every measurement starts cold so rounds do not feed each other
+        TTClear(pool->tt);
+        ClearPool(pool);
+
+        int64_t start = GetMicroseconds();
+        PoolSearch(pool, &pos, &limits, &info);
+        result.micros += GetMicroseconds() - start;
+        result.nodes += info.nodes;
+    }
+    return result;
+}
+
+static int RunSmpBench(int depth, int maxThreads, int hashMb) {
+    static SearchPool pool;
+    TranspositionTable tt = { 0 };
+    SmpResult base = { 0 };
+
+    if (maxThreads <= 0) maxThreads = GetProcessorCount();
+    if (maxThreads > MAX_SEARCH_THREADS) maxThreads = MAX_SEARCH_THREADS;
+    if (!TTInit(&tt, (size_t)hashMb) || !InitSearchPool(&pool, 1, &tt)) {
+        printf("out of memory\n");
+        return 1;
+    }
+
+    printf("Lazy SMP time to depth %d, %d positions, %d MB hash, %d processors\n\n",
+           depth, BENCH_POSITION_COUNT, hashMb, GetProcessorCount());
+    printf("threads      time ms        nodes        knps   speedup  efficiency\n");
+
+    for (int threads = 1;; threads *= 2) {
+        if (threads > maxThreads) threads = maxThreads;
+
+        SmpResult round = RunSmpRound(&pool, threads, depth);
+        if (threads == 1) base = round;
+
+        double seconds = round.micros > 0 ? round.micros / 1e6 : 1e-6;
+        double speedup = round.micros > 0 ? (double)base.micros / (double)round.micros : 0.0;
+        printf("%7d %12.1f %12llu %11.0f %9.2f %10.0f%%\n", threads, round.micros / 1000.0,
+               (unsigned long long)round.nodes, round.nodes / seconds / 1000.0, speedup, 100.0 * speedup / threads);
+        fflush(stdout);
+
+        if (threads == maxThreads) break;
+    }
+
+    FreeSearchPool(&pool);
+    TTFree(&tt);
+    return 0;
+}
+
+// True if the running material, piece-square and phase sums match a full scan
+static bool CheckIncrementalSums(const Position *pos) {
+    int mg = 0, eg = 0, phase = 0;
+
+    for (int sq = 0; sq < 64; sq++) {
+        int piece = pos->squares[sq];
+        if (piece == NO_PIECE) continue;
+        mg += psqtMg[piece][sq];
+        eg += psqtEg[piece][sq];
+        phase += phaseWeights[PIECE_TYPE(piece)];
+    }
+    return mg == pos->psqMg && eg == pos->psqEg && phase == pos->phase;
+}
+
+// Random games from the bench positions, one sample per ply. Every move is
+// also taken back once so the sums are checked after unmake as well.
+static int SamplePositions(Position *positions, int count, int *mismatches) {
+    uint64_t random = 0x2545F4914F6CDD1DULL;
+    int sampled = 0;
+
+    *mismatches = 0;
+    for (int game = 0; sampled < count; game++) {
+        Position pos;
+        PositionFromFen(&pos, benchPositions[game % BENCH_POSITION_COUNT]);
+
+        for (int ply = 0; ply < 200 && sampled < count; ply++) {
+            MoveList list;
+            UndoInfo undo;
+
+            GenerateLegalMoves(&pos, &list);
+            if (list.count == 0 || pos.halfmoveClock >= 100) break;
+
+            Move move = list.moves[NextRandom(&random) % list.count];
+            MakeMove(&pos, move, &undo);
+            if (!CheckIncrementalSums(&pos)) (*mismatches)++;
+            UnmakeMove(&pos, move, &undo);
+            if (!CheckIncrementalSums(&pos)) (*mismatches)++;
+            MakeMove(&pos, move, &undo);
+
+            positions[sampled++] = pos;
+        }
+    }
+    return sampled;
+}
+
+// Seconds for passes over the set, and a checksum so the work is not optimized away
+static double TimeEvaluations(const Position *positions, int count, int passes, PawnTable *pawns, int64_t *checksum) {
+    int64_t start = GetMicroseconds();
+
+    for (int pass = 0; pass < passes; pass++) {
+        for (int i = 0; i < count; i++) *checksum += Evaluate(&positions[i], pawns);
+    }
+    return (GetMicroseconds() - start) / 1e6;
+}
+
+// What the material and piece-square terms would cost if they were summed from the board
+static double TimeBoardScan(const Position *positions, int count, int passes, int64_t *checksum) {
+    int64_t start = GetMicroseconds();
+
+    for (int pass = 0; pass < passes; pass++) {
+        for (int i = 0; i < count; i++) {
+            const Position *pos = &positions[i];
+            int mg = 0, eg = 0, phase = 0;
+            for (int sq = 0; sq < 64; sq++) {
+                int piece = pos->squares[sq];
+                if (piece == NO_PIECE) continue;
+                mg += psqtMg[piece][sq];
+                eg += psqtEg[piece][sq];
+                phase += phaseWeights[PIECE_TYPE(piece)];
+            }
+            *checksum += mg + eg + phase;
+        }
+    }
+    return (GetMicroseconds() - start) / 1e6;
+}
+
+static int RunEvalBench(int count) {
+    static PawnTable pawns;
+    Position *positions = malloc(sizeof(Position) * (size_t)count);
+    int64_t checksum = 0;
+    int mismatches;
+    int passes = 10;
+
+    if (!positions) {
+        printf("out of memory\n");
+        return 1;
+    }
+
+    count = SamplePositions(positions, count, &mismatches);
+    printf("Evaluation on %d positions from random games, %d passes\n\n", count, passes);
+
+    // Warm up, then measure
+    ClearPawnTable(&pawns);
+    TimeEvaluations(positions, count, 1, &pawns, &checksum);
+    pawns.probes = pawns.hits = 0;
+
+    double cached = TimeEvaluations(positions, count, passes, &pawns, &checksum);
+    double uncached = TimeEvaluations(positions, count, passes, NULL, &checksum);
+    double scan = TimeBoardScan(positions, count, passes, &checksum);
+    double evals = (double)count * passes;
+
+    printf("evaluate, pawn hash     %10.2f M evals/s  %6.1f ns/eval  %5.1f%% pawn hits\n",
+           evals / cached / 1e6, cached * 1e9 / evals, pawns.probes ? 100.0 * pawns.hits / pawns.probes : 0.0);
+    printf("evaluate, no pawn hash  %10.2f M evals/s  %6.1f ns/eval\n", evals / uncached / 1e6, uncached * 1e9 / evals);
+    printf("psqt board scan         %10.2f M scans/s  %6.1f ns/scan   (what the incremental sums save)\n",
+           evals / scan / 1e6, scan * 1e9 / evals);
+    printf("\nincremental sum mismatches: %d   checksum %lld\n", mismatches, (long long)checksum);
+
+    free(positions);
+    return mismatches ? 1 : 0;
+}
+
+#define RANDOM_NETWORK_FILE "chess_bench.nnue"
+
+// Speed does not depend on the weights, so a random network measures the
+// kernels as well as a trained one and needs no download
+static bool WriteRandomNetwork(const char *path) {
+    size_t weightCount = (size_t)NNUE_FEATURES * NNUE_HIDDEN + NNUE_HIDDEN + 2 * NNUE_HIDDEN;
+    int16_t *weights = malloc(weightCount * sizeof(int16_t));
+    NnueHeader header = { NNUE_MAGIC, NNUE_VERSION, NNUE_FEATURES, NNUE_HIDDEN, 255, 64, 400, { 0 } };
+    int32_t outputBias = 0;
+    uint64_t random = 0x9E3779B97F4A7C15ULL;
+    FILE *file;
+
+    if (!weights) return false;
+    for (size_t i = 0; i < weightCount; i++) {
+        int range = i < weightCount - 2 * NNUE_HIDDEN ? 32 : 64;
+        weights[i] = (int16_t)((int)(NextRandom(&random) % (2 * range + 1)) - range);
+    }
+
+    file = fopen(path, "wb");
+    bool written = file && fwrite(&header, sizeof(header), 1, file) == 1
+        && fwrite(weights, sizeof(int16_t), weightCount, file) == weightCount
+        && fwrite(&outputBias, sizeof(outputBias), 1, file) == 1;
+    if (file && fclose(file) != 0) written = false;
+    free(weights);
+    return written;
+}
+
+// Moves of random games from the bench positions; startFen[i] is the position
+// index a game starts from before move i, or -1 when move i continues a game
+static int SampleGames(Move *moves, int *startFen, int count) {
+    uint64_t random = 0x2545F4914F6CDD1DULL;
+    int sampled = 0;
+
+    for (int game = 0; sampled < count; game++) {
+        Position pos;
+        PositionFromFen(&pos, benchPositions[game % BENCH_POSITION_COUNT]);
+
+        for (int ply = 0; ply < 200 && sampled < count; ply++) {
+            MoveList list;
+            UndoInfo undo;
+
+            GenerateLegalMoves(&pos, &list);
+            if (list.count == 0 || pos.halfmoveClock >= 100) break;
+
+            moves[sampled] = list.moves[NextRandom(&random) % list.count];
+            startFen[sampled] = ply == 0 ? game % BENCH_POSITION_COUNT : -1;
+            MakeMove(&pos, moves[sampled++], &undo);
+        }
+    }
+    return sampled;
+}
+
+#define NNUE_MODE_HCE 0             // hand-crafted Evaluate, for reference
+#define NNUE_MODE_REFRESH 1
+#define NNUE_MODE_INCREMENTAL 2
+
+// Replays the games, evaluating after every move. Scores go to scores[] when
+// given; otherwise they are compared against it and mismatches counted.
+static double ReplayGames(const Network *net, const Move *moves, const int *startFen, int count, int mode,
+                          int *scores, int *mismatches, int64_t *checksum) {
+    static Accumulator stack[2];
+    static PawnTable pawns;
+    Position pos;
+    UndoInfo undo;
+    int current = 0;
+    int64_t start = GetMicroseconds();
+
+    for (int i = 0; i < count; i++) {
+        if (startFen[i] >= 0) {
+            PositionFromFen(&pos, benchPositions[startFen[i]]);
+            if (mode == NNUE_MODE_INCREMENTAL) NnueRefresh(net, &pos, &stack[current]);
+        }
+
+        int score;
+        if (mode == NNUE_MODE_HCE) {
+            MakeMove(&pos, moves[i], &undo);
+            score = Evaluate(&pos, &pawns);
+        } else if (mode == NNUE_MODE_REFRESH) {
+            MakeMove(&pos, moves[i], &undo);
+            NnueRefresh(net, &pos, &stack[0]);
+            score = NnueOutput(net, &stack[0], pos.sideToMove);
+        } else {
+            Accumulator *child = &stack[current ^ 1];
+            NnuePush(child, &pos, moves[i]);
+            MakeMove(&pos, moves[i], &undo);
+            NnueUpdate(net, &stack[current], child);
+            score = NnueOutput(net, child, pos.sideToMove);
+            current ^= 1;
+        }
+
+        *checksum += score;
+        if (mode == NNUE_MODE_HCE) continue;
+        if (!mismatches) scores[i] = score;
+        else if (scores[i] != score) (*mismatches)++;
+    }
+    return (GetMicroseconds() - start) / 1e6;
+}
+
+static int RunNnueBench(const char *path, int count) {
+    Network net;
+    Move *moves = malloc(sizeof(Move) * (size_t)count);
+    int *startFen = malloc(sizeof(int) * (size_t)count);
+    int *reference = malloc(sizeof(int) * (size_t)count);
+    int64_t checksum = 0;
+    int mismatches = 0;
+
+    if (!moves || !startFen || !reference) {
+        printf("out of memory\n");
+        return 1;
+    }
+    if (!path) {
+        path = RANDOM_NETWORK_FILE;
+        if (!WriteRandomNetwork(path)) {
+            printf("cannot write %s\n", path);
+            return 1;
+        }
+    }
+    if (!LoadNetwork(&net, path)) {
+        printf("%s is missing or not a %dx%d network of version %d\n", path, NNUE_FEATURES, NNUE_HIDDEN, NNUE_VERSION);
+        return 1;
+    }
+
+    count = SampleGames(moves, startFen, count);
+    printf("Network %s on %d positions from random games, best kernels: %s\n\n", path, count,
+           NnueSimdName(NnueDetectSimd()));
+    printf("evaluator                      M evals/s   ns/eval   (each includes MakeMove)\n");
+
+    // Scalar refresh is the reference every other kernel and mode must reproduce exactly
+    NnueSetSimd(NNUE_SIMD_SCALAR);
+    ReplayGames(&net, moves, startFen, count, NNUE_MODE_REFRESH, reference, NULL, &checksum);
+
+    double seconds = ReplayGames(&net, moves, startFen, count, NNUE_MODE_HCE, NULL, NULL, &checksum);
+    printf("hand-crafted Evaluate        %11.2f %9.1f\n", count / seconds / 1e6, seconds * 1e9 / count);
+
+    for (int level = NNUE_SIMD_SCALAR; level <= NnueDetectSimd(); level++) {
+        NnueSetSimd(level);
+        for (int mode = NNUE_MODE_REFRESH; mode <= NNUE_MODE_INCREMENTAL; mode++) {
+            seconds = ReplayGames(&net, moves, startFen, count, mode, reference, &mismatches, &checksum);
+            printf("%-6s %-21s %11.2f %9.1f\n", NnueSimdName(level), mode == NNUE_MODE_REFRESH ? "refresh" : "incremental",
+                   count / seconds / 1e6, seconds * 1e9 / count);
+        }
+    }
+    printf("\nmismatches against the scalar refresh: %d   checksum %lld\n", mismatches, (long long)checksum);
+
+    UnloadNetwork(&net);
+    free(moves);
+    free(startFen);
+    free(reference);
+    return mismatches ? 1 : 0;
+}
+
+#define PACKED_BENCH_GAMES "chess_bench.bin"
+#define PACKED_BENCH_PGN "chess_bench.pgn"
+
+static bool SamePosition(const Position *a, const Position *b) {
+    return a->key == b->key && a->castling == b->castling && a->epSquare == b->epSquare &&
+           a->halfmoveClock == b->halfmoveClock && a->fullmoveNumber == b->fullmoveNumber &&
+           memcmp(a->squares, b->squares, sizeof(a->squares)) == 0;
+}
+
+// Writes the sampled games as PGN with a FEN tag and in the binary format
+static bool WriteBenchGames(const Move *moves, const int *startFen, int count) {
+    FILE *pgn = fopen(PACKED_BENCH_PGN, "wb");
+    FILE *packed = fopen(PACKED_BENCH_GAMES, "wb");
+    bool written = pgn && packed && WritePackedHeader(packed, PACKED_KIND_GAMES);
+
+    for (int first = 0; written && first < count;) {
+        Position start, pos;
+        UndoInfo undo;
+        char san[PGN_MAX_SAN];
+        int end = first + 1;
+
+        while (end < count && startFen[end] < 0) end++;
+        PositionFromFen(&start, benchPositions[startFen[first]]);
+        written = WritePackedGame(packed, &start, moves + first, end - first, PACKED_RESULT_UNKNOWN);
+
+        pos = start;
+        fprintf(pgn, "[Event \"bench\"]\n[FEN \"%s\"]\n\n", benchPositions[startFen[first]]);
+        for (int i = first; i < end; i++) {
+            MoveToSan(&pos, moves[i], san);
+            if (pos.sideToMove == SIDE_WHITE) fprintf(pgn, "%d. ", pos.fullmoveNumber);
+            fprintf(pgn, "%s%s", san, (i - first) % 12 == 11 ? "\n" : " ");
+            MakeMove(&pos, moves[i], &undo);
+        }
+        fprintf(pgn, "*\n\n");
+        first = end;
+    }
+    if (pgn && fclose(pgn) != 0) written = false;
+    if (packed && fclose(packed) != 0) written = false;
+    return written;
+}
+
+static int RunPackedBench(int count) {
+    Position *positions = malloc(sizeof(Position) * (size_t)count);
+    PackedPosition *packed = malloc(sizeof(PackedPosition) * (size_t)count);
+    Move *moves = malloc(sizeof(Move) * (size_t)count);
+    int *startFen = malloc(sizeof(int) * (size_t)count);
+    char *fens = malloc((size_t)count * 100);
+    int64_t checksum = 0;
+    int mismatches = 0;
+
+    if (!positions || !packed || !moves || !startFen || !fens) {
+        printf("out of memory\n");
+        return 1;
+    }
+
+    // Positions: FEN lines against 32-byte records
+    count = SamplePositions(positions, count, &mismatches);
+    size_t fenBytes = 0;
+    for (int i = 0; i < count; i++) {
+        PositionToFen(&positions[i], fens + fenBytes, 100);
+        fenBytes += strlen(fens + fenBytes) + 1;
+        if (!PackPosition(&positions[i], &packed[i])) mismatches++;
+    }
+
+    Position pos;
+    int64_t start = GetMicroseconds();
+    for (size_t offset = 0; offset < fenBytes; offset += strlen(fens + offset) + 1) {
+        PositionFromFen(&pos, fens + offset);
+        checksum += (int64_t)(pos.key & 0xFFFF);
+    }
+    double fenSeconds = (GetMicroseconds() - start) / 1e6;
+
+    start = GetMicroseconds();
+    for (int i = 0; i < count; i++) {
+        if (!UnpackPosition(&packed[i], &pos)) mismatches++;
+        checksum += (int64_t)(pos.key & 0xFFFF);
+    }
+    double packedSeconds = (GetMicroseconds() - start) / 1e6;
+
+    // Filters such as "white to move, at most 12 pieces" need no unpacking
+    start = GetMicroseconds();
+    for (int i = 0; i < count; i++) checksum += PopCount(packed[i].occupied) + (packed[i].state & 1);
+    double inPlaceSeconds = (GetMicroseconds() - start) / 1e6;
+    if (inPlaceSeconds <= 0.0) inPlaceSeconds = 1e-6;
+
+    for (int i = 0; i < count; i++) {
+        if (!UnpackPosition(&packed[i], &pos) || !SamePosition(&pos, &positions[i])) mismatches++;
+    }
+
+    printf("%d positions from random games\n\n", count);
+    printf("format        bytes/position   M positions/s\n");
+    printf("FEN           %14.1f %15.2f\n", (double)fenBytes / count, count / fenSeconds / 1e6);
+    printf("packed        %14.1f %15.2f\n", (double)sizeof(PackedPosition), count / packedSeconds / 1e6);
+    printf("  in place    %14.1f %15.2f   (fields read from the record, no Position built)\n",
+           (double)sizeof(PackedPosition), count / inPlaceSeconds / 1e6);
+
+    // Games: PGN movetext against 16-bit moves, both read from mapped files
+    // and replayed with every move checked against the legal moves
+    count = SampleGames(moves, startFen, count);
+    MappedFile pgnFile, gamesFile;
+    if (!WriteBenchGames(moves, startFen, count) || !MapFile(&pgnFile, PACKED_BENCH_PGN) ||
+        !MapFile(&gamesFile, PACKED_BENCH_GAMES)) {
+        printf("cannot write %s and %s\n", PACKED_BENCH_PGN, PACKED_BENCH_GAMES);
+        return 1;
+    }
+
+    PgnScanner scanner;
+    PgnGame game;
+    int pgnMoves = 0, games = 0;
+    start = GetMicroseconds();
+    InitPgnScanner(&scanner, (const char *)pgnFile.data, pgnFile.size);
+    while (NextPgnGame(&scanner, &game)) {
+        PgnMoveReader reader;
+        UndoInfo undo;
+        char fen[128];
+        const char *san;
+
+        GetPgnTag(&game, "FEN", fen, sizeof(fen));
+        PositionFromFen(&pos, fen);
+        InitPgnMoveReader(&reader, &game);
+        while ((san = NextPgnMove(&reader)) != NULL) {
+            Move move = ParseSan(&pos, san);
+            if (move == MOVE_NONE) break;
+            MakeMove(&pos, move, &undo);
+            pgnMoves++;
+        }
+        checksum += (int64_t)(pos.key & 0xFFFF);
+        games++;
+    }
+    double pgnSeconds = (GetMicroseconds() - start) / 1e6;
+
+    PackedReader reader;
+    const PackedGame *stored;
+    const Move *storedMoves;
+    int packedMoves = 0;
+    start = GetMicroseconds();
+    InitPackedReader(&reader, gamesFile.data, gamesFile.size);
+    while ((stored = NextPackedGame(&reader, &storedMoves)) != NULL) {
+        packedMoves += ReplayPackedGame(stored, storedMoves, &pos);
+        checksum += (int64_t)(pos.key & 0xFFFF);
+    }
+    double gamesSeconds = (GetMicroseconds() - start) / 1e6;
+    if (pgnMoves != count || packedMoves != count) mismatches++;
+
+    printf("\n%d games, %d moves\n\n", games, count);
+    printf("format        bytes/move       M moves/s\n");
+    printf("PGN           %10.1f %15.2f\n", (double)pgnFile.size / count, pgnMoves / pgnSeconds / 1e6);
+    printf("packed        %10.1f %15.2f\n", (double)gamesFile.size / count, packedMoves / gamesSeconds / 1e6);
+    printf("\nround-trip mismatches: %d   checksum %lld\n", mismatches, (long long)checksum);
+
+    UnmapFile(&pgnFile);
+    UnmapFile(&gamesFile);
+    free(positions);
+    free(packed);
+    free(moves);
+    free(startFen);
+    free(fens);
+    return mismatches ? 1 : 0;
+}
+
+static void PrintUsage(void) {
+    printf("usage: chess_bench smp [--depth N] [--threads N] [--hash MB]\n");
+    printf("       chess_bench eval [--positions N]\n");
+    printf("       chess_bench nnue [--net FILE] [--positions N]\n");
+    printf("       chess_bench packed [--positions N]\n");
+}
+
+int main(int argc, char **argv) {
+    int depth = 12;
+    int threads = 0;
+    int hashMb = 256;
+    int positions = 100000;
+    const char *network = NULL;
+
+    if (argc < 2 || (strcmp(argv[1], "smp") != 0 && strcmp(argv[1], "eval") != 0 && strcmp(argv[1], "nnue") != 0 &&
+                      strcmp(argv[1], "packed") != 0)) {
+        PrintUsage();
+        return 2;
+    }
+
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--positions") == 0 && i + 1 < argc) positions = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--net") == 0 && i + 1 < argc) network = argv[++i];
+        else if ((strcmp(argv[i], "--depth") == 0 || strcmp(argv[i], "-d") == 0) && i + 1 < argc) depth = atoi(argv[++i]);
+        else if ((strcmp(argv[i], "--threads") == 0 || strcmp(argv[i], "-t") == 0) && i + 1 < argc) threads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--hash") == 0 && i + 1 < argc) hashMb = atoi(argv[++i]);
+        else {
+            PrintUsage();
+            return 2;
+        }
+    }
+
+    InitBitboards();
+    if (strcmp(argv[1], "eval") == 0) return RunEvalBench(positions > 0 ? positions : 100000);
+    if (strcmp(argv[1], "nnue") == 0) return RunNnueBench(network, positions > 0 ? positions : 100000);
+    if (strcmp(argv[1], "packed") == 0) return RunPackedBench(positions > 0 ? positions : 100000);
+    return RunSmpBench(depth > 0 ? depth : 12, threads, hashMb > 0 ? hashMb : 256);
+}
@@ -0,0 +1,203 @@
+#include "bitboard.h"
+#include "position.h"
+#include "random.h"
+
+#include <string.h>
+
+Bitboard knightAttacks[64];
+Bitboard kingAttacks[64];
+Bitboard pawnAttacks[2][64];
+Bitboard betweenBB[64][64];
+Bitboard lineBB[64][64];
+Magic rookMagics[64];
+Magic bishopMagics[64];
+
+// Shared attack storage for all squares ("fancy" magics)
+static Bitboard rookTable[102400];
+static Bitboard bishopTable[5248];
+
+static bool bitboardsReady = false;
+
+// Magics found offline with the search below; kept so startup skips the search
+static const Bitboard rookMagicNumbers[64] = {
+    0x0A80004000801220ULL, 0x8040004010002008ULL, 0x2080200010008008ULL, 0x1100100008210004ULL,
+    0xC200209084020008ULL, 0x2100010004000208ULL, 0x0400081000822421ULL, 0x0200010422048844ULL,
+    0x0800800080400024ULL, 0x0001402000401000ULL, 0x3000801000802001ULL, 0x4400800800100083ULL,
+    0x0904802402480080ULL, 0x4040800400020080ULL, 0x0018808042000100ULL, 0x4040800080004100ULL,
+    0x0040048001458024ULL, 0x00A0004000205000ULL, 0x3100808010002000ULL, 0x4825010010000820ULL,
+    0x5004808008000401ULL, 0x2024818004000A00ULL, 0x0005808002000100ULL, 0x2100060004806104ULL,
+    0x0080400880008421ULL, 0x4062220600410280ULL, 0x010A004A00108022ULL, 0x0000100080080080ULL,
+    0x0021000500080010ULL, 0x0044000202001008ULL, 0x0000100400080102ULL, 0xC020128200040545ULL,
+    0x0080002000400040ULL, 0x0000804000802004ULL, 0x0000120022004080ULL, 0x010A386103001001ULL,
+    0x9010080080800400ULL, 0x8440020080800400ULL, 0x0004228824001001ULL, 0x000000490A000084ULL,
+    0x0080002000504000ULL, 0x200020005000C000ULL, 0x0012088020420010ULL, 0x0010010080080800ULL,
+    0x0085001008010004ULL, 0x0002000204008080ULL, 0x0040413002040008ULL, 0x0000304081020004ULL,
+    0x0080204000800080ULL, 0x3008804000290100ULL, 0x1010100080200080ULL, 0x2008100208028080ULL,
+    0x5000850800910100ULL, 0x8402019004680200ULL, 0x0120911028020400ULL, 0x0000008044010200ULL,
+    0x0020850200244012ULL, 0x0020850200244012ULL, 0x0000102001040841ULL, 0x140900040A100021ULL,
+    0x000200282410A102ULL, 0x000200282410A102ULL, 0x000200282410A102ULL, 0x4048240043802106ULL
+};
+
+static const Bitboard bishopMagicNumbers[64] = {
+    0x40106000A1160020ULL, 0x0020010250810120ULL, 0x2010010220280081ULL, 0x002806004050C040ULL,
+    0x0002021018000000ULL, 0x2001112010000400ULL, 0x0881010120218080ULL, 0x1030820110010500ULL,
+    0x0000120222042400ULL, 0x2000020404040044ULL, 0x8000480094208000ULL, 0x0003422A02000001ULL,
+    0x000A220210100040ULL, 0x8004820202226000ULL, 0x0018234854100800ULL, 0x0100004042101040ULL,
+    0x0004001004082820ULL, 0x0010000810010048ULL, 0x1014004208081300ULL, 0x2080818802044202ULL,
+    0x0040880C00A00100ULL, 0x0080400200522010ULL, 0x0001000188180B04ULL, 0x0080249202020204ULL,
+    0x1004400004100410ULL, 0x00013100A0022206ULL, 0x2148500001040080ULL, 0x4241080011004300ULL,
+    0x4020848004002000ULL, 0x10101380D1004100ULL, 0x0008004422020284ULL, 0x01010A1041008080ULL,
+    0x0808080400082121ULL, 0x0808080400082121ULL, 0x0091128200100C00ULL, 0x0202200802010104ULL,
+    0x8C0A020200440085ULL, 0x01A0008080B10040ULL, 0x0889520080122800ULL, 0x100902022202010AULL,
+    0x04081A0816002000ULL, 0x0000681208005000ULL, 0x8170840041008802ULL, 0x0A00004200810805ULL,
+    0x0830404408210100ULL, 0x2602208106006102ULL, 0x1048300680802628ULL, 0x2602208106006102ULL,
+    0x0602010120110040ULL, 0x0941010801043000ULL, 0x000040440A210428ULL, 0x0008240020880021ULL,
+    0x0400002012048200ULL, 0x00AC102001210220ULL, 0x0220021002009900ULL, 0x84440C080A013080ULL,
+    0x0001008044200440ULL, 0x0004C04410841000ULL, 0x2000500104011130ULL, 0x1A0C010011C20229ULL,
+    0x0044800112202200ULL, 0x0434804908100424ULL, 0x0300404822C08200ULL, 0x48081010008A2A80ULL
+};
+
+static const int rookDirections[4][2] = { {1, 0}, {-1, 0}, {0, 1}, {0, -1} };
+static const int bishopDirections[4][2] = { {1, 1}, {1, -1}, {-1, 1}, {-1, -1} };
+
+// Slow ray walk, only used while building the tables
+static Bitboard SlidingAttacks(int sq, Bitboard occupied, const int directions[4][2]) {
+    Bitboard attacks = 0;
+
+    for (int d = 0; d < 4; d++) {
+        int file = SQUARE_FILE(sq) + directions[d][0];
+        int rank = SQUARE_RANK(sq) + directions[d][1];
+
+        while (file >= 0 && file < 8 && rank >= 0 && rank < 8) {
+            int target = SQUARE(file, rank);
+            attacks |= BB(target);
+            if (occupied & BB(target)) break;
+            file += directions[d][0];
+            rank += directions[d][1];
+        }
+    }
+
+    return attacks;
+}
+
+static Bitboard LeaperAttacks(int sq, const int offsets[][2], int count) {
+    Bitboard attacks = 0;
+
+    for (int i = 0; i < count; i++) {
+        int file = SQUARE_FILE(sq) + offsets[i][0];
+        int rank = SQUARE_RANK(sq) + offsets[i][1];
+        if (file >= 0 && file < 8 && rank >= 0 && rank < 8) {
+            attacks |= BB(SQUARE(file, rank));
+        }
+    }
+
+    return attacks;
+}
+
+static void InitMagics(Magic magics[64], Bitboard *table, const int directions[4][2], const Bitboard known[64]) {
+    // Per-rank seeds known to find all magics in a few thousand tries; fixed,
+    // so the magics (and startup time) are reproducible
+    static const uint64_t seeds[8] = { 728, 10316, 55013, 32803, 12281, 15100, 16645, 255 };
+    static Bitboard occupancy[4096];
+    static Bitboard reference[4096];
+    static int epoch[4096];
+    int attempt = 0;
+    int size = 0;
+
+    memset(epoch, 0, sizeof(epoch));
+
+    for (int sq = 0; sq < 64; sq++) {
+        Magic *m = &magics[sq];
+
+        // Board edges are not relevant unless the piece is on them
+        Bitboard edges = ((RANK_1_BB | RANK_8_BB) & ~(RANK_1_BB << (8 * SQUARE_RANK(sq))))
+                       | ((FILE_A_BB | FILE_H_BB) & ~(FILE_A_BB << SQUARE_FILE(sq)));
+
+        m->mask = SlidingAttacks(sq, 0, directions) & ~edges;
+        m->shift = 64 - PopCount(m->mask);
+        m->attacks = sq == 0 ? table : magics[sq - 1].attacks + size;
+
+        // Enumerate all subsets of the mask (Carry-Rippler)
+        Bitboard b = 0;
+        size = 0;
+        do {
+            occupancy[size] = b;
+            reference[size] = SlidingAttacks(sq, b, directions);
+            size++;
+            b = (b - m->mask) & m->mask;
+        } while (b);
+
+#if defined(USE_PEXT)
+        for (int i = 0; i < size; i++) {
+            m->attacks[_pext_u64(occupancy[i], m->mask)] = reference[i];
+        }
+#else
+        uint64_t seed = seeds[SQUARE_RANK(sq)];
+        bool useKnown = true;
+        for (int i = 0; i < size; ) {
+            // Fall back to a random search if the stored magic does not verify
+            if (useKnown) {
+                m->magic = known[sq];
+                useKnown = false;
+            } else {
+                do {
+                    m->magic = NextRandom(&seed) & NextRandom(&seed) & NextRandom(&seed);
+                } while (PopCount((m->mask * m->magic) >> 56) < 6);
+            }
+
+            attempt++;
+            for (i = 0; i < size; i++) {
+                unsigned int index = MagicIndex(m, occupancy[i]);
+                if (epoch[index] < attempt) {
+                    epoch[index] = attempt;
+                    m->attacks[index] = reference[i];
+                } else if (m->attacks[index] != reference[i]) {
+                    break;
+                }
+            }
+        }
+#endif
+    }
+}
+
+void InitBitboards(void) {
+    static const int knightOffsets[8][2] = {
+        {1, 2}, {2, 1}, {2, -1}, {1, -2}, {-1, -2}, {-2, -1}, {-2, 1}, {-1, 2}
+    };
+    static const int kingOffsets[8][2] = {
+        {1, 0}, {1, 1}, {0, 1}, {-1, 1}, {-1, 0}, {-1, -1}, {0, -1}, {1, -1}
+    };
+    static const int whitePawnOffsets[2][2] = { {-1, 1}, {1, 1} };
+    static const int blackPawnOffsets[2][2] = { {-1, -1}, {1, -1} };
+
+    if (bitboardsReady) return;
+
+    for (int sq = 0; sq < 64; sq++) {
+        knightAttacks[sq] = LeaperAttacks(sq, knightOffsets, 8);
+        kingAttacks[sq] = LeaperAttacks(sq, kingOffsets, 8);
+        pawnAttacks[SIDE_WHITE][sq] = LeaperAttacks(sq, whitePawnOffsets, 2);
+        pawnAttacks[SIDE_BLACK][sq] = LeaperAttacks(sq, blackPawnOffsets, 2);
+    }
+
+    InitMagics(rookMagics, rookTable, rookDirections, rookMagicNumbers);
+    InitMagics(bishopMagics, bishopTable, bishopDirections, bishopMagicNumbers);
+
+    for (int a = 0; a < 64; a++) {
+        for (int b = 0; b < 64; b++) {
+            betweenBB[a][b] = 0;
+            lineBB[a][b] = 0;
+            if (a == b) continue;
+
+            if (BishopAttacks(a, 0) & BB(b)) {
+                betweenBB[a][b] = BishopAttacks(a, BB(b)) & BishopAttacks(b, BB(a));
+                lineBB[a][b] = (BishopAttacks(a, 0) & BishopAttacks(b, 0)) | BB(a) | BB(b);
+            } else if (RookAttacks(a, 0) & BB(b)) {
+                betweenBB[a][b] = RookAttacks(a, BB(b)) & RookAttacks(b, BB(a));
+                lineBB[a][b] = (RookAttacks(a, 0) & RookAttacks(b, 0)) | BB(a) | BB(b);
+            }
+        }
+    }
+
+    InitPositionTables();
+    bitboardsReady = true;
+}
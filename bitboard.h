@@ -0,0 +1,152 @@
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#if defined(USE_PEXT)
+#include <immintrin.h>
+#endif
+
+// One bit per square, a1 = bit 0, h8 = bit 63
+typedef uint64_t Bitboard;
+
+#define SIDE_WHITE 0
+#define SIDE_BLACK 1
+#define SIDE_BOTH 2
+
+#define PIECE_PAWN 0
+#define PIECE_KNIGHT 1
+#define PIECE_BISHOP 2
+#define PIECE_ROOK 3
+#define PIECE_QUEEN 4
+#define PIECE_KING 5
+#define PIECE_TYPE_COUNT 6
+
+// Colored piece codes used by the mailbox: side * 6 + type
+#define NO_PIECE 12
+#define MAKE_PIECE(side, type) ((side) * PIECE_TYPE_COUNT + (type))
+#define PIECE_SIDE(piece) ((piece) / PIECE_TYPE_COUNT)
+#define PIECE_TYPE(piece) ((piece) % PIECE_TYPE_COUNT)
+
+#define SQ_NONE 64
+#define SQ_A1 0
+#define SQ_C1 2
+#define SQ_D1 3
+#define SQ_E1 4
+#define SQ_F1 5
+#define SQ_G1 6
+#define SQ_H1 7
+#define SQ_A8 56
+#define SQ_C8 58
+#define SQ_D8 59
+#define SQ_E8 60
+#define SQ_F8 61
+#define SQ_G8 62
+#define SQ_H8 63
+
+#define SQUARE(file, rank) ((rank) * 8 + (file))
+#define SQUARE_FILE(sq) ((sq) & 7)
+#define SQUARE_RANK(sq) ((sq) >> 3)
+
+// The UI board is indexed [row][col] with row 0 = rank 8 (black's back rank)
+#define SQUARE_FROM_ROWCOL(row, col) ((7 - (row)) * 8 + (col))
+#define SQUARE_ROW(sq) (7 - ((sq) >> 3))
+#define SQUARE_COL(sq) ((sq) & 7)
+
+#define BB(sq) (1ULL << (sq))
+
+#define FILE_A_BB 0x0101010101010101ULL
+#define FILE_H_BB 0x8080808080808080ULL
+#define RANK_1_BB 0x00000000000000FFULL
+#define RANK_2_BB 0x000000000000FF00ULL
+#define RANK_3_BB 0x0000000000FF0000ULL
+#define RANK_6_BB 0x0000FF0000000000ULL
+#define RANK_7_BB 0x00FF000000000000ULL
+#define RANK_8_BB 0xFF00000000000000ULL
+
+static inline int PopCount(Bitboard b) {
+#if defined(_MSC_VER) && defined(_M_X64)
+    return (int)__popcnt64(b);
+#elif defined(_MSC_VER)
+    return (int)(__popcnt((unsigned int)b) + __popcnt((unsigned int)(b >> 32)));
+#else
+    return __builtin_popcountll(b);
+#endif
+}
+
+// Index of the least significant set bit; b must be non-zero
+static inline int Lsb(Bitboard b) {
+#if defined(_MSC_VER) && defined(_M_X64)
+    unsigned long index;
+    _BitScanForward64(&index, b);
+    return (int)index;
+#elif defined(_MSC_VER)
+    unsigned long index;
+    if ((unsigned int)b) {
+        _BitScanForward(&index, (unsigned int)b);
+        return (int)index;
+    }
+    _BitScanForward(&index, (unsigned int)(b >> 32));
+    return (int)index + 32;
+#else
+    return __builtin_ctzll(b);
+#endif
+}
+
+static inline int PopLsb(Bitboard *b) {
+    int sq = Lsb(*b);
+    *b &= *b - 1;
+    return sq;
+}
+
+static inline bool MoreThanOne(Bitboard b) {
+    return (b & (b - 1)) != 0;
+}
+
+// Magic lookup entry for one square of a sliding piece
+typedef struct Magic {
+    Bitboard mask;
+    Bitboard magic;
+    Bitboard *attacks;
+    unsigned int shift;
+} Magic;
+
+extern Bitboard knightAttacks[64];
+extern Bitboard kingAttacks[64];
+extern Bitboard pawnAttacks[2][64];
+extern Bitboard betweenBB[64][64];   // squares strictly between two aligned squares
+extern Bitboard lineBB[64][64];      // full line through two aligned squares
+extern Magic rookMagics[64];
+extern Magic bishopMagics[64];
+
+// Builds the leaper tables, finds the slider magics and fills the position
+// tables; safe to call more than once, but only from one thread
+void InitBitboards(void);
+
+static inline unsigned int MagicIndex(const Magic *m, Bitboard occupied) {
+#if defined(USE_PEXT)
+    return (unsigned int)_pext_u64(occupied, m->mask);
+#else
+    return (unsigned int)(((occupied & m->mask) * m->magic) >> m->shift);
+#endif
+}
+
+static inline Bitboard RookAttacks(int sq, Bitboard occupied) {
+    const Magic *m = &rookMagics[sq];
+    return m->attacks[MagicIndex(m, occupied)];
+}
+
+static inline Bitboard BishopAttacks(int sq, Bitboard occupied) {
+    const Magic *m = &bishopMagics[sq];
+    return m->attacks[MagicIndex(m, occupied)];
+}
+
+static inline Bitboard QueenAttacks(int sq, Bitboard occupied) {
+    return RookAttacks(sq, occupied) | BishopAttacks(sq, occupied);
+}
+
+#endif
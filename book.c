@@ -0,0 +1,74 @@
+#include "book.h"
+#include "movegen.h"
+#include "random.h"
+
+#include <string.h>
+
+bool LoadBook(Book *book, const char *path) {
+    BookHeader header;
+
+    memset(book, 0, sizeof(*book));
+    if (!MapFile(&book->file, path)) return false;
+
+    if (book->file.size < sizeof(header)) {
+        UnmapFile(&book->file);
+        return false;
+    }
+    memcpy(&header, book->file.data, sizeof(header));
+    if (header.magic != BOOK_MAGIC || header.version != BOOK_VERSION ||
+        header.entryCount != (book->file.size - sizeof(header)) / sizeof(BookEntry)) {
+        UnmapFile(&book->file);
+        return false;
+    }
+
+    book->entries = (const BookEntry *)(book->file.data + sizeof(header));
+    book->count = (size_t)header.entryCount;
+    return true;
+}
+
+void UnloadBook(Book *book) {
+    UnmapFile(&book->file);
+    book->entries = NULL;
+    book->count = 0;
+}
+
+size_t FindBookEntries(const Book *book, uint64_t key, const BookEntry **first) {
+    size_t low = 0, high = book->count;
+
+    // First entry whose key is not below the one searched
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (book->entries[middle].key < key) low = middle + 1;
+        else high = middle;
+    }
+
+    size_t end = low;
+    while (end < book->count && book->entries[end].key == key) end++;
+    *first = book->entries + low;
+    return end - low;
+}
+
+Move PickBookMove(const Book *book, const Position *pos, uint64_t *random) {
+    const BookEntry *entries;
+    size_t count = FindBookEntries(book, pos->key, &entries);
+    uint32_t total = 0;
+    Move moves[MAX_MOVES];
+    uint16_t weights[MAX_MOVES];
+    int playable = 0;
+
+    // A key collision or a damaged book must never produce an illegal move
+    for (size_t i = 0; i < count && playable < MAX_MOVES; i++) {
+        if (entries[i].weight == 0 || !IsMoveLegal(pos, entries[i].move)) continue;
+        moves[playable] = entries[i].move;
+        weights[playable++] = entries[i].weight;
+        total += entries[i].weight;
+    }
+    if (playable == 0) return MOVE_NONE;
+
+    uint32_t pick = (uint32_t)(NextRandom(random) % total);
+    for (int i = 0; i < playable; i++) {
+        if (pick < weights[i]) return moves[i];
+        pick -= weights[i];
+    }
+    return moves[playable - 1];
+}
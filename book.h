@@ -0,0 +1,52 @@
+#ifndef BOOK_H
+#define BOOK_H
+
+#include "position.h"
+#include "platform.h"
+
+// Opening book: entries sorted by position key, memory-mapped and binary
+// searched, so opening a book of any size costs one mapping and a lookup
+// O(log n) page touches. chess_book builds books from game collections.
+//
+// The layout follows Polyglot's 16-byte entries, but keys are this engine's
+// Zobrist keys and moves its 16-bit codes, so Polyglot books are not
+// readable as such.
+
+#define BOOK_MAGIC 0x4B423343u      // "C3BK" read as little endian
+#define BOOK_VERSION 1
+#define BOOK_DEFAULT_FILE "chess.book"
+
+// File layout, little endian: BookHeader (16 bytes), then BookEntry records
+// sorted by key and, within a key, by descending weight
+typedef struct BookHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t entryCount;
+} BookHeader;
+
+typedef struct BookEntry {
+    uint64_t key;
+    Move move;
+    uint16_t weight;                // relative chance of being played, 0 never
+    uint32_t games;                 // games of the source that played it
+} BookEntry;
+
+typedef struct Book {
+    MappedFile file;
+    const BookEntry *entries;
+    size_t count;
+} Book;
+
+// False for a missing file or one that is not a book of this version
+bool LoadBook(Book *book, const char *path);
+void UnloadBook(Book *book);
+
+// The entries of a position, pointing into the mapping; returns how many
+// there are and *first the first, or 0
+size_t FindBookEntries(const Book *book, uint64_t key, const BookEntry **first);
+
+// A legal book move picked at random by weight, MOVE_NONE when the position
+// is not in the book. random is xorshift state owned by the caller.
+Move PickBookMove(const Book *book, const Position *pos, uint64_t *random);
+
+#endif
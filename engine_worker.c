@@ -0,0 +1,152 @@
+#include "engine_worker.h"
+#include "profile.h"
+
+#include <string.h>
+
+// Results the owner must not miss wait for room in the queue; progress reports are dropped instead
+static void PushResult(EngineWorker *worker, const EngineResult *result, bool required) {
+    while (!RingPush(&worker->results, result)) {
+        if (!required || AtomicLoad(&worker->quit)) return;
+        SleepMilliseconds(1);
+    }
+}
+
+static void ReportProgress(const SearchInfo *info, void *userData) {
+    EngineWorker *worker = userData;
+    EngineResult result;
+
+    // Catches an abort that arrived just before the pool cleared its stop flag
+    if (worker->currentId <= AtomicLoad(&worker->abortedId)) {
+        StopPoolSearch(&worker->pool);
+        return;
+    }
+
+    result.type = ENGINE_RESULT_INFO;
+    result.id = worker->currentId;
+    result.key = worker->pool.root.key;
+    result.moves.count = 0;
+    result.info = *info;
+    result.bestMove = info->pvLength > 0 ? info->pv[0] : MOVE_NONE;
+    PushResult(worker, &result, false);
+}
+
+// What each move leads to for the side playing it, as far as the tablebases know
+static void RateMoves(EngineWorker *worker, const Position *pos, const MoveList *moves, signed char *outcomes) {
+    for (int i = 0; i < moves->count; i++) {
+        Position child = *pos;
+        UndoInfo undo;
+        TbResult reply;
+
+        outcomes[i] = TB_UNKNOWN;
+        if (!worker->tablebases.tableCount) continue;
+        MakeMove(&child, moves->moves[i], &undo);
+        if (ProbeTablebase(&worker->tablebases, &child, &reply)) outcomes[i] = (signed char)-reply.wdl;
+    }
+}
+
+static void RunCommand(EngineWorker *worker, const EngineCommand *command, EngineResult *result) {
+    memset(result, 0, sizeof(*result));
+    result->id = command->id;
+    result->key = command->pos.key;
+
+    if (command->type == ENGINE_CMD_MOVES) {
+        result->type = ENGINE_RESULT_MOVES;
+        PROFILE_BEGIN(EngineMoves);
+        GenerateLegalMoves(&command->pos, &result->moves);
+        RateMoves(worker, &command->pos, &result->moves, result->outcomes);
+        PROFILE_END(EngineMoves);
+        PushResult(worker, result, true);
+    } else if (command->type == ENGINE_CMD_SEARCH) {
+        if (command->id <= AtomicLoad(&worker->abortedId)) return;
+
+        // A book move is answered at once, with a one-move line and no search
+        Move bookMove = worker->book.count ? PickBookMove(&worker->book, &command->pos, &worker->random) : MOVE_NONE;
+        if (bookMove != MOVE_NONE) {
+            result->type = ENGINE_RESULT_BESTMOVE;
+            result->bestMove = bookMove;
+            result->info.pv[0] = bookMove;
+            result->info.pvLength = 1;
+            PushResult(worker, result, true);
+            return;
+        }
+
+        worker->currentId = command->id;
+        SetPoolHistory(&worker->pool, command->history, command->historyCount);
+        result->type = ENGINE_RESULT_BESTMOVE;
+        PROFILE_BEGIN(EngineSearch);
+        result->bestMove = PoolSearch(&worker->pool, &command->pos, &command->limits, &result->info);
+        PROFILE_END(EngineSearch);
+        PROFILE_COUNT("SearchNodes", (int64_t)result->info.nodes);
+        if (command->id > AtomicLoad(&worker->abortedId)) PushResult(worker, result, true);
+    }
+}
+
+static void EngineMain(void *arg) {
+    EngineWorker *worker = arg;
+
+    LowerThreadPriority();
+    PROFILE_THREAD("Engine");
+
+    while (!AtomicLoad(&worker->quit)) {
+        if (!RingPop(&worker->commands, &worker->command)) {
+            WaitSignal(worker->wake);
+            continue;
+        }
+        if (worker->command.type == ENGINE_CMD_QUIT) break;
+        RunCommand(worker, &worker->command, &worker->result);
+    }
+}
+
+bool StartEngineWorker(EngineWorker *worker, int threads, size_t hashMb) {
+    memset(worker, 0, sizeof(*worker));
+    InitRing(&worker->commands, worker->commandStorage, sizeof(EngineCommand), ENGINE_COMMAND_CAPACITY);
+    InitRing(&worker->results, worker->resultStorage, sizeof(EngineResult), ENGINE_RESULT_CAPACITY);
+
+    if (threads <= 0) threads = GetProcessorCount() > 1 ? GetProcessorCount() - 1 : 1;
+    if (!TTInit(&worker->tt, hashMb) || !InitSearchPool(&worker->pool, 1, &worker->tt)) return false;
+    worker->pool.lowPriority = true;
+    worker->pool.report = ReportProgress;
+    worker->pool.reportData = worker;
+    if (LoadNetwork(&worker->network, NNUE_DEFAULT_FILE)) SetPoolNetwork(&worker->pool, &worker->network);
+    LoadBook(&worker->book, BOOK_DEFAULT_FILE);
+    if (LoadTablebases(&worker->tablebases, TB_DEFAULT_DIR, TB_DEFAULT_CACHE_MB)) SetPoolTablebases(&worker->pool, &worker->tablebases);
+    worker->random = (uint64_t)GetMicroseconds() | 1;
+    SetPoolThreads(&worker->pool, threads);
+
+    worker->wake = CreateSignal();
+    if (worker->wake) worker->thread = StartThread(EngineMain, worker);
+    return worker->thread != NULL;
+}
+
+void StopEngineWorker(EngineWorker *worker) {
+    if (worker->thread) {
+        AtomicStore(&worker->quit, 1);
+        StopPoolSearch(&worker->pool);
+        SetSignal(worker->wake);
+        JoinThread(worker->thread);
+        worker->thread = NULL;
+    }
+    DestroySignal(worker->wake);
+    worker->wake = NULL;
+    FreeSearchPool(&worker->pool);
+    TTFree(&worker->tt);
+    UnloadNetwork(&worker->network);
+    UnloadBook(&worker->book);
+    UnloadTablebases(&worker->tablebases);
+}
+
+bool PostEngineCommand(EngineWorker *worker, const EngineCommand *command) {
+    // Nobody would take the command without the thread, and the signal may not exist
+    if (!worker->thread || !RingPush(&worker->commands, command)) return false;
+    SetSignal(worker->wake);
+    return true;
+}
+
+bool PollEngineResult(EngineWorker *worker, EngineResult *result) {
+    return RingPop(&worker->results, result);
+}
+
+void AbortEngineSearch(EngineWorker *worker, int id) {
+    if (id > AtomicLoad(&worker->abortedId)) AtomicStore(&worker->abortedId, id);
+    StopPoolSearch(&worker->pool);
+}
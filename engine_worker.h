@@ -0,0 +1,79 @@
+#ifndef ENGINE_WORKER_H
+#define ENGINE_WORKER_H
+
+#include "smp.h"
+#include "ring.h"
+#include "book.h"
+
+#define ENGINE_COMMAND_CAPACITY 16
+#define ENGINE_RESULT_CAPACITY 64
+#define ENGINE_HISTORY_KEYS 128     // enough for the fifty-move window
+
+#define ENGINE_CMD_MOVES 0          // legal moves of a position
+#define ENGINE_CMD_SEARCH 1         // best move within limits, with progress reports
+#define ENGINE_CMD_QUIT 2
+
+#define ENGINE_RESULT_MOVES 0
+#define ENGINE_RESULT_INFO 1
+#define ENGINE_RESULT_BESTMOVE 2
+
+typedef struct EngineCommand {
+    int type;
+    int id;                         // echoed in every result, so stale ones can be ignored
+    Position pos;
+    SearchLimits limits;
+    int historyCount;
+    uint64_t history[ENGINE_HISTORY_KEYS];  // positions before pos, oldest first
+} EngineCommand;
+
+typedef struct EngineResult {
+    int type;
+    int id;
+    uint64_t key;                   // position the result belongs to
+    MoveList moves;                 // ENGINE_RESULT_MOVES
+    signed char outcomes[MAX_MOVES];    // of each move for the mover, TB_UNKNOWN outside the tablebases
+    SearchInfo info;                // ENGINE_RESULT_INFO and ENGINE_RESULT_BESTMOVE
+    Move bestMove;                  // ENGINE_RESULT_BESTMOVE
+} EngineResult;
+
+// Runs move generation and search on a background thread. The owner posts
+// commands and polls results once per frame; neither call ever blocks, so
+// the render loop keeps its frame rate however long the engine thinks.
+typedef struct EngineWorker {
+    SearchPool pool;
+    TranspositionTable tt;
+    Network network;                // mapped from NNUE_DEFAULT_FILE if present, else unused
+    Book book;                      // mapped from BOOK_DEFAULT_FILE if present, else empty
+    Tablebases tablebases;          // tables found in TB_DEFAULT_DIR, possibly none
+    PlatformThread *thread;
+    PlatformSignal *wake;
+    RingQueue commands;             // owner -> worker
+    RingQueue results;              // worker -> owner
+    EngineCommand commandStorage[ENGINE_COMMAND_CAPACITY];
+    EngineResult resultStorage[ENGINE_RESULT_CAPACITY];
+    volatile int abortedId;         // searches up to this id are abandoned
+    volatile int quit;
+
+    // Used by the worker thread only
+    int currentId;                  // search in progress
+    uint64_t random;                // picks among book moves
+    EngineCommand command;
+    EngineResult result;
+} EngineWorker;
+
+// threads <= 0 leaves one processor free for rendering. Evaluates with the
+// network in NNUE_DEFAULT_FILE when there is a valid one, and answers
+// searches of positions in BOOK_DEFAULT_FILE from the book without searching.
+// Tablebases in TB_DEFAULT_DIR are probed by the search and rate legal moves.
+bool StartEngineWorker(EngineWorker *worker, int threads, size_t hashMb);
+void StopEngineWorker(EngineWorker *worker);
+
+// False if the command queue is full, when the caller may retry next frame,
+// or if the worker never started
+bool PostEngineCommand(EngineWorker *worker, const EngineCommand *command);
+bool PollEngineResult(EngineWorker *worker, EngineResult *result);
+
+// Ends the search with this id (and any queued before it) without a best move
+void AbortEngineSearch(EngineWorker *worker, int id);
+
+#endif
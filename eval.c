@@ -0,0 +1,159 @@
+#include "eval.h"
+#include "psqt.h"
+
+#include <string.h>
+
+const int pieceValues[PIECE_TYPE_COUNT] = { 100, 320, 330, 500, 900, 0 };
+
+// Pawn structure, middlegame and endgame
+#define DOUBLED_MG (-10)
+#define DOUBLED_EG (-20)
+#define ISOLATED_MG (-8)
+#define ISOLATED_EG (-12)
+static const int passedMg[8] = { 0, 0, 5, 10, 20, 35, 55, 0 };     // by rank from the pawn's own side
+static const int passedEg[8] = { 0, 10, 15, 25, 45, 75, 120, 0 };
+
+// Mobility per reachable square, relative to a typical count for the piece
+static const int mobilityMg[PIECE_TYPE_COUNT] = { 0, 4, 5, 2, 1, 0 };
+static const int mobilityEg[PIECE_TYPE_COUNT] = { 0, 4, 5, 4, 2, 0 };
+static const int mobilityBase[PIECE_TYPE_COUNT] = { 0, 4, 7, 7, 14, 0 };
+
+// King safety: attack units of the pieces hitting the king zone, turned into a
+// penalty that grows faster than linearly. Middlegame only.
+static const int attackUnits[PIECE_TYPE_COUNT] = { 0, 2, 2, 3, 5, 0 };
+static const int kingDanger[16] = { 0, 0, 5, 12, 22, 35, 52, 72, 95, 122, 152, 185, 220, 258, 298, 340 };
+#define PAWN_SHIELD_MG 12
+
+// Files next to a file, for isolated pawns
+static Bitboard AdjacentFiles(int file) {
+    Bitboard f = FILE_A_BB << file;
+    return ((f << 1) & ~FILE_A_BB) | ((f >> 1) & ~FILE_H_BB);
+}
+
+// Squares in front of a pawn on its own and the adjacent files
+static Bitboard PassedSpan(int side, int sq) {
+    int file = SQUARE_FILE(sq), rank = SQUARE_RANK(sq);
+    Bitboard files = (FILE_A_BB << file) | AdjacentFiles(file);
+
+    // Pawns never stand on the first or last rank, so neither shift reaches 64
+    return files & (side == SIDE_WHITE ? ~0ULL << (8 * (rank + 1)) : ~0ULL >> (8 * (8 - rank)));
+}
+
+static void ScorePawns(const Position *pos, int *mg, int *eg) {
+    *mg = 0;
+    *eg = 0;
+
+    for (int side = SIDE_WHITE; side <= SIDE_BLACK; side++) {
+        Bitboard own = pos->pieces[side][PIECE_PAWN];
+        Bitboard enemy = pos->pieces[side ^ 1][PIECE_PAWN];
+        int sign = side == SIDE_WHITE ? 1 : -1;
+        int sideMg = 0, sideEg = 0;
+
+        for (int file = 0; file < 8; file++) {
+            int count = PopCount(own & (FILE_A_BB << file));
+            if (count > 1) {
+                sideMg += DOUBLED_MG * (count - 1);
+                sideEg += DOUBLED_EG * (count - 1);
+            }
+            if (count && !(own & AdjacentFiles(file))) {
+                sideMg += ISOLATED_MG * count;
+                sideEg += ISOLATED_EG * count;
+            }
+        }
+
+        for (Bitboard b = own; b;) {
+            int sq = PopLsb(&b);
+            if (enemy & PassedSpan(side, sq)) continue;
+
+            int rank = side == SIDE_WHITE ? SQUARE_RANK(sq) : 7 - SQUARE_RANK(sq);
+            sideMg += passedMg[rank];
+            sideEg += passedEg[rank];
+        }
+
+        *mg += sign * sideMg;
+        *eg += sign * sideEg;
+    }
+}
+
+// Without pawns pawnKey is zero, which matches a cleared entry scoring zero
+static void ProbePawns(const Position *pos, PawnTable *table, int *mg, int *eg) {
+    if (!table) {
+        ScorePawns(pos, mg, eg);
+        return;
+    }
+
+    PawnEntry *entry = &table->entries[pos->pawnKey & (PAWN_TABLE_ENTRIES - 1)];
+    table->probes++;
+    if (entry->key == pos->pawnKey) {
+        table->hits++;
+    } else {
+        entry->key = pos->pawnKey;
+        ScorePawns(pos, &entry->mg, &entry->eg);
+    }
+    *mg = entry->mg;
+    *eg = entry->eg;
+}
+
+// Mobility of one side's pieces and the attack units they aim at the enemy king
+static void ScorePieces(const Position *pos, int side, int *mg, int *eg) {
+    const Bitboard *own = pos->pieces[side];
+    Bitboard occupied = pos->occupancy[SIDE_BOTH];
+    Bitboard enemyPawns = pos->pieces[side ^ 1][PIECE_PAWN];
+    Bitboard pawnGuarded = side == SIDE_WHITE
+        ? ((enemyPawns & ~FILE_A_BB) >> 9) | ((enemyPawns & ~FILE_H_BB) >> 7)
+        : ((enemyPawns & ~FILE_A_BB) << 7) | ((enemyPawns & ~FILE_H_BB) << 9);
+    Bitboard area = ~pos->occupancy[side] & ~pawnGuarded;
+    int enemyKing = KingSquare(pos, side ^ 1);
+    Bitboard kingZone = kingAttacks[enemyKing] | BB(enemyKing);
+    int units = 0, attackers = 0;
+
+    *mg = 0;
+    *eg = 0;
+    for (int type = PIECE_KNIGHT; type <= PIECE_QUEEN; type++) {
+        for (Bitboard b = own[type]; b;) {
+            int sq = PopLsb(&b);
+            Bitboard attacks = type == PIECE_KNIGHT ? knightAttacks[sq]
+                             : type == PIECE_BISHOP ? BishopAttacks(sq, occupied)
+                             : type == PIECE_ROOK ? RookAttacks(sq, occupied)
+                             : QueenAttacks(sq, occupied);
+            int moves = PopCount(attacks & area) - mobilityBase[type];
+
+            *mg += mobilityMg[type] * moves;
+            *eg += mobilityEg[type] * moves;
+            if (attacks & kingZone) {
+                units += attackUnits[type] * PopCount(attacks & kingZone);
+                attackers++;
+            }
+        }
+    }
+
+    // A lone attacker is rarely dangerous
+    if (attackers >= 2) *mg += kingDanger[units < 16 ? units : 15];
+
+    // Own pawns on the three files in front of the king, one or two ranks ahead
+    int king = KingSquare(pos, side);
+    Bitboard row = (kingAttacks[king] & (RANK_1_BB << (8 * SQUARE_RANK(king)))) | BB(king);
+    Bitboard front = side == SIDE_WHITE ? (row << 8) | (row << 16) : (row >> 8) | (row >> 16);
+    *mg += PAWN_SHIELD_MG * PopCount(front & own[PIECE_PAWN]);
+}
+
+void ClearPawnTable(PawnTable *table) {
+    memset(table, 0, sizeof(*table));
+}
+
+int Evaluate(const Position *pos, PawnTable *pawns) {
+    int mg = pos->psqMg, eg = pos->psqEg;
+    int pawnMg, pawnEg, whiteMg, whiteEg, blackMg, blackEg;
+
+    ProbePawns(pos, pawns, &pawnMg, &pawnEg);
+    ScorePieces(pos, SIDE_WHITE, &whiteMg, &whiteEg);
+    ScorePieces(pos, SIDE_BLACK, &blackMg, &blackEg);
+    mg += pawnMg + whiteMg - blackMg;
+    eg += pawnEg + whiteEg - blackEg;
+
+    // Blend by phase: all middlegame with every piece on, all endgame with none
+    int phase = pos->phase < PHASE_MAX ? pos->phase : PHASE_MAX;
+    int score = (mg * phase + eg * (PHASE_MAX - phase)) / PHASE_MAX;
+
+    return pos->sideToMove == SIDE_WHITE ? score : -score;
+}
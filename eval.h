@@ -0,0 +1,31 @@
+#ifndef EVAL_H
+#define EVAL_H
+
+#include "position.h"
+
+#define PAWN_TABLE_ENTRIES 16384    // power of two, 256 KB
+
+extern const int pieceValues[PIECE_TYPE_COUNT];
+
+// Pawn structure score of one pawn configuration, keyed on pawnKey
+typedef struct PawnEntry {
+    uint64_t key;
+    int mg, eg;                     // white's point of view
+} PawnEntry;
+
+// Pawn structure changes in few moves of a search, so its score is cached.
+// One table per searching thread; no locking.
+typedef struct PawnTable {
+    PawnEntry entries[PAWN_TABLE_ENTRIES];
+    uint64_t probes, hits;
+} PawnTable;
+
+void ClearPawnTable(PawnTable *table);
+
+// Static score in centipawns from the side to move's point of view: material
+// and piece-square terms from the position's running sums, pawn structure,
+// mobility and king safety, blended between middlegame and endgame by phase.
+// pawns may be NULL to score the pawn structure without a cache.
+int Evaluate(const Position *pos, PawnTable *pawns);
+
+#endif
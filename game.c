@@ -0,0 +1,153 @@
+#include "game.h"
+#include "profile.h"
+
+#include <string.h>
+
+void InitGame(Game *game) {
+    memset(game, 0, sizeof(*game));
+    PositionFromFen(&game->pos, START_FEN);
+    PositionToBoard(&game->pos, game->board);
+    game->selectedRow = -1;
+    game->selectedCol = -1;
+}
+
+void PlayGameMove(Game *game, Move move) {
+    // Keep the most recent moves for take-back if the history is full
+    if (game->ply == MAX_GAME_PLY) {
+        memmove(game->history, game->history + 1, sizeof(game->history) - sizeof(game->history[0]));
+        memmove(game->moves, game->moves + 1, sizeof(game->moves) - sizeof(game->moves[0]));
+        game->ply--;
+    }
+
+    // Apply the move to the game position, which also updates castling rights and en passant
+    MakeMove(&game->pos, move, &game->history[game->ply]);
+    game->moves[game->ply++] = move;
+
+    PositionToBoard(&game->pos, game->board);
+    game->movesReady = false;
+}
+
+bool TakeBackGameMove(Game *game) {
+    if (game->ply == 0) return false;
+
+    game->ply--;
+    UnmakeMove(&game->pos, game->moves[game->ply], &game->history[game->ply]);
+    PositionToBoard(&game->pos, game->board);
+
+    game->pieceSelected = false;
+    ClearLegalMoves(game);
+    ClearTweens(&game->tweens);
+    game->movesReady = false;
+    return true;
+}
+
+void GetGameStart(const Game *game, Position *start) {
+    *start = game->pos;
+    for (int i = game->ply - 1; i >= 0; i--) UnmakeMove(start, game->moves[i], &game->history[i]);
+}
+
+int LoadGameMoves(Game *game, const Position *start, const Move *moves, int count) {
+    int played = 0;
+
+    InitGame(game);
+    game->pos = *start;
+    PositionToBoard(&game->pos, game->board);
+    while (played < count && IsMoveLegal(&game->pos, moves[played])) PlayGameMove(game, moves[played++]);
+    return played;
+}
+
+int CountGameRepetitions(const Game *game) {
+    int count = 0;
+    for (int i = game->ply - 2; i >= 0 && i >= game->ply - game->pos.halfmoveClock; i -= 2) {
+        if (game->history[i].key == game->pos.key) count++;
+    }
+    return count;
+}
+
+const char *GetGameStatus(const Game *game) {
+    const Position *pos = &game->pos;
+
+    if (!game->movesReady) return NULL;
+
+    if (game->legalMoveList.count == 0) {
+        return InCheck(pos) ? (pos->sideToMove == SIDE_WHITE ? "Checkmate - Black wins" : "Checkmate - White wins")
+                            : "Stalemate";
+    }
+    if (pos->halfmoveClock >= 100) return "Draw by fifty-move rule";
+    if (CountGameRepetitions(game) >= 2) return "Draw by threefold repetition";
+    if (InCheck(pos)) return "Check";
+    return NULL;
+}
+
+void ClearLegalMoves(Game *game) {
+    memset(game->legalMoves, 0, sizeof(game->legalMoves));
+    game->selectedMoves.count = 0;
+}
+
+void HighlightLegalMoves(Game *game, int row, int col) {
+    ClearLegalMoves(game);
+
+    // Until the legal moves are known, the owner calls this again
+    if (!game->movesReady) return;
+
+    // Keep only the moves of the selected piece
+    PROFILE_BEGIN(HighlightLegalMoves);
+    int from = SQUARE_FROM_ROWCOL(row, col);
+    for (int i = 0; i < game->legalMoveList.count; i++) {
+        Move move = game->legalMoveList.moves[i];
+        if (MOVE_FROM(move) == from) {
+            int to = MOVE_TO(move);
+            game->legalMoves[SQUARE_ROW(to)][SQUARE_COL(to)] = true;
+            game->targetOutcomes[SQUARE_ROW(to)][SQUARE_COL(to)] = game->moveOutcomes[i];
+            game->selectedMoves.moves[game->selectedMoves.count++] = move;
+        }
+    }
+    PROFILE_END(HighlightLegalMoves);
+}
+
+Move FindSelectedMove(const Game *game, int toRow, int toCol) {
+    // Promotions are listed queen first, so the first match auto-queens
+    int to = SQUARE_FROM_ROWCOL(toRow, toCol);
+    for (int i = 0; i < game->selectedMoves.count; i++) {
+        if (MOVE_TO(game->selectedMoves.moves[i]) == to) return game->selectedMoves.moves[i];
+    }
+    return MOVE_NONE;
+}
+
+// Board-local center of a square, as tweens use
+static Vector3 SquareCenter(int sq) {
+    return (Vector3){ (float)SQUARE_COL(sq), 0.0f, (float)SQUARE_ROW(sq) };
+}
+
+// Where the piece on sq is drawn right now, taking over its tween if it has one
+static Vector3 CurrentPosition(Game *game, int sq) {
+    Vector3 position = SquareCenter(sq);
+
+    TakeTween(&game->tweens, BoardIndex(sq), &position);
+    return position;
+}
+
+void StartMoveTweens(Game *game, Move move, float duration) {
+    const Position *pos = &game->pos;
+    int from = MOVE_FROM(move);
+    int to = MOVE_TO(move);
+    int flags = MOVE_FLAGS(move);
+
+    // The captured pawn of an en passant capture is beside the mover, not on the target
+    if (MOVE_IS_CAPTURE(move)) {
+        int captured = flags == MOVE_EP_CAPTURE ? SQUARE_FROM_ROWCOL(SQUARE_ROW(from), SQUARE_COL(to)) : to;
+        Vector3 position = CurrentPosition(game, captured);
+        StartTween(&game->tweens, PieceOn(pos, captured), -1, position, position, duration, TWEEN_EVENT_NONE);
+    }
+
+    // A promoting pawn flies as a pawn and turns into its new piece on landing
+    StartTween(&game->tweens, PieceOn(pos, from), BoardIndex(to), CurrentPosition(game, from), SquareCenter(to), duration,
+               MOVE_IS_CASTLE(move) ? TWEEN_EVENT_CASTLE : TWEEN_EVENT_MOVE);
+
+    if (MOVE_IS_CASTLE(move)) {
+        int rookFrom = flags == MOVE_KING_CASTLE ? to + 1 : to - 2;
+        int rookTo = flags == MOVE_KING_CASTLE ? to - 1 : to + 1;
+        StartTween(&game->tweens, PieceOn(pos, rookFrom), BoardIndex(rookTo), CurrentPosition(game, rookFrom),
+                   SquareCenter(rookTo), duration, TWEEN_EVENT_NONE);
+    }
+}
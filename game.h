@@ -0,0 +1,78 @@
+#ifndef GAME_H
+#define GAME_H
+
+#include "raylib.h"
+#include "movegen.h"
+#include "anim.h"
+
+#define BOARD_SIZE 8
+#define MAX_GAME_PLY 1024
+#define MOVE_ANIMATION_SECONDS 0.3f
+
+// Everything one game on screen needs: the rules position with its history,
+// the board the UI draws, the selection and the pieces in motion. The
+// interactive game is one of these, and every board of the grid view is another.
+typedef struct Game {
+    // The position is the source of truth for the rules; board mirrors it for drawing
+    Position pos;
+    UndoInfo history[MAX_GAME_PLY];
+    Move moves[MAX_GAME_PLY];
+    int ply;
+    char board[BOARD_SIZE][BOARD_SIZE];
+
+    // Legal moves of pos, valid once movesReady is set
+    MoveList legalMoveList;
+    signed char moveOutcomes[MAX_MOVES];        // tablebase outcome of each for the mover, TB_* values
+    bool movesReady;
+
+    bool pieceSelected;
+    int selectedRow, selectedCol;
+    bool legalMoves[BOARD_SIZE][BOARD_SIZE];    // targets of the selected piece
+    MoveList selectedMoves;                     // legal moves of the selected piece
+    signed char targetOutcomes[BOARD_SIZE][BOARD_SIZE]; // moveOutcomes of those by target
+
+    // Moves are played at once; tweens only change where pieces are drawn
+    TweenPool tweens;
+} Game;
+
+// Standard starting position, no history, nothing selected
+void InitGame(Game *game);
+
+// Plays a legal move and keeps the most recent moves for take-back when the
+// history is full. The legal move list is stale afterwards.
+void PlayGameMove(Game *game, Move move);
+
+// False if there is nothing to take back. Running tweens are dropped.
+bool TakeBackGameMove(Game *game);
+
+// The position the kept history starts from: the start position, or a later
+// one once the oldest moves were dropped
+void GetGameStart(const Game *game, Position *start);
+
+// Replaces the game with start followed by moves, stopping at the first
+// illegal one. Returns how many moves were played.
+int LoadGameMoves(Game *game, const Position *start, const Move *moves, int count);
+
+// Earlier occurrences of the current position since the last capture or pawn move
+int CountGameRepetitions(const Game *game);
+
+// Checkmate, stalemate, draw or check text, NULL while the game simply goes on
+// or the legal moves are not known yet
+const char *GetGameStatus(const Game *game);
+
+void ClearLegalMoves(Game *game);
+void HighlightLegalMoves(Game *game, int row, int col);
+Move FindSelectedMove(const Game *game, int toRow, int toCol);
+
+// Tweens for a move about to be played: the moving piece, the rook when
+// castling, and a captured piece that stays until the mover lands. Call it
+// right before PlayGameMove. A piece still in flight continues from where it is,
+// so moves can follow each other faster than they animate.
+void StartMoveTweens(Game *game, Move move, float duration);
+
+// Row * 8 + col of a square, the index tweens and the UI board use
+static inline int BoardIndex(int sq) {
+    return SQUARE_ROW(sq) * BOARD_SIZE + SQUARE_COL(sq);
+}
+
+#endif
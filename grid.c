@@ -0,0 +1,200 @@
+#include "grid.h"
+#include "random.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define GRID_GAP_SQUARES 2          // empty squares between neighboring boards
+#define GRID_BOARD_HEIGHT 3.0f      // above the tallest piece, for the culling box
+#define GRID_MAX_PLY 400            // longer random games are restarted
+#define GRID_MOVE_INTERVAL 1.0      // seconds between the moves of one game, on average
+#define GRID_RESTART_DELAY 3.0      // seconds a finished game stays on screen
+
+// Uniform in [0.5, 1.5) times the interval. Each board has its own random
+// stream, so the games do not move in lockstep.
+static double NextMoveDelay(GridBoard *board) {
+    return GRID_MOVE_INTERVAL * (0.5 + (NextRandom(&board->random) >> 11) * (1.0 / 9007199254740992.0));
+}
+
+// Places the pieces whose square changed since the last call. Comparing 64
+// bytes is cheaper than working out which squares castling, en passant or a
+// promotion touched, and it cannot miss one.
+static void PlaceChangedPieces(const GridView *view, GridBoard *board) {
+    for (int row = 0; row < BOARD_SIZE; row++) {
+        for (int col = 0; col < BOARD_SIZE; col++) {
+            int index = row * BOARD_SIZE + col;
+            int piece = PieceOn(&board->game.pos, SQUARE_FROM_ROWCOL(row, col));
+            if (board->pieces[index] == piece) continue;
+
+            board->pieces[index] = (unsigned char)piece;
+            if (piece != NO_PIECE) {
+                Vector3 position = { board->origin.x + col * view->squareSize, board->origin.y, board->origin.z + row * view->squareSize };
+                board->transforms[index] = PieceTransform(piece, position);
+            }
+        }
+    }
+}
+
+static void StartGridGame(const GridView *view, GridBoard *board, double now) {
+    InitGame(&board->game);
+    GenerateLegalMoves(&board->game.pos, &board->game.legalMoveList);
+    board->game.movesReady = true;
+    board->finished = false;
+    board->nextMoveTime = now + NextMoveDelay(board);
+    PlaceChangedPieces(view, board);
+}
+
+static void PlayRandomMove(const GridView *view, GridBoard *board, double now) {
+    Game *game = &board->game;
+    Move move = game->legalMoveList.moves[NextRandom(&board->random) % game->legalMoveList.count];
+
+    StartMoveTweens(game, move, MOVE_ANIMATION_SECONDS);
+    PlayGameMove(game, move);
+    GenerateLegalMoves(&game->pos, &game->legalMoveList);
+    game->movesReady = true;
+    PlaceChangedPieces(view, board);
+
+    // GetGameStatus also reports plain check, which does not end the game
+    bool over = game->legalMoveList.count == 0 || game->pos.halfmoveClock >= 100
+        || CountGameRepetitions(game) >= 2 || game->ply >= GRID_MAX_PLY;
+    board->finished = over;
+    board->nextMoveTime = now + (over ? GRID_RESTART_DELAY : NextMoveDelay(board));
+}
+
+bool InitGridView(GridView *view, int boardCount, float squareSize) {
+    memset(view, 0, sizeof(*view));
+    if (boardCount < 1) boardCount = 1;
+    if (boardCount > GRID_MAX_BOARDS) boardCount = GRID_MAX_BOARDS;
+
+    view->boards = calloc(boardCount, sizeof(GridBoard));
+    if (!view->boards) return false;
+    view->boardCount = boardCount;
+    view->columns = (int)ceilf(sqrtf((float)boardCount));
+    view->squareSize = squareSize;
+
+    float spacing = (BOARD_SIZE + GRID_GAP_SQUARES) * squareSize;
+    for (int i = 0; i < boardCount; i++) {
+        GridBoard *board = &view->boards[i];
+        float half = squareSize / 2.0f;
+
+        board->origin = (Vector3){ (i % view->columns) * spacing, 0.0f, (i / view->columns) * spacing };
+        board->bounds.min = (Vector3){ board->origin.x - half, -0.05f, board->origin.z - half };
+        board->bounds.max = (Vector3){ board->origin.x + BOARD_SIZE * squareSize - half, GRID_BOARD_HEIGHT,
+                                       board->origin.z + BOARD_SIZE * squareSize - half };
+        board->random = 0x9E3779B97F4A7C15ULL * (uint64_t)(i + 1);
+        memset(board->pieces, NO_PIECE, sizeof(board->pieces));
+        StartGridGame(view, board, 0.0);
+    }
+    return true;
+}
+
+void UnloadGridView(GridView *view) {
+    free(view->boards);
+    memset(view, 0, sizeof(*view));
+}
+
+void UpdateGridView(GridView *view, float dt) {
+    int scanned = 0;
+
+    view->clock += dt;
+    view->movesApplied = 0;
+
+    // Tweens run on every board, not only the ones in the update budget
+    for (int i = 0; i < view->boardCount; i++) {
+        if (view->boards[i].game.tweens.count > 0) UpdateTweens(&view->boards[i].game.tweens, dt);
+    }
+
+    for (; scanned < view->boardCount && view->movesApplied < GRID_MOVES_PER_FRAME; scanned++) {
+        GridBoard *board = &view->boards[(view->nextBoard + scanned) % view->boardCount];
+        if (board->nextMoveTime > view->clock) continue;
+
+        if (board->finished) StartGridGame(view, board, view->clock);
+        else PlayRandomMove(view, board, view->clock);
+        view->movesApplied++;
+    }
+
+    view->nextBoard = (view->nextBoard + scanned) % view->boardCount;
+    view->totalMoves += view->movesApplied;
+}
+
+void QueueGridView(GridView *view, BoardRenderer *renderer, Camera camera) {
+    Frustum frustum = GetCameraFrustum(camera, (float)GetScreenWidth() / (float)GetScreenHeight());
+
+    ClearRenderQueue(renderer, camera);
+    view->visibleBoards = 0;
+
+    for (int i = 0; i < view->boardCount; i++) {
+        GridBoard *board = &view->boards[i];
+        if (!BoxInFrustum(&frustum, board->bounds)) continue;
+
+        view->visibleBoards++;
+        AddPlainBoard(renderer, board->origin);
+        for (int square = 0; square < 64; square++) {
+            int piece = board->pieces[square];
+            if (piece == NO_PIECE || IsSquareTweened(&board->game.tweens, square)) continue;
+
+            Vector3 position = {
+                board->origin.x + (square % BOARD_SIZE) * view->squareSize,
+                board->origin.y,
+                board->origin.z + (square / BOARD_SIZE) * view->squareSize
+            };
+            AddPieceInstance(renderer, piece, board->transforms[square], position);
+        }
+
+        // Pieces in motion are rare enough to place every frame
+        for (int t = 0; t < board->game.tweens.count; t++) {
+            const Tween *tween = &board->game.tweens.tweens[t];
+            Vector3 local = TweenPosition(tween);
+            Vector3 position = {
+                board->origin.x + local.x * view->squareSize,
+                board->origin.y + local.y * view->squareSize,
+                board->origin.z + local.z * view->squareSize
+            };
+            AddPieceInstance(renderer, tween->piece, PieceTransform(tween->piece, position), position);
+        }
+    }
+}
+
+void GetGridLayout(const GridView *view, BoardLayout *layout) {
+    layout->origin = (Vector3){ 0.0f, 0.0f, 0.0f };
+    layout->squareSize = view->squareSize;
+    layout->columns = view->columns;
+    layout->boardCount = view->boardCount;
+    layout->gapSquares = GRID_GAP_SQUARES;
+}
+
+Camera GridOverviewCamera(const GridView *view, float aspect) {
+    int rows = (view->boardCount + view->columns - 1) / view->columns;
+    float spacing = (BOARD_SIZE + GRID_GAP_SQUARES) * view->squareSize;
+    float width = view->columns * spacing;
+    float depth = rows * spacing;
+    float tanHalf = tanf(45.0f * 0.5f * DEG2RAD);
+    Camera camera = { 0 };
+
+    // High enough that the whole grid fits both ways, with a little margin
+    float height = 1.1f * fmaxf(depth / 2.0f / tanHalf, width / 2.0f / (tanHalf * aspect));
+    float half = view->squareSize / 2.0f;
+
+    camera.target = (Vector3){ width / 2.0f - half - GRID_GAP_SQUARES * view->squareSize / 2.0f, 0.0f,
+                               depth / 2.0f - half - GRID_GAP_SQUARES * view->squareSize / 2.0f };
+    camera.up = (Vector3){ 0.0f, 0.0f, -1.0f };
+    camera.fovy = 45.0f;
+    camera.projection = CAMERA_PERSPECTIVE;
+
+    // The tilt shrinks the far rows, so back off until every board is in view
+    for (int attempt = 0; attempt < 20; attempt++) {
+        camera.position = (Vector3){ camera.target.x, height, camera.target.z + height / 3.0f };
+
+        Frustum frustum = GetCameraFrustum(camera, aspect);
+        bool allVisible = true;
+        for (int i = 0; i < view->boardCount && allVisible; i++) {
+            BoundingBox bounds = view->boards[i].bounds;
+            allVisible = BoxInFrustum(&frustum, (BoundingBox){ bounds.min, bounds.min })
+                && BoxInFrustum(&frustum, (BoundingBox){ bounds.max, bounds.max });
+        }
+        if (allVisible) break;
+        height *= 1.1f;
+    }
+    return camera;
+}
@@ -0,0 +1,58 @@
+#ifndef GRID_H
+#define GRID_H
+
+#include "game.h"
+#include "render.h"
+#include "picking.h"
+
+#define GRID_DEFAULT_BOARDS 100
+#define GRID_MAX_BOARDS 1024
+#define GRID_MOVES_PER_FRAME 16     // update budget, the rest wait for the next frame
+
+// One spectated board. The piece placement is cached per square and only the
+// squares a move changed are placed again, so a frame with no moves does no
+// per-piece math beyond culling and level of detail.
+typedef struct GridBoard {
+    Game game;
+    Vector3 origin;                 // center of the a8 square
+    BoundingBox bounds;             // board and the tallest piece, for culling
+    unsigned char pieces[64];       // by row * 8 + col, as last placed
+    Matrix transforms[64];          // PieceTransform of the piece on each square
+    double nextMoveTime;            // grid clock time of the next move
+    bool finished;                  // restarts at nextMoveTime
+    uint64_t random;                // xorshift state picking the moves
+} GridBoard;
+
+// Many games at once for watching tournaments. Moves come from a stand-in
+// feed that plays random legal moves; UpdateGridView applies what is due
+// within the per-frame budget, round robin so no board starves.
+typedef struct GridView {
+    GridBoard *boards;
+    int boardCount;
+    int columns;
+    float squareSize;
+    double clock;                   // seconds since the grid started
+    int nextBoard;                  // where the next update pass starts
+
+    // Statistics of the last update and queue
+    int movesApplied;
+    int visibleBoards;
+    int64_t totalMoves;
+} GridView;
+
+bool InitGridView(GridView *view, int boardCount, float squareSize);
+void UnloadGridView(GridView *view);
+
+// Advances the grid clock by dt seconds and plays the moves that are due
+void UpdateGridView(GridView *view, float dt);
+
+// Clears the render queue and fills it with the boards inside the camera's view
+void QueueGridView(GridView *view, BoardRenderer *renderer, Camera camera);
+
+// Where the boards lie, for PickSquare with the boards' games
+void GetGridLayout(const GridView *view, BoardLayout *layout);
+
+// Looks down at the whole grid, tilted like the game's camera
+Camera GridOverviewCamera(const GridView *view, float aspect);
+
+#endif
@@ -0,0 +1,162 @@
+#include "lod.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define EMPTY_SLOT 0xFFFFFFFFu
+
+typedef struct Cluster {
+    float position[3];
+    float normal[3];
+    int count;
+    int first;              // source vertex whose texcoords and color the cluster keeps
+} Cluster;
+
+static unsigned int SourceIndex(const Mesh *mesh, int i) {
+    return mesh->indices ? mesh->indices[i] : (unsigned int)i;
+}
+
+static void MeshBounds(const Mesh *mesh, float min[3], float max[3]) {
+    for (int axis = 0; axis < 3; axis++) {
+        min[axis] = mesh->vertices[axis];
+        max[axis] = mesh->vertices[axis];
+    }
+    for (int v = 1; v < mesh->vertexCount; v++) {
+        for (int axis = 0; axis < 3; axis++) {
+            float value = mesh->vertices[v * 3 + axis];
+            if (value < min[axis]) min[axis] = value;
+            if (value > max[axis]) max[axis] = value;
+        }
+    }
+}
+
+float MeshExtent(const Mesh *mesh) {
+    float min[3], max[3], extent = 0.0f;
+
+    if (mesh->vertexCount == 0) return 0.0f;
+    MeshBounds(mesh, min, max);
+    for (int axis = 0; axis < 3; axis++) {
+        if (max[axis] - min[axis] > extent) extent = max[axis] - min[axis];
+    }
+    return extent;
+}
+
+uint64_t MeshDataSize(const Mesh *mesh) {
+    uint64_t perVertex = 3 * sizeof(float);
+
+    if (mesh->normals) perVertex += 3 * sizeof(float);
+    if (mesh->texcoords) perVertex += 2 * sizeof(float);
+    if (mesh->texcoords2) perVertex += 2 * sizeof(float);
+    if (mesh->tangents) perVertex += 4 * sizeof(float);
+    if (mesh->colors) perVertex += 4;
+
+    uint64_t size = perVertex * mesh->vertexCount;
+    if (mesh->indices) size += (uint64_t)mesh->triangleCount * 3 * sizeof(unsigned short);
+    return size;
+}
+
+Mesh SimplifyMesh(const Mesh *mesh, int cells) {
+    Mesh result = { 0 };
+    int vertexCount = mesh->vertexCount;
+    float min[3], max[3];
+
+    if (vertexCount == 0 || cells < 2 || cells > 1024) return result;
+    MeshBounds(mesh, min, max);
+
+    float extent = MeshExtent(mesh);
+    float cellSize = extent > 0.0f ? extent / cells : 1.0f;
+
+    // Open addressing from cell key to cluster, at most half full
+    unsigned int slotCount = 1;
+    while (slotCount < 2u * (unsigned int)vertexCount) slotCount <<= 1;
+
+    uint32_t *slotKeys = malloc(sizeof(uint32_t) * slotCount);
+    int *slotClusters = malloc(sizeof(int) * slotCount);
+    Cluster *clusters = calloc(vertexCount, sizeof(Cluster));
+    int *remap = malloc(sizeof(int) * vertexCount);
+    unsigned short *indices = malloc(sizeof(unsigned short) * 3 * (mesh->triangleCount > 0 ? mesh->triangleCount : 1));
+    int clusterCount = 0, triangleCount = 0;
+
+    if (!slotKeys || !slotClusters || !clusters || !remap || !indices) {
+        free(slotKeys);
+        free(slotClusters);
+        free(clusters);
+        free(remap);
+        free(indices);
+        return result;
+    }
+    memset(slotKeys, 0xFF, sizeof(uint32_t) * slotCount);
+
+    for (int v = 0; v < vertexCount; v++) {
+        const float *p = &mesh->vertices[v * 3];
+        uint32_t key = 0;
+
+        for (int axis = 2; axis >= 0; axis--) {
+            int cell = (int)((p[axis] - min[axis]) / cellSize);
+            if (cell >= cells) cell = cells - 1;
+            key = key * (uint32_t)cells + (uint32_t)cell;
+        }
+
+        unsigned int slot = (key * 2654435761u) & (slotCount - 1);
+        while (slotKeys[slot] != EMPTY_SLOT && slotKeys[slot] != key) slot = (slot + 1) & (slotCount - 1);
+        if (slotKeys[slot] == EMPTY_SLOT) {
+            slotKeys[slot] = key;
+            slotClusters[slot] = clusterCount;
+            clusters[clusterCount++].first = v;
+        }
+
+        Cluster *cluster = &clusters[slotClusters[slot]];
+        for (int axis = 0; axis < 3; axis++) {
+            cluster->position[axis] += p[axis];
+            if (mesh->normals) cluster->normal[axis] += mesh->normals[v * 3 + axis];
+        }
+        cluster->count++;
+        remap[v] = slotClusters[slot];
+    }
+
+    for (int t = 0; t < mesh->triangleCount; t++) {
+        int a = remap[SourceIndex(mesh, t * 3 + 0)];
+        int b = remap[SourceIndex(mesh, t * 3 + 1)];
+        int c = remap[SourceIndex(mesh, t * 3 + 2)];
+        if (a == b || b == c || a == c) continue;
+        indices[triangleCount * 3 + 0] = (unsigned short)a;
+        indices[triangleCount * 3 + 1] = (unsigned short)b;
+        indices[triangleCount * 3 + 2] = (unsigned short)c;
+        triangleCount++;
+    }
+
+    if (triangleCount > 0 && clusterCount <= 65535) {
+        result.vertexCount = clusterCount;
+        result.triangleCount = triangleCount;
+        result.vertices = MemAlloc(sizeof(float) * 3 * clusterCount);
+        result.indices = MemAlloc(sizeof(unsigned short) * 3 * triangleCount);
+        memcpy(result.indices, indices, sizeof(unsigned short) * 3 * triangleCount);
+        if (mesh->normals) result.normals = MemAlloc(sizeof(float) * 3 * clusterCount);
+        if (mesh->texcoords) result.texcoords = MemAlloc(sizeof(float) * 2 * clusterCount);
+        if (mesh->colors) result.colors = MemAlloc(4 * clusterCount);
+
+        for (int i = 0; i < clusterCount; i++) {
+            const Cluster *cluster = &clusters[i];
+            for (int axis = 0; axis < 3; axis++) result.vertices[i * 3 + axis] = cluster->position[axis] / cluster->count;
+
+            if (result.normals) {
+                const float *n = cluster->normal;
+                float length = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+                for (int axis = 0; axis < 3; axis++) {
+                    result.normals[i * 3 + axis] = length > 0.0f ? n[axis] / length : (axis == 1 ? 1.0f : 0.0f);
+                }
+            }
+            // Averaging across a texture seam would smear it, so keep one vertex's coordinates
+            if (result.texcoords) memcpy(&result.texcoords[i * 2], &mesh->texcoords[cluster->first * 2], sizeof(float) * 2);
+            if (result.colors) memcpy(&result.colors[i * 4], &mesh->colors[cluster->first * 4], 4);
+        }
+    }
+
+    free(slotKeys);
+    free(slotClusters);
+    free(clusters);
+    free(remap);
+    free(indices);
+    return result;
+}
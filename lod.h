@@ -0,0 +1,21 @@
+#ifndef LOD_H
+#define LOD_H
+
+#include "raylib.h"
+
+#include <stdint.h>
+
+// Simplifies a mesh by vertex clustering. Vertices snap to a grid of `cells`
+// cells along the longest side of the bounding box, all vertices in one cell
+// merge into their average, and triangles that collapse are dropped. The
+// error is at most one cell, so a level is fine wherever a cell projects to
+// about a pixel. The result has CPU arrays only and is zeroed if nothing is left.
+Mesh SimplifyMesh(const Mesh *mesh, int cells);
+
+// Longest side of the mesh's bounding box
+float MeshExtent(const Mesh *mesh);
+
+// Bytes of vertex and index data, the same on the CPU and once uploaded
+uint64_t MeshDataSize(const Mesh *mesh);
+
+#endif
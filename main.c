@@ -1,66 +1,166 @@
 #include "raylib.h"
+#include "raymath.h"
+#include "engine_worker.h"
+#include "render.h"
+#include "assets.h"
+#include "game.h"
+#include "grid.h"
+#include "packed.h"
+#include "picking.h"
+#include "profile.h"
+#include <math.h>
 #include <stdio.h>
-
-#define BOARD_SIZE 8
-#define ANIMATION_STEPS 30
-
-// Global variables for board and selected piece
-char board[BOARD_SIZE][BOARD_SIZE] = {
-    {'r', 'n', 'b', 'q', 'k', 'b', 'n', 'r'},  // black pieces
-    {'p', 'p', 'p', 'p', 'p', 'p', 'p', 'p'},  // black pawns
-    {'.', '.', '.', '.', '.', '.', '.', '.'},  // empty squares
-    {'.', '.', '.', '.', '.', '.', '.', '.'},
-    {'.', '.', '.', '.', '.', '.', '.', '.'},
-    {'.', '.', '.', '.', '.', '.', '.', '.'},
-    {'P', 'P', 'P', 'P', 'P', 'P', 'P', 'P'},  // white pawns
-    {'R', 'N', 'B', 'Q', 'K', 'B', 'N', 'R'}   // white pieces
-};
-
-bool pieceSelected = false;
-int selectedRow = -1, selectedCol = -1;
-bool legalMoves[BOARD_SIZE][BOARD_SIZE] = { false };
-bool whiteKingMoved = false;
-bool blackKingMoved = false;
-bool whiteRookMoved[2] = { false, false };
-bool blackRookMoved[2] = { false, false };
-bool attackedSquares[BOARD_SIZE][BOARD_SIZE] = { false };
-
-bool isAnimating = false;
-int animationStep = 0;
-int startRow, startCol;
-int endRow, endCol;
-Vector3 currentPosition;
-
-// Chess piece models
-Model whitePawn, whiteRook, whiteKnight, whiteBishop, whiteQueen, whiteKing;
-Model blackPawn, blackRook, blackKnight, blackBishop, blackQueen, blackKing;
-
-Texture2D whiteTexture;
+#include <stdlib.h>
+#include <string.h>
+
+#define ENGINE_MOVE_TIME_MS 1000
+// Music alone only needs UpdateMusicStream before raylib's half-buffer (2048 frames, ~46 ms) drains
+#define MUSIC_IDLE_WAIT_MS 30
+#define BENCHMARK_DEFAULT_FRAMES 2000
+#define BENCHMARK_WARMUP_FRAMES 120
+
+// The interactive game: position, board, selection and animation
+Game game;
+
+// Computer opponent, toggled with E; -1 when nobody is played by the engine.
+// Move generation and search run on the engine thread; the frame loop only
+// posts commands and polls for results.
+EngineWorker engine;
+int engineSide = -1;
+int engineRequestId = 0;
+int engineSearchId = 0;         // id of the search whose move we are waiting for
+bool engineThinking = false;
+bool engineInfoValid = false;
+SearchInfo engineInfo;          // latest progress report of that search
+bool movesRequestPending = false;
+bool searchRequestPending = false;
+
+// Piece models, textures and sounds, from the packed bundle when there is one
+GameAssets assets;
+
+// Bounding boxes of the piece models, for picking pieces by their model
+PieceBounds pieceBounds;
+
+// Instanced renderer; --legacy-render keeps the per-square, per-piece draw path for comparison
+BoardRenderer renderer;
+bool legacyRender = false;
+int legacyDrawCalls = 0;
+
+// Everything a frame shows. A frame is only drawn when this differs from the
+// last drawn one, and the 3D scene is only re-rendered when its part differs.
+typedef struct FrameState {
+    struct {
+        char board[BOARD_SIZE][BOARD_SIZE];
+        bool legalMoves[BOARD_SIZE][BOARD_SIZE];
+        signed char targetOutcomes[BOARD_SIZE][BOARD_SIZE];
+        bool pieceSelected;
+        int selectedRow, selectedCol;
+        TweenPool tweens;
+        Camera camera;
+        int screenWidth, screenHeight;
+    } scene;
+    const char* status;
+    bool engineThinking;
+    int engineDepth, engineScore;
+    bool focused, minimized;
+} FrameState;
+
+// Event-driven redraw (default); --continuous redraws every frame as before
+bool continuousRedraw = false;
+bool eventWaiting = false;
+FrameState drawnFrame;
+bool sceneCacheValid = false;
+RenderTexture2D sceneCache;     // last rendered 3D scene, reused while only the overlay changes
+
+// --benchmark [frames]: uncapped frame rate, scripted highlights, frame time report on exit
+int benchmarkFrames = 0;
+float* frameTimes = NULL;
+int frameCount = 0;
+int benchmarkFramesRun = 0;
+
+// --grid [boards]: spectate many games at once instead of playing one
+GridView grid;
+int gridBoards = 0;
+int64_t gridCpuMicroseconds = 0;    // updating and queueing the grid, over the benchmark frames
+
+// F3 (or --profile) shows frame time percentiles, draw calls, engine speed and
+// the hot-path zones; F4 (or --trace, on exit) writes a Chrome trace. While the
+// overlay is up every frame is redrawn, so the frame times are real.
+bool profileOverlay = false;
+bool traceOnExit = false;
 
 // Function declarations
+Color SquareColor(int row, int col);
 void DrawChessBoard(Vector3 boardPosition, float squareSize);
-Vector2 GetBoardPosition(Vector3 boardPosition, float squareSize, Vector3 hitPosition);
+void QueueBoard(Camera camera, Vector3 boardPosition, float squareSize);
 void DrawPiece(char piece, Vector3 position);
-void HighlightLegalMoves(int row, int col);
-bool IsOpponentPiece(int r, int c, bool isWhite);
-bool IsValidSquare(int r, int c);
-
-void HighlightRookMoves(int row, int col, bool isWhite);
-void HighlightBishopMoves(int row, int col, bool isWhite);
-void HighlightWhitePawnMoves(int row, int col);
-void HighlightBlackPawnMoves(int row, int col);
-void HighlightKnightMoves(int row, int col, bool isWhite);
-void HighlightKingMoves(int row, int col, bool isWhite);
-void MovePiece(int fromRow, int fromCol, int toRow, int toCol);
-
-void AnimatePiece(int fromRow, int fromCol, int toRow, int toCol);
-
-//void MarkAttackedSquares(bool isWhite);
+void MovePiece(Move move);
+Vector3 TweenWorldPosition(const Tween* tween, Vector3 boardPosition, float squareSize);
+void TakeBackMove(void);
+void SaveGameFile(void);
+void LoadGameFile(void);
+void RequestEngineUpdate(void);
+void PostEngineRequests(void);
+void PollEngine(void);
+
+void DrawScene(Camera camera, Vector3 boardPosition, float squareSize);
+void DrawOverlay(void);
+void CaptureFrameState(FrameState* frame, Camera camera);
+bool EngineBusy(void);
+void RunBenchmarkScript(int frame);
+bool RecordBenchmarkFrame(void);
+void RunGridView(float squareSize);
+void PrintFrameReport(void);
+void HandleProfileKeys(void);
+void DrawProfileOverlay(void);
+void WriteTraceFile(void);
+
+
+int main(int argc, char** argv) {
+    int64_t startTime = GetMicroseconds();
+    bool startupReported = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--legacy-render") == 0) {
+            legacyRender = true;
+        } else if (strcmp(argv[i], "--continuous") == 0) {
+            continuousRedraw = true;
+        } else if (strcmp(argv[i], "--benchmark") == 0) {
+            benchmarkFrames = BENCHMARK_DEFAULT_FRAMES;
+            if (i + 1 < argc && atoi(argv[i + 1]) > 0) benchmarkFrames = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--grid") == 0) {
+            gridBoards = GRID_DEFAULT_BOARDS;
+            if (i + 1 < argc && atoi(argv[i + 1]) > 0) gridBoards = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--profile") == 0) {
+            profileOverlay = true;
+        } else if (strcmp(argv[i], "--trace") == 0) {
+            traceOnExit = true;
+        }
+    }
+    if (benchmarkFrames > 0 && !(frameTimes = malloc(sizeof(float) * benchmarkFrames))) {
+        TraceLog(LOG_ERROR, "BENCHMARK: Not enough memory for %d frame times", benchmarkFrames);
+        return 1;
+    }
 
+    PROFILE_THREAD("Main");
+    InitBitboards();
+    InitGame(&game);
+    if (!StartEngineWorker(&engine, 0, TT_DEFAULT_MB)) {
+        TraceLog(LOG_ERROR, "ENGINE: Could not start the engine thread");
+        StopEngineWorker(&engine);
+        free(frameTimes);
+        return 1;
+    }
+    if (engine.pool.network) TraceLog(LOG_INFO, "ENGINE: Evaluating with %s (%s kernels)", NNUE_DEFAULT_FILE, NnueSimdName(NnueActiveSimd()));
+    if (engine.tablebases.tableCount) {
+        TraceLog(LOG_INFO, "ENGINE: Tablebases in %s, %d tables up to %d pieces", TB_DEFAULT_DIR,
+                 engine.tablebases.tableCount, engine.tablebases.maxPieces);
+    }
+    if (engine.book.count) TraceLog(LOG_INFO, "ENGINE: Opening book %s, %llu entries", BOOK_DEFAULT_FILE, (unsigned long long)engine.book.count);
+    RequestEngineUpdate();
 
-int main(void) {
     InitWindow(1920, 1080, "3D Chess");
-    SetTargetFPS(180);
+    SetTargetFPS(benchmarkFrames > 0 ? 0 : 180); // the benchmark measures uncapped frame times
     InitAudioDevice();
 
     // Define a top-down static camera
@@ -71,169 +171,267 @@ int main(void) {
     camera.fovy = 45.0f;                              // Field of view angle
     // Field of view angle
 
-    // load sounds
-    Sound moveSound = LoadSound("sounds/move.mp3");
-    Sound castleSound = LoadSound("sounds/castle.mp3");
-    Music backgroundMusic = LoadMusicStream("sounds/music.mp3");
-
-    // Load chess piece models
-    whitePawn = LoadModel("models_assets/WPawn.glb");
-    whiteRook = LoadModel("models_assets/WRook.glb");
-    whiteKnight = LoadModel("models_assets/WKnight.glb");
-    whiteBishop = LoadModel("models_assets/WBishop.glb");
-    whiteQueen = LoadModel("models_assets/WQueen.glb");
-    whiteKing = LoadModel("models_assets/WKing.glb");
-
-    blackPawn = LoadModel("models_assets/BPawn.glb");
-    blackRook = LoadModel("models_assets/BRook.glb");
-    blackKnight = LoadModel("models_assets/BKnight.glb");
-    blackBishop = LoadModel("models_assets/BBishop.glb");
-    blackQueen = LoadModel("models_assets/BQueen.glb");
-    blackKing = LoadModel("models_assets/BKing.glb");
-
-    whiteTexture = LoadTexture("models_assets/BetterWhiteTexture.png");
-
-    // Assign texture to white pieces
-    for (int i = 0; i < whitePawn.materialCount; i++) {
-        whitePawn.materials[i].maps[MATERIAL_MAP_DIFFUSE].texture = whiteTexture;
-        whiteRook.materials[i].maps[MATERIAL_MAP_DIFFUSE].texture = whiteTexture;
-        whiteKnight.materials[i].maps[MATERIAL_MAP_DIFFUSE].texture = whiteTexture;
-        whiteBishop.materials[i].maps[MATERIAL_MAP_DIFFUSE].texture = whiteTexture;
-        whiteQueen.materials[i].maps[MATERIAL_MAP_DIFFUSE].texture = whiteTexture;
-        whiteKing.materials[i].maps[MATERIAL_MAP_DIFFUSE].texture = whiteTexture;
-    }
+    // Load models, textures and sounds; chess_pack bakes them into one bundle
+    // that loads in a fraction of the time of the glTF and mp3 files
+    PROFILE_BEGIN(LoadGameAssets);
+    LoadGameAssets(&assets, ASSET_BUNDLE_PATH);
+    PROFILE_END(LoadGameAssets);
+    ReportAssetMemory(&assets);
+    Music backgroundMusic = assets.music;
+    InitPieceBounds(&pieceBounds, &assets.pieces);
 
     // Chessboard settings
     Vector3 boardPosition = { 0.0f, 0.0f, 0.0f };    // Position of the chessboard
     float squareSize = 1.0f;                         // Each square is 1x1 in world units
 
+    if (!legacyRender && !InitBoardRenderer(&renderer, boardPosition, squareSize, &assets.pieces)) {
+        TraceLog(LOG_WARNING, "Instanced renderer unavailable, using the legacy draw path");
+        legacyRender = true;
+    }
+    if (gridBoards > 0 && legacyRender) {
+        TraceLog(LOG_WARNING, "GRID: The grid view needs the instanced renderer, showing the game instead");
+        gridBoards = 0;
+    }
+
+    if (benchmarkFrames > 0) continuousRedraw = true; // measure full redraws
+
     SetMusicVolume(backgroundMusic, 0.1f);
-    PlayMusicStream(backgroundMusic);
+    if (benchmarkFrames == 0) PlayMusicStream(backgroundMusic);
 
-    while (!WindowShouldClose()) {
+    // The grid view has a loop of its own and leaves the game untouched
+    if (gridBoards > 0) RunGridView(squareSize);
 
+    while (gridBoards == 0 && !WindowShouldClose()) {
+
+        PROFILE_BEGIN(UpdateMusicStream);
         UpdateMusicStream(backgroundMusic);
+        PROFILE_END(UpdateMusicStream);
 
-        // Handle mouse input
-        if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
-            // Get mouse ray
-            Ray ray = GetMouseRay(GetMousePosition(), camera);
-
-            // Check for intersection with the ground (chessboard plane, assuming y=0)
-            float t = (0.0f - ray.position.y) / ray.direction.y;
-            Vector3 hitPosition = {
-                ray.position.x + t * ray.direction.x,
-                0.0f,
-                ray.position.z + t * ray.direction.z
-            };
+        // Take back the last move
+        if (IsKeyPressed(KEY_BACKSPACE)) {
+            TakeBackMove();
+            if (engineSide == game.pos.sideToMove) TakeBackMove(); // back to the player's own move
+        }
+
+        // Quick save and load of the game in the binary game format
+        if (IsKeyPressed(KEY_F5)) SaveGameFile();
+        if (IsKeyPressed(KEY_F9)) LoadGameFile();
+        HandleProfileKeys();
 
-            // Convert the hit position to board coordinates
-            Vector2 boardCoords = GetBoardPosition(boardPosition, squareSize, hitPosition);
-            int row = (int)boardCoords.y;
-            int col = (int)boardCoords.x;
-
-            // Check if click is within the chessboard bounds
-            if (row >= 0 && row < BOARD_SIZE && col >= 0 && col < BOARD_SIZE) {
-                if (!pieceSelected) {
-                    // Select the piece
-                    if (board[row][col] != '.') {
-                        pieceSelected = true;
-                        selectedRow = row;
-                        selectedCol = col;
-
-                        HighlightLegalMoves(row, col);
+        // Let the engine play black
+        if (IsKeyPressed(KEY_E)) {
+            engineSide = engineSide < 0 ? SIDE_BLACK : -1;
+            RequestEngineUpdate();
+        }
+
+        // Talk to the engine thread without ever waiting for it
+        PostEngineRequests();
+        PollEngine();
+
+        // Handle mouse input; moves are played at once, so clicks never wait for an animation
+        if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
+            // The square under the mouse, or the square of the piece model the mouse is on
+            BoardLayout layout = { boardPosition, squareSize, 1, 1, 0 };
+            PickResult pick = PickSquare(&layout, &pieceBounds, &game, sizeof(Game), GetMouseRay(GetMousePosition(), camera));
+            int row = pick.row;
+            int col = pick.col;
+
+            if (pick.board == 0) {
+                if (!game.pieceSelected) {
+                    // Select the piece, only for the side to move and never for the engine's side
+                    int piece = PieceOn(&game.pos, SQUARE_FROM_ROWCOL(row, col));
+                    if (piece != NO_PIECE && PIECE_SIDE(piece) == game.pos.sideToMove && game.pos.sideToMove != engineSide) {
+                        game.pieceSelected = true;
+                        game.selectedRow = row;
+                        game.selectedCol = col;
+
+                        HighlightLegalMoves(&game, row, col);
                     }
                 } else {
-                    if (legalMoves[row][col]) {
-                        // Call the MovePiece function to handle the move
-                        AnimatePiece(selectedRow, selectedCol, row, col);
-                        pieceSelected = false;
-
-                        // Reset legal moves
-                        for (int r = 0; r < BOARD_SIZE; r++) {
-                            for (int c = 0; c < BOARD_SIZE; c++) {
-                                legalMoves[r][c] = false;
-                            }
-                        }
+                    if (game.legalMoves[row][col]) {
+                        Move move = FindSelectedMove(&game, row, col);
+                        game.pieceSelected = false;
+                        ClearLegalMoves(&game);
+                        MovePiece(move);
                     } else {
-                        pieceSelected = false; // Deselect piece if move is illegal
-
-                        // Reset legal moves
-                        for (int r = 0; r < BOARD_SIZE; r++) {
-                            for (int c = 0; c < BOARD_SIZE; c++) {
-                                legalMoves[r][c] = false;
-                            }
-                        }
+                        game.pieceSelected = false; // Deselect piece if move is illegal
+                        ClearLegalMoves(&game);
                     }
                 }
             }
         }
 
-        if (isAnimating) {
-            animationStep++;
+        // Animation runs on elapsed time, so pieces move at the same speed at any frame rate
+        int landed = UpdateTweens(&game.tweens, fminf(GetFrameTime(), MAX_FRAME_SECONDS));
+        if (landed & TWEEN_EVENT_CASTLE) PlaySound(assets.castleSound);
+        else if (landed & TWEEN_EVENT_MOVE) PlaySound(assets.moveSound);
 
-            if (animationStep >= ANIMATION_STEPS) {
-                isAnimating = false; // Animation finished
-                board[endRow][endCol] = board[startRow][startCol]; // Move the piece on the board
-                board[startRow][startCol] = '.'; // Empty the original square
-                PlaySound(moveSound);
+        if (continuousRedraw || profileOverlay) {
+            if (eventWaiting) {
+                DisableEventWaiting();
+                eventWaiting = false;
             }
-            else {
-                // Interpolate the position in a straight line between start and end
-                float t = (float)animationStep / (float)ANIMATION_STEPS;
-
-                // Start and end positions (center of squares)
-                float startX = startCol + 0.5f;
-                float startZ = startRow + 0.5f;
-                float endX = endCol + 0.5f;
-                float endZ = endRow + 0.5f;
-
-                // Interpolate the current position along the X and Z axis
-                currentPosition.x = startX + (endX - startX) * t; // X axis movement
-                currentPosition.z = startZ + (endZ - startZ) * t; // Z axis movement
+            sceneCacheValid = false; // the scene moves on without the cache
+
+            BeginDrawing();
+            ClearBackground(RAYWHITE);
+            DrawScene(camera, boardPosition, squareSize);
+            DrawOverlay();
+            EndDrawing();
+            ProfileFrame(GetFrameTime());
+        } else {
+            // Sleep on input events only when no animation, engine reply or music stream needs the loop
+            bool quiet = game.tweens.count == 0 && !EngineBusy();
+            bool musicPlaying = IsMusicStreamPlaying(backgroundMusic);
+            bool idle = quiet && !musicPlaying;
+            if (idle != eventWaiting) {
+                if (idle) EnableEventWaiting();
+                else DisableEventWaiting();
+                eventWaiting = idle;
             }
-        }
 
-        // Draw the scene
-        BeginDrawing();
-        ClearBackground(RAYWHITE);
+            FrameState frame;
+            CaptureFrameState(&frame, camera);
+            bool sceneChanged = !sceneCacheValid || memcmp(&frame.scene, &drawnFrame.scene, sizeof(frame.scene)) != 0;
 
-        BeginMode3D(camera);
-
-        DrawChessBoard(boardPosition, squareSize);
+            if (sceneChanged || memcmp(&frame, &drawnFrame, sizeof(frame)) != 0) {
+                if (sceneChanged) {
+                    if (sceneCache.texture.width != frame.scene.screenWidth || sceneCache.texture.height != frame.scene.screenHeight) {
+                        if (sceneCache.id != 0) UnloadRenderTexture(sceneCache);
+                        sceneCache = LoadRenderTexture(frame.scene.screenWidth, frame.scene.screenHeight);
+                    }
+                    BeginTextureMode(sceneCache);
+                    ClearBackground(RAYWHITE);
+                    DrawScene(camera, boardPosition, squareSize);
+                    EndTextureMode();
+                }
 
-        if (isAnimating) {
-            DrawPiece(board[startRow][startCol], currentPosition);
+                // Render textures are stored upside down, hence the negative height
+                BeginDrawing();
+                ClearBackground(RAYWHITE);
+                DrawTextureRec(sceneCache.texture, (Rectangle) { 0, 0, (float)sceneCache.texture.width, -(float)sceneCache.texture.height },
+                               (Vector2) { 0, 0 }, WHITE);
+                DrawOverlay();
+                EndDrawing(); // also waits for the next input event when idle
+
+                drawnFrame = frame;
+                sceneCacheValid = true;
+            } else if (idle) {
+                PollInputEvents(); // blocks until the next input event
+            } else if (quiet && musicPlaying) {
+                SleepMilliseconds(MUSIC_IDLE_WAIT_MS); // plain OS sleep, no busy-wait tail
+                PollInputEvents();
+            } else {
+                WaitTime(0.002);
+                PollInputEvents();
+            }
         }
 
-        EndMode3D();
+        // Cold start cost: asset loading, and the time until the first frame is presented
+        if (!startupReported) {
+            TraceLog(LOG_INFO, "STARTUP: Assets loaded from %s in %.1f ms, first frame after %.1f ms",
+                     assets.fromBundle ? ASSET_BUNDLE_PATH : "loose files", assets.loadMs, (GetMicroseconds() - startTime) / 1000.0);
+            startupReported = true;
+        }
 
-        EndDrawing();
+        if (benchmarkFrames > 0) {
+            if (RecordBenchmarkFrame()) break;
+            RunBenchmarkScript(benchmarkFramesRun);
+        }
     }
 
-    // Unload models
-    UnloadModel(whitePawn);
-    UnloadModel(whiteRook);
-    UnloadModel(whiteKnight);
-    UnloadModel(whiteBishop);
-    UnloadModel(whiteQueen);
-    UnloadModel(whiteKing);
-
-    UnloadModel(blackPawn);
-    UnloadModel(blackRook);
-    UnloadModel(blackKnight);
-    UnloadModel(blackBishop);
-    UnloadModel(blackQueen);
-    UnloadModel(blackKing);
-    UnloadMusicStream(backgroundMusic);
-    UnloadSound(castleSound);
+    if (traceOnExit) WriteTraceFile();
+    if (sceneCache.id != 0) UnloadRenderTexture(sceneCache);
+    if (!legacyRender) UnloadBoardRenderer(&renderer);
+    free(frameTimes);
+
+    UnloadGameAssets(&assets);
 
     CloseAudioDevice();
+    StopEngineWorker(&engine);
     CloseWindow();
     return 0;
 }
 
+void DrawScene(Camera camera, Vector3 boardPosition, float squareSize) {
+    PROFILE_BEGIN(DrawScene);
+    BeginMode3D(camera);
+
+    if (legacyRender) {
+        legacyDrawCalls = 0;
+        DrawChessBoard(boardPosition, squareSize);
+
+        for (int i = 0; i < game.tweens.count; i++) {
+            const Tween* tween = &game.tweens.tweens[i];
+            DrawPiece(PieceToChar(tween->piece), TweenWorldPosition(tween, boardPosition, squareSize));
+        }
+    } else {
+        QueueBoard(camera, boardPosition, squareSize);
+        DrawBoardRenderer(&renderer);
+    }
+
+    EndMode3D();
+    PROFILE_END(DrawScene);
+    PROFILE_COUNT("DrawCalls", legacyRender ? legacyDrawCalls : renderer.drawCalls);
+}
+
+void DrawOverlay(void) {
+    const char* status = GetGameStatus(&game);
+    if (status != NULL) {
+        DrawText(status, 20, 20, 40, MAROON);
+    }
+
+    if (engineThinking && engineInfoValid) {
+        DrawText(TextFormat("Engine thinking: depth %d  score %+.2f", engineInfo.depth, engineInfo.score / 100.0f),
+                 20, 70, 20, DARKGRAY);
+    }
+
+    if (profileOverlay) DrawProfileOverlay();
+}
+
+void CaptureFrameState(FrameState* frame, Camera camera) {
+    memset(frame, 0, sizeof(*frame)); // padding takes part in the comparison
+    memcpy(frame->scene.board, game.board, sizeof(game.board));
+    memcpy(frame->scene.legalMoves, game.legalMoves, sizeof(game.legalMoves));
+    memcpy(frame->scene.targetOutcomes, game.targetOutcomes, sizeof(game.targetOutcomes));
+    frame->scene.pieceSelected = game.pieceSelected;
+    frame->scene.selectedRow = game.selectedRow;
+    frame->scene.selectedCol = game.selectedCol;
+    frame->scene.tweens = game.tweens;
+    frame->scene.camera = camera;
+    frame->scene.screenWidth = GetScreenWidth();
+    frame->scene.screenHeight = GetScreenHeight();
+    frame->status = GetGameStatus(&game);
+    frame->engineThinking = engineThinking && engineInfoValid;
+    frame->engineDepth = engineInfo.depth;
+    frame->engineScore = engineInfo.score;
+    frame->focused = IsWindowFocused();
+    frame->minimized = IsWindowMinimized();
+}
+
+// True while the engine thread owes the frame loop a reply
+bool EngineBusy(void) {
+    return engineThinking || movesRequestPending || searchRequestPending || !game.movesReady;
+}
+
+Color SquareColor(int row, int col) {
+    Color squareColor = ((row + col) % 2 == 0) ? LIGHTGRAY : DARKGRAY;
+
+    // Targets the tablebases know are a win or a loss for the mover stand out from the rest
+    if (game.legalMoves[row][col]) {
+        int outcome = game.targetOutcomes[row][col];
+        squareColor = outcome == TB_WIN ? LIME : outcome == TB_LOSS ? ORANGE : YELLOW;
+    }
+
+    if (game.pieceSelected && row == game.selectedRow && col == game.selectedCol) {
+        squareColor = GREEN;
+    }
+
+    return squareColor;
+}
+
 void DrawChessBoard(Vector3 boardPosition, float squareSize) {
+    PROFILE_BEGIN(DrawChessBoard);
     for (int row = 0; row < BOARD_SIZE; row++) {
         for (int col = 0; col < BOARD_SIZE; col++) {
             Vector3 position = {
@@ -242,365 +440,361 @@ void DrawChessBoard(Vector3 boardPosition, float squareSize) {
                 boardPosition.z + row * squareSize
             };
 
-            Color squareColor = ((row + col) % 2 == 0) ? LIGHTGRAY : DARKGRAY;
+            DrawCube(position, squareSize, 0.1f, squareSize, SquareColor(row, col));
+            legacyDrawCalls++;
 
-            if (legalMoves[row][col]) {
-                squareColor = YELLOW;
-            }
+            // Draw the actual piece model if it exists and is not in motion
+            if (!IsSquareTweened(&game.tweens, row * BOARD_SIZE + col)) DrawPiece(game.board[row][col], position);
+        }
+    }
+    PROFILE_END(DrawChessBoard);
+}
 
-            if (pieceSelected && row == selectedRow && col == selectedCol) {
-                squareColor = GREEN;
-            }
+// Fills the instanced renderer for this frame; only changed square colors reach the GPU
+void QueueBoard(Camera camera, Vector3 boardPosition, float squareSize) {
+    PROFILE_BEGIN(QueueBoard);
+    ClearRenderQueue(&renderer, camera);
+    AddGameBoard(&renderer);
 
-            DrawCube(position, squareSize, 0.1f, squareSize, squareColor);
+    for (int row = 0; row < BOARD_SIZE; row++) {
+        for (int col = 0; col < BOARD_SIZE; col++) {
+            SetSquareColor(&renderer, row, col, SquareColor(row, col));
+
+            // Pieces in motion are drawn at their tweened positions instead
+            if (IsSquareTweened(&game.tweens, row * BOARD_SIZE + col)) continue;
 
-            // Draw the actual piece model if it exists
-            DrawPiece(board[row][col], position);
+            Vector3 position = {
+                boardPosition.x + col * squareSize,
+                boardPosition.y,
+                boardPosition.z + row * squareSize
+            };
+            AddPiece(&renderer, CharToPiece(game.board[row][col]), position);
         }
     }
-}
 
-// Convert hit position to board coordinates
-Vector2 GetBoardPosition(Vector3 boardPosition, float squareSize, Vector3 hitPosition) {
-    // Adjust the hit position to the center of the squares
-    int col = (int)((hitPosition.x - boardPosition.x + (squareSize / 2.0f)) / squareSize);
-    int row = (int)((hitPosition.z - boardPosition.z + (squareSize / 2.0f)) / squareSize);
-
-    // Check if the calculated coordinates are valid
-    if (col < 0 || col >= BOARD_SIZE || row < 0 || row >= BOARD_SIZE) {
-        return (Vector2) { -1, -1 };  // Return invalid coordinates if the hit is outside the board
+    for (int i = 0; i < game.tweens.count; i++) {
+        const Tween* tween = &game.tweens.tweens[i];
+        AddPiece(&renderer, tween->piece, TweenWorldPosition(tween, boardPosition, squareSize));
     }
+    PROFILE_END(QueueBoard);
+}
 
-    return (Vector2) { col, row };
+// Tweens are board local, in squares; this is where the same spot is on the drawn board
+Vector3 TweenWorldPosition(const Tween* tween, Vector3 boardPosition, float squareSize) {
+    Vector3 local = TweenPosition(tween);
+    return (Vector3){ boardPosition.x + local.x * squareSize, boardPosition.y + local.y * squareSize, boardPosition.z + local.z * squareSize };
 }
 
 // Function to draw the chess piece model at a given position
+// The legacy path always draws the full-detail mesh
 void DrawPiece(char piece, Vector3 position) {
-    Model* modelToDraw = NULL;
-    Color pieceColor = WHITE; // Default to white color
-
-    switch (piece) {
-    case 'P': modelToDraw = &whitePawn; break; // White pieces
-    case 'R': modelToDraw = &whiteRook; break;
-    case 'N': modelToDraw = &whiteKnight; break; // Knight (white)
-    case 'B': modelToDraw = &whiteBishop; break;
-    case 'Q': modelToDraw = &whiteQueen; break;
-    case 'K': modelToDraw = &whiteKing; break;
-
-    case 'p': modelToDraw = &blackPawn; break; // Black pieces
-    case 'r': modelToDraw = &blackRook; break;
-    case 'n': modelToDraw = &blackKnight; break; // Knight (black)
-    case 'b': modelToDraw = &blackBishop; break;
-    case 'q': modelToDraw = &blackQueen; break;
-    case 'k': modelToDraw = &blackKing; break;
-
-    default: break; // If there is no piece, do nothing
-    }
+    int code = CharToPiece(piece);
 
-    if (modelToDraw != NULL) {
-        // Adjust the position for drawing (lifted slightly above the board)
-        Vector3 drawPosition = (Vector3){ position.x, position.y + 0.5f, position.z };
-
-        // Check if the piece is a knight
-        if (piece == 'N') {
-            // Rotate the white knight 90 degrees around the Y-axis to face forward
-            DrawModelEx(*modelToDraw, drawPosition, (Vector3) { 0.0f, 1.0f, 0.0f }, -90.0f, (Vector3) { 0.4f, 0.4f, 0.4f }, pieceColor);
-        }
-        else if (piece == 'n') {
-            // Rotate the black knight 90 degrees around the Y-axis to face forward
-            DrawModelEx(*modelToDraw, drawPosition, (Vector3) { 0.0f, 1.0f, 0.0f }, 90.0f, (Vector3) { 0.4f, 0.4f, 0.4f }, pieceColor);
-        }
-        else {
-            // Draw the model without rotation for other pieces
-            DrawModel(*modelToDraw, drawPosition, 0.4f, pieceColor);
-        }
-    }
-}
+    if (code == NO_PIECE) return; // If there is no piece, do nothing
 
-bool IsOpponentPiece(int r, int c, bool isWhite) {
-    char p = board[r][c];
-    return p != '.' && (isWhite ? p >= 'a' && p <= 'z' : p >= 'A' && p <= 'Z');
+    PROFILE_BEGIN(DrawPiece);
+    legacyDrawCalls++;
+    DrawMesh(assets.pieces.meshes[PIECE_TYPE(code)][0], assets.pieces.materials[PIECE_SIDE(code)], PieceTransform(code, position));
+    PROFILE_END(DrawPiece);
 }
 
-bool IsValidSquare(int r, int c) {
-    return r >= 0 && r < BOARD_SIZE && c >= 0 && c < BOARD_SIZE;
+// Plays the move right away (rook, en passant and promotion included); the
+// tweens catch the pieces up on screen
+void MovePiece(Move move) {
+    StartMoveTweens(&game, move, MOVE_ANIMATION_SECONDS);
+    PlayGameMove(&game, move);
+    RequestEngineUpdate();
 }
 
-void MovePiece(int fromRow, int fromCol, int toRow, int toCol) {
-    // Move the piece to the new square
-    board[toRow][toCol] = board[fromRow][fromCol];
-    board[fromRow][fromCol] = '.'; // Empty the old square
+void TakeBackMove(void) {
+    if (TakeBackGameMove(&game)) RequestEngineUpdate();
 }
 
-void AnimatePiece(int fromRow, int fromCol, int toRow, int toCol) {
-    // Store starting and ending positions (center of squares)
-    startRow = fromRow;
-    startCol = fromCol;
-    endRow = toRow;
-    endCol = toCol;
-
-    // Set the current position at the center of the starting square
-    currentPosition = (Vector3){ startCol + 0.5f, 0.5f, startRow + 0.5f };
-    animationStep = 0;
-    isAnimating = true; // Start the animation
-}
+void SaveGameFile(void) {
+    Position start;
+    int result = PACKED_RESULT_UNKNOWN;
 
-void HighlightLegalMoves(int row, int col) {
-    for (int r = 0; r < BOARD_SIZE; r++) {
-        for (int c = 0; c < BOARD_SIZE; c++) {
-            legalMoves[r][c] = false;
-        }
+    if (game.movesReady && game.legalMoveList.count == 0) {
+        if (!InCheck(&game.pos)) result = PACKED_RESULT_DRAW;
+        else result = game.pos.sideToMove == SIDE_WHITE ? PACKED_RESULT_BLACK : PACKED_RESULT_WHITE;
     }
 
-    char piece = board[row][col];
-
-    switch (piece) {
-    case 'P': // White Pawn
-        HighlightWhitePawnMoves(row, col);
-        break;
-    case 'p': // Black Pawn
-        HighlightBlackPawnMoves(row, col);
-        break;
-
-    case 'R': case 'r':// Rooks
-        HighlightRookMoves(row, col, piece == 'R');
-        break;
+    GetGameStart(&game, &start);
+    FILE* file = fopen(PACKED_SAVE_FILE, "wb");
+    bool saved = file && WritePackedHeader(file, PACKED_KIND_GAMES) &&
+                 WritePackedGame(file, &start, game.moves, game.ply, result);
+    if (file && fclose(file) != 0) saved = false;
 
-    case 'N': case 'n': // Knights
-        HighlightKnightMoves(row, col, piece == 'N');
-        break;
-
-    case 'B': case 'b': // Bishops
-        HighlightBishopMoves(row, col, piece == 'B');
-        break;
+    if (saved) TraceLog(LOG_INFO, "GAME: Saved %d moves to %s", game.ply, PACKED_SAVE_FILE);
+    else TraceLog(LOG_WARNING, "GAME: Could not write %s", PACKED_SAVE_FILE);
+}
 
-    case 'Q': case 'q': // Queens
-        HighlightRookMoves(row, col, piece == 'Q');
-        HighlightBishopMoves(row, col, piece == 'Q');
-        break;
+// Replays the first game of the file; moves after an illegal one are dropped
+void LoadGameFile(void) {
+    MappedFile file;
+    PackedReader reader;
+    const PackedGame* saved;
+    const Move* moves;
+    Position start;
+
+    if (!MapFile(&file, PACKED_SAVE_FILE)) {
+        TraceLog(LOG_WARNING, "GAME: No saved game in %s", PACKED_SAVE_FILE);
+        return;
+    }
+    if (InitPackedReader(&reader, file.data, file.size) && (saved = NextPackedGame(&reader, &moves)) != NULL &&
+        UnpackPosition(&saved->start, &start)) {
+        int played = LoadGameMoves(&game, &start, moves, (int)saved->moveCount);
+        TraceLog(LOG_INFO, "GAME: Loaded %d of %u moves from %s", played, saved->moveCount, PACKED_SAVE_FILE);
+        RequestEngineUpdate();
+    } else {
+        TraceLog(LOG_WARNING, "GAME: %s is not a saved game", PACKED_SAVE_FILE);
+    }
+    UnmapFile(&file);
+}
 
-    case 'K': case 'k': // Kings
-        HighlightKingMoves(row, col, piece == 'K');
-        break;
+// The game position changed: results for the old one are now stale
+void RequestEngineUpdate(void) {
+    if (engineThinking) {
+        AbortEngineSearch(&engine, engineSearchId);
+        engineThinking = false;
     }
+    game.movesReady = false;
+    movesRequestPending = true;
+    searchRequestPending = engineSide == game.pos.sideToMove;
 }
 
+// Posts what RequestEngineUpdate asked for; a full queue is retried next frame
+void PostEngineRequests(void) {
+    static EngineCommand command;
 
-void HighlightRookMoves(int row, int col, bool isWhite) {
-    char piece = board[row][col];
+    if (!movesRequestPending && !searchRequestPending) return;
 
-    for (int i = row - 1; i >= 0; i--) { // UP
-        if (board[i][col] == '.') legalMoves[i][col] = true;
-        else {
-            if (IsOpponentPiece(i, col, piece == 'R')) {
-                legalMoves[i][col] = true;
-            }
-            break;
-        }
-    }
+    command.pos = game.pos;
+    command.limits = (SearchLimits){ 0, 0, ENGINE_MOVE_TIME_MS, 0 };
 
-    for (int i = row + 1; i < BOARD_SIZE; i++) { // DOWN
-        if (board[i][col] == '.') legalMoves[i][col] = true;
-        else {
-            if (IsOpponentPiece(i, col, piece == 'R')) {
-                legalMoves[i][col] = true;
-            }
-            break;
-        }
+    // Repetitions cannot reach back past the last capture or pawn move
+    int first = game.ply - game.pos.halfmoveClock;
+    if (first < 0) first = 0;
+    if (game.ply - first > ENGINE_HISTORY_KEYS) first = game.ply - ENGINE_HISTORY_KEYS;
+    command.historyCount = game.ply - first;
+    for (int i = first; i < game.ply; i++) command.history[i - first] = game.history[i].key;
+
+    if (movesRequestPending) {
+        command.type = ENGINE_CMD_MOVES;
+        command.id = ++engineRequestId;
+        if (!PostEngineCommand(&engine, &command)) return;
+        movesRequestPending = false;
     }
 
-    for (int i = col - 1; i >= 0; i--) { // LEFT
-        if (board[row][i] == '.') legalMoves[row][i] = true;
-        else {
-            if (IsOpponentPiece(row, i, piece == 'R')) {
-                legalMoves[row][i] = true;
-            }
-            break;
-        }
+    if (searchRequestPending) {
+        command.type = ENGINE_CMD_SEARCH;
+        command.id = ++engineRequestId;
+        if (!PostEngineCommand(&engine, &command)) return;
+        searchRequestPending = false;
+        engineSearchId = command.id;
+        engineThinking = true;
+        engineInfoValid = false;
     }
+}
 
-    for (int i = col + 1; i < BOARD_SIZE; i++) { // RIGHT
-        if (board[row][i] == '.') legalMoves[row][i] = true;
-        else {
-            if (IsOpponentPiece(row, i, piece == 'R')) {
-                legalMoves[row][i] = true;
+void PollEngine(void) {
+    static EngineResult result;
+
+    PROFILE_BEGIN(PollEngine);
+    while (PollEngineResult(&engine, &result)) {
+        if (result.type == ENGINE_RESULT_MOVES) {
+            if (result.key != game.pos.key) continue;
+            game.legalMoveList = result.moves;
+            memcpy(game.moveOutcomes, result.outcomes, sizeof(game.moveOutcomes));
+            game.movesReady = true;
+            if (game.pieceSelected) HighlightLegalMoves(&game, game.selectedRow, game.selectedCol);
+        } else if (engineThinking && result.id == engineSearchId) {
+            engineInfo = result.info;
+            engineInfoValid = true;
+            if (result.type == ENGINE_RESULT_BESTMOVE) {
+                engineThinking = false;
+                if (result.bestMove != MOVE_NONE) {
+                    game.pieceSelected = false;
+                    ClearLegalMoves(&game);
+                    MovePiece(result.bestMove);
+                }
             }
-            break;
         }
     }
+    PROFILE_END(PollEngine);
 }
 
+// Benchmark input: select the e2 pawn for one second, then deselect, so square
+// color updates are part of the measurement
+void RunBenchmarkScript(int frame) {
+    if (frame % 180 == 0) {
+        game.pieceSelected = true;
+        game.selectedRow = 6;
+        game.selectedCol = 4;
+        HighlightLegalMoves(&game, game.selectedRow, game.selectedCol);
+    } else if (frame % 180 == 90) {
+        game.pieceSelected = false;
+        ClearLegalMoves(&game);
+    }
+}
 
-void HighlightBishopMoves(int row, int col, bool isWhite) {
-    char piece = board[row][col];
+// Counts a frame of the benchmark; true once the report is printed and the run is over
+bool RecordBenchmarkFrame(void) {
+    benchmarkFramesRun++;
+    if (benchmarkFramesRun > BENCHMARK_WARMUP_FRAMES) frameTimes[frameCount++] = GetFrameTime();
+    if (frameCount < benchmarkFrames) return false;
 
-    // UP LEFT
-    for (int i = 1; i < BOARD_SIZE; i++) {
-        int newRow = row - i, newCol = col - i;
-        if (!IsValidSquare(newRow, newCol)) break;
+    PrintFrameReport();
+    return true;
+}
 
-        if (board[newRow][newCol] == '.') {
-            legalMoves[newRow][newCol] = true;
-        }
-        else {
-            if (IsOpponentPiece(newRow, newCol, isWhite)) {
-                legalMoves[newRow][newCol] = true;
-            }
-            break;
-        }
+// Spectator grid: every board is a game of its own, drawn by the instanced
+// renderer with the boards outside the view culled. Mouse wheel zooms,
+// arrow keys or WASD pan, R resets the view.
+void RunGridView(float squareSize) {
+    if (!InitGridView(&grid, gridBoards, squareSize)) {
+        TraceLog(LOG_WARNING, "GRID: Not enough memory for %d boards", gridBoards);
+        return;
     }
 
-    // UP RIGHT
-    for (int i = 1; i < BOARD_SIZE; i++) {
-        int newRow = row - i, newCol = col + i;
-        if (!IsValidSquare(newRow, newCol)) break;
+    Camera camera = GridOverviewCamera(&grid, (float)GetScreenWidth() / (float)GetScreenHeight());
+    BoardLayout layout;
+    GetGridLayout(&grid, &layout);
 
-        if (board[newRow][newCol] == '.') {
-            legalMoves[newRow][newCol] = true;
-        }
-        else {
-            if (IsOpponentPiece(newRow, newCol, isWhite)) {
-                legalMoves[newRow][newCol] = true;
-            }
-            break;
+    while (!WindowShouldClose()) {
+        float dt = fminf(GetFrameTime(), MAX_FRAME_SECONDS);
+
+        PROFILE_BEGIN(UpdateMusicStream);
+        UpdateMusicStream(assets.music);
+        PROFILE_END(UpdateMusicStream);
+        HandleProfileKeys();
+
+        // The benchmark keeps the whole grid in view
+        if (benchmarkFrames == 0) {
+            Vector3 offset = Vector3Subtract(camera.position, camera.target);
+            float height = offset.y;
+            float wheel = GetMouseWheelMove();
+            Vector3 pan = { 0 };
+
+            if (wheel != 0.0f) offset = Vector3Scale(offset, wheel > 0.0f ? 0.85f : 1.0f / 0.85f);
+            if (IsKeyDown(KEY_LEFT) || IsKeyDown(KEY_A)) pan.x -= 1.0f;
+            if (IsKeyDown(KEY_RIGHT) || IsKeyDown(KEY_D)) pan.x += 1.0f;
+            if (IsKeyDown(KEY_UP) || IsKeyDown(KEY_W)) pan.z -= 1.0f;
+            if (IsKeyDown(KEY_DOWN) || IsKeyDown(KEY_S)) pan.z += 1.0f;
+
+            // Pan speed follows the height, so it feels the same at any zoom
+            camera.target = Vector3Add(camera.target, Vector3Scale(pan, height * dt));
+            camera.position = Vector3Add(camera.target, offset);
+            if (IsKeyPressed(KEY_R)) camera = GridOverviewCamera(&grid, (float)GetScreenWidth() / (float)GetScreenHeight());
         }
-    }
 
-    // DOWN LEFT
-    for (int i = 1; i < BOARD_SIZE; i++) {
-        int newRow = row + i, newCol = col - i;
-        if (!IsValidSquare(newRow, newCol)) break;
+        int64_t start = GetMicroseconds();
+        UpdateGridView(&grid, dt);
+        QueueGridView(&grid, &renderer, camera);
+        if (benchmarkFramesRun >= BENCHMARK_WARMUP_FRAMES) gridCpuMicroseconds += GetMicroseconds() - start;
 
-        if (board[newRow][newCol] == '.') {
-            legalMoves[newRow][newCol] = true;
-        }
-        else {
-            if (IsOpponentPiece(newRow, newCol, isWhite)) {
-                legalMoves[newRow][newCol] = true;
-            }
-            break;
+        BeginDrawing();
+        ClearBackground(RAYWHITE);
+        BeginMode3D(camera);
+        DrawBoardRenderer(&renderer);
+        EndMode3D();
+        DrawText(TextFormat("%d boards, %d in view, %d pieces, %d draw calls, %d FPS", grid.boardCount, grid.visibleBoards,
+                            renderer.pieceInstances, renderer.drawCalls, GetFPS()), 20, 20, 20, DARKGRAY);
+        // The board and square under the mouse, picked the same way as in the game
+        PickResult pick = PickSquare(&layout, &pieceBounds, &grid.boards[0].game, sizeof(GridBoard), GetMouseRay(GetMousePosition(), camera));
+        if (pick.board >= 0) {
+            DrawText(TextFormat("Board %d, %c%d%s", pick.board + 1, 'a' + pick.col, BOARD_SIZE - pick.row, pick.onPiece ? ", on the piece" : ""),
+                     20, 45, 20, DARKGRAY);
         }
+        if (profileOverlay) DrawProfileOverlay();
+        EndDrawing();
+        PROFILE_COUNT("DrawCalls", renderer.drawCalls);
+        ProfileFrame(GetFrameTime());
+
+        if (benchmarkFrames > 0 && RecordBenchmarkFrame()) break;
     }
 
-    // DOWN RIGHT
-    for (int i = 1; i < BOARD_SIZE; i++) {
-        int newRow = row + i, newCol = col + i;
-        if (!IsValidSquare(newRow, newCol)) break;
+    UnloadGridView(&grid);
+}
 
-        if (board[newRow][newCol] == '.') {
-            legalMoves[newRow][newCol] = true;
-        }
-        else {
-            if (IsOpponentPiece(newRow, newCol, isWhite)) {
-                legalMoves[newRow][newCol] = true;
-            }
-            break;
-        }
-    }
+int CompareFloats(const void* a, const void* b) {
+    float x = *(const float*)a, y = *(const float*)b;
+    return (x > y) - (x < y);
 }
 
-void HighlightWhitePawnMoves(int row, int col) {
-    if (IsValidSquare(row - 1, col) && board[row - 1][col] == '.') {
-        legalMoves[row - 1][col] = true;
-        if (row == 6 && board[row - 2][col] == '.') {
-            legalMoves[row - 2][col] = true;
-        }
+void PrintFrameReport(void) {
+    double total = 0.0;
+    for (int i = 0; i < frameCount; i++) total += frameTimes[i];
+    qsort(frameTimes, frameCount, sizeof(float), CompareFloats);
+
+    double average = total / frameCount;
+    printf("renderer: %s\n", legacyRender ? "legacy (DrawCube + DrawModel per piece)" : grid.boardCount > 0 ? "instanced grid" : "instanced");
+    printf("frames: %d  average: %.3f ms  (%.0f FPS)\n", frameCount, average * 1000.0, 1.0 / average);
+    printf("p50: %.3f ms  p95: %.3f ms  p99: %.3f ms  max: %.3f ms\n",
+           frameTimes[frameCount / 2] * 1000.0, frameTimes[frameCount * 95 / 100] * 1000.0,
+           frameTimes[frameCount * 99 / 100] * 1000.0, frameTimes[frameCount - 1] * 1000.0);
+    printf("draw submissions per frame: %d\n", legacyRender ? legacyDrawCalls : renderer.drawCalls);
+    if (grid.boardCount > 0) {
+        printf("grid: %d boards, %d in view, %d pieces drawn, %lld moves played\n", grid.boardCount, grid.visibleBoards,
+               renderer.pieceInstances, (long long)grid.totalMoves);
+        printf("grid update and queue: %.3f ms per frame on the CPU\n", gridCpuMicroseconds / 1000.0 / frameCount);
     }
+    fflush(stdout);
+}
 
-    if (IsValidSquare(row - 1, col - 1) && IsOpponentPiece(row - 1, col - 1, true)) {
-        legalMoves[row - 1][col - 1] = true;
-    }
-    if (IsValidSquare(row - 1, col + 1) && IsOpponentPiece(row - 1, col + 1, true)) {
-        legalMoves[row - 1][col + 1] = true;
-    }
+void HandleProfileKeys(void) {
+    if (IsKeyPressed(KEY_F3)) profileOverlay = !profileOverlay;
+    if (IsKeyPressed(KEY_F4)) WriteTraceFile();
 }
 
-void HighlightBlackPawnMoves(int row, int col) {
-    if (IsValidSquare(row + 1, col) && board[row + 1][col] == '.') {
-        legalMoves[row + 1][col] = true;
-        if (row == 1 && board[row + 2][col] == '.') {
-            legalMoves[row + 2][col] = true;
-        }
+// Top right, over a dark panel so it reads on any part of the board
+void DrawProfileOverlay(void) {
+    FrameTimeStats frames;
+    ProfileZoneStats zones[PROFILE_MAX_ZONES];
+    ProfileCounterStats counters[PROFILE_MAX_COUNTERS];
+    int zoneCount = GetProfileZones(zones, PROFILE_MAX_ZONES);
+    int counterCount = GetProfileCounters(counters, PROFILE_MAX_COUNTERS);
+    int lines = 4 + (zoneCount > 0 ? zoneCount + counterCount + 1 : 1);
+    int x = GetScreenWidth() - 560, y = 20;
+
+    GetFrameTimeStats(&frames);
+    DrawRectangle(x - 10, y - 10, 550, lines * 22 + 20, Fade(BLACK, 0.6f));
+
+    DrawText(TextFormat("Frame ms  p50 %.2f  p95 %.2f  p99 %.2f  max %.2f", frames.p50 * 1000.0f, frames.p95 * 1000.0f,
+                        frames.p99 * 1000.0f, frames.max * 1000.0f), x, y, 20, RAYWHITE);
+    y += 22;
+    DrawText(TextFormat("%d FPS over the last %d frames", GetFPS(), frames.frames), x, y, 20, RAYWHITE);
+    y += 22;
+    // The legacy path draws one cube per square and one mesh per piece
+    DrawText(TextFormat("Draw calls %d, pieces %d", legacyRender ? legacyDrawCalls : renderer.drawCalls,
+                        legacyRender ? legacyDrawCalls - BOARD_SIZE * BOARD_SIZE : renderer.pieceInstances), x, y, 20, RAYWHITE);
+    y += 22;
+    if (engineInfoValid) {
+        DrawText(TextFormat("Engine %.2f Mnps, TT hit rate %.1f%%, %d%% full", engineInfo.nps / 1e6,
+                            TTHitRate(&engineInfo.tt) * 100.0, engineInfo.hashfull / 10), x, y, 20, RAYWHITE);
+    } else {
+        DrawText("Engine idle", x, y, 20, RAYWHITE);
     }
+    y += 22;
 
-    if (IsValidSquare(row + 1, col - 1) && IsOpponentPiece(row + 1, col - 1, false)) {
-        legalMoves[row + 1][col - 1] = true;
+    if (zoneCount == 0) {
+        DrawText("Zones need a build with PROFILE_ENABLED", x, y, 20, LIGHTGRAY);
+        return;
     }
-    if (IsValidSquare(row + 1, col + 1) && IsOpponentPiece(row + 1, col + 1, false)) {
-        legalMoves[row + 1][col + 1] = true;
+    DrawText(TextFormat("Per frame, F4 writes %s", PROFILE_TRACE_FILE), x, y, 20, LIGHTGRAY);
+    y += 22;
+    for (int i = 0; i < zoneCount; i++, y += 22) {
+        DrawText(TextFormat("%s  %.3f ms  %d calls", zones[i].name, zones[i].milliseconds, zones[i].calls), x, y, 20, RAYWHITE);
     }
-}
-
-void HighlightKnightMoves(int row, int col, bool isWhite) {
-    {
-        int knightMoves[8][2] = {
-            {-2, -1}, {-2, 1}, {-1, -2}, {-1, 2},
-            {1, -2}, {1, 2}, {2, -1}, {2, 1}
-        };
-
-        for (int i = 0; i < 8; i++) {
-            int newRow = row + knightMoves[i][0];
-            int newCol = col + knightMoves[i][1];
-            if (IsValidSquare(newRow, newCol) &&
-                (board[newRow][newCol] == '.' || IsOpponentPiece(newRow, newCol, isWhite))) {
-                legalMoves[newRow][newCol] = true;
-            }
-        }
+    for (int i = 0; i < counterCount; i++, y += 22) {
+        DrawText(TextFormat("%s  %lld", counters[i].name, (long long)counters[i].value), x, y, 20, RAYWHITE);
     }
 }
 
-void HighlightKingMoves(int row, int col, bool isWhite) {
-    memset(legalMoves, false, sizeof(legalMoves)); // Resets the legalMoves array
-
-    // Check all surrounding squares for legal moves
-    for (int i = -1; i <= 1; i++) {
-        for (int j = -1; j <= 1; j++) {
-            if (i == 0 && j == 0) continue; // Skip current position
-
-            int newRow = row + i;
-            int newCol = col + j;
-
-            if (IsValidSquare(newRow, newCol)) {
-                // Check if the square is empty or occupied by an opponent's piece
-                if (board[newRow][newCol] == '.' || IsOpponentPiece(newRow, newCol, isWhite)) {
-                    // Check if the square is not under attack
-                    if (!attackedSquares[newRow][newCol]) {
-                        legalMoves[newRow][newCol] = true; // Mark the square as a legal move
-                    }
-                }
-            }
-        }
-    }
+void WriteTraceFile(void) {
+    int events = WriteProfileTrace(PROFILE_TRACE_FILE);
 
-    // Handle castling
-    if (isWhite && !whiteKingMoved) {
-        // Kingside castling - white
-        if (!whiteRookMoved[1] && board[7][5] == '.' && board[7][6] == '.'
-            && !attackedSquares[7][5] && !attackedSquares[7][6]) {
-            legalMoves[7][6] = true;
-        }
-
-        // Queenside castling - white
-        if (!whiteRookMoved[0] && board[7][3] == '.' && board[7][2] == '.'
-            && board[7][1] == '.' && !attackedSquares[7][3] && !attackedSquares[7][2]
-            && !attackedSquares[7][1]) {
-            legalMoves[7][2] = true;
-        }
-    }
-    else if (!isWhite && !blackKingMoved) {
-        // Kingside castling - black
-        if (!blackRookMoved[1] && board[0][5] == '.' && board[0][6] == '.'
-            && !attackedSquares[0][5] && !attackedSquares[0][6]) {
-            legalMoves[0][6] = true;
-        }
-
-        // Queenside castling - black
-        if (!blackRookMoved[0] && board[0][3] == '.' && board[0][2] == '.'
-            && board[0][1] == '.' && !attackedSquares[0][3] && !attackedSquares[0][2]
-            && !attackedSquares[0][1]) {
-            legalMoves[0][2] = true;
-        }
-    }
+    if (events > 0) TraceLog(LOG_INFO, "PROFILE: Wrote %d events to %s", events, PROFILE_TRACE_FILE);
+    else if (events == 0) TraceLog(LOG_WARNING, "PROFILE: No events to trace, zones need a build with PROFILE_ENABLED");
+    else TraceLog(LOG_WARNING, "PROFILE: Could not write %s", PROFILE_TRACE_FILE);
 }
-
-// old code
\ No newline at end of file
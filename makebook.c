@@ -0,0 +1,398 @@
+// chess_book: builds opening books from game collections.
+//
+//   chess_book <games.pgn|games.bin> ... [--out FILE] [--plies N]
+//              [--min-games N] [--memory MB]
+//       replays the first --plies plies (default 24, at most 64) of every game, PGN or
+//       the binary game format, and writes the moves played from each
+//       position to --out (default chess.book). Moves seen in fewer than
+//       --min-games games (default 2) are left out.
+//
+//   chess_book --show FILE [--fen FEN]
+//       lists the book moves of a position, the start position by default
+//
+// Collections of any size are handled with an external sort: records are
+// sorted and combined in a buffer of --memory MB (default 64), written out
+// as sorted runs next to the output file, and the runs merged at the end.
+// A move scores 2 for the side that played it when it won, 1 for a draw or
+// an unknown result and 0 for a loss; the weights are those scores, scaled
+// per position to fit 16 bits.
+
+#include "book.h"
+#include "packed.h"
+#include "pgn.h"
+#include "movegen.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MERGE_BUFFER_BYTES 65536    // stdio buffer per run while merging
+#define BOOK_MAX_PLIES 64
+
+// One (position, move) pair with the totals of every game that played it
+typedef struct BookRecord {
+    uint64_t key;
+    uint32_t score;
+    uint32_t games;
+    Move move;
+} BookRecord;
+
+typedef struct BookBuilder {
+    const char *outPath;
+    int plies;
+    uint32_t minGames;
+
+    BookRecord *records;            // the run being collected
+    size_t count, capacity;
+    int runCount;
+
+    int64_t games, skipped, moves;
+} BookBuilder;
+
+static int CompareRecords(const void *a, const void *b) {
+    const BookRecord *x = a, *y = b;
+
+    if (x->key != y->key) return x->key < y->key ? -1 : 1;
+    return (int)x->move - (int)y->move;
+}
+
+static void RunPath(const BookBuilder *builder, int run, char *path, size_t size) {
+    snprintf(path, size, "%s.run%d", builder->outPath, run);
+}
+
+// Sorts the buffer, adds up equal pairs and writes the result as the next run
+static bool FlushRun(BookBuilder *builder) {
+    char path[1100];
+    size_t combined = 0;
+
+    if (builder->count == 0) return true;
+    qsort(builder->records, builder->count, sizeof(BookRecord), CompareRecords);
+    for (size_t i = 1; i < builder->count; i++) {
+        BookRecord *last = &builder->records[combined];
+        if (builder->records[i].key == last->key && builder->records[i].move == last->move) {
+            last->score += builder->records[i].score;
+            last->games += builder->records[i].games;
+        } else {
+            builder->records[++combined] = builder->records[i];
+        }
+    }
+    combined++;
+
+    RunPath(builder, builder->runCount, path, sizeof(path));
+    FILE *file = fopen(path, "wb");
+    bool written = file && fwrite(builder->records, sizeof(BookRecord), combined, file) == combined;
+    if (file && fclose(file) != 0) written = false;
+    if (!written) {
+        fprintf(stderr, "cannot write %s\n", path);
+        return false;
+    }
+
+    builder->runCount++;
+    builder->count = 0;
+    return true;
+}
+
+static bool AddRecord(BookBuilder *builder, uint64_t key, Move move, uint32_t score) {
+    if (builder->count == builder->capacity && !FlushRun(builder)) return false;
+    builder->records[builder->count++] = (BookRecord){ key, score, 1, move };
+    return true;
+}
+
+// result is PACKED_RESULT_*; moves stop at the first illegal one
+static bool AddGame(BookBuilder *builder, Position *pos, const Move *moves, int count, int result) {
+    UndoInfo undo;
+
+    if (count > builder->plies) count = builder->plies;
+    for (int i = 0; i < count && IsMoveLegal(pos, moves[i]); i++) {
+        uint32_t score = 1;
+        if (result == PACKED_RESULT_WHITE) score = pos->sideToMove == SIDE_WHITE ? 2 : 0;
+        if (result == PACKED_RESULT_BLACK) score = pos->sideToMove == SIDE_BLACK ? 2 : 0;
+
+        if (!AddRecord(builder, pos->key, moves[i], score)) return false;
+        MakeMove(pos, moves[i], &undo);
+        builder->moves++;
+    }
+    builder->games++;
+    return true;
+}
+
+static int ResultFromText(const char *text) {
+    if (strcmp(text, "1-0") == 0) return PACKED_RESULT_WHITE;
+    if (strcmp(text, "0-1") == 0) return PACKED_RESULT_BLACK;
+    if (strcmp(text, "1/2-1/2") == 0) return PACKED_RESULT_DRAW;
+    return PACKED_RESULT_UNKNOWN;
+}
+
+static bool AddPgnGames(BookBuilder *builder, const MappedFile *file) {
+    PgnScanner scanner;
+    PgnGame game;
+
+    InitPgnScanner(&scanner, (const char *)file->data, file->size);
+    while (NextPgnGame(&scanner, &game)) {
+        Move moves[BOOK_MAX_PLIES];
+        PgnMoveReader reader;
+        Position pos, start;
+        UndoInfo undo;
+        char text[128];
+        const char *san;
+        int count = 0;
+
+        if (!GetPgnTag(&game, "FEN", text, sizeof(text))) strcpy(text, START_FEN);
+        if (!PositionFromFen(&start, text)) {
+            builder->skipped++;
+            continue;
+        }
+
+        // SAN needs the position, so the moves are resolved on a copy first
+        pos = start;
+        InitPgnMoveReader(&reader, &game);
+        while (count < builder->plies && (san = NextPgnMove(&reader)) != NULL) {
+            Move move = ParseSan(&pos, san);
+            if (move == MOVE_NONE) break;
+            MakeMove(&pos, move, &undo);
+            moves[count++] = move;
+        }
+
+        if (!GetPgnTag(&game, "Result", text, sizeof(text))) text[0] = '\0';
+        if (!AddGame(builder, &start, moves, count, ResultFromText(text))) return false;
+    }
+    return true;
+}
+
+static bool AddPackedGames(BookBuilder *builder, PackedReader *reader) {
+    const PackedGame *game;
+    const Move *moves;
+
+    while ((game = NextPackedGame(reader, &moves)) != NULL) {
+        Position pos;
+        if (!UnpackPosition(&game->start, &pos)) {
+            builder->skipped++;
+            continue;
+        }
+        int count = game->moveCount < (uint32_t)builder->plies ? (int)game->moveCount : builder->plies;
+        if (!AddGame(builder, &pos, moves, count, game->start.result)) return false;
+    }
+    return true;
+}
+
+// Binary heap of the runs' current records, smallest on top
+typedef struct MergeHeap {
+    BookRecord *heads;
+    FILE **runs;
+    int *order;
+    int size;
+} MergeHeap;
+
+static bool HeapLess(const MergeHeap *heap, int a, int b) {
+    return CompareRecords(&heap->heads[heap->order[a]], &heap->heads[heap->order[b]]) < 0;
+}
+
+static void SiftDown(MergeHeap *heap, int i) {
+    for (;;) {
+        int smallest = i, left = 2 * i + 1, right = 2 * i + 2;
+        if (left < heap->size && HeapLess(heap, left, smallest)) smallest = left;
+        if (right < heap->size && HeapLess(heap, right, smallest)) smallest = right;
+        if (smallest == i) return;
+
+        int swap = heap->order[i];
+        heap->order[i] = heap->order[smallest];
+        heap->order[smallest] = swap;
+        i = smallest;
+    }
+}
+
+static int CompareByWeight(const void *a, const void *b) {
+    const BookEntry *x = a, *y = b;
+    return (int)y->weight - (int)x->weight;
+}
+
+// Writes the moves of one position that pass the filter, weights scaled to 16 bits
+static bool WritePosition(FILE *out, const BookBuilder *builder, const BookRecord *records, int count, uint64_t *written) {
+    BookEntry entries[MAX_MOVES];
+    uint32_t maxScore = 0;
+    int kept = 0;
+
+    for (int i = 0; i < count; i++) {
+        if (records[i].games >= builder->minGames && records[i].score > maxScore) maxScore = records[i].score;
+    }
+    for (int i = 0; i < count; i++) {
+        if (records[i].games < builder->minGames) continue;
+
+        uint32_t weight = records[i].score;
+        if (maxScore > 65535) weight = (uint32_t)((uint64_t)weight * 65535 / maxScore);
+        entries[kept++] = (BookEntry){ records[i].key, records[i].move, (uint16_t)weight, records[i].games };
+    }
+
+    qsort(entries, (size_t)kept, sizeof(BookEntry), CompareByWeight);
+    *written += (uint64_t)kept;
+    return fwrite(entries, sizeof(BookEntry), (size_t)kept, out) == (size_t)kept;
+}
+
+static bool MergeRuns(BookBuilder *builder, uint64_t *entryCount) {
+    MergeHeap heap = { 0 };
+    BookRecord group[MAX_MOVES];
+    int groupCount = 0;
+    bool ok = true;
+    char path[1100];
+
+    heap.heads = malloc(sizeof(BookRecord) * (size_t)builder->runCount);
+    heap.runs = calloc((size_t)builder->runCount, sizeof(FILE *));
+    heap.order = malloc(sizeof(int) * (size_t)builder->runCount);
+    FILE *out = fopen(builder->outPath, "wb");
+    if (!heap.heads || !heap.runs || !heap.order || !out) ok = false;
+
+    for (int run = 0; ok && run < builder->runCount; run++) {
+        RunPath(builder, run, path, sizeof(path));
+        heap.runs[run] = fopen(path, "rb");
+        if (!heap.runs[run]) {
+            ok = false;
+            break;
+        }
+        setvbuf(heap.runs[run], NULL, _IOFBF, MERGE_BUFFER_BYTES);
+        if (fread(&heap.heads[run], sizeof(BookRecord), 1, heap.runs[run]) == 1) heap.order[heap.size++] = run;
+    }
+    for (int i = heap.size / 2 - 1; i >= 0; i--) SiftDown(&heap, i);
+
+    // The count is known at the end; the header is written again then
+    BookHeader header = { BOOK_MAGIC, BOOK_VERSION, 0 };
+    *entryCount = 0;
+    if (ok) ok = fwrite(&header, sizeof(header), 1, out) == 1;
+
+    while (ok && heap.size > 0) {
+        int run = heap.order[0];
+        BookRecord record = heap.heads[run];
+
+        if (fread(&heap.heads[run], sizeof(BookRecord), 1, heap.runs[run]) != 1) heap.order[0] = heap.order[--heap.size];
+        SiftDown(&heap, 0);
+
+        // Runs were combined on their own; the same pair can still come from several
+        BookRecord *last = groupCount > 0 ? &group[groupCount - 1] : NULL;
+        if (last && last->key == record.key && last->move == record.move) {
+            last->score += record.score;
+            last->games += record.games;
+            continue;
+        }
+        if (last && (last->key != record.key || groupCount == MAX_MOVES)) {
+            ok = WritePosition(out, builder, group, groupCount, entryCount);
+            groupCount = 0;
+        }
+        group[groupCount++] = record;
+    }
+    if (ok && groupCount > 0) ok = WritePosition(out, builder, group, groupCount, entryCount);
+
+    header.entryCount = *entryCount;
+    if (ok) ok = fseek(out, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, out) == 1;
+    if (out && fclose(out) != 0) ok = false;
+
+    for (int run = 0; run < builder->runCount; run++) {
+        if (heap.runs && heap.runs[run]) fclose(heap.runs[run]);
+        RunPath(builder, run, path, sizeof(path));
+        remove(path);
+    }
+    free(heap.heads);
+    free(heap.runs);
+    free(heap.order);
+    return ok;
+}
+
+static int ShowBook(const char *path, const char *fen) {
+    Book book;
+    Position pos;
+    const BookEntry *entries;
+    char san[PGN_MAX_SAN];
+
+    if (!LoadBook(&book, path)) {
+        fprintf(stderr, "%s is missing or not a book of version %d\n", path, BOOK_VERSION);
+        return 1;
+    }
+    if (!PositionFromFen(&pos, fen)) {
+        fprintf(stderr, "bad FEN: %s\n", fen);
+        return 1;
+    }
+
+    size_t count = FindBookEntries(&book, pos.key, &entries);
+    printf("%llu entries, %llu for this position\n", (unsigned long long)book.count, (unsigned long long)count);
+    for (size_t i = 0; i < count; i++) {
+        if (IsMoveLegal(&pos, entries[i].move)) MoveToSan(&pos, entries[i].move, san);
+        else strcpy(san, "(illegal)");
+        printf("%-8s weight %5u  games %u\n", san, entries[i].weight, entries[i].games);
+    }
+    UnloadBook(&book);
+    return 0;
+}
+
+static void PrintUsage(void) {
+    fprintf(stderr, "usage: chess_book <games.pgn|games.bin> ... [--out FILE] [--plies N] [--min-games N] [--memory MB]\n");
+    fprintf(stderr, "       chess_book --show FILE [--fen FEN]\n");
+}
+
+int main(int argc, char **argv) {
+    BookBuilder builder = { 0 };
+    const char *inputs[256];
+    const char *showPath = NULL, *fen = START_FEN;
+    int inputCount = 0;
+    int memoryMb = 64;
+
+    builder.outPath = BOOK_DEFAULT_FILE;
+    builder.plies = 24;
+    builder.minGames = 2;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) builder.outPath = argv[++i];
+        else if (strcmp(argv[i], "--plies") == 0 && i + 1 < argc) builder.plies = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--min-games") == 0 && i + 1 < argc) builder.minGames = (uint32_t)atoi(argv[++i]);
+        else if (strcmp(argv[i], "--memory") == 0 && i + 1 < argc) memoryMb = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--show") == 0 && i + 1 < argc) showPath = argv[++i];
+        else if (strcmp(argv[i], "--fen") == 0 && i + 1 < argc) fen = argv[++i];
+        else if (argv[i][0] != '-' && inputCount < 256) inputs[inputCount++] = argv[i];
+        else {
+            PrintUsage();
+            return 2;
+        }
+    }
+
+    InitBitboards();
+    if (showPath) return ShowBook(showPath, fen);
+    if (inputCount == 0) {
+        PrintUsage();
+        return 2;
+    }
+    if (builder.plies <= 0) builder.plies = 24;
+    if (builder.plies > BOOK_MAX_PLIES) builder.plies = BOOK_MAX_PLIES;
+    if (memoryMb < 1) memoryMb = 1;
+
+    builder.capacity = (size_t)memoryMb * 1024 * 1024 / sizeof(BookRecord);
+    builder.records = malloc(builder.capacity * sizeof(BookRecord));
+    if (!builder.records) {
+        fprintf(stderr, "cannot allocate %d MB\n", memoryMb);
+        return 1;
+    }
+
+    int64_t start = GetMicroseconds();
+    for (int i = 0; i < inputCount; i++) {
+        MappedFile file;
+        PackedReader reader;
+
+        if (!MapFile(&file, inputs[i])) {
+            fprintf(stderr, "cannot read %s\n", inputs[i]);
+            return 1;
+        }
+        bool ok = InitPackedReader(&reader, file.data, file.size) ? AddPackedGames(&builder, &reader)
+                                                                   : AddPgnGames(&builder, &file);
+        UnmapFile(&file);
+        if (!ok) return 1;
+    }
+
+    uint64_t entryCount;
+    if (!FlushRun(&builder)) return 1;
+    free(builder.records);
+    if (!MergeRuns(&builder, &entryCount)) {
+        fprintf(stderr, "cannot write %s\n", builder.outPath);
+        return 1;
+    }
+
+    printf("%lld games (%lld skipped), %lld moves, %d runs: %llu entries in %s, %.2f s\n",
+           (long long)builder.games, (long long)builder.skipped, (long long)builder.moves, builder.runCount,
+           (unsigned long long)entryCount, builder.outPath, (GetMicroseconds() - start) / 1e6);
+    return 0;
+}
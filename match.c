@@ -0,0 +1,652 @@
+// chess_match: engine-versus-engine matches without a window, for telling
+// whether a change helps or costs playing strength.
+//
+//   chess_match [--games N] [--threads N] [--hash MB] [--nodes N] [--depth N]
+//               [--movetime MS] [--net FILE] [--tb DIR] [--openings FILE]
+//               [--random-plies N] [--seed N] [--max-plies N]
+//               [--draw-after N] [--draw-score CP] [--draw-plies N]
+//               [--resign-score CP] [--resign-plies N]
+//               [--sprt ELO0 ELO1] [--alpha A] [--beta B]
+//               [--out FILE] [--save FILE] [--report N]
+//
+// Two engines, A and B, play --games games (default 100). --nodes, --depth,
+// --movetime, --net and --tb set both; with -a or -b appended (--nodes-b
+// 40000, --net-a old.nnue) they set one engine only. Without limits each move
+// searches 20000 nodes. Every engine in every worker thread has its own hash
+// table of --hash MB (default 8).
+//
+// Games come in pairs from the same opening with colors swapped. Openings are
+// FEN or EPD lines, or a binary position file, from --openings, used in turn;
+// otherwise --random-plies random moves (default 8) from the start position,
+// drawn again while the static evaluation is out of balance.
+//
+// Besides the rules (mate, stalemate, repetition, the fifty-move rule,
+// insufficient material and --max-plies, default 400), games are adjudicated:
+// a loss once --resign-plies plies in a row (default 8) agree that one side is
+// down --resign-score (default 600) or more, and a draw once, from move
+// --draw-after (default 40), --draw-plies plies in a row (default 8) score
+// within --draw-score (default 10) of zero.
+//
+// One line per game goes to stdout or --out as games finish:
+//
+//   <game> <white> <black> <result> <reason> <plies> <opening>
+//
+// --save also writes the games in the binary game format. Progress every
+// --report games (default 100) and the summary go to stderr: score, Elo
+// difference with a 95% interval, likelihood of superiority, throughput, and
+// with --sprt the log-likelihood ratio of the test of ELO0 against ELO1 with
+// error rates --alpha and --beta (default 0.05). The match stops early once
+// the test accepts either hypothesis.
+
+#include "search.h"
+#include "packed.h"
+#include "ring.h"
+#include "random.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MATCH_MAX_WORKERS 64
+#define MATCH_QUEUE 16              // finished games per worker waiting for the main thread; power of two
+#define MATCH_MAX_PLIES 1000
+#define MATCH_DEFAULT_NODES 20000
+#define MATCH_BALANCE_CP 150        // random openings further from equal are drawn again
+#define MATCH_OPENING_TRIES 100
+
+#define ENGINE_A 0
+#define ENGINE_B 1
+
+#define REASON_MATE 0
+#define REASON_STALEMATE 1
+#define REASON_REPETITION 2
+#define REASON_FIFTY 3
+#define REASON_MATERIAL 4
+#define REASON_LENGTH 5
+#define REASON_RESIGN 6
+#define REASON_DRAW 7
+
+typedef struct MatchEngine {
+    SearchLimits limits;
+    const char *netPath;
+    const char *tbPath;
+    const Network *network;
+    Tablebases *tablebases;
+} MatchEngine;
+
+typedef struct MatchOptions {
+    MatchEngine engines[2];
+    int games;
+    size_t hashMb;
+    int randomPlies;
+    uint64_t seed;
+    Position *openings;             // from --openings, NULL for random ones
+    int openingCount;
+    int maxPlies;
+    int drawAfter, drawScore, drawPlies;
+    int resignScore, resignPlies;
+} MatchOptions;
+
+// State shared by the main thread and the workers
+typedef struct Match {
+    const MatchOptions *options;
+    volatile int64_t nextGame;      // taken by workers one at a time
+    volatile int stop;              // no new games once set
+} Match;
+
+typedef struct MatchResult {
+    int64_t game;
+    int white;                      // ENGINE_A or ENGINE_B
+    int result;                     // PACKED_RESULT_*
+    int reason;                     // REASON_*
+    int plies;
+    uint64_t nodes[2];              // by engine
+    int64_t searchUs[2];
+    Position start;
+    Move moves[MATCH_MAX_PLIES];
+} MatchResult;
+
+typedef struct MatchWorker {
+    RingQueue results;
+    MatchResult resultStorage[MATCH_QUEUE];
+    PlatformThread *thread;
+    PlatformSignal *progress;       // shared, set after every game
+    volatile int done;
+
+    Match *match;
+    Searcher *searchers[2];         // heap, they are large
+    TranspositionTable tt[2];
+    PawnTable pawns;
+    uint64_t keys[MATCH_MAX_PLIES + 1];
+    MatchResult result;
+} MatchWorker;
+
+static bool IsInsufficientMaterial(const Position *pos) {
+    const Bitboard (*p)[PIECE_TYPE_COUNT] = pos->pieces;
+    Bitboard heavy = p[SIDE_WHITE][PIECE_PAWN] | p[SIDE_BLACK][PIECE_PAWN]
+                   | p[SIDE_WHITE][PIECE_ROOK] | p[SIDE_BLACK][PIECE_ROOK]
+                   | p[SIDE_WHITE][PIECE_QUEEN] | p[SIDE_BLACK][PIECE_QUEEN];
+    Bitboard minors = p[SIDE_WHITE][PIECE_KNIGHT] | p[SIDE_BLACK][PIECE_KNIGHT]
+                    | p[SIDE_WHITE][PIECE_BISHOP] | p[SIDE_BLACK][PIECE_BISHOP];
+    return !heavy && !MoreThanOne(minors);
+}
+
+// Both games of a pair start here. Random openings depend only on the seed
+// and the pair, so a match replays the same way with any number of threads.
+static void PairOpening(MatchWorker *worker, int64_t pair, Position *pos) {
+    const MatchOptions *options = worker->match->options;
+    uint64_t random = (options->seed + (uint64_t)pair) * 0x9E3779B97F4A7C15ULL | 1;
+
+    if (options->openingCount > 0) {
+        *pos = options->openings[pair % options->openingCount];
+        return;
+    }
+
+    for (int tries = 0; tries < MATCH_OPENING_TRIES; tries++) {
+        MoveList list;
+        UndoInfo undo;
+        bool playable = true;
+
+        PositionFromFen(pos, START_FEN);
+        for (int ply = 0; ply < options->randomPlies && playable; ply++) {
+            GenerateLegalMoves(pos, &list);
+            playable = list.count > 0;
+            if (playable) MakeMove(pos, list.moves[NextRandom(&random) % (uint64_t)list.count], &undo);
+        }
+
+        GenerateLegalMoves(pos, &list);
+        if (playable && list.count > 0 && abs(Evaluate(pos, &worker->pawns)) <= MATCH_BALANCE_CP) return;
+    }
+}
+
+static int CountRepetitions(const uint64_t *keys, int count, const Position *pos) {
+    int repetitions = 0;
+    for (int i = count - 2; i >= 0 && i >= count - pos->halfmoveClock; i -= 2) {
+        if (keys[i] == pos->key) repetitions++;
+    }
+    return repetitions;
+}
+
+// REASON_* once the rules end the game, else -1. Only mate has a winner.
+static int RulesOutcome(const Position *pos, const uint64_t *keys, int plies, int maxPlies) {
+    MoveList list;
+
+    GenerateLegalMoves(pos, &list);
+    if (list.count == 0) return InCheck(pos) ? REASON_MATE : REASON_STALEMATE;
+    if (CountRepetitions(keys, plies, pos) >= 2) return REASON_REPETITION;
+    if (pos->halfmoveClock >= 100) return REASON_FIFTY;
+    if (IsInsufficientMaterial(pos)) return REASON_MATERIAL;
+    if (plies >= maxPlies) return REASON_LENGTH;
+    return -1;
+}
+
+static void EndGame(MatchResult *result, int winner, int reason) {
+    result->result = winner == SIDE_WHITE ? PACKED_RESULT_WHITE : winner == SIDE_BLACK ? PACKED_RESULT_BLACK : PACKED_RESULT_DRAW;
+    result->reason = reason;
+}
+
+static void PlayGame(MatchWorker *worker, MatchResult *result) {
+    const MatchOptions *options = worker->match->options;
+    Position pos = result->start;
+    int resignStreak = 0, resignWinner = SIDE_BOTH, drawStreak = 0;
+
+    // Each game starts from fresh tables; the engine's table, network and
+    // tablebases outlive the reset
+    for (int e = 0; e < 2; e++) {
+        Searcher *searcher = worker->searchers[e];
+        TranspositionTable *tt = searcher->tt;
+        const Network *network = searcher->network;
+        Tablebases *tablebases = searcher->tablebases;
+
+        InitSearcher(searcher);
+        searcher->tt = tt;
+        searcher->network = network;
+        searcher->tablebases = tablebases;
+        if (tt) TTClear(tt);
+    }
+
+    for (result->plies = 0;; result->plies++) {
+        SearchInfo info;
+        UndoInfo undo;
+
+        int reason = RulesOutcome(&pos, worker->keys, result->plies, options->maxPlies);
+        if (reason >= 0) {
+            EndGame(result, reason == REASON_MATE ? pos.sideToMove ^ 1 : SIDE_BOTH, reason);
+            return;
+        }
+
+        int engine = pos.sideToMove == SIDE_WHITE ? result->white : result->white ^ 1;
+        Searcher *searcher = worker->searchers[engine];
+        int count = result->plies < MAX_HISTORY ? result->plies : MAX_HISTORY;
+
+        SetSearchHistory(searcher, worker->keys + result->plies - count, count);
+        int64_t start = GetMicroseconds();
+        Move move = Search(searcher, &pos, &options->engines[engine].limits, &info);
+        result->searchUs[engine] += GetMicroseconds() - start;
+        result->nodes[engine] += info.nodes;
+
+        // Adjudication trusts the engines' scores, from the side to move's point of view
+        int winner = info.score >= options->resignScore ? pos.sideToMove
+                   : info.score <= -options->resignScore ? pos.sideToMove ^ 1 : SIDE_BOTH;
+        if (winner == SIDE_BOTH) resignStreak = 0;
+        else resignStreak = winner == resignWinner ? resignStreak + 1 : 1;
+        resignWinner = winner;
+        bool quiet = result->plies >= 2 * options->drawAfter && abs(info.score) <= options->drawScore;
+        drawStreak = quiet ? drawStreak + 1 : 0;
+
+        worker->keys[result->plies] = pos.key;
+        result->moves[result->plies] = move;
+        MakeMove(&pos, move, &undo);
+
+        if (options->resignPlies > 0 && resignStreak >= options->resignPlies) {
+            EndGame(result, resignWinner, REASON_RESIGN);
+            result->plies++;
+            return;
+        }
+        if (options->drawPlies > 0 && drawStreak >= options->drawPlies) {
+            EndGame(result, SIDE_BOTH, REASON_DRAW);
+            result->plies++;
+            return;
+        }
+    }
+}
+
+static void WorkerMain(void *arg) {
+    MatchWorker *worker = arg;
+    Match *match = worker->match;
+
+    while (!AtomicLoad(&match->stop)) {
+        int64_t game = AtomicAdd64(&match->nextGame, 1) - 1;
+        if (game >= match->options->games) break;
+
+        MatchResult *result = &worker->result;
+        memset(result, 0, offsetof(MatchResult, moves));
+        result->game = game;
+        result->white = (int)(game & 1);
+        PairOpening(worker, game / 2, &result->start);
+        PlayGame(worker, result);
+
+        while (!RingPush(&worker->results, result)) SleepMilliseconds(1);
+        SetSignal(worker->progress);
+    }
+
+    AtomicStore(&worker->done, 1);
+    SetSignal(worker->progress);
+}
+
+static bool StartWorker(MatchWorker *worker, Match *match, PlatformSignal *progress) {
+    const MatchOptions *options = match->options;
+
+    memset(worker, 0, sizeof(*worker));
+    InitRing(&worker->results, worker->resultStorage, sizeof(MatchResult), MATCH_QUEUE);
+    worker->match = match;
+    worker->progress = progress;
+    ClearPawnTable(&worker->pawns);
+
+    for (int e = 0; e < 2; e++) {
+        worker->searchers[e] = malloc(sizeof(Searcher));
+        if (!worker->searchers[e] || !TTInit(&worker->tt[e], options->hashMb)) return false;
+        InitSearcher(worker->searchers[e]);
+        worker->searchers[e]->tt = &worker->tt[e];
+        worker->searchers[e]->network = options->engines[e].network;
+        worker->searchers[e]->tablebases = options->engines[e].tablebases;
+    }
+
+    worker->thread = StartThread(WorkerMain, worker);
+    return worker->thread != NULL;
+}
+
+static void StopWorker(MatchWorker *worker) {
+    if (worker->thread) JoinThread(worker->thread);
+    for (int e = 0; e < 2; e++) {
+        TTFree(&worker->tt[e]);
+        free(worker->searchers[e]);
+    }
+}
+
+// One FEN or EPD position per line, or a binary position file
+static int LoadOpenings(const char *path, Position **openings) {
+    MappedFile file;
+    PackedReader reader;
+    int count = 0, capacity = 0;
+
+    if (!MapFile(&file, path)) return 0;
+
+    bool packed = InitPackedReader(&reader, file.data, file.size);
+    const char *text = (const char *)file.data, *end = text + file.size;
+    for (;;) {
+        Position pos;
+        bool valid;
+
+        if (packed) {
+            const PackedPosition *next = NextPackedPosition(&reader);
+            if (!next) break;
+            valid = UnpackPosition(next, &pos);
+        } else {
+            char line[256];
+            const char *newline = memchr(text, '\n', (size_t)(end - text));
+            size_t length = (size_t)((newline ? newline : end) - text);
+
+            if (text >= end) break;
+            snprintf(line, sizeof(line), "%.*s", (int)(length < sizeof(line) ? length : sizeof(line) - 1), text);
+            text += length + 1;
+            valid = PositionFromFen(&pos, line);
+        }
+
+        if (!valid) continue;
+        if (count == capacity) {
+            capacity = capacity ? capacity * 2 : 256;
+            Position *grown = realloc(*openings, sizeof(Position) * (size_t)capacity);
+            if (!grown) break;
+            *openings = grown;
+        }
+        (*openings)[count++] = pos;
+    }
+
+    UnmapFile(&file);
+    return count;
+}
+
+// Wins, draws and losses of engine A
+typedef struct MatchScore {
+    int64_t wins, draws, losses;
+} MatchScore;
+
+static double EloFromScore(double score) {
+    if (score <= 0.0) score = 1e-6;
+    if (score >= 1.0) score = 1.0 - 1e-6;
+    return -400.0 * log10(1.0 / score - 1.0);
+}
+
+static double ScoreFromElo(double elo) {
+    return 1.0 / (1.0 + pow(10.0, -elo / 400.0));
+}
+
+// Mean score per game and its variance, from the trinomial distribution
+static double ScoreMean(const MatchScore *score, double *variance) {
+    double n = (double)(score->wins + score->draws + score->losses);
+    double mean = (score->wins + score->draws * 0.5) / n;
+
+    *variance = (score->wins * (1.0 - mean) * (1.0 - mean) + score->draws * (0.5 - mean) * (0.5 - mean)
+                 + score->losses * mean * mean) / n;
+    return mean;
+}
+
+// Log-likelihood ratio of elo1 against elo0, in the normal approximation
+static double SprtLlr(const MatchScore *score, double elo0, double elo1) {
+    double variance, n = (double)(score->wins + score->draws + score->losses);
+    double mean = ScoreMean(score, &variance);
+    double s0 = ScoreFromElo(elo0), s1 = ScoreFromElo(elo1);
+
+    if (variance <= 0.0) return 0.0;
+    return n * (s1 - s0) * (2.0 * mean - s0 - s1) / (2.0 * variance);
+}
+
+static void PrintScore(const MatchScore *score) {
+    int64_t n = score->wins + score->draws + score->losses;
+    double variance;
+    double mean = ScoreMean(score, &variance);
+    double error = 1.96 * sqrt(variance / (double)n);
+    int64_t decisive = score->wins + score->losses;
+    double los = decisive ? 0.5 * (1.0 + erf((double)(score->wins - score->losses) / sqrt(2.0 * (double)decisive))) : 0.5;
+
+    fprintf(stderr, "%lld games: +%lld =%lld -%lld, score %.1f%%, Elo %+.1f [%+.1f, %+.1f], LOS %.1f%%\n", (long long)n,
+            (long long)score->wins, (long long)score->draws, (long long)score->losses, mean * 100.0, EloFromScore(mean),
+            EloFromScore(mean - error), EloFromScore(mean + error), los * 100.0);
+}
+
+static const char *ResultText(int result) {
+    return result == PACKED_RESULT_WHITE ? "1-0" : result == PACKED_RESULT_BLACK ? "0-1" : "1/2-1/2";
+}
+
+static const char *ReasonText(int reason) {
+    static const char *texts[] = { "mate", "stalemate", "repetition", "fifty", "material", "length", "resign", "draw" };
+    return texts[reason];
+}
+
+// "--nodes" names both engines, "--nodes-a" and "--nodes-b" one of them
+static bool EngineOption(const char *arg, const char *name, int *first, int *last) {
+    size_t length = strlen(name);
+
+    if (strncmp(arg, name, length) != 0) return false;
+    if (arg[length] == '\0') *first = ENGINE_A, *last = ENGINE_B;
+    else if (strcmp(arg + length, "-a") == 0) *first = *last = ENGINE_A;
+    else if (strcmp(arg + length, "-b") == 0) *first = *last = ENGINE_B;
+    else return false;
+    return true;
+}
+
+// Networks and tablebases are loaded once per file and shared by every thread
+static bool LoadEngineFiles(MatchOptions *options, Network networks[2], Tablebases tablebases[2]) {
+    for (int e = 0; e < 2; e++) {
+        MatchEngine *engine = &options->engines[e];
+        MatchEngine *other = &options->engines[ENGINE_A];
+
+        if (engine->netPath) {
+            if (e == ENGINE_B && other->netPath && strcmp(other->netPath, engine->netPath) == 0) {
+                engine->network = other->network;
+            } else if (LoadNetwork(&networks[e], engine->netPath)) {
+                engine->network = &networks[e];
+            } else {
+                fprintf(stderr, "%s is not a usable network\n", engine->netPath);
+                return false;
+            }
+        }
+        if (engine->tbPath) {
+            if (e == ENGINE_B && other->tbPath && strcmp(other->tbPath, engine->tbPath) == 0) {
+                engine->tablebases = other->tablebases;
+            } else if (LoadTablebases(&tablebases[e], engine->tbPath, TB_DEFAULT_CACHE_MB)) {
+                engine->tablebases = &tablebases[e];
+            } else {
+                fprintf(stderr, "no tablebases in %s\n", engine->tbPath);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static void PrintUsage(void) {
+    fprintf(stderr, "usage: chess_match [--games N] [--threads N] [--hash MB] [--nodes N] [--depth N] [--movetime MS]\n"
+                    "                   [--net FILE] [--tb DIR] [--openings FILE] [--random-plies N] [--seed N]\n"
+                    "                   [--max-plies N] [--draw-after N] [--draw-score CP] [--draw-plies N]\n"
+                    "                   [--resign-score CP] [--resign-plies N] [--sprt ELO0 ELO1] [--alpha A] [--beta B]\n"
+                    "                   [--out FILE] [--save FILE] [--report N]\n"
+                    "engine options also take -a or -b, e.g. --nodes-b 40000, to set one engine only\n");
+}
+
+int main(int argc, char **argv) {
+    static MatchWorker workers[MATCH_MAX_WORKERS];
+    static MatchResult result;
+    static Network networks[2];
+    static Tablebases tablebases[2];
+    MatchOptions options;
+    Match match;
+    const char *openingPath = NULL, *outPath = NULL, *savePath = NULL;
+    int threads = 0, report = 100;
+    bool sprt = false;
+    double elo0 = 0.0, elo1 = 5.0, alpha = 0.05, beta = 0.05;
+    FILE *out = stdout, *save = NULL;
+
+    memset(&options, 0, sizeof(options));
+    options.games = 100;
+    options.hashMb = 8;
+    options.randomPlies = 8;
+    options.seed = 1;
+    options.maxPlies = 400;
+    options.drawAfter = 40;
+    options.drawScore = 10;
+    options.drawPlies = 8;
+    options.resignScore = 600;
+    options.resignPlies = 8;
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+        int first, last;
+
+        if (!value) {
+            PrintUsage();
+            return 2;
+        }
+        if (EngineOption(arg, "--nodes", &first, &last)) {
+            for (int e = first; e <= last; e++) options.engines[e].limits.nodes = strtoull(value, NULL, 10);
+        } else if (EngineOption(arg, "--depth", &first, &last)) {
+            for (int e = first; e <= last; e++) options.engines[e].limits.depth = atoi(value);
+        } else if (EngineOption(arg, "--movetime", &first, &last)) {
+            for (int e = first; e <= last; e++) options.engines[e].limits.timeMs = atoll(value);
+        } else if (EngineOption(arg, "--net", &first, &last)) {
+            for (int e = first; e <= last; e++) options.engines[e].netPath = value;
+        } else if (EngineOption(arg, "--tb", &first, &last)) {
+            for (int e = first; e <= last; e++) options.engines[e].tbPath = value;
+        } else if (strcmp(arg, "--sprt") == 0 && i + 2 < argc) {
+            sprt = true;
+            elo0 = atof(argv[++i]);
+            elo1 = atof(argv[i + 1]);
+        } else if (strcmp(arg, "--games") == 0) options.games = atoi(value);
+        else if (strcmp(arg, "--threads") == 0) threads = atoi(value);
+        else if (strcmp(arg, "--hash") == 0) options.hashMb = (size_t)atoi(value);
+        else if (strcmp(arg, "--openings") == 0) openingPath = value;
+        else if (strcmp(arg, "--random-plies") == 0) options.randomPlies = atoi(value);
+        else if (strcmp(arg, "--seed") == 0) options.seed = strtoull(value, NULL, 10);
+        else if (strcmp(arg, "--max-plies") == 0) options.maxPlies = atoi(value);
+        else if (strcmp(arg, "--draw-after") == 0) options.drawAfter = atoi(value);
+        else if (strcmp(arg, "--draw-score") == 0) options.drawScore = atoi(value);
+        else if (strcmp(arg, "--draw-plies") == 0) options.drawPlies = atoi(value);
+        else if (strcmp(arg, "--resign-score") == 0) options.resignScore = atoi(value);
+        else if (strcmp(arg, "--resign-plies") == 0) options.resignPlies = atoi(value);
+        else if (strcmp(arg, "--alpha") == 0) alpha = atof(value);
+        else if (strcmp(arg, "--beta") == 0) beta = atof(value);
+        else if (strcmp(arg, "--out") == 0) outPath = value;
+        else if (strcmp(arg, "--save") == 0) savePath = value;
+        else if (strcmp(arg, "--report") == 0) report = atoi(value);
+        else {
+            PrintUsage();
+            return 2;
+        }
+        i++;
+    }
+
+    for (int e = 0; e < 2; e++) {
+        SearchLimits *limits = &options.engines[e].limits;
+        if (!limits->nodes && !limits->depth && !limits->timeMs) limits->nodes = MATCH_DEFAULT_NODES;
+    }
+    if (options.games < 1) options.games = 1;
+    if (options.hashMb < 1) options.hashMb = 1;
+    if (options.maxPlies < 1 || options.maxPlies > MATCH_MAX_PLIES) options.maxPlies = MATCH_MAX_PLIES;
+    if (report < 1) report = options.games;
+    if (alpha <= 0.0 || alpha >= 1.0) alpha = 0.05;
+    if (beta <= 0.0 || beta >= 1.0) beta = 0.05;
+
+    InitBitboards();
+    if (!LoadEngineFiles(&options, networks, tablebases)) return 1;
+    if (openingPath && (options.openingCount = LoadOpenings(openingPath, &options.openings)) == 0) {
+        fprintf(stderr, "no openings in %s\n", openingPath);
+        return 1;
+    }
+    if (outPath && !(out = fopen(outPath, "w"))) {
+        fprintf(stderr, "cannot write %s\n", outPath);
+        return 1;
+    }
+    if (savePath && (!(save = fopen(savePath, "wb")) || !WritePackedHeader(save, PACKED_KIND_GAMES))) {
+        fprintf(stderr, "cannot write %s\n", savePath);
+        return 1;
+    }
+
+    if (threads <= 0) threads = GetProcessorCount();
+    if (threads > MATCH_MAX_WORKERS) threads = MATCH_MAX_WORKERS;
+    if (threads > options.games) threads = options.games;
+    match.options = &options;
+    match.nextGame = 0;
+    match.stop = 0;
+    PlatformSignal *progress = CreateSignal();
+    int workerCount = 0;
+    while (progress && workerCount < threads && StartWorker(&workers[workerCount], &match, progress)) workerCount++;
+    if (workerCount == 0) {
+        fprintf(stderr, "cannot start worker threads\n");
+        return 1;
+    }
+
+    double lower = log(beta / (1.0 - alpha)), upper = log((1.0 - beta) / alpha);
+    MatchScore score = { 0, 0, 0 };
+    uint64_t nodes[2] = { 0, 0 };
+    int64_t searchUs[2] = { 0, 0 }, plies = 0, finished = 0;
+    int64_t start = GetMicroseconds();
+    int reasons[REASON_DRAW + 1] = { 0 };
+    const char *verdict = NULL;
+
+    for (;;) {
+        bool progressed = false, running = false;
+
+        for (int i = 0; i < workerCount; i++) {
+            MatchWorker *worker = &workers[i];
+            bool done = AtomicLoad(&worker->done) != 0;
+
+            while (RingPop(&worker->results, &result)) {
+                int white = result.white, black = white ^ 1;
+                int scoreA = result.result == PACKED_RESULT_DRAW ? 1 : (result.result == PACKED_RESULT_WHITE) == (white == ENGINE_A) ? 2 : 0;
+
+                fprintf(out, "%lld %c %c %s %s %d %lld\n", (long long)result.game, 'A' + white, 'A' + black,
+                        ResultText(result.result), ReasonText(result.reason), result.plies, (long long)(result.game / 2));
+                if (save) WritePackedGame(save, &result.start, result.moves, result.plies, result.result);
+
+                if (scoreA == 2) score.wins++;
+                else if (scoreA == 1) score.draws++;
+                else score.losses++;
+                for (int e = 0; e < 2; e++) {
+                    nodes[e] += result.nodes[e];
+                    searchUs[e] += result.searchUs[e];
+                }
+                plies += result.plies;
+                reasons[result.reason]++;
+                finished++;
+                progressed = true;
+
+                if (finished % report == 0) PrintScore(&score);
+                if (sprt && !verdict) {
+                    double llr = SprtLlr(&score, elo0, elo1);
+                    if (llr <= lower) verdict = "H0 accepted";
+                    else if (llr >= upper) verdict = "H1 accepted";
+                    if (verdict) AtomicStore(&match.stop, 1);
+                }
+            }
+            if (!done) running = true;
+        }
+
+        if (!running) break;
+        if (!progressed) WaitSignal(progress);
+    }
+
+    for (int i = 0; i < workerCount; i++) StopWorker(&workers[i]);
+    DestroySignal(progress);
+    if (out != stdout) fclose(out);
+    if (save && fclose(save) != 0) fprintf(stderr, "cannot write %s\n", savePath);
+
+    double seconds = (GetMicroseconds() - start) / 1e6;
+    if (seconds <= 0.0) seconds = 1e-6;
+    fprintf(stderr, "\n");
+    PrintScore(&score);
+    fprintf(stderr, "ends:");
+    for (int r = 0; r <= REASON_DRAW; r++) {
+        if (reasons[r]) fprintf(stderr, " %s %d", ReasonText(r), reasons[r]);
+    }
+    fprintf(stderr, "\n");
+    if (sprt) {
+        fprintf(stderr, "SPRT Elo %.1f vs %.1f, alpha %.2f, beta %.2f: LLR %.2f [%.2f, %.2f], %s\n", elo0, elo1, alpha,
+                beta, SprtLlr(&score, elo0, elo1), lower, upper, verdict ? verdict : "no decision yet");
+    }
+    fprintf(stderr, "%.1f s, %d threads: %.0f games/hour, %.1f plies/game\n", seconds, workerCount,
+            finished * 3600.0 / seconds, finished ? (double)plies / (double)finished : 0.0);
+    for (int e = 0; e < 2; e++) {
+        fprintf(stderr, "engine %c: %llu nodes, %.0f nps per thread\n", 'A' + e, (unsigned long long)nodes[e],
+                searchUs[e] > 0 ? nodes[e] * 1e6 / (double)searchUs[e] : 0.0);
+    }
+
+    for (int e = 0; e < 2; e++) {
+        if (options.engines[e].network == &networks[e]) UnloadNetwork(&networks[e]);
+        if (options.engines[e].tablebases == &tablebases[e]) UnloadTablebases(&tablebases[e]);
+    }
+    free(options.openings);
+    return 0;
+}
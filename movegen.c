@@ -0,0 +1,195 @@
+#include "movegen.h"
+
+#include <string.h>
+
+static inline void AddMove(MoveList *list, int from, int to, int flags) {
+    list->moves[list->count++] = MAKE_MOVE(from, to, flags);
+}
+
+static inline void AddPromotions(MoveList *list, int from, int to, int baseFlags) {
+    for (int promo = 3; promo >= 0; promo--) {
+        AddMove(list, from, to, baseFlags + promo);
+    }
+}
+
+// Adds one move per set bit in targets, capture flag taken from the destination
+static inline void AddTargets(const Position *pos, MoveList *list, int from, Bitboard targets) {
+    Bitboard enemies = pos->occupancy[pos->sideToMove ^ 1];
+
+    while (targets) {
+        int to = PopLsb(&targets);
+        AddMove(list, from, to, (enemies & BB(to)) ? MOVE_CAPTURE : MOVE_QUIET);
+    }
+}
+
+// Pawns that are pinned may only move along the line through their king
+static inline bool PawnMoveAllowed(const Position *pos, int king, int from, int to) {
+    return !(pos->pinned & BB(from)) || (lineBB[king][from] & BB(to));
+}
+
+static void GeneratePawnMoves(const Position *pos, MoveList *list, Bitboard target, int type) {
+    int us = pos->sideToMove;
+    int king = KingSquare(pos, us);
+    Bitboard pawns = pos->pieces[us][PIECE_PAWN];
+    Bitboard empty = ~pos->occupancy[SIDE_BOTH];
+    Bitboard enemies = pos->occupancy[us ^ 1];
+    Bitboard promotionRank = us == SIDE_WHITE ? RANK_8_BB : RANK_1_BB;
+    Bitboard doubleRank = us == SIDE_WHITE ? RANK_3_BB : RANK_6_BB;
+    int forward = us == SIDE_WHITE ? 8 : -8;
+    int leftDelta = us == SIDE_WHITE ? 7 : -9;
+    int rightDelta = us == SIDE_WHITE ? 9 : -7;
+
+    Bitboard single = (us == SIDE_WHITE ? pawns << 8 : pawns >> 8) & empty;
+    Bitboard dbl = (us == SIDE_WHITE ? (single & doubleRank) << 8 : (single & doubleRank) >> 8) & empty & target;
+    Bitboard left = (us == SIDE_WHITE ? (pawns & ~FILE_A_BB) << 7 : (pawns & ~FILE_A_BB) >> 9) & enemies & target;
+    Bitboard right = (us == SIDE_WHITE ? (pawns & ~FILE_H_BB) << 9 : (pawns & ~FILE_H_BB) >> 7) & enemies & target;
+    Bitboard b;
+
+    single &= target;
+
+    // Promotions count as tactical moves, so they are generated for both types
+    b = single & promotionRank;
+    while (b) {
+        int to = PopLsb(&b);
+        if (PawnMoveAllowed(pos, king, to - forward, to)) AddPromotions(list, to - forward, to, MOVE_PROMOTION);
+    }
+
+    if (type == GEN_ALL) {
+        b = single & ~promotionRank;
+        while (b) {
+            int to = PopLsb(&b);
+            if (PawnMoveAllowed(pos, king, to - forward, to)) AddMove(list, to - forward, to, MOVE_QUIET);
+        }
+        while (dbl) {
+            int to = PopLsb(&dbl);
+            if (PawnMoveAllowed(pos, king, to - 2 * forward, to)) AddMove(list, to - 2 * forward, to, MOVE_DOUBLE_PUSH);
+        }
+    }
+
+    while (left) {
+        int to = PopLsb(&left);
+        if (!PawnMoveAllowed(pos, king, to - leftDelta, to)) continue;
+        if (BB(to) & promotionRank) AddPromotions(list, to - leftDelta, to, MOVE_PROMOTION_CAPTURE);
+        else AddMove(list, to - leftDelta, to, MOVE_CAPTURE);
+    }
+    while (right) {
+        int to = PopLsb(&right);
+        if (!PawnMoveAllowed(pos, king, to - rightDelta, to)) continue;
+        if (BB(to) & promotionRank) AddPromotions(list, to - rightDelta, to, MOVE_PROMOTION_CAPTURE);
+        else AddMove(list, to - rightDelta, to, MOVE_CAPTURE);
+    }
+
+    if (pos->epSquare != SQ_NONE) {
+        int captured = us == SIDE_WHITE ? pos->epSquare - 8 : pos->epSquare + 8;
+
+        b = pawnAttacks[us ^ 1][pos->epSquare] & pawns;
+        while (b) {
+            int from = PopLsb(&b);
+
+            // Two pawns leave the rank at once, so test the king directly
+            // instead of relying on the pin mask
+            Bitboard occupied = (pos->occupancy[SIDE_BOTH] ^ BB(from) ^ BB(captured)) | BB(pos->epSquare);
+            Bitboard attackers = AttackersTo(pos, king, occupied) & pos->occupancy[us ^ 1] & ~BB(captured);
+            if (!attackers) AddMove(list, from, pos->epSquare, MOVE_EP_CAPTURE);
+        }
+    }
+}
+
+static void GenerateCastling(const Position *pos, MoveList *list) {
+    int us = pos->sideToMove;
+    Bitboard occupied = pos->occupancy[SIDE_BOTH];
+    int kingRights = us == SIDE_WHITE ? CASTLE_WHITE_KING : CASTLE_BLACK_KING;
+    int queenRights = us == SIDE_WHITE ? CASTLE_WHITE_QUEEN : CASTLE_BLACK_QUEEN;
+    int king = us == SIDE_WHITE ? SQ_E1 : SQ_E8;
+    Bitboard rooks = pos->pieces[us][PIECE_ROOK];
+
+    // The rights are not trusted alone: castling without the king and rook at
+    // home would move pieces that are not there
+    if (!(pos->pieces[us][PIECE_KING] & BB(king))) return;
+
+    if ((pos->castling & kingRights) && (rooks & BB(king + 3)) && !(occupied & (BB(king + 1) | BB(king + 2)))
+        && !(pos->threats & (BB(king + 1) | BB(king + 2)))) {
+        AddMove(list, king, king + 2, MOVE_KING_CASTLE);
+    }
+
+    if ((pos->castling & queenRights) && (rooks & BB(king - 4)) && !(occupied & (BB(king - 1) | BB(king - 2) | BB(king - 3)))
+        && !(pos->threats & (BB(king - 1) | BB(king - 2)))) {
+        AddMove(list, king, king - 2, MOVE_QUEEN_CASTLE);
+    }
+}
+
+void GenerateMoves(const Position *pos, MoveList *list, int type) {
+    int us = pos->sideToMove;
+    int king = KingSquare(pos, us);
+    Bitboard occupied = pos->occupancy[SIDE_BOTH];
+    Bitboard enemies = pos->occupancy[us ^ 1];
+    Bitboard notOwn = ~pos->occupancy[us];
+    Bitboard b;
+
+    list->count = 0;
+
+    Bitboard kingTargets = kingAttacks[king] & notOwn & ~pos->threats;
+    if (type == GEN_CAPTURES) kingTargets &= enemies;
+    AddTargets(pos, list, king, kingTargets);
+
+    // In double check only the king can move
+    if (MoreThanOne(pos->checkers)) return;
+
+    // In single check the other pieces must capture the checker or block
+    Bitboard target = pos->checkers ? betweenBB[king][Lsb(pos->checkers)] | pos->checkers : ~0ULL;
+
+    GeneratePawnMoves(pos, list, target, type);
+
+    target &= type == GEN_CAPTURES ? enemies : notOwn;
+
+    // Pinned knights can never move
+    b = pos->pieces[us][PIECE_KNIGHT] & ~pos->pinned;
+    while (b) {
+        int from = PopLsb(&b);
+        AddTargets(pos, list, from, knightAttacks[from] & target);
+    }
+
+    b = pos->pieces[us][PIECE_BISHOP] | pos->pieces[us][PIECE_QUEEN];
+    while (b) {
+        int from = PopLsb(&b);
+        Bitboard moves = BishopAttacks(from, occupied) & target;
+        if (pos->pinned & BB(from)) moves &= lineBB[king][from];
+        AddTargets(pos, list, from, moves);
+    }
+
+    b = pos->pieces[us][PIECE_ROOK] | pos->pieces[us][PIECE_QUEEN];
+    while (b) {
+        int from = PopLsb(&b);
+        Bitboard moves = RookAttacks(from, occupied) & target;
+        if (pos->pinned & BB(from)) moves &= lineBB[king][from];
+        AddTargets(pos, list, from, moves);
+    }
+
+    if (type == GEN_ALL && !pos->checkers) GenerateCastling(pos, list);
+}
+
+Move ParseMove(const Position *pos, const char *text) {
+    MoveList list;
+    char buffer[6];
+
+    GenerateLegalMoves(pos, &list);
+    for (int i = 0; i < list.count; i++) {
+        MoveToString(list.moves[i], buffer);
+        size_t length = strlen(buffer);
+        if (strncmp(text, buffer, length) == 0 && (unsigned char)text[length] <= ' ') {
+            return list.moves[i];
+        }
+    }
+    return MOVE_NONE;
+}
+
+bool IsMoveLegal(const Position *pos, Move move) {
+    MoveList list;
+
+    if (move == MOVE_NONE) return false;
+    GenerateLegalMoves(pos, &list);
+    for (int i = 0; i < list.count; i++) {
+        if (list.moves[i] == move) return true;
+    }
+    return false;
+}
@@ -0,0 +1,29 @@
+#ifndef MOVEGEN_H
+#define MOVEGEN_H
+
+#include "position.h"
+
+#define MAX_MOVES 256
+
+typedef struct MoveList {
+    Move moves[MAX_MOVES];
+    int count;
+} MoveList;
+
+#define GEN_ALL 0
+#define GEN_CAPTURES 1   // captures and promotions, for quiescence search
+
+// Fully legal moves, using the check and pin masks kept in the position
+void GenerateMoves(const Position *pos, MoveList *list, int type);
+
+static inline void GenerateLegalMoves(const Position *pos, MoveList *list) {
+    GenerateMoves(pos, list, GEN_ALL);
+}
+
+// Finds the legal move written in UCI notation, MOVE_NONE if there is none
+Move ParseMove(const Position *pos, const char *text);
+
+// True if move, with its flags, is one of the legal moves; for moves from files
+bool IsMoveLegal(const Position *pos, Move move);
+
+#endif
@@ -0,0 +1,281 @@
+#include "nnue.h"
+
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define NNUE_X86 1
+#include <immintrin.h>
+#else
+#define NNUE_X86 0
+#endif
+
+// GCC and Clang compile each kernel for its own instruction set, so the build
+// needs no -mavx2; MSVC accepts the intrinsics anywhere
+#if defined(__GNUC__)
+#define NNUE_TARGET(isa) __attribute__((target(isa)))
+#else
+#define NNUE_TARGET(isa)
+#endif
+
+#define MAX_REFRESH_ROWS 32         // every piece on the board
+
+typedef void (*UpdateKernel)(int16_t *out, const int16_t *in, const int16_t *const *added, int addedCount,
+                             const int16_t *const *removed, int removedCount);
+typedef int32_t (*OutputKernel)(const int16_t *us, const int16_t *them, const int16_t *weights, int qa);
+
+static UpdateKernel updateKernel;
+static OutputKernel outputKernel;
+static int simdLevel = -1;
+
+// Scalar kernels, also the reference the vector ones must match exactly.
+// Sums wrap at 16 bits like the vector adds do.
+static void UpdateScalar(int16_t *out, const int16_t *in, const int16_t *const *added, int addedCount,
+                         const int16_t *const *removed, int removedCount) {
+    for (int i = 0; i < NNUE_HIDDEN; i++) {
+        int value = in[i];
+        for (int a = 0; a < addedCount; a++) value += added[a][i];
+        for (int r = 0; r < removedCount; r++) value -= removed[r][i];
+        out[i] = (int16_t)value;
+    }
+}
+
+static int32_t OutputScalar(const int16_t *us, const int16_t *them, const int16_t *weights, int qa) {
+    int32_t sum = 0;
+
+    for (int i = 0; i < NNUE_HIDDEN; i++) {
+        int a = us[i] < 0 ? 0 : us[i] > qa ? qa : us[i];
+        int b = them[i] < 0 ? 0 : them[i] > qa ? qa : them[i];
+        sum += a * weights[i] + b * weights[NNUE_HIDDEN + i];
+    }
+    return sum;
+}
+
+#if NNUE_X86
+NNUE_TARGET("sse4.1")
+static void UpdateSse41(int16_t *out, const int16_t *in, const int16_t *const *added, int addedCount,
+                        const int16_t *const *removed, int removedCount) {
+    for (int i = 0; i < NNUE_HIDDEN; i += 8) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(in + i));
+        for (int a = 0; a < addedCount; a++) v = _mm_add_epi16(v, _mm_loadu_si128((const __m128i *)(added[a] + i)));
+        for (int r = 0; r < removedCount; r++) v = _mm_sub_epi16(v, _mm_loadu_si128((const __m128i *)(removed[r] + i)));
+        _mm_storeu_si128((__m128i *)(out + i), v);
+    }
+}
+
+NNUE_TARGET("sse4.1")
+static int32_t OutputSse41(const int16_t *us, const int16_t *them, const int16_t *weights, int qa) {
+    __m128i zero = _mm_setzero_si128();
+    __m128i ceiling = _mm_set1_epi16((short)qa);
+    __m128i sum = zero;
+
+    for (int i = 0; i < NNUE_HIDDEN; i += 8) {
+        __m128i a = _mm_min_epi16(_mm_max_epi16(_mm_loadu_si128((const __m128i *)(us + i)), zero), ceiling);
+        __m128i b = _mm_min_epi16(_mm_max_epi16(_mm_loadu_si128((const __m128i *)(them + i)), zero), ceiling);
+        sum = _mm_add_epi32(sum, _mm_madd_epi16(a, _mm_loadu_si128((const __m128i *)(weights + i))));
+        sum = _mm_add_epi32(sum, _mm_madd_epi16(b, _mm_loadu_si128((const __m128i *)(weights + NNUE_HIDDEN + i))));
+    }
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4E));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xB1));
+    return _mm_cvtsi128_si32(sum);
+}
+
+NNUE_TARGET("avx2")
+static void UpdateAvx2(int16_t *out, const int16_t *in, const int16_t *const *added, int addedCount,
+                       const int16_t *const *removed, int removedCount) {
+    for (int i = 0; i < NNUE_HIDDEN; i += 16) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(in + i));
+        for (int a = 0; a < addedCount; a++) v = _mm256_add_epi16(v, _mm256_loadu_si256((const __m256i *)(added[a] + i)));
+        for (int r = 0; r < removedCount; r++) v = _mm256_sub_epi16(v, _mm256_loadu_si256((const __m256i *)(removed[r] + i)));
+        _mm256_storeu_si256((__m256i *)(out + i), v);
+    }
+}
+
+NNUE_TARGET("avx2")
+static int32_t OutputAvx2(const int16_t *us, const int16_t *them, const int16_t *weights, int qa) {
+    __m256i zero = _mm256_setzero_si256();
+    __m256i ceiling = _mm256_set1_epi16((short)qa);
+    __m256i sum = zero;
+
+    for (int i = 0; i < NNUE_HIDDEN; i += 16) {
+        __m256i a = _mm256_min_epi16(_mm256_max_epi16(_mm256_loadu_si256((const __m256i *)(us + i)), zero), ceiling);
+        __m256i b = _mm256_min_epi16(_mm256_max_epi16(_mm256_loadu_si256((const __m256i *)(them + i)), zero), ceiling);
+        sum = _mm256_add_epi32(sum, _mm256_madd_epi16(a, _mm256_loadu_si256((const __m256i *)(weights + i))));
+        sum = _mm256_add_epi32(sum, _mm256_madd_epi16(b, _mm256_loadu_si256((const __m256i *)(weights + NNUE_HIDDEN + i))));
+    }
+
+    __m128i half = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0x4E));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0xB1));
+    return _mm_cvtsi128_si32(half);
+}
+#endif
+
+int NnueDetectSimd(void) {
+#if NNUE_X86 && defined(__GNUC__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return NNUE_SIMD_AVX2;
+    if (__builtin_cpu_supports("sse4.1")) return NNUE_SIMD_SSE41;
+#elif NNUE_X86 && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    int maxLeaf = info[0];
+
+    __cpuid(info, 1);
+    bool sse41 = (info[2] & (1 << 19)) != 0;
+    bool osSavesYmm = (info[2] & (1 << 27)) && (_xgetbv(0) & 6) == 6;
+    if (maxLeaf >= 7 && osSavesYmm) {
+        __cpuidex(info, 7, 0);
+        if (info[1] & (1 << 5)) return NNUE_SIMD_AVX2;
+    }
+    if (sse41) return NNUE_SIMD_SSE41;
+#endif
+    return NNUE_SIMD_SCALAR;
+}
+
+int NnueSetSimd(int level) {
+    int supported = NnueDetectSimd();
+    if (level > supported || level < NNUE_SIMD_SCALAR) level = supported;
+
+    updateKernel = UpdateScalar;
+    outputKernel = OutputScalar;
+#if NNUE_X86
+    if (level == NNUE_SIMD_SSE41) {
+        updateKernel = UpdateSse41;
+        outputKernel = OutputSse41;
+    } else if (level == NNUE_SIMD_AVX2) {
+        updateKernel = UpdateAvx2;
+        outputKernel = OutputAvx2;
+    }
+#endif
+    simdLevel = level;
+    return level;
+}
+
+int NnueActiveSimd(void) {
+    return simdLevel;
+}
+
+const char *NnueSimdName(int level) {
+    static const char *names[] = { "scalar", "sse4.1", "avx2" };
+    return level >= NNUE_SIMD_SCALAR && level <= NNUE_SIMD_AVX2 ? names[level] : "unknown";
+}
+
+// The header must describe exactly the network this build evaluates
+static bool ReadHeader(const MappedFile *file, NnueHeader *header) {
+    size_t weights = (size_t)NNUE_FEATURES * NNUE_HIDDEN + NNUE_HIDDEN + 2 * NNUE_HIDDEN;
+
+    if (file->size != sizeof(*header) + weights * sizeof(int16_t) + sizeof(int32_t)) return false;
+    memcpy(header, file->data, sizeof(*header));
+    return header->magic == NNUE_MAGIC && header->version == NNUE_VERSION && header->features == NNUE_FEATURES
+        && header->hidden == NNUE_HIDDEN && header->qa > 0 && header->qa <= 32767 && header->qb > 0 && header->scale > 0;
+}
+
+bool LoadNetwork(Network *net, const char *path) {
+    NnueHeader header;
+
+    memset(net, 0, sizeof(*net));
+    if (!MapFile(&net->file, path)) return false;
+    if (!ReadHeader(&net->file, &header)) {
+        UnmapFile(&net->file);
+        return false;
+    }
+
+    const int16_t *data = (const int16_t *)(net->file.data + sizeof(header));
+    net->featureWeights = data;
+    net->featureBias = data + (size_t)NNUE_FEATURES * NNUE_HIDDEN;
+    net->outputWeights = net->featureBias + NNUE_HIDDEN;
+    memcpy(&net->outputBias, net->outputWeights + 2 * NNUE_HIDDEN, sizeof(int32_t));
+    net->qa = header.qa;
+    net->qb = header.qb;
+    net->scale = header.scale;
+
+    if (simdLevel < 0) NnueSetSimd(NnueDetectSimd());
+    return true;
+}
+
+void UnloadNetwork(Network *net) {
+    UnmapFile(&net->file);
+    memset(net, 0, sizeof(*net));
+}
+
+static int Feature(int piece, int sq) {
+    return piece * 64 + sq;
+}
+
+// The same input seen from black: colors swapped, board flipped vertically
+static int FlipFeature(int feature) {
+    int piece = feature >> 6, sq = feature & 63;
+    return Feature(piece < PIECE_TYPE_COUNT ? piece + PIECE_TYPE_COUNT : piece - PIECE_TYPE_COUNT, sq ^ 56);
+}
+
+static const int16_t *WeightRow(const Network *net, int perspective, int feature) {
+    if (perspective == SIDE_BLACK) feature = FlipFeature(feature);
+    return net->featureWeights + (size_t)feature * NNUE_HIDDEN;
+}
+
+void NnuePush(Accumulator *child, const Position *pos, Move move) {
+    NnueDelta *delta = &child->delta;
+
+    child->computed = false;
+    delta->removedCount = 0;
+    delta->addedCount = 0;
+    if (move == MOVE_NONE) return;
+
+    int us = pos->sideToMove;
+    int from = MOVE_FROM(move), to = MOVE_TO(move), flags = MOVE_FLAGS(move);
+    int piece = pos->squares[from];
+
+    delta->removed[delta->removedCount++] = Feature(piece, from);
+    delta->added[delta->addedCount++] = Feature(MOVE_IS_PROMOTION(move) ? MAKE_PIECE(us, MOVE_PROMOTION_TYPE(move)) : piece, to);
+
+    if (MOVE_IS_CAPTURE(move)) {
+        int capturedSquare = flags == MOVE_EP_CAPTURE ? (us == SIDE_WHITE ? to - 8 : to + 8) : to;
+        delta->removed[delta->removedCount++] = Feature(pos->squares[capturedSquare], capturedSquare);
+    } else if (MOVE_IS_CASTLE(move)) {
+        int rook = MAKE_PIECE(us, PIECE_ROOK);
+        delta->removed[delta->removedCount++] = Feature(rook, flags == MOVE_KING_CASTLE ? to + 1 : to - 2);
+        delta->added[delta->addedCount++] = Feature(rook, flags == MOVE_KING_CASTLE ? to - 1 : to + 1);
+    }
+}
+
+void NnueRefresh(const Network *net, const Position *pos, Accumulator *acc) {
+    for (int perspective = SIDE_WHITE; perspective <= SIDE_BLACK; perspective++) {
+        const int16_t *rows[MAX_REFRESH_ROWS];
+        int count = 0;
+
+        for (Bitboard b = pos->occupancy[SIDE_BOTH]; b && count < MAX_REFRESH_ROWS;) {
+            int sq = PopLsb(&b);
+            rows[count++] = WeightRow(net, perspective, Feature(pos->squares[sq], sq));
+        }
+        updateKernel(acc->values[perspective], net->featureBias, rows, count, NULL, 0);
+    }
+    acc->computed = true;
+}
+
+void NnueUpdate(const Network *net, const Accumulator *parent, Accumulator *child) {
+    const NnueDelta *delta = &child->delta;
+
+    for (int perspective = SIDE_WHITE; perspective <= SIDE_BLACK; perspective++) {
+        const int16_t *added[2], *removed[2];
+
+        for (int i = 0; i < delta->addedCount; i++) added[i] = WeightRow(net, perspective, delta->added[i]);
+        for (int i = 0; i < delta->removedCount; i++) removed[i] = WeightRow(net, perspective, delta->removed[i]);
+        updateKernel(child->values[perspective], parent->values[perspective], added, delta->addedCount,
+                     removed, delta->removedCount);
+    }
+    child->computed = true;
+}
+
+int NnueOutput(const Network *net, const Accumulator *acc, int sideToMove) {
+    int64_t sum = outputKernel(acc->values[sideToMove], acc->values[sideToMove ^ 1], net->outputWeights, net->qa);
+    return (int)((sum + net->outputBias) * net->scale / ((int64_t)net->qa * net->qb));
+}
+
+int NnueEvaluate(const Network *net, Accumulator *stack, int ply, const Position *pos) {
+    int first = ply;
+
+    while (first > 0 && !stack[first].computed) first--;
+    if (!stack[first].computed) NnueRefresh(net, pos, &stack[ply]);
+    for (int i = first + 1; i <= ply && !stack[ply].computed; i++) NnueUpdate(net, &stack[i - 1], &stack[i]);
+    return NnueOutput(net, &stack[ply], pos->sideToMove);
+}
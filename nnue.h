@@ -0,0 +1,93 @@
+#ifndef NNUE_H
+#define NNUE_H
+
+#include "position.h"
+#include "platform.h"
+
+// Efficiently updatable network: 768 piece-square inputs seen from each
+// side, NNUE_HIDDEN accumulator neurons per side, clipped ReLU, one output.
+// The first layer's outputs are kept per search ply and only the few inputs
+// a move changes are added and subtracted, so a node costs a handful of
+// vector adds plus the output layer instead of a full forward pass.
+
+#define NNUE_FEATURES 768           // piece code * 64 + square, from the perspective's side
+#define NNUE_HIDDEN 256
+#define NNUE_MAGIC 0x4E443343u      // "C3DN" read as little endian
+#define NNUE_VERSION 1
+#define NNUE_DEFAULT_FILE "chess.nnue"
+
+#define NNUE_SIMD_SCALAR 0
+#define NNUE_SIMD_SSE41 1
+#define NNUE_SIMD_AVX2 2
+
+// File layout, little endian, every section 32-byte aligned in the mapping:
+//   NnueHeader (64 bytes)
+//   int16 featureWeights[NNUE_FEATURES][NNUE_HIDDEN]
+//   int16 featureBias[NNUE_HIDDEN]
+//   int16 outputWeights[2 * NNUE_HIDDEN]   side to move's half first
+//   int32 outputBias
+typedef struct NnueHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t features;
+    uint32_t hidden;
+    int32_t qa;                     // accumulator clipping ceiling
+    int32_t qb;                     // output weight scale
+    int32_t scale;                  // centipawns per unit of the dequantized output
+    uint32_t reserved[9];
+} NnueHeader;
+
+// Weights point straight into the mapped file; nothing is copied
+typedef struct Network {
+    MappedFile file;
+    const int16_t *featureWeights;
+    const int16_t *featureBias;
+    const int16_t *outputWeights;
+    int32_t outputBias;
+    int qa, qb, scale;
+} Network;
+
+// Input changes of one move, as white-perspective feature indices
+typedef struct NnueDelta {
+    int removedCount, addedCount;
+    int removed[2];
+    int added[2];
+} NnueDelta;
+
+// First layer output for both perspectives, white's first. delta turns the
+// parent ply's accumulator into this one.
+typedef struct Accumulator {
+    int16_t values[2][NNUE_HIDDEN];
+    NnueDelta delta;
+    bool computed;
+} Accumulator;
+
+// False for a missing file or one whose header or size does not match this build
+bool LoadNetwork(Network *net, const char *path);
+void UnloadNetwork(Network *net);
+
+// Best kernel set the processor supports; the kernels are picked on first load
+int NnueDetectSimd(void);
+
+// Picks a kernel set, falling back to what the processor supports; returns the one chosen
+int NnueSetSimd(int level);
+int NnueActiveSimd(void);
+const char *NnueSimdName(int level);
+
+// Records the inputs a move changes; call before MakeMove, MOVE_NONE for a null move
+void NnuePush(Accumulator *child, const Position *pos, Move move);
+
+// Full recomputation from the pieces on the board
+void NnueRefresh(const Network *net, const Position *pos, Accumulator *acc);
+
+// Applies child->delta to the parent's values
+void NnueUpdate(const Network *net, const Accumulator *parent, Accumulator *child);
+
+// Centipawns for sideToMove from an up to date accumulator
+int NnueOutput(const Network *net, const Accumulator *acc, int sideToMove);
+
+// Brings stack[ply] up to date from its nearest computed ancestor, then
+// evaluates it. stack[0] must have been refreshed for the root.
+int NnueEvaluate(const Network *net, Accumulator *stack, int ply, const Position *pos);
+
+#endif
@@ -0,0 +1,336 @@
+#include "assets.h"
+#include "lod.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_BUNDLE_ENTRIES 64
+
+// Entries and their payloads, built in memory and written in one go
+typedef struct Packer {
+    BundleEntry entries[MAX_BUNDLE_ENTRIES];
+    Image images[MAX_BUNDLE_ENTRIES];   // texture pixels by entry index, to share identical textures
+    int entryCount;
+    unsigned char *payload;             // every payload back to back, offsets relative to its start
+    uint64_t size;
+    uint64_t capacity;
+    unsigned int defaultTextureId;      // raylib's 1x1 white texture, left out of the bundle
+} Packer;
+
+static const char *typeNames[] = { "", "mesh", "texture", "sound", "music", "material" };
+
+static void Reserve(Packer *packer, uint64_t bytes) {
+    if (packer->size + bytes <= packer->capacity) return;
+    while (packer->size + bytes > packer->capacity) packer->capacity = packer->capacity ? packer->capacity * 2 : 1 << 20;
+    packer->payload = realloc(packer->payload, packer->capacity);
+    if (!packer->payload) {
+        fprintf(stderr, "chess_pack: out of memory\n");
+        exit(1);
+    }
+}
+
+// Pads to the next ASSET_ALIGNMENT boundary, as the loader's reads expect
+static void Align(Packer *packer) {
+    uint64_t aligned = (packer->size + ASSET_ALIGNMENT - 1) & ~(uint64_t)(ASSET_ALIGNMENT - 1);
+
+    if (aligned == packer->size) return;
+    Reserve(packer, aligned - packer->size);
+    memset(packer->payload + packer->size, 0, aligned - packer->size);
+    packer->size = aligned;
+}
+
+static void AppendBlock(Packer *packer, const void *data, uint64_t bytes) {
+    Align(packer);
+    Reserve(packer, bytes);
+    memcpy(packer->payload + packer->size, data, bytes);
+    packer->size += bytes;
+}
+
+static int BeginEntry(Packer *packer, const char *name, uint32_t type) {
+    BundleEntry *entry = &packer->entries[packer->entryCount];
+
+    if (packer->entryCount == MAX_BUNDLE_ENTRIES || strlen(name) >= ASSET_NAME_LENGTH) {
+        fprintf(stderr, "chess_pack: cannot add %s\n", name);
+        exit(1);
+    }
+    Align(packer);
+    memset(entry, 0, sizeof(*entry));
+    strcpy(entry->name, name);
+    entry->type = type;
+    entry->offset = packer->size;
+    return packer->entryCount++;
+}
+
+static void EndEntry(Packer *packer, int index) {
+    packer->entries[index].size = packer->size - packer->entries[index].offset;
+}
+
+static bool SameImage(Image a, Image b) {
+    return a.width == b.width && a.height == b.height && a.format == b.format && a.mipmaps == b.mipmaps
+        && memcmp(a.data, b.data, TextureDataSize(a.width, a.height, a.format, a.mipmaps)) == 0;
+}
+
+// Takes ownership of image; returns the entry of an identical texture if there is one
+static int PackTexture(Packer *packer, const char *name, Image image) {
+    BundleTexture header = { image.width, image.height, image.format, image.mipmaps };
+
+    for (int i = 0; i < packer->entryCount; i++) {
+        if (packer->images[i].data && SameImage(packer->images[i], image)) {
+            UnloadImage(image);
+            return i;
+        }
+    }
+
+    int index = BeginEntry(packer, name, ASSET_TEXTURE);
+    AppendBlock(packer, &header, sizeof(header));
+    AppendBlock(packer, image.data, TextureDataSize(image.width, image.height, image.format, image.mipmaps));
+    EndEntry(packer, index);
+    packer->images[index] = image;
+    return index;
+}
+
+// Vertex and texture bytes of the pieces, as separate models and as packed
+typedef struct MemoryStats {
+    uint64_t separateMeshes, separateTextures;
+    uint64_t sharedMeshes, sharedTextures;
+} MemoryStats;
+
+static void PackMaterial(Packer *packer, const char *name, Color diffuse, int texture) {
+    BundleMaterial material = { diffuse, texture };
+    int index = BeginEntry(packer, name, ASSET_MATERIAL);
+
+    AppendBlock(packer, &material, sizeof(material));
+    EndEntry(packer, index);
+}
+
+static void PackMesh(Packer *packer, const char *name, const Mesh *mesh) {
+    BundleMesh header = { mesh->vertexCount, mesh->triangleCount, 0, 0 };
+    uint64_t vertices = (uint64_t)mesh->vertexCount;
+
+    if (mesh->normals) header.arrays |= BUNDLE_MESH_NORMALS;
+    if (mesh->texcoords) header.arrays |= BUNDLE_MESH_TEXCOORDS;
+    if (mesh->colors) header.arrays |= BUNDLE_MESH_COLORS;
+    if (mesh->indices) header.arrays |= BUNDLE_MESH_INDICES;
+
+    int index = BeginEntry(packer, name, ASSET_MESH);
+    AppendBlock(packer, &header, sizeof(header));
+    AppendBlock(packer, mesh->vertices, vertices * 3 * sizeof(float));
+    if (mesh->normals) AppendBlock(packer, mesh->normals, vertices * 3 * sizeof(float));
+    if (mesh->texcoords) AppendBlock(packer, mesh->texcoords, vertices * 2 * sizeof(float));
+    if (mesh->colors) AppendBlock(packer, mesh->colors, vertices * 4);
+    if (mesh->indices) AppendBlock(packer, mesh->indices, (uint64_t)mesh->triangleCount * 3 * sizeof(unsigned short));
+    EndEntry(packer, index);
+}
+
+// Adds up what the game held when it loaded every model separately, then
+// unloads the model together with the textures glTF brought along
+static void UnloadCountedModel(Packer *packer, Model model, MemoryStats *stats) {
+    for (int i = 0; i < model.meshCount; i++) stats->separateMeshes += MeshDataSize(&model.meshes[i]);
+
+    for (int i = 0; i < model.materialCount; i++) {
+        for (int map = 0; map <= MATERIAL_MAP_BRDF; map++) {
+            Texture2D texture = model.materials[i].maps[map].texture;
+            if (texture.id == 0 || texture.id == packer->defaultTextureId) continue;
+
+            stats->separateTextures += TextureDataSize(texture.width, texture.height, texture.format, texture.mipmaps);
+            UnloadTexture(texture);
+            for (int j = i; j < model.materialCount; j++) {
+                for (int other = 0; other <= MATERIAL_MAP_BRDF; other++) {
+                    if (model.materials[j].maps[other].texture.id == texture.id) model.materials[j].maps[other].texture.id = 0;
+                }
+            }
+        }
+    }
+    UnloadModel(model);
+}
+
+// Both colors share the white model's geometry. The black model of the type
+// is loaded for the memory comparison, and the black pawn's diffuse map
+// becomes the black material.
+static bool PackPieceType(Packer *packer, int type, MemoryStats *stats) {
+    const char *whitePath = TextFormat(MODEL_PATH_FORMAT, pieceModelNames[MAKE_PIECE(SIDE_WHITE, type)]);
+    const char *blackPath = TextFormat(MODEL_PATH_FORMAT, pieceModelNames[MAKE_PIECE(SIDE_BLACK, type)]);
+
+    if (!FileExists(whitePath) || !FileExists(blackPath)) {
+        fprintf(stderr, "chess_pack: %s not found\n", FileExists(whitePath) ? blackPath : whitePath);
+        return false;
+    }
+
+    Model white = LoadModel(whitePath);
+    Model black = LoadModel(blackPath);
+
+    if (white.meshCount != 1) {
+        printf("%s has %d meshes, only the first one is packed\n", whitePath, white.meshCount);
+    }
+    if (black.meshes[0].vertexCount != white.meshes[0].vertexCount || black.meshes[0].triangleCount != white.meshes[0].triangleCount) {
+        printf("%s differs from %s; both colors use the white geometry\n", blackPath, whitePath);
+    }
+
+    PackMesh(packer, pieceTypeNames[type], &white.meshes[0]);
+    stats->sharedMeshes += MeshDataSize(&white.meshes[0]);
+
+    if (type == PIECE_PAWN) {
+        MaterialMap *diffuse = &black.materials[black.meshMaterial[0]].maps[MATERIAL_MAP_DIFFUSE];
+        int texture = -1;
+        if (diffuse->texture.id != packer->defaultTextureId) {
+            texture = PackTexture(packer, "black", LoadImageFromTexture(diffuse->texture));
+        }
+        PackMaterial(packer, BLACK_MATERIAL_NAME, diffuse->color, texture);
+    }
+
+    UnloadCountedModel(packer, white, stats);
+    UnloadCountedModel(packer, black, stats);
+    return true;
+}
+
+// Decoded to PCM here so the game only has to copy the samples to the device
+static bool PackSound(Packer *packer, const char *name, const char *path) {
+    Wave wave = FileExists(path) ? LoadWave(path) : (Wave){ 0 };
+    BundleSound header = { wave.frameCount, wave.sampleRate, wave.sampleSize, wave.channels };
+
+    if (!wave.data) {
+        fprintf(stderr, "chess_pack: cannot decode %s\n", path);
+        return false;
+    }
+
+    int index = BeginEntry(packer, name, ASSET_SOUND);
+    AppendBlock(packer, &header, sizeof(header));
+    AppendBlock(packer, wave.data, (uint64_t)wave.frameCount * wave.channels * wave.sampleSize / 8);
+    EndEntry(packer, index);
+    UnloadWave(wave);
+    return true;
+}
+
+// Music stays encoded: decoded it would be tens of megabytes, and raylib
+// streams it in small chunks while it plays anyway
+static void PackMusic(Packer *packer, const char *name, const char *path) {
+    BundleMusic header = { 0 };
+    int size = 0;
+    unsigned char *data;
+
+    if (!FileExists(path)) {
+        printf("%s not found, the bundle has no music\n", path);
+        return;
+    }
+    data = LoadFileData(path, &size);
+    if (!data) return;
+
+    strncpy(header.fileType, GetFileExtension(path), sizeof(header.fileType) - 1);
+    header.size = (uint64_t)size;
+
+    int index = BeginEntry(packer, name, ASSET_MUSIC);
+    AppendBlock(packer, &header, sizeof(header));
+    AppendBlock(packer, data, header.size);
+    EndEntry(packer, index);
+    UnloadFileData(data);
+}
+
+// Written to a temporary file first so a failed run never leaves a damaged bundle behind
+static bool WriteBundle(Packer *packer, const char *path) {
+    uint64_t tableEnd = sizeof(BundleHeader) + (uint64_t)packer->entryCount * sizeof(BundleEntry);
+    uint64_t dataStart = (tableEnd + ASSET_ALIGNMENT - 1) & ~(uint64_t)(ASSET_ALIGNMENT - 1);
+    BundleHeader header = { ASSET_BUNDLE_MAGIC, ASSET_BUNDLE_VERSION, (uint32_t)packer->entryCount, 0, dataStart + packer->size };
+    static const unsigned char padding[ASSET_ALIGNMENT] = { 0 };
+    char tempPath[1024];
+    bool ok;
+
+    snprintf(tempPath, sizeof(tempPath), "%s.tmp", path);
+    FILE *file = fopen(tempPath, "wb");
+    if (!file) return false;
+
+    for (int i = 0; i < packer->entryCount; i++) packer->entries[i].offset += dataStart;
+    ok = fwrite(&header, sizeof(header), 1, file) == 1
+        && fwrite(packer->entries, sizeof(BundleEntry), packer->entryCount, file) == (size_t)packer->entryCount
+        && fwrite(padding, 1, dataStart - tableEnd, file) == dataStart - tableEnd
+        && fwrite(packer->payload, 1, packer->size, file) == packer->size;
+    for (int i = 0; i < packer->entryCount; i++) packer->entries[i].offset -= dataStart;
+    ok = fclose(file) == 0 && ok;
+
+    remove(path);
+    if (!ok || rename(tempPath, path) != 0) {
+        remove(tempPath);
+        return false;
+    }
+    return true;
+}
+
+static void PrintUsage(void) {
+    printf("usage: chess_pack [--out file]\n");
+    printf("  Bakes the piece models, textures and sounds into one bundle (default %s)\n", ASSET_BUNDLE_PATH);
+    printf("  that the game maps into memory at startup. Run it from the game directory.\n");
+}
+
+int main(int argc, char **argv) {
+    const char *outPath = ASSET_BUNDLE_PATH;
+    Packer *packer = calloc(1, sizeof(*packer));
+    MemoryStats stats = { 0 };
+    bool ok = true;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+            outPath = argv[++i];
+        } else {
+            PrintUsage();
+            return strcmp(argv[i], "--help") == 0 ? 0 : 1;
+        }
+    }
+
+    int64_t start = GetMicroseconds();
+
+    // LoadModel uploads what it parses, so it needs a GL context
+    SetTraceLogLevel(LOG_WARNING);
+    SetConfigFlags(FLAG_WINDOW_HIDDEN);
+    InitWindow(64, 64, "chess_pack");
+
+    packer->defaultTextureId = DefaultTextureId();
+
+    if (!FileExists(WHITE_TEXTURE_PATH)) {
+        fprintf(stderr, "chess_pack: %s not found\n", WHITE_TEXTURE_PATH);
+        ok = false;
+    } else {
+        int whiteTexture = PackTexture(packer, WHITE_TEXTURE_NAME, LoadImage(WHITE_TEXTURE_PATH));
+
+        PackMaterial(packer, WHITE_MATERIAL_NAME, WHITE, whiteTexture);
+        stats.separateTextures += TextureDataSize(packer->images[whiteTexture].width, packer->images[whiteTexture].height,
+                                                  packer->images[whiteTexture].format, packer->images[whiteTexture].mipmaps);
+        for (int type = 0; type < PIECE_TYPE_COUNT && ok; type++) ok = PackPieceType(packer, type, &stats);
+        ok = ok && PackSound(packer, MOVE_SOUND_NAME, MOVE_SOUND_PATH);
+        ok = ok && PackSound(packer, CASTLE_SOUND_NAME, CASTLE_SOUND_PATH);
+        if (ok) PackMusic(packer, MUSIC_NAME, MUSIC_PATH);
+    }
+
+    CloseWindow();
+
+    if (ok && !WriteBundle(packer, outPath)) {
+        fprintf(stderr, "chess_pack: cannot write %s\n", outPath);
+        ok = false;
+    }
+
+    if (ok) {
+        for (int i = 0; i < packer->entryCount; i++) {
+            printf("%-24s %-8s %10.1f KB\n", packer->entries[i].name, typeNames[packer->entries[i].type],
+                packer->entries[i].size / 1024.0);
+        }
+        printf("Wrote %s: %d entries, %.1f MB in %.0f ms\n", outPath, packer->entryCount,
+            packer->size / (1024.0 * 1024.0), (GetMicroseconds() - start) / 1000.0);
+
+        for (int i = 0; i < packer->entryCount; i++) {
+            if (packer->images[i].data) {
+                stats.sharedTextures += TextureDataSize(packer->images[i].width, packer->images[i].height,
+                                                        packer->images[i].format, packer->images[i].mipmaps);
+            }
+        }
+        printf("Piece meshes:   %7.2f MB as twelve separate models, %7.2f MB shared by both colors\n",
+            stats.separateMeshes / 1048576.0, stats.sharedMeshes / 1048576.0);
+        printf("Piece textures: %7.2f MB as loaded from the models, %7.2f MB packed\n",
+            stats.separateTextures / 1048576.0, stats.sharedTextures / 1048576.0);
+    }
+
+    for (int i = 0; i < packer->entryCount; i++) {
+        if (packer->images[i].data) UnloadImage(packer->images[i]);
+    }
+    free(packer->payload);
+    free(packer);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,133 @@
+#include "packed.h"
+#include "movegen.h"
+
+#include <string.h>
+
+#define PACKED_STATE_BLACK 1
+#define PACKED_STATE_CASTLING_SHIFT 1
+
+// Moves are stored in groups of four so the next record stays 8-byte aligned
+static size_t PaddedMoveCount(uint32_t moveCount) {
+    return ((size_t)moveCount + 3) & ~(size_t)3;
+}
+
+bool PackPosition(const Position *pos, PackedPosition *packed) {
+    Bitboard occupied = pos->occupancy[SIDE_BOTH];
+    int count = 0;
+
+    if (PopCount(occupied) > PACKED_MAX_PIECES) return false;
+
+    memset(packed, 0, sizeof(*packed));
+    packed->occupied = occupied;
+    while (occupied) {
+        int sq = PopLsb(&occupied);
+        packed->pieces[count / 2] |= (uint8_t)(pos->squares[sq] << ((count & 1) * 4));
+        count++;
+    }
+
+    packed->state = (uint8_t)((pos->sideToMove == SIDE_BLACK ? PACKED_STATE_BLACK : 0) |
+                              (pos->castling << PACKED_STATE_CASTLING_SHIFT));
+    packed->epSquare = (uint8_t)pos->epSquare;
+    packed->halfmoveClock = (uint8_t)(pos->halfmoveClock < 255 ? pos->halfmoveClock : 255);
+    packed->fullmoveNumber = (uint16_t)(pos->fullmoveNumber < 65535 ? pos->fullmoveNumber : 65535);
+    return true;
+}
+
+bool UnpackPosition(const PackedPosition *packed, Position *pos) {
+    unsigned char squares[64];
+    Bitboard occupied = packed->occupied;
+    int count = 0;
+
+    if (PopCount(occupied) > PACKED_MAX_PIECES) return false;
+
+    memset(squares, NO_PIECE, sizeof(squares));
+    while (occupied) {
+        int sq = PopLsb(&occupied);
+        int piece = (packed->pieces[count / 2] >> ((count & 1) * 4)) & 15;
+        if (piece >= NO_PIECE) return false;
+        squares[sq] = (unsigned char)piece;
+        count++;
+    }
+
+    Position unpacked;
+    int castling = (packed->state >> PACKED_STATE_CASTLING_SHIFT) & CASTLE_ALL;
+    int side = (packed->state & PACKED_STATE_BLACK) ? SIDE_BLACK : SIDE_WHITE;
+    if (!PositionFromSquares(&unpacked, squares, side, castling, packed->epSquare)) return false;
+
+    unpacked.halfmoveClock = packed->halfmoveClock;
+    unpacked.fullmoveNumber = packed->fullmoveNumber > 0 ? packed->fullmoveNumber : 1;
+    *pos = unpacked;
+    return true;
+}
+
+bool WritePackedHeader(FILE *file, int kind) {
+    PackedFileHeader header = { PACKED_MAGIC, PACKED_VERSION, (uint32_t)kind, 0 };
+    return fwrite(&header, sizeof(header), 1, file) == 1;
+}
+
+bool WritePackedPosition(FILE *file, const PackedPosition *packed) {
+    return fwrite(packed, sizeof(*packed), 1, file) == 1;
+}
+
+bool WritePackedGame(FILE *file, const Position *start, const Move *moves, int moveCount, int result) {
+    static const Move padding[3] = { MOVE_NONE, MOVE_NONE, MOVE_NONE };
+    PackedGame game;
+
+    if (moveCount < 0 || !PackPosition(start, &game.start)) return false;
+    game.start.result = (uint8_t)result;
+    game.moveCount = (uint32_t)moveCount;
+    game.reserved = 0;
+
+    size_t paddingCount = PaddedMoveCount(game.moveCount) - game.moveCount;
+    return fwrite(&game, sizeof(game), 1, file) == 1 &&
+           fwrite(moves, sizeof(Move), (size_t)moveCount, file) == (size_t)moveCount &&
+           fwrite(padding, sizeof(Move), paddingCount, file) == paddingCount;
+}
+
+bool InitPackedReader(PackedReader *reader, const void *data, size_t size) {
+    PackedFileHeader header;
+
+    memset(reader, 0, sizeof(*reader));
+    if (size < sizeof(header)) return false;
+    memcpy(&header, data, sizeof(header));
+    if (header.magic != PACKED_MAGIC || header.version != PACKED_VERSION) return false;
+    if (header.kind != PACKED_KIND_POSITIONS && header.kind != PACKED_KIND_GAMES) return false;
+
+    reader->data = data;
+    reader->size = size;
+    reader->offset = sizeof(header);
+    reader->kind = (int)header.kind;
+    return true;
+}
+
+const PackedPosition *NextPackedPosition(PackedReader *reader) {
+    if (reader->kind != PACKED_KIND_POSITIONS || reader->size - reader->offset < sizeof(PackedPosition)) return NULL;
+
+    const PackedPosition *packed = (const PackedPosition *)(reader->data + reader->offset);
+    reader->offset += sizeof(PackedPosition);
+    return packed;
+}
+
+const PackedGame *NextPackedGame(PackedReader *reader, const Move **moves) {
+    if (reader->kind != PACKED_KIND_GAMES || reader->size - reader->offset < sizeof(PackedGame)) return NULL;
+
+    const PackedGame *game = (const PackedGame *)(reader->data + reader->offset);
+    size_t moveBytes = PaddedMoveCount(game->moveCount) * sizeof(Move);
+    if (reader->size - reader->offset - sizeof(PackedGame) < moveBytes) return NULL;
+
+    *moves = (const Move *)(game + 1);
+    reader->offset += sizeof(PackedGame) + moveBytes;
+    return game;
+}
+
+int ReplayPackedGame(const PackedGame *game, const Move *moves, Position *pos) {
+    UndoInfo undo;
+    uint32_t played = 0;
+
+    if (!UnpackPosition(&game->start, pos)) return -1;
+    while (played < game->moveCount && IsMoveLegal(pos, moves[played])) {
+        MakeMove(pos, moves[played], &undo);
+        played++;
+    }
+    return (int)played;
+}
@@ -0,0 +1,91 @@
+#ifndef PACKED_H
+#define PACKED_H
+
+#include "position.h"
+
+#include <stdio.h>
+
+// Binary positions and games, for saved games, opening books and training
+// sets. A position takes 32 bytes instead of a ~60 byte FEN line, a move 2
+// bytes instead of a SAN token and its move number, and records are read
+// straight from a mapped file: the reader hands out pointers into it.
+
+#define PACKED_MAGIC 0x47503343u     // "C3PG" read as little endian
+#define PACKED_VERSION 1
+
+#define PACKED_KIND_POSITIONS 1     // PackedPosition records back to back
+#define PACKED_KIND_GAMES 2         // PackedGame records, each followed by its moves
+
+#define PACKED_RESULT_UNKNOWN 0
+#define PACKED_RESULT_WHITE 1
+#define PACKED_RESULT_BLACK 2
+#define PACKED_RESULT_DRAW 3
+
+#define PACKED_MAX_PIECES 32
+#define PACKED_SAVE_FILE "chess_save.bin"
+
+// File layout, little endian: PackedFileHeader (16 bytes), then records of
+// the file's kind. Every record starts 8-byte aligned.
+typedef struct PackedFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t kind;                  // PACKED_KIND_*
+    uint32_t reserved;
+} PackedFileHeader;
+
+// 32 bytes. The occupied squares as a bitboard, then their piece codes in
+// square order, two per byte with the lower square in the low nibble. score
+// and result label positions of a training set and are 0 otherwise.
+typedef struct PackedPosition {
+    uint64_t occupied;
+    uint8_t pieces[PACKED_MAX_PIECES / 2];
+    uint8_t state;                  // bit 0 black to move, bits 1-4 castling rights
+    uint8_t epSquare;               // SQ_NONE if none
+    uint8_t halfmoveClock;          // saturates at 255
+    uint8_t result;                 // PACKED_RESULT_*
+    uint16_t fullmoveNumber;
+    int16_t score;                  // centipawns, side to move's point of view
+} PackedPosition;
+
+// 40 bytes, followed by moveCount moves (the engine's 16-bit codes) padded
+// with MOVE_NONE to a multiple of four
+typedef struct PackedGame {
+    PackedPosition start;           // its result field is the game's
+    uint32_t moveCount;
+    uint32_t reserved;
+} PackedGame;
+
+// False if the position has more than PACKED_MAX_PIECES pieces
+bool PackPosition(const Position *pos, PackedPosition *packed);
+
+// False for a record that does not describe a position (bad piece codes, no
+// kings, bad en passant square); pos is then untouched
+bool UnpackPosition(const PackedPosition *packed, Position *pos);
+
+// Writers. Each returns false on a write error or an unpackable position.
+bool WritePackedHeader(FILE *file, int kind);
+bool WritePackedPosition(FILE *file, const PackedPosition *packed);
+bool WritePackedGame(FILE *file, const Position *start, const Move *moves, int moveCount, int result);
+
+// Reads records in place from a mapped or loaded buffer, which must be
+// 8-byte aligned as mappings and malloc blocks are
+typedef struct PackedReader {
+    const unsigned char *data;
+    size_t size;
+    size_t offset;
+    int kind;
+} PackedReader;
+
+// False if the buffer does not start with a header of this version
+bool InitPackedReader(PackedReader *reader, const void *data, size_t size);
+
+// NULL at the end, on a truncated record or for a file of the other kind
+const PackedPosition *NextPackedPosition(PackedReader *reader);
+const PackedGame *NextPackedGame(PackedReader *reader, const Move **moves);
+
+// Plays a stored game from its start position, checking every move against
+// the legal moves. Returns how many were legal, with pos after them, or -1
+// if the start position is invalid.
+int ReplayPackedGame(const PackedGame *game, const Move *moves, Position *pos);
+
+#endif
@@ -0,0 +1,155 @@
+// chess_perft: headless move generator benchmark and correctness check.
+//
+//   chess_perft                      run the built-in suite (exit code 1 on mismatch)
+//   chess_perft --fen "<fen>" -d 5   count leaf nodes of one position
+//   chess_perft -d 5 --divide        per-move node counts for the start position
+
+#include "movegen.h"
+#include "platform.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct PerftCase {
+    const char *name;
+    const char *fen;
+    int depth;
+    uint64_t nodes;
+} PerftCase;
+
+// Published counts (chessprogramming.org perft results and Martin Sedlak's edge-case set)
+static const PerftCase perftSuite[] = {
+    { "start position", START_FEN, 5, 4865609ULL },
+    { "kiwipete", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 4, 4085603ULL },
+    { "position 3", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 5, 674624ULL },
+    { "position 4", "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 4, 422333ULL },
+    { "position 5", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 4, 2103487ULL },
+    { "position 6", "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10", 4, 3894594ULL },
+    { "illegal en passant", "3k4/3p4/8/K1P4r/8/8/8/8 b - - 0 1", 6, 1134888ULL },
+    { "en passant capture checks", "8/8/1k6/2b5/2pP4/8/5K2/8 b - d3 0 1", 6, 1440467ULL },
+    { "short castle gives check", "5k2/8/8/8/8/8/8/4K2R w K - 0 1", 6, 661072ULL },
+    { "long castle gives check", "3k4/8/8/8/8/8/8/R3K3 w Q - 0 1", 6, 803711ULL },
+    { "castling rights", "r3k2r/1b4bq/8/8/8/8/7B/R3K2R w KQkq - 0 1", 4, 1274206ULL },
+    { "castling prevented", "r3k2r/8/3Q4/8/8/5q2/8/R3K2R b KQkq - 0 1", 4, 1720476ULL },
+    { "promote out of check", "2K2r2/4P3/8/8/8/8/8/3k4 w - - 0 1", 6, 3821001ULL },
+    { "discovered check", "8/8/1P2K3/8/2n5/1q6/8/5k2 b - - 0 1", 5, 1004658ULL },
+    { "promote to give check", "4k3/1P6/8/8/8/8/K7/8 w - - 0 1", 6, 217342ULL },
+    { "underpromote to check", "8/P1k5/K7/8/8/8/8/8 w - - 0 1", 6, 92683ULL },
+    { "self stalemate", "K1k5/8/P7/8/8/8/8/8 w - - 0 1", 6, 2217ULL },
+    { "stalemate and checkmate", "8/k1P5/8/1K6/8/8/8/8 w - - 0 1", 7, 567584ULL },
+    { "stalemate and checkmate 2", "8/8/2k5/5q2/5n2/8/5K2/8 b - - 0 1", 4, 23527ULL },
+};
+
+static uint64_t Perft(Position *pos, int depth) {
+    MoveList list;
+    UndoInfo undo;
+    uint64_t nodes = 0;
+
+    GenerateLegalMoves(pos, &list);
+    if (depth <= 1) return depth == 1 ? (uint64_t)list.count : 1;
+
+    for (int i = 0; i < list.count; i++) {
+        MakeMove(pos, list.moves[i], &undo);
+        nodes += Perft(pos, depth - 1);
+        UnmakeMove(pos, list.moves[i], &undo);
+    }
+    return nodes;
+}
+
+static uint64_t Divide(Position *pos, int depth) {
+    MoveList list;
+    UndoInfo undo;
+    uint64_t total = 0;
+    char text[6];
+
+    GenerateLegalMoves(pos, &list);
+    for (int i = 0; i < list.count; i++) {
+        MakeMove(pos, list.moves[i], &undo);
+        uint64_t nodes = Perft(pos, depth - 1);
+        UnmakeMove(pos, list.moves[i], &undo);
+        MoveToString(list.moves[i], text);
+        printf("%-6s %llu\n", text, (unsigned long long)nodes);
+        total += nodes;
+    }
+    printf("\nmoves: %d\n", list.count);
+    return total;
+}
+
+static void PrintRate(uint64_t nodes, int64_t micros) {
+    double seconds = micros > 0 ? micros / 1e6 : 1e-6;
+    printf("nodes: %llu  time: %.3f s  nps: %.0f\n", (unsigned long long)nodes, seconds, nodes / seconds);
+}
+
+static int RunSuite(void) {
+    int count = (int)(sizeof(perftSuite) / sizeof(perftSuite[0]));
+    int failures = 0;
+    uint64_t totalNodes = 0;
+    int64_t totalMicros = 0;
+
+    for (int i = 0; i < count; i++) {
+        const PerftCase *test = &perftSuite[i];
+        Position pos;
+
+        if (!PositionFromFen(&pos, test->fen)) {
+            printf("FAIL %-28s bad FEN\n", test->name);
+            failures++;
+            continue;
+        }
+
+        int64_t start = GetMicroseconds();
+        uint64_t nodes = Perft(&pos, test->depth);
+        int64_t elapsed = GetMicroseconds() - start;
+
+        bool ok = nodes == test->nodes;
+        printf("%s %-28s depth %d  %12llu", ok ? "ok  " : "FAIL", test->name, test->depth, (unsigned long long)nodes);
+        if (!ok) printf("  expected %llu", (unsigned long long)test->nodes);
+        printf("  %8.1f Mnps\n", elapsed > 0 ? nodes / (double)elapsed : 0.0);
+
+        failures += !ok;
+        totalNodes += nodes;
+        totalMicros += elapsed;
+    }
+
+    printf("\n%d/%d positions passed\n", count - failures, count);
+    PrintRate(totalNodes, totalMicros);
+    return failures ? 1 : 0;
+}
+
+static void PrintUsage(void) {
+    printf("usage: chess_perft [--suite] [--fen \"<fen>\"] [--depth N] [--divide]\n");
+}
+
+int main(int argc, char **argv) {
+    const char *fen = START_FEN;
+    int depth = 0;
+    bool divide = false;
+    bool suite = argc == 1;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--suite") == 0) suite = true;
+        else if (strcmp(argv[i], "--divide") == 0) divide = true;
+        else if ((strcmp(argv[i], "--fen") == 0 || strcmp(argv[i], "-f") == 0) && i + 1 < argc) fen = argv[++i];
+        else if ((strcmp(argv[i], "--depth") == 0 || strcmp(argv[i], "-d") == 0) && i + 1 < argc) depth = atoi(argv[++i]);
+        else {
+            PrintUsage();
+            return 2;
+        }
+    }
+
+    InitBitboards();
+
+    if (suite) return RunSuite();
+
+    Position pos;
+    if (!PositionFromFen(&pos, fen)) {
+        printf("invalid FEN: %s\n", fen);
+        return 2;
+    }
+    if (depth <= 0) depth = 5;
+
+    int64_t start = GetMicroseconds();
+    uint64_t nodes = divide ? Divide(&pos, depth) : Perft(&pos, depth);
+    PrintRate(nodes, GetMicroseconds() - start);
+    return 0;
+}
@@ -0,0 +1,307 @@
+#include "pgn.h"
+
+#include <string.h>
+
+static const char pieceLetters[] = "PNBRQK";
+
+static bool IsSuffix(char c) {
+    return c == '+' || c == '#' || c == '!' || c == '?';
+}
+
+Move ParseSan(const Position *pos, const char *san) {
+    MoveList list;
+    char text[PGN_MAX_SAN];
+    size_t length = strlen(san);
+
+    if (length == 0 || length >= sizeof(text)) return MOVE_NONE;
+    memcpy(text, san, length + 1);
+    while (length > 0 && IsSuffix(text[length - 1])) text[--length] = '\0';
+
+    GenerateLegalMoves(pos, &list);
+
+    // Castling, with letter O or digit zero
+    if (strcmp(text, "O-O") == 0 || strcmp(text, "0-0") == 0 || strcmp(text, "O-O-O") == 0 || strcmp(text, "0-0-0") == 0) {
+        int flags = length == 3 ? MOVE_KING_CASTLE : MOVE_QUEEN_CASTLE;
+        for (int i = 0; i < list.count; i++) {
+            if (MOVE_FLAGS(list.moves[i]) == flags) return list.moves[i];
+        }
+        return MOVE_NONE;
+    }
+
+    // Promotion: "e8=Q" or "e8Q"
+    int promotion = -1;
+    if (length >= 2 && strchr("NBRQ", text[length - 1])) {
+        promotion = (int)(strchr(pieceLetters, text[length - 1]) - pieceLetters);
+        length -= text[length - 2] == '=' ? 2 : 1;
+    }
+
+    // Target square is the last two characters left
+    if (length < 2) return MOVE_NONE;
+    int toFile = text[length - 2] - 'a', toRank = text[length - 1] - '1';
+    if (toFile < 0 || toFile > 7 || toRank < 0 || toRank > 7) return MOVE_NONE;
+    int to = SQUARE(toFile, toRank);
+
+    // Piece letter, then optional file and rank disambiguation; 'x' carries no information
+    const char *p = text;
+    int type = PIECE_PAWN;
+    if (*p >= 'A' && *p <= 'Z') {
+        const char *letter = strchr(pieceLetters, *p);
+        if (!letter || !*letter) return MOVE_NONE;
+        type = (int)(letter - pieceLetters);
+        p++;
+    }
+    int fromFile = -1, fromRank = -1;
+    for (; p < text + length - 2; p++) {
+        if (*p >= 'a' && *p <= 'h') fromFile = *p - 'a';
+        else if (*p >= '1' && *p <= '8') fromRank = *p - '1';
+        else if (*p != 'x' && *p != '-') return MOVE_NONE;
+    }
+
+    Move found = MOVE_NONE;
+    for (int i = 0; i < list.count; i++) {
+        Move move = list.moves[i];
+        int from = MOVE_FROM(move);
+
+        if (MOVE_TO(move) != to || PIECE_TYPE(pos->squares[from]) != type || MOVE_IS_CASTLE(move)) continue;
+        if (fromFile >= 0 && SQUARE_FILE(from) != fromFile) continue;
+        if (fromRank >= 0 && SQUARE_RANK(from) != fromRank) continue;
+        if (MOVE_IS_PROMOTION(move) ? MOVE_PROMOTION_TYPE(move) != promotion : promotion >= 0) continue;
+        if (found != MOVE_NONE) return MOVE_NONE; // ambiguous
+        found = move;
+    }
+    return found;
+}
+
+void MoveToSan(const Position *pos, Move move, char *buffer) {
+    int from = MOVE_FROM(move), to = MOVE_TO(move);
+    int type = PIECE_TYPE(pos->squares[from]);
+    char *out = buffer;
+
+    if (MOVE_FLAGS(move) == MOVE_KING_CASTLE) {
+        strcpy(out, "O-O");
+        out += 3;
+    } else if (MOVE_FLAGS(move) == MOVE_QUEEN_CASTLE) {
+        strcpy(out, "O-O-O");
+        out += 5;
+    } else {
+        if (type == PIECE_PAWN) {
+            if (MOVE_IS_CAPTURE(move)) *out++ = (char)('a' + SQUARE_FILE(from));
+        } else {
+            MoveList list;
+            bool ambiguous = false, sameFile = false, sameRank = false;
+
+            // Another piece of the type reaching the same square needs the from square spelled out
+            *out++ = pieceLetters[type];
+            GenerateLegalMoves(pos, &list);
+            for (int i = 0; i < list.count; i++) {
+                int other = MOVE_FROM(list.moves[i]);
+                if (MOVE_TO(list.moves[i]) != to || other == from || PIECE_TYPE(pos->squares[other]) != type) continue;
+                ambiguous = true;
+                sameFile |= SQUARE_FILE(other) == SQUARE_FILE(from);
+                sameRank |= SQUARE_RANK(other) == SQUARE_RANK(from);
+            }
+            if (ambiguous && (!sameFile || sameRank)) *out++ = (char)('a' + SQUARE_FILE(from));
+            if (ambiguous && sameFile) *out++ = (char)('1' + SQUARE_RANK(from));
+        }
+        if (MOVE_IS_CAPTURE(move)) *out++ = 'x';
+        *out++ = (char)('a' + SQUARE_FILE(to));
+        *out++ = (char)('1' + SQUARE_RANK(to));
+        if (MOVE_IS_PROMOTION(move)) {
+            *out++ = '=';
+            *out++ = pieceLetters[MOVE_PROMOTION_TYPE(move)];
+        }
+    }
+
+    Position after = *pos;
+    UndoInfo undo;
+    MakeMove(&after, move, &undo);
+    if (InCheck(&after)) {
+        MoveList replies;
+        GenerateLegalMoves(&after, &replies);
+        *out++ = replies.count == 0 ? '#' : '+';
+    }
+    *out = '\0';
+}
+
+void InitPgnScanner(PgnScanner *scanner, const char *data, size_t size) {
+    scanner->data = data;
+    scanner->size = size;
+    scanner->offset = 0;
+}
+
+static bool IsPgnSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+// Length of the result token starting at text, 0 if there is none
+static size_t ResultTokenLength(const char *text, const char *end) {
+    static const char *results[] = { "1-0", "0-1", "1/2-1/2", "*" };
+    for (int i = 0; i < 4; i++) {
+        size_t length = strlen(results[i]);
+        if ((size_t)(end - text) >= length && memcmp(text, results[i], length) == 0 &&
+            (text + length == end || IsPgnSpace(text[length]))) return length;
+    }
+    return 0;
+}
+
+// A game runs from its first tag to its result token. A tag line or a blank
+// line after movetext also ends it, so games missing a result or their tags
+// are still split apart.
+bool NextPgnGame(PgnScanner *scanner, PgnGame *game) {
+    const char *data = scanner->data;
+    size_t i = scanner->offset, size = scanner->size;
+    bool inMoves = false, inComment = false;
+
+    // Skip blank lines before the game
+    while (i < size && (data[i] == ' ' || data[i] == '\t' || data[i] == '\r' || data[i] == '\n')) i++;
+    if (i >= size) return false;
+
+    size_t start = i, end = size;
+    bool ended = false;
+    while (i < size && !ended) {
+        const char *lineEnd = memchr(data + i, '\n', size - i);
+        size_t next = lineEnd ? (size_t)(lineEnd - data) + 1 : size;
+        size_t first = i;
+
+        while (first < next && IsPgnSpace(data[first])) first++;
+        if (!inComment && inMoves && (first == next || data[first] == '[')) {
+            end = i;
+            break;
+        }
+        if (!inComment && first < next && data[first] == '[') {
+            i = next;
+            continue;
+        }
+
+        for (size_t j = first; j < next; j++) {
+            char c = data[j];
+            if (inComment) {
+                if (c == '}') inComment = false;
+            } else if (c == '{') {
+                inComment = true;
+            } else if (c == ';') {
+                break; // the rest of the line is a comment
+            } else if (!IsPgnSpace(c)) {
+                // Tokens start after whitespace or a closing variation
+                size_t length = j == first || IsPgnSpace(data[j - 1]) || data[j - 1] == ')' ? ResultTokenLength(data + j, data + next) : 0;
+                if (length > 0) {
+                    end = next = j + length;
+                    ended = true;
+                    break;
+                }
+                inMoves = true;
+            }
+        }
+        i = next;
+        end = i;
+    }
+
+    game->text = data + start;
+    game->length = end - start;
+    scanner->offset = end;
+    return true;
+}
+
+bool GetPgnTag(const PgnGame *game, const char *name, char *value, size_t size) {
+    const char *p = game->text, *end = game->text + game->length;
+    size_t nameLength = strlen(name);
+
+    while (p < end) {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) p++;
+        if (p >= end || *p != '[') return false; // tags only come first
+
+        const char *lineEnd = memchr(p, '\n', (size_t)(end - p));
+        if (!lineEnd) lineEnd = end;
+
+        if ((size_t)(lineEnd - p) > nameLength + 1 && strncmp(p + 1, name, nameLength) == 0 && p[1 + nameLength] == ' ') {
+            const char *open = memchr(p, '"', (size_t)(lineEnd - p));
+            const char *close = open ? memchr(open + 1, '"', (size_t)(lineEnd - open - 1)) : NULL;
+            if (!close || size == 0) return false;
+
+            size_t length = (size_t)(close - open - 1);
+            if (length >= size) length = size - 1;
+            memcpy(value, open + 1, length);
+            value[length] = '\0';
+            return true;
+        }
+        p = lineEnd;
+    }
+    return false;
+}
+
+void InitPgnMoveReader(PgnMoveReader *reader, const PgnGame *game) {
+    const char *p = game->text, *end = game->text + game->length;
+
+    // Skip the tag section
+    for (;;) {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) p++;
+        if (p >= end || *p != '[') break;
+        const char *lineEnd = memchr(p, '\n', (size_t)(end - p));
+        p = lineEnd ? lineEnd + 1 : end;
+    }
+
+    reader->p = p;
+    reader->end = end;
+    reader->san[0] = '\0';
+    strcpy(reader->result, "*");
+}
+
+static bool IsDelimiter(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '{' || c == '(' || c == ')' || c == ';';
+}
+
+const char *NextPgnMove(PgnMoveReader *reader) {
+    const char *p = reader->p, *end = reader->end;
+    int depth = 0;                  // variation nesting
+
+    while (p < end) {
+        char c = *p;
+
+        if (c == '{') {
+            const char *close = memchr(p, '}', (size_t)(end - p));
+            p = close ? close + 1 : end;
+        } else if (c == ';') {
+            const char *lineEnd = memchr(p, '\n', (size_t)(end - p));
+            p = lineEnd ? lineEnd + 1 : end;
+        } else if (c == '(') {
+            depth++;
+            p++;
+        } else if (c == ')') {
+            if (depth > 0) depth--;
+            p++;
+        } else if (IsDelimiter(c) || c == '.') {
+            p++;
+        } else {
+            const char *token = p;
+            while (p < end && !IsDelimiter(*p)) p++;
+            size_t length = (size_t)(p - token);
+            if (depth > 0 || *token == '$') continue;
+
+            // Results end the game; a move number may run into its move, as in "12.e4"
+            if ((length == 3 && (strncmp(token, "1-0", 3) == 0 || strncmp(token, "0-1", 3) == 0))
+                || (length == 7 && strncmp(token, "1/2-1/2", 7) == 0) || (length == 1 && *token == '*')) {
+                memcpy(reader->result, token, length);
+                reader->result[length] = '\0';
+                reader->p = end;
+                return NULL;
+            }
+            size_t digits = 0;
+            while (digits < length && token[digits] >= '0' && token[digits] <= '9') digits++;
+            if (digits == length) continue; // a move number without its dot
+            if (digits < length && token[digits] == '.') {
+                token += digits;
+                length -= digits;
+                while (length > 0 && *token == '.') token++, length--;
+            }
+            if (length == 0) continue;
+            if (length >= PGN_MAX_SAN) length = PGN_MAX_SAN - 1;
+
+            memcpy(reader->san, token, length);
+            reader->san[length] = '\0';
+            reader->p = p;
+            return reader->san;
+        }
+    }
+    reader->p = end;
+    return NULL;
+}
@@ -0,0 +1,51 @@
+#ifndef PGN_H
+#define PGN_H
+
+#include "movegen.h"
+
+#include <stddef.h>
+
+#define PGN_MAX_SAN 16              // longest SAN kept, e.g. "Qh4xe1=Q+" with room to spare
+
+// Standard algebraic notation. ParseSan accepts check, mate and annotation
+// suffixes, "0-0" for castling and promotions with or without '='; it
+// returns MOVE_NONE for an illegal or ambiguous move.
+Move ParseSan(const Position *pos, const char *san);
+
+// SAN with check and mate marks; buffer needs PGN_MAX_SAN bytes
+void MoveToSan(const Position *pos, Move move, char *buffer);
+
+// One game of a PGN file, pointing into the file's bytes: nothing is copied
+typedef struct PgnGame {
+    const char *text;               // tag section and movetext
+    size_t length;
+} PgnGame;
+
+// Splits a PGN file into games without parsing them: a game ends at its
+// result token, or at a blank line or tag line after its movetext. Brace
+// comments can hide all three, so those are all the scanner tracks.
+typedef struct PgnScanner {
+    const char *data;
+    size_t size;
+    size_t offset;
+} PgnScanner;
+
+void InitPgnScanner(PgnScanner *scanner, const char *data, size_t size);
+bool NextPgnGame(PgnScanner *scanner, PgnGame *game);
+
+// Copies the value of a tag into value, false if the game has no such tag
+bool GetPgnTag(const PgnGame *game, const char *name, char *value, size_t size);
+
+// Walks the movetext of a game, skipping comments, variations, move numbers
+// and NAGs. Returns the SAN of the next move, or NULL at the end of the game;
+// a result token ("1-0", "0-1", "1/2-1/2", "*") ends it and lands in result.
+typedef struct PgnMoveReader {
+    const char *p, *end;
+    char san[PGN_MAX_SAN];
+    char result[8];
+} PgnMoveReader;
+
+void InitPgnMoveReader(PgnMoveReader *reader, const PgnGame *game);
+const char *NextPgnMove(PgnMoveReader *reader);
+
+#endif
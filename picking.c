@@ -0,0 +1,169 @@
+#include "picking.h"
+#include "render.h"
+#include "raymath.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+// State of one PickSquare walk
+typedef struct PickWalk {
+    const BoardLayout *layout;
+    const PieceBounds *bounds;
+    const unsigned char *games;
+    size_t gameStride;
+    Ray ray;
+    float nearest;                  // distance of the closest piece hit so far
+    PickResult result;
+    int tweensTested;               // board whose tweens were tested last, -1 for none
+} PickWalk;
+
+void InitPieceBounds(PieceBounds *bounds, const PieceSet *pieces) {
+    bounds->height = 0.0f;
+    bounds->halfWidth = 0.0f;
+    for (int piece = 0; piece < NO_PIECE; piece++) {
+        const Mesh *mesh = &pieces->meshes[PIECE_TYPE(piece)][0];
+        Matrix transform = PieceTransform(piece, (Vector3){ 0.0f, 0.0f, 0.0f });
+
+        bounds->valid[piece] = mesh->vertices != NULL && mesh->vertexCount > 0;
+        if (!bounds->valid[piece]) continue;
+
+        // Knights are turned, so the box of the placed model is rebuilt from the turned corners
+        BoundingBox local = GetMeshBoundingBox(*mesh);
+        BoundingBox box = { { INFINITY, INFINITY, INFINITY }, { -INFINITY, -INFINITY, -INFINITY } };
+        for (int corner = 0; corner < 8; corner++) {
+            Vector3 point = {
+                corner & 1 ? local.max.x : local.min.x,
+                corner & 2 ? local.max.y : local.min.y,
+                corner & 4 ? local.max.z : local.min.z
+            };
+            point = Vector3Transform(point, transform);
+            box.min = Vector3Min(box.min, point);
+            box.max = Vector3Max(box.max, point);
+        }
+        bounds->boxes[piece] = box;
+
+        bounds->halfWidth = fmaxf(bounds->halfWidth, fmaxf(fmaxf(-box.min.x, box.max.x), fmaxf(-box.min.z, box.max.z)));
+        bounds->height = fmaxf(bounds->height, box.max.y);
+    }
+}
+
+// A square of the world lattice to a board, row and col; false over a gap or off the grid
+static bool CellToSquare(const BoardLayout *layout, int x, int z, int *board, int *row, int *col) {
+    int stride = BOARD_SIZE + layout->gapSquares;
+
+    if (x < 0 || z < 0 || x / stride >= layout->columns) return false;
+    *col = x % stride;
+    *row = z % stride;
+    *board = (z / stride) * layout->columns + x / stride;
+    return *col < BOARD_SIZE && *row < BOARD_SIZE && *board < layout->boardCount;
+}
+
+static Vector3 BoardOrigin(const BoardLayout *layout, int board) {
+    float spacing = (BOARD_SIZE + layout->gapSquares) * layout->squareSize;
+    return (Vector3){
+        layout->origin.x + (board % layout->columns) * spacing,
+        layout->origin.y,
+        layout->origin.z + (board / layout->columns) * spacing
+    };
+}
+
+static void TestPiece(PickWalk *walk, int piece, Vector3 position, int board, int row, int col) {
+    if (piece < 0 || piece >= NO_PIECE || !walk->bounds->valid[piece]) return;
+
+    BoundingBox box = walk->bounds->boxes[piece];
+    box.min = Vector3Add(box.min, position);
+    box.max = Vector3Add(box.max, position);
+
+    RayCollision hit = GetRayCollisionBox(walk->ray, box);
+    if (!hit.hit || hit.distance >= walk->nearest) return;
+
+    walk->nearest = hit.distance;
+    walk->result = (PickResult){ board, row, col, true };
+}
+
+// The piece standing on a square, and the pieces in motion on its board,
+// which are drawn away from their squares
+static void TestCell(PickWalk *walk, int x, int z) {
+    const BoardLayout *layout = walk->layout;
+    int board, row, col;
+
+    if (!CellToSquare(layout, x, z, &board, &row, &col)) return;
+
+    const Game *game = (const Game *)(walk->games + board * walk->gameStride);
+    Vector3 origin = BoardOrigin(layout, board);
+    float size = layout->squareSize;
+
+    if (!IsSquareTweened(&game->tweens, row * BOARD_SIZE + col)) {
+        Vector3 position = { origin.x + col * size, origin.y, origin.z + row * size };
+        TestPiece(walk, PieceOn(&game->pos, SQUARE_FROM_ROWCOL(row, col)), position, board, row, col);
+    }
+
+    if (walk->tweensTested == board) return;
+    walk->tweensTested = board;
+    for (int i = 0; i < game->tweens.count; i++) {
+        const Tween *tween = &game->tweens.tweens[i];
+        if (tween->square < 0) continue; // a captured piece on its way out
+
+        Vector3 local = TweenPosition(tween);
+        Vector3 position = Vector3Add(origin, Vector3Scale(local, size));
+        TestPiece(walk, tween->piece, position, board, tween->square / BOARD_SIZE, tween->square % BOARD_SIZE);
+    }
+}
+
+// Lattice coordinates of a world point: square centers are whole numbers
+static float LatticeX(const BoardLayout *layout, Vector3 point) {
+    return (point.x - layout->origin.x) / layout->squareSize + 0.5f;
+}
+
+static float LatticeZ(const BoardLayout *layout, Vector3 point) {
+    return (point.z - layout->origin.z) / layout->squareSize + 0.5f;
+}
+
+PickResult PickSquare(const BoardLayout *layout, const PieceBounds *bounds, const Game *games, size_t gameStride, Ray ray) {
+    PickWalk walk = { layout, bounds, (const unsigned char *)games, gameStride, ray, INFINITY, { -1, -1, -1, false }, -1 };
+
+    // Only a ray heading down reaches the boards
+    if (ray.direction.y >= -1e-6f) return walk.result;
+
+    float surfaceT = (layout->origin.y + BOARD_SURFACE_HEIGHT - ray.position.y) / ray.direction.y;
+    float topT = (layout->origin.y + bounds->height - ray.position.y) / ray.direction.y;
+    if (surfaceT < 0.0f) return walk.result;
+    if (topT < 0.0f) topT = 0.0f;
+
+    // Walk the squares under the ray from the tallest piece's top down to the
+    // surface, one square boundary at a time (Amanatides and Woo)
+    Vector3 top = Vector3Add(ray.position, Vector3Scale(ray.direction, topT));
+    Vector3 surface = Vector3Add(ray.position, Vector3Scale(ray.direction, surfaceT));
+    float u0 = LatticeX(layout, top), v0 = LatticeZ(layout, top);
+    float u1 = LatticeX(layout, surface), v1 = LatticeZ(layout, surface);
+    int x = (int)floorf(u0), z = (int)floorf(v0);
+    int endX = (int)floorf(u1), endZ = (int)floorf(v1);
+    int stepX = endX > x ? 1 : -1, stepZ = endZ > z ? 1 : -1;
+    float du = fabsf(u1 - u0), dv = fabsf(v1 - v0);
+    float nextX = du > 0.0f ? (stepX > 0 ? x + 1 - u0 : u0 - x) / du : INFINITY;
+    float nextZ = dv > 0.0f ? (stepZ > 0 ? z + 1 - v0 : v0 - z) / dv : INFINITY;
+    int steps = abs(endX - x) + abs(endZ - z);
+    int reach = (int)ceilf(bounds->halfWidth / layout->squareSize - 0.5f); // squares a box sticks out of its own, usually 0
+    if (reach < 0) reach = 0;
+
+    for (int step = 0; step <= steps; step++) {
+        for (int dz = -reach; dz <= reach; dz++) {
+            for (int dx = -reach; dx <= reach; dx++) TestCell(&walk, x + dx, z + dz);
+        }
+        if (step == steps) break;
+
+        if (x != endX && (z == endZ || nextX < nextZ)) {
+            x += stepX;
+            nextX += 1.0f / du;
+        } else {
+            z += stepZ;
+            nextZ += 1.0f / dv;
+        }
+    }
+    if (walk.result.onPiece) return walk.result;
+
+    // No piece in the way: the square of the surface point, rounded to the nearest center
+    int board, row, col;
+    if (CellToSquare(layout, endX, endZ, &board, &row, &col)) walk.result = (PickResult){ board, row, col, false };
+    return walk.result;
+}
@@ -0,0 +1,50 @@
+#ifndef PICKING_H
+#define PICKING_H
+
+#include "raylib.h"
+#include "assets.h"
+#include "game.h"
+
+#include <stddef.h>
+
+#define BOARD_SURFACE_HEIGHT 0.05f     // top face of the squares, which are drawn 0.1 thick around the origin
+
+// Where boards lie: flat, a8 centered at the origin of board 0, squares
+// centered on whole multiples of squareSize, boards in rows of columns with
+// gapSquares empty squares between neighbors. The interactive game is one
+// board in one column.
+typedef struct BoardLayout {
+    Vector3 origin;
+    float squareSize;
+    int columns;
+    int boardCount;
+    int gapSquares;
+} BoardLayout;
+
+// Bounding boxes of the piece models as PieceTransform places them on a square
+// centered at the origin; a piece elsewhere is the same box moved
+typedef struct PieceBounds {
+    BoundingBox boxes[NO_PIECE];
+    bool valid[NO_PIECE];           // false where the model did not load
+    float height;                   // top of the tallest piece
+    float halfWidth;                // farthest a box reaches across the board from its square's center
+} PieceBounds;
+
+typedef struct PickResult {
+    int board;                      // -1 when the ray hits no square
+    int row, col;
+    bool onPiece;                   // hit a piece model rather than the board surface
+} PickResult;
+
+void InitPieceBounds(PieceBounds *bounds, const PieceSet *pieces);
+
+// The square under the mouse ray. A piece model hit by the ray wins over the
+// surface, so a tall piece standing in front of a square is picked by its
+// head. The squares themselves are the spatial index: the ray only visits
+// the few squares under its path between the tallest piece's top and the
+// surface, so the cost does not depend on how many boards there are.
+// Pieces come from games[board], the boards' Game structs gameStride bytes
+// apart, so an array of structs that hold a Game works as well.
+PickResult PickSquare(const BoardLayout *layout, const PieceBounds *bounds, const Game *games, size_t gameStride, Ray ray);
+
+#endif
@@ -0,0 +1,400 @@
+#include "platform.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <winsock2.h>
+#include <afunix.h>
+#include <windows.h>
+#include <process.h>
+#if defined(_MSC_VER)
+#pragma comment(lib, "ws2_32.lib")
+#endif
+#else
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+int64_t GetMicroseconds(void) {
+#if defined(_WIN32)
+    static LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    if (frequency.QuadPart == 0) QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (int64_t)(counter.QuadPart / frequency.QuadPart) * 1000000
+         + (int64_t)(counter.QuadPart % frequency.QuadPart) * 1000000 / frequency.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#endif
+}
+
+int GetProcessorCount(void) {
+#if defined(_WIN32)
+    // Counts every processor group, so machines with more than 64 cores report all of them
+    DWORD count = GetActiveProcessorCount(ALL_PROCESSOR_GROUPS);
+#else
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    return count > 0 ? (int)count : 1;
+}
+
+struct PlatformThread {
+#if defined(_WIN32)
+    HANDLE handle;
+#else
+    pthread_t handle;
+#endif
+    ThreadFunction function;
+    void *arg;
+};
+
+#if defined(_WIN32)
+static unsigned __stdcall ThreadEntry(void *arg) {
+#else
+static void *ThreadEntry(void *arg) {
+#endif
+    PlatformThread *thread = arg;
+    thread->function(thread->arg);
+    return 0;
+}
+
+PlatformThread *StartThread(ThreadFunction function, void *arg) {
+    PlatformThread *thread = malloc(sizeof(*thread));
+    if (!thread) return NULL;
+
+    thread->function = function;
+    thread->arg = arg;
+
+#if defined(_WIN32)
+    thread->handle = (HANDLE)_beginthreadex(NULL, 0, ThreadEntry, thread, 0, NULL);
+    if (!thread->handle) {
+#else
+    if (pthread_create(&thread->handle, NULL, ThreadEntry, thread) != 0) {
+#endif
+        free(thread);
+        return NULL;
+    }
+    return thread;
+}
+
+void JoinThread(PlatformThread *thread) {
+#if defined(_WIN32)
+    WaitForSingleObject(thread->handle, INFINITE);
+    CloseHandle(thread->handle);
+#else
+    pthread_join(thread->handle, NULL);
+#endif
+    free(thread);
+}
+
+void LowerThreadPriority(void) {
+#if defined(_WIN32)
+    SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_BELOW_NORMAL);
+#elif defined(__linux__)
+    // Linux applies the nice value to the calling thread only
+    setpriority(PRIO_PROCESS, 0, 10);
+#endif
+}
+
+void SleepMilliseconds(int milliseconds) {
+#if defined(_WIN32)
+    Sleep((DWORD)milliseconds);
+#else
+    struct timespec ts = { milliseconds / 1000, (long)(milliseconds % 1000) * 1000000 };
+    nanosleep(&ts, NULL);
+#endif
+}
+
+struct PlatformSignal {
+#if defined(_WIN32)
+    HANDLE event;
+#else
+    pthread_mutex_t mutex;
+    pthread_cond_t condition;
+    bool set;
+#endif
+};
+
+PlatformSignal *CreateSignal(void) {
+    PlatformSignal *signal = malloc(sizeof(*signal));
+    if (!signal) return NULL;
+
+#if defined(_WIN32)
+    signal->event = CreateEventW(NULL, FALSE, FALSE, NULL);
+    if (!signal->event) {
+        free(signal);
+        return NULL;
+    }
+#else
+    pthread_mutex_init(&signal->mutex, NULL);
+    pthread_cond_init(&signal->condition, NULL);
+    signal->set = false;
+#endif
+    return signal;
+}
+
+void DestroySignal(PlatformSignal *signal) {
+    if (!signal) return;
+#if defined(_WIN32)
+    CloseHandle(signal->event);
+#else
+    pthread_cond_destroy(&signal->condition);
+    pthread_mutex_destroy(&signal->mutex);
+#endif
+    free(signal);
+}
+
+void SetSignal(PlatformSignal *signal) {
+#if defined(_WIN32)
+    SetEvent(signal->event);
+#else
+    pthread_mutex_lock(&signal->mutex);
+    signal->set = true;
+    pthread_cond_signal(&signal->condition);
+    pthread_mutex_unlock(&signal->mutex);
+#endif
+}
+
+void WaitSignal(PlatformSignal *signal) {
+#if defined(_WIN32)
+    WaitForSingleObject(signal->event, INFINITE);
+#else
+    pthread_mutex_lock(&signal->mutex);
+    while (!signal->set) pthread_cond_wait(&signal->condition, &signal->mutex);
+    signal->set = false;
+    pthread_mutex_unlock(&signal->mutex);
+#endif
+}
+
+bool MapFile(MappedFile *file, const char *path) {
+    file->data = NULL;
+    file->size = 0;
+
+#if defined(_WIN32)
+    HANDLE handle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (handle == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(handle, &size) || size.QuadPart == 0 || (uint64_t)size.QuadPart > SIZE_MAX) {
+        CloseHandle(handle);
+        return false;
+    }
+
+    // The view keeps the mapping alive, so both handles can be closed right away
+    HANDLE mapping = CreateFileMappingA(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(handle);
+    if (!mapping) return false;
+    file->data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (!file->data) return false;
+    file->size = (size_t)size.QuadPart;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+        close(fd);
+        return false;
+    }
+
+    void *data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return false;
+    file->data = data;
+    file->size = (size_t)info.st_size;
+#endif
+    return true;
+}
+
+void UnmapFile(MappedFile *file) {
+    if (!file->data) return;
+#if defined(_WIN32)
+    UnmapViewOfFile(file->data);
+#else
+    munmap((void *)file->data, file->size);
+#endif
+    file->data = NULL;
+    file->size = 0;
+}
+
+bool MakeDirectory(const char *path) {
+#if defined(_WIN32)
+    return CreateDirectoryA(path, NULL) || GetLastError() == ERROR_ALREADY_EXISTS;
+#else
+    struct stat info;
+    return mkdir(path, 0777) == 0 || (stat(path, &info) == 0 && S_ISDIR(info.st_mode));
+#endif
+}
+
+struct LocalSocket {
+#if defined(_WIN32)
+    SOCKET handle;
+#else
+    int handle;
+#endif
+    char path[108];                 // a listener's socket file, empty otherwise
+};
+
+#if defined(_WIN32)
+#define SOCKET_INVALID INVALID_SOCKET
+#define CloseSocketHandle closesocket
+#else
+#define SOCKET_INVALID (-1)
+#define CloseSocketHandle close
+#endif
+
+// Fills in the address; false if the path does not fit
+static bool LocalAddress(struct sockaddr_un *address, const char *path) {
+#if defined(_WIN32)
+    static bool started;            // sockets are opened by the main thread only
+    WSADATA data;
+    if (!started) started = WSAStartup(MAKEWORD(2, 2), &data) == 0;
+#endif
+    memset(address, 0, sizeof(*address));
+    address->sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(address->sun_path)) return false;
+    strcpy(address->sun_path, path);
+    return true;
+}
+
+static LocalSocket *WrapSocket(LocalSocket *socket, const char *path) {
+    LocalSocket *wrapped = malloc(sizeof(*wrapped));
+    if (!wrapped) {
+        CloseSocketHandle(socket->handle);
+        return NULL;
+    }
+    *wrapped = *socket;
+    snprintf(wrapped->path, sizeof(wrapped->path), "%s", path);
+    return wrapped;
+}
+
+#if defined(_WIN32) && !defined(IO_REPARSE_TAG_AF_UNIX)
+#define IO_REPARSE_TAG_AF_UNIX 0x80000023L
+#endif
+
+// True if the file at path is a socket that refuses connections
+static bool StaleLocalSocket(const char *path, const struct sockaddr_un *address) {
+#if defined(_WIN32)
+    WIN32_FIND_DATAA data;
+    HANDLE find = FindFirstFileA(path, &data);
+    if (find == INVALID_HANDLE_VALUE) return false;
+    FindClose(find);
+    if (!(data.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) || data.dwReserved0 != IO_REPARSE_TAG_AF_UNIX) return false;
+#else
+    struct stat info;
+    if (lstat(path, &info) != 0 || !S_ISSOCK(info.st_mode)) return false;
+#endif
+
+    LocalSocket probe;
+    probe.handle = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (probe.handle == SOCKET_INVALID) return false;
+    bool refused = connect(probe.handle, (const struct sockaddr *)address, sizeof(*address)) != 0;
+#if defined(_WIN32)
+    refused = refused && WSAGetLastError() == WSAECONNREFUSED;
+#else
+    refused = refused && errno == ECONNREFUSED;
+#endif
+    CloseSocketHandle(probe.handle);
+    return refused;
+}
+
+LocalSocket *ListenLocalSocket(const char *path, bool *inUse) {
+    struct sockaddr_un address;
+    LocalSocket listener;
+
+    *inUse = false;
+    if (!LocalAddress(&address, path)) return NULL;
+    listener.handle = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener.handle == SOCKET_INVALID) return NULL;
+
+    if (StaleLocalSocket(path, &address)) remove(path);
+    if (bind(listener.handle, (struct sockaddr *)&address, sizeof(address)) != 0) {
+#if defined(_WIN32)
+        *inUse = WSAGetLastError() == WSAEADDRINUSE;
+#else
+        *inUse = errno == EADDRINUSE;
+#endif
+        CloseSocketHandle(listener.handle);
+        return NULL;
+    }
+    if (listen(listener.handle, 16) != 0) {
+        CloseSocketHandle(listener.handle);
+        remove(path);
+        return NULL;
+    }
+    return WrapSocket(&listener, path);
+}
+
+LocalSocket *AcceptLocalSocket(LocalSocket *listener) {
+    LocalSocket client;
+
+    client.handle = accept(listener->handle, NULL, NULL);
+    if (client.handle == SOCKET_INVALID) return NULL;
+    return WrapSocket(&client, "");
+}
+
+LocalSocket *ConnectLocalSocket(const char *path) {
+    struct sockaddr_un address;
+    LocalSocket server;
+
+    if (!LocalAddress(&address, path)) return NULL;
+    server.handle = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (server.handle == SOCKET_INVALID) return NULL;
+    if (connect(server.handle, (struct sockaddr *)&address, sizeof(address)) != 0) {
+        CloseSocketHandle(server.handle);
+        return NULL;
+    }
+    return WrapSocket(&server, "");
+}
+
+int ReadLocalSocket(LocalSocket *socket, void *buffer, int size) {
+    int received = (int)recv(socket->handle, buffer, size, 0);
+    return received < 0 ? -1 : received;
+}
+
+bool WriteLocalSocket(LocalSocket *socket, const void *buffer, int size) {
+    const char *bytes = buffer;
+
+    // A peer that hung up must fail the write, not raise SIGPIPE
+#if defined(MSG_NOSIGNAL)
+    int flags = MSG_NOSIGNAL;
+#else
+    int flags = 0;
+#endif
+    while (size > 0) {
+        int sent = (int)send(socket->handle, bytes, size, flags);
+        if (sent <= 0) return false;
+        bytes += sent;
+        size -= sent;
+    }
+    return true;
+}
+
+void FinishLocalSocket(LocalSocket *socket) {
+#if defined(_WIN32)
+    shutdown(socket->handle, SD_SEND);
+#else
+    shutdown(socket->handle, SHUT_WR);
+#endif
+}
+
+void CloseLocalSocket(LocalSocket *socket) {
+    if (!socket) return;
+    CloseSocketHandle(socket->handle);
+    if (socket->path[0]) remove(socket->path);
+    free(socket);
+}
@@ -0,0 +1,121 @@
+#ifndef PLATFORM_H
+#define PLATFORM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// OS services used by the engine and tools. Kept out of raylib code paths so
+// windows.h never meets raylib.h in the same translation unit.
+
+// Monotonic clock in microseconds
+int64_t GetMicroseconds(void);
+
+// Logical processors available to this process, at least 1
+int GetProcessorCount(void);
+
+typedef struct PlatformThread PlatformThread;
+typedef void (*ThreadFunction)(void *arg);
+
+// Returns NULL if the thread could not be created
+PlatformThread *StartThread(ThreadFunction function, void *arg);
+void JoinThread(PlatformThread *thread);
+
+// Lets the calling thread yield to the render thread when cores are contended
+void LowerThreadPriority(void);
+void SleepMilliseconds(int milliseconds);
+
+// Read-only view of a whole file; pages are loaded on first touch and shared
+// with the OS file cache
+typedef struct MappedFile {
+    const unsigned char *data;
+    size_t size;
+} MappedFile;
+
+// Returns false for a missing or empty file
+bool MapFile(MappedFile *file, const char *path);
+void UnmapFile(MappedFile *file);
+
+// Creates a directory; true if it exists afterwards
+bool MakeDirectory(const char *path);
+
+// Local stream socket: a Unix domain socket at a file path. Windows has them
+// since Windows 10 version 1803.
+typedef struct LocalSocket LocalSocket;
+
+// Listens at path; NULL on failure. Only a socket file that refuses
+// connections, left behind by a server that died, is replaced: when a live
+// server or any other file holds the path, *inUse is set and nothing is removed.
+LocalSocket *ListenLocalSocket(const char *path, bool *inUse);
+
+// Blocks until a client connects; NULL if the listener failed
+LocalSocket *AcceptLocalSocket(LocalSocket *listener);
+LocalSocket *ConnectLocalSocket(const char *path);
+
+// Bytes read, 0 once the peer has finished writing, -1 on error
+int ReadLocalSocket(LocalSocket *socket, void *buffer, int size);
+
+// Writes all of buffer; false if the peer is gone
+bool WriteLocalSocket(LocalSocket *socket, const void *buffer, int size);
+
+// No more writes: the peer reads the end of the stream, and can still answer
+void FinishLocalSocket(LocalSocket *socket);
+
+// A listener also removes its socket file
+void CloseLocalSocket(LocalSocket *socket);
+
+// Auto-reset event: one WaitSignal returns per SetSignal, extra sets are merged
+typedef struct PlatformSignal PlatformSignal;
+
+PlatformSignal *CreateSignal(void);
+void DestroySignal(PlatformSignal *signal);
+void SetSignal(PlatformSignal *signal);
+void WaitSignal(PlatformSignal *signal);
+
+// Sequentially consistent atomics for flags and counters shared between threads
+static inline int AtomicLoad(volatile int *value) {
+#if defined(_MSC_VER)
+    return _InterlockedOr((volatile long *)value, 0);
+#else
+    return __atomic_load_n(value, __ATOMIC_SEQ_CST);
+#endif
+}
+
+static inline void AtomicStore(volatile int *value, int newValue) {
+#if defined(_MSC_VER)
+    _InterlockedExchange((volatile long *)value, newValue);
+#else
+    __atomic_store_n(value, newValue, __ATOMIC_SEQ_CST);
+#endif
+}
+
+// Sets *value to desired if it equals expected; true if it did
+static inline bool AtomicCompareExchange(volatile int *value, int expected, int desired) {
+#if defined(_MSC_VER)
+    return _InterlockedCompareExchange((volatile long *)value, desired, expected) == expected;
+#else
+    return __atomic_compare_exchange_n(value, &expected, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+#endif
+}
+
+static inline int64_t AtomicLoad64(volatile int64_t *value) {
+#if defined(_MSC_VER)
+    return _InterlockedCompareExchange64(value, 0, 0);
+#else
+    return __atomic_load_n(value, __ATOMIC_SEQ_CST);
+#endif
+}
+
+static inline int64_t AtomicAdd64(volatile int64_t *value, int64_t delta) {
+#if defined(_MSC_VER)
+    return _InterlockedExchangeAdd64(value, delta) + delta;
+#else
+    return __atomic_add_fetch(value, delta, __ATOMIC_SEQ_CST);
+#endif
+}
+
+#endif
@@ -0,0 +1,524 @@
+#include "position.h"
+#include "psqt.h"
+#include "random.h"
+
+#include <stdio.h>
+#include <string.h>
+
+static const char pieceChars[] = "PNBRQKpnbrqk.";
+
+// Castling rights that survive a move touching each square
+static int castlingMask[64];
+
+uint64_t zobristPieces[NO_PIECE][64];
+uint64_t zobristCastling[16];
+uint64_t zobristEp[8];
+uint64_t zobristSide;
+
+void InitPositionTables(void) {
+    uint64_t seed = 1070372;    // fixed, so keys are the same in every build and run
+
+    for (int sq = 0; sq < 64; sq++) castlingMask[sq] = CASTLE_ALL;
+    castlingMask[SQ_E1] &= ~(CASTLE_WHITE_KING | CASTLE_WHITE_QUEEN);
+    castlingMask[SQ_H1] &= ~CASTLE_WHITE_KING;
+    castlingMask[SQ_A1] &= ~CASTLE_WHITE_QUEEN;
+    castlingMask[SQ_E8] &= ~(CASTLE_BLACK_KING | CASTLE_BLACK_QUEEN);
+    castlingMask[SQ_H8] &= ~CASTLE_BLACK_KING;
+    castlingMask[SQ_A8] &= ~CASTLE_BLACK_QUEEN;
+
+    for (int piece = 0; piece < NO_PIECE; piece++) {
+        for (int sq = 0; sq < 64; sq++) zobristPieces[piece][sq] = NextRandom(&seed);
+    }
+
+    // One key per right; a set of rights is the XOR of its members
+    uint64_t rights[4];
+    for (int i = 0; i < 4; i++) rights[i] = NextRandom(&seed);
+    for (int mask = 0; mask < 16; mask++) {
+        zobristCastling[mask] = 0;
+        for (int i = 0; i < 4; i++) {
+            if (mask & (1 << i)) zobristCastling[mask] ^= rights[i];
+        }
+    }
+
+    for (int file = 0; file < 8; file++) zobristEp[file] = NextRandom(&seed);
+    zobristSide = NextRandom(&seed);
+    InitPsqt();
+}
+
+char PieceToChar(int piece) {
+    return pieceChars[piece];
+}
+
+int CharToPiece(char c) {
+    for (int piece = 0; piece < NO_PIECE; piece++) {
+        if (pieceChars[piece] == c) return piece;
+    }
+    return NO_PIECE;
+}
+
+static void PutPiece(Position *pos, int piece, int sq) {
+    int side = PIECE_SIDE(piece);
+    pos->pieces[side][PIECE_TYPE(piece)] |= BB(sq);
+    pos->occupancy[side] |= BB(sq);
+    pos->occupancy[SIDE_BOTH] |= BB(sq);
+    pos->squares[sq] = (unsigned char)piece;
+    pos->key ^= zobristPieces[piece][sq];
+    if (PIECE_TYPE(piece) == PIECE_PAWN) pos->pawnKey ^= zobristPieces[piece][sq];
+    pos->psqMg += psqtMg[piece][sq];
+    pos->psqEg += psqtEg[piece][sq];
+    pos->phase += phaseWeights[PIECE_TYPE(piece)];
+}
+
+static void RemovePiece(Position *pos, int sq) {
+    int piece = pos->squares[sq];
+    int side = PIECE_SIDE(piece);
+    pos->pieces[side][PIECE_TYPE(piece)] &= ~BB(sq);
+    pos->occupancy[side] &= ~BB(sq);
+    pos->occupancy[SIDE_BOTH] &= ~BB(sq);
+    pos->squares[sq] = NO_PIECE;
+    pos->key ^= zobristPieces[piece][sq];
+    if (PIECE_TYPE(piece) == PIECE_PAWN) pos->pawnKey ^= zobristPieces[piece][sq];
+    pos->psqMg -= psqtMg[piece][sq];
+    pos->psqEg -= psqtEg[piece][sq];
+    pos->phase -= phaseWeights[PIECE_TYPE(piece)];
+}
+
+static void ShiftPiece(Position *pos, int from, int to) {
+    int piece = pos->squares[from];
+    int side = PIECE_SIDE(piece);
+    Bitboard fromTo = BB(from) | BB(to);
+    pos->pieces[side][PIECE_TYPE(piece)] ^= fromTo;
+    pos->occupancy[side] ^= fromTo;
+    pos->occupancy[SIDE_BOTH] ^= fromTo;
+    pos->squares[from] = NO_PIECE;
+    pos->squares[to] = (unsigned char)piece;
+
+    uint64_t fromToKey = zobristPieces[piece][from] ^ zobristPieces[piece][to];
+    pos->key ^= fromToKey;
+    if (PIECE_TYPE(piece) == PIECE_PAWN) pos->pawnKey ^= fromToKey;
+    pos->psqMg += psqtMg[piece][to] - psqtMg[piece][from];
+    pos->psqEg += psqtEg[piece][to] - psqtEg[piece][from];
+}
+
+static void UpdateLegality(Position *pos);
+
+static void ClearPosition(Position *pos) {
+    memset(pos, 0, sizeof(*pos));
+    memset(pos->squares, NO_PIECE, sizeof(pos->squares));
+    pos->epSquare = SQ_NONE;
+    pos->fullmoveNumber = 1;
+}
+
+// The rights whose king and rook are on their home squares. Any other right
+// could never be used, and castling with it would move a rook that is not there.
+static int ValidCastling(const Position *pos, int castling) {
+    static const struct { int right, king, rook, side; } homes[4] = {
+        { CASTLE_WHITE_KING, SQ_E1, SQ_H1, SIDE_WHITE }, { CASTLE_WHITE_QUEEN, SQ_E1, SQ_A1, SIDE_WHITE },
+        { CASTLE_BLACK_KING, SQ_E8, SQ_H8, SIDE_BLACK }, { CASTLE_BLACK_QUEEN, SQ_E8, SQ_A8, SIDE_BLACK }
+    };
+
+    for (int i = 0; i < 4; i++) {
+        if (pos->squares[homes[i].king] != MAKE_PIECE(homes[i].side, PIECE_KING)
+            || pos->squares[homes[i].rook] != MAKE_PIECE(homes[i].side, PIECE_ROOK)) {
+            castling &= ~homes[i].right;
+        }
+    }
+    return castling & CASTLE_ALL;
+}
+
+// The en passant square as MakeMove would have recorded it: SQ_NONE unless
+// a pawn of the side to move can capture there. Returns -1 for a square that
+// cannot follow a double push of the other side.
+static int ValidEpSquare(const Position *pos, int epSquare) {
+    int us = pos->sideToMove, them = us ^ 1;
+
+    if (epSquare == SQ_NONE) return SQ_NONE;
+    if (epSquare < 0 || epSquare > 63 || SQUARE_RANK(epSquare) != (them == SIDE_WHITE ? 2 : 5)) return -1;
+
+    int pushed = them == SIDE_WHITE ? epSquare + 8 : epSquare - 8;
+    int start = them == SIDE_WHITE ? epSquare - 8 : epSquare + 8;
+    if (pos->squares[pushed] != MAKE_PIECE(them, PIECE_PAWN) || pos->squares[epSquare] != NO_PIECE
+        || pos->squares[start] != NO_PIECE) {
+        return -1;
+    }
+    return pawnAttacks[them][epSquare] & pos->pieces[us][PIECE_PAWN] ? epSquare : SQ_NONE;
+}
+
+void ComputeKeys(const Position *pos, uint64_t *key, uint64_t *pawnKey) {
+    *key = 0;
+    *pawnKey = 0;
+
+    for (int sq = 0; sq < 64; sq++) {
+        int piece = pos->squares[sq];
+        if (piece == NO_PIECE) continue;
+        *key ^= zobristPieces[piece][sq];
+        if (PIECE_TYPE(piece) == PIECE_PAWN) *pawnKey ^= zobristPieces[piece][sq];
+    }
+
+    *key ^= zobristCastling[pos->castling];
+    if (pos->epSquare != SQ_NONE) *key ^= zobristEp[SQUARE_FILE(pos->epSquare)];
+    if (pos->sideToMove == SIDE_BLACK) *key ^= zobristSide;
+}
+
+void PositionFromBoard(Position *pos, const char board[8][8], int sideToMove, int castling) {
+    ClearPosition(pos);
+
+    for (int row = 0; row < 8; row++) {
+        for (int col = 0; col < 8; col++) {
+            int piece = CharToPiece(board[row][col]);
+            if (piece != NO_PIECE) PutPiece(pos, piece, SQUARE_FROM_ROWCOL(row, col));
+        }
+    }
+
+    pos->sideToMove = sideToMove;
+    pos->castling = ValidCastling(pos, castling);
+    ComputeKeys(pos, &pos->key, &pos->pawnKey);
+    UpdateLegality(pos);
+}
+
+void PositionToBoard(const Position *pos, char board[8][8]) {
+    for (int row = 0; row < 8; row++) {
+        for (int col = 0; col < 8; col++) {
+            board[row][col] = PieceToChar(pos->squares[SQUARE_FROM_ROWCOL(row, col)]);
+        }
+    }
+}
+
+bool PositionFromSquares(Position *pos, const unsigned char squares[64], int sideToMove, int castling, int epSquare) {
+    Position built;
+
+    ClearPosition(&built);
+    for (int sq = 0; sq < 64; sq++) {
+        if (squares[sq] > NO_PIECE) return false;
+        if (squares[sq] != NO_PIECE) PutPiece(&built, squares[sq], sq);
+    }
+    if (PopCount(built.pieces[SIDE_WHITE][PIECE_KING]) != 1) return false;
+    if (PopCount(built.pieces[SIDE_BLACK][PIECE_KING]) != 1) return false;
+
+    built.sideToMove = sideToMove == SIDE_BLACK ? SIDE_BLACK : SIDE_WHITE;
+    built.castling = ValidCastling(&built, castling);
+    built.epSquare = ValidEpSquare(&built, epSquare);
+    if (built.epSquare < 0) return false;
+
+    // PutPiece already hashed the pieces
+    built.key ^= zobristCastling[built.castling];
+    if (built.epSquare != SQ_NONE) built.key ^= zobristEp[SQUARE_FILE(built.epSquare)];
+    if (built.sideToMove == SIDE_BLACK) built.key ^= zobristSide;
+    UpdateLegality(&built);
+    *pos = built;
+    return true;
+}
+
+bool PositionFromFen(Position *pos, const char *fen) {
+    Position parsed;
+    const char *p = fen;
+    int file = 0, rank = 7;
+
+    ClearPosition(&parsed);
+
+    // Piece placement, rank 8 first
+    for (; *p && *p != ' '; p++) {
+        if (*p == '/') {
+            if (file != 8 || rank == 0) return false;
+            file = 0;
+            rank--;
+        } else if (*p >= '1' && *p <= '8') {
+            file += *p - '0';
+            if (file > 8) return false;
+        } else {
+            int piece = CharToPiece(*p);
+            if (piece == NO_PIECE || file > 7) return false;
+            PutPiece(&parsed, piece, SQUARE(file, rank));
+            file++;
+        }
+    }
+    if (file != 8 || rank != 0) return false;
+    if (PopCount(parsed.pieces[SIDE_WHITE][PIECE_KING]) != 1) return false;
+    if (PopCount(parsed.pieces[SIDE_BLACK][PIECE_KING]) != 1) return false;
+
+    while (*p == ' ') p++;
+    if (*p == 'w') parsed.sideToMove = SIDE_WHITE;
+    else if (*p == 'b') parsed.sideToMove = SIDE_BLACK;
+    else return false;
+    p++;
+
+    while (*p == ' ') p++;
+    for (; *p && *p != ' '; p++) {
+        switch (*p) {
+        case 'K': parsed.castling |= CASTLE_WHITE_KING; break;
+        case 'Q': parsed.castling |= CASTLE_WHITE_QUEEN; break;
+        case 'k': parsed.castling |= CASTLE_BLACK_KING; break;
+        case 'q': parsed.castling |= CASTLE_BLACK_QUEEN; break;
+        case '-': break;
+        default: return false;
+        }
+    }
+
+    parsed.castling = ValidCastling(&parsed, parsed.castling);
+
+    while (*p == ' ') p++;
+    if (p[0] >= 'a' && p[0] <= 'h' && (p[1] == '3' || p[1] == '6')) {
+        parsed.epSquare = SQUARE(p[0] - 'a', p[1] - '1');
+        p += 2;
+    } else if (*p == '-') {
+        p++;
+    } else if (*p) {
+        return false;
+    }
+    parsed.epSquare = ValidEpSquare(&parsed, parsed.epSquare);
+    if (parsed.epSquare < 0) return false;
+
+    // Move counters are optional (EPD lines omit them)
+    int halfmove = 0, fullmove = 1;
+    if (sscanf(p, " %d %d", &halfmove, &fullmove) == 2) {
+        parsed.halfmoveClock = halfmove;
+        parsed.fullmoveNumber = fullmove > 0 ? fullmove : 1;
+    }
+
+    ComputeKeys(&parsed, &parsed.key, &parsed.pawnKey);
+    UpdateLegality(&parsed);
+    *pos = parsed;
+    return true;
+}
+
+void PositionToFen(const Position *pos, char *fen, int size) {
+    char buffer[100];
+    int n = 0;
+
+    for (int rank = 7; rank >= 0; rank--) {
+        int empty = 0;
+        for (int file = 0; file < 8; file++) {
+            int piece = pos->squares[SQUARE(file, rank)];
+            if (piece == NO_PIECE) {
+                empty++;
+                continue;
+            }
+            if (empty) buffer[n++] = (char)('0' + empty);
+            empty = 0;
+            buffer[n++] = PieceToChar(piece);
+        }
+        if (empty) buffer[n++] = (char)('0' + empty);
+        if (rank > 0) buffer[n++] = '/';
+    }
+
+    buffer[n++] = ' ';
+    buffer[n++] = pos->sideToMove == SIDE_WHITE ? 'w' : 'b';
+    buffer[n++] = ' ';
+    if (pos->castling & CASTLE_WHITE_KING) buffer[n++] = 'K';
+    if (pos->castling & CASTLE_WHITE_QUEEN) buffer[n++] = 'Q';
+    if (pos->castling & CASTLE_BLACK_KING) buffer[n++] = 'k';
+    if (pos->castling & CASTLE_BLACK_QUEEN) buffer[n++] = 'q';
+    if (!pos->castling) buffer[n++] = '-';
+    buffer[n++] = ' ';
+    if (pos->epSquare != SQ_NONE) {
+        buffer[n++] = (char)('a' + SQUARE_FILE(pos->epSquare));
+        buffer[n++] = (char)('1' + SQUARE_RANK(pos->epSquare));
+    } else {
+        buffer[n++] = '-';
+    }
+    buffer[n] = '\0';
+
+    snprintf(fen, size, "%s %d %d", buffer, pos->halfmoveClock, pos->fullmoveNumber);
+}
+
+void MoveToString(Move move, char *buffer) {
+    static const char promotionChars[] = "nbrq";
+    int from = MOVE_FROM(move), to = MOVE_TO(move);
+
+    buffer[0] = (char)('a' + SQUARE_FILE(from));
+    buffer[1] = (char)('1' + SQUARE_RANK(from));
+    buffer[2] = (char)('a' + SQUARE_FILE(to));
+    buffer[3] = (char)('1' + SQUARE_RANK(to));
+    buffer[4] = MOVE_IS_PROMOTION(move) ? promotionChars[MOVE_FLAGS(move) & 3] : '\0';
+    buffer[5] = '\0';
+}
+
+Bitboard AttackersTo(const Position *pos, int sq, Bitboard occupied) {
+    const Bitboard (*p)[PIECE_TYPE_COUNT] = pos->pieces;
+
+    return (pawnAttacks[SIDE_BLACK][sq] & p[SIDE_WHITE][PIECE_PAWN])
+         | (pawnAttacks[SIDE_WHITE][sq] & p[SIDE_BLACK][PIECE_PAWN])
+         | (knightAttacks[sq] & (p[SIDE_WHITE][PIECE_KNIGHT] | p[SIDE_BLACK][PIECE_KNIGHT]))
+         | (kingAttacks[sq] & (p[SIDE_WHITE][PIECE_KING] | p[SIDE_BLACK][PIECE_KING]))
+         | (BishopAttacks(sq, occupied) & (p[SIDE_WHITE][PIECE_BISHOP] | p[SIDE_BLACK][PIECE_BISHOP]
+                                         | p[SIDE_WHITE][PIECE_QUEEN] | p[SIDE_BLACK][PIECE_QUEEN]))
+         | (RookAttacks(sq, occupied) & (p[SIDE_WHITE][PIECE_ROOK] | p[SIDE_BLACK][PIECE_ROOK]
+                                       | p[SIDE_WHITE][PIECE_QUEEN] | p[SIDE_BLACK][PIECE_QUEEN]));
+}
+
+bool IsSquareAttacked(const Position *pos, int sq, int bySide) {
+    const Bitboard *p = pos->pieces[bySide];
+    Bitboard occupied = pos->occupancy[SIDE_BOTH];
+
+    return (pawnAttacks[bySide ^ 1][sq] & p[PIECE_PAWN])
+        || (knightAttacks[sq] & p[PIECE_KNIGHT])
+        || (kingAttacks[sq] & p[PIECE_KING])
+        || (BishopAttacks(sq, occupied) & (p[PIECE_BISHOP] | p[PIECE_QUEEN]))
+        || (RookAttacks(sq, occupied) & (p[PIECE_ROOK] | p[PIECE_QUEEN]));
+}
+
+// Threat map, checkers and pins for the side to move. Computed once per move so
+// move generation and king-safety tests are plain mask lookups afterwards.
+static void UpdateLegality(Position *pos) {
+    int us = pos->sideToMove;
+    int them = us ^ 1;
+    int king = KingSquare(pos, us);
+    const Bitboard *enemy = pos->pieces[them];
+    Bitboard occupied = pos->occupancy[SIDE_BOTH];
+    Bitboard b;
+
+    // Sliders see through our king so it cannot step back along a checking ray
+    Bitboard xray = occupied ^ BB(king);
+    Bitboard pawns = enemy[PIECE_PAWN];
+    Bitboard threats = them == SIDE_WHITE
+        ? ((pawns & ~FILE_A_BB) << 7) | ((pawns & ~FILE_H_BB) << 9)
+        : ((pawns & ~FILE_A_BB) >> 9) | ((pawns & ~FILE_H_BB) >> 7);
+
+    threats |= kingAttacks[KingSquare(pos, them)];
+    b = enemy[PIECE_KNIGHT];
+    while (b) threats |= knightAttacks[PopLsb(&b)];
+    b = enemy[PIECE_BISHOP] | enemy[PIECE_QUEEN];
+    while (b) threats |= BishopAttacks(PopLsb(&b), xray);
+    b = enemy[PIECE_ROOK] | enemy[PIECE_QUEEN];
+    while (b) threats |= RookAttacks(PopLsb(&b), xray);
+
+    pos->threats = threats;
+    pos->checkers = (threats & BB(king)) ? AttackersTo(pos, king, occupied) & pos->occupancy[them] : 0;
+
+    // A single own piece between the king and an enemy slider is pinned
+    Bitboard snipers = (RookAttacks(king, 0) & (enemy[PIECE_ROOK] | enemy[PIECE_QUEEN]))
+                     | (BishopAttacks(king, 0) & (enemy[PIECE_BISHOP] | enemy[PIECE_QUEEN]));
+    pos->pinned = 0;
+    while (snipers) {
+        Bitboard blockers = betweenBB[king][PopLsb(&snipers)] & occupied;
+        if (blockers && !MoreThanOne(blockers)) pos->pinned |= blockers & pos->occupancy[us];
+    }
+}
+
+void MakeMove(Position *pos, Move move, UndoInfo *undo) {
+    int us = pos->sideToMove;
+    int from = MOVE_FROM(move);
+    int to = MOVE_TO(move);
+    int flags = MOVE_FLAGS(move);
+    int moved = PIECE_TYPE(pos->squares[from]);
+
+    undo->castling = pos->castling;
+    undo->epSquare = pos->epSquare;
+    undo->halfmoveClock = pos->halfmoveClock;
+    undo->key = pos->key;
+    undo->pawnKey = pos->pawnKey;
+    undo->checkers = pos->checkers;
+    undo->pinned = pos->pinned;
+    undo->threats = pos->threats;
+    undo->captured = NO_PIECE;
+
+    pos->halfmoveClock++;
+    if (pos->epSquare != SQ_NONE) pos->key ^= zobristEp[SQUARE_FILE(pos->epSquare)];
+    pos->epSquare = SQ_NONE;
+
+    if (flags == MOVE_EP_CAPTURE) {
+        int capturedSquare = us == SIDE_WHITE ? to - 8 : to + 8;
+        undo->captured = pos->squares[capturedSquare];
+        RemovePiece(pos, capturedSquare);
+    } else if (flags & MOVE_CAPTURE) {
+        undo->captured = pos->squares[to];
+        RemovePiece(pos, to);
+    }
+
+    ShiftPiece(pos, from, to);
+
+    if (moved == PIECE_PAWN) {
+        pos->halfmoveClock = 0;
+        if (flags == MOVE_DOUBLE_PUSH) {
+            // Only record en passant when a capture is actually possible
+            int ep = us == SIDE_WHITE ? from + 8 : from - 8;
+            if (pawnAttacks[us][ep] & pos->pieces[us ^ 1][PIECE_PAWN]) {
+                pos->epSquare = ep;
+                pos->key ^= zobristEp[SQUARE_FILE(ep)];
+            }
+        } else if (flags & MOVE_PROMOTION) {
+            RemovePiece(pos, to);
+            PutPiece(pos, MAKE_PIECE(us, MOVE_PROMOTION_TYPE(move)), to);
+        }
+    } else if (flags == MOVE_KING_CASTLE) {
+        ShiftPiece(pos, to + 1, to - 1);
+    } else if (flags == MOVE_QUEEN_CASTLE) {
+        ShiftPiece(pos, to - 2, to + 1);
+    }
+
+    if (undo->captured != NO_PIECE) pos->halfmoveClock = 0;
+    pos->key ^= zobristCastling[pos->castling];
+    pos->castling &= castlingMask[from] & castlingMask[to];
+    pos->key ^= zobristCastling[pos->castling] ^ zobristSide;
+
+    if (us == SIDE_BLACK) pos->fullmoveNumber++;
+    pos->sideToMove = us ^ 1;
+
+    UpdateLegality(pos);
+}
+
+void UnmakeMove(Position *pos, Move move, const UndoInfo *undo) {
+    int us = pos->sideToMove ^ 1;
+    int from = MOVE_FROM(move);
+    int to = MOVE_TO(move);
+    int flags = MOVE_FLAGS(move);
+
+    pos->sideToMove = us;
+    if (us == SIDE_BLACK) pos->fullmoveNumber--;
+
+    if (flags & MOVE_PROMOTION) {
+        RemovePiece(pos, to);
+        PutPiece(pos, MAKE_PIECE(us, PIECE_PAWN), to);
+    } else if (flags == MOVE_KING_CASTLE) {
+        ShiftPiece(pos, to - 1, to + 1);
+    } else if (flags == MOVE_QUEEN_CASTLE) {
+        ShiftPiece(pos, to + 1, to - 2);
+    }
+
+    ShiftPiece(pos, to, from);
+
+    if (flags == MOVE_EP_CAPTURE) {
+        PutPiece(pos, undo->captured, us == SIDE_WHITE ? to - 8 : to + 8);
+    } else if (undo->captured != NO_PIECE) {
+        PutPiece(pos, undo->captured, to);
+    }
+
+    pos->castling = undo->castling;
+    pos->epSquare = undo->epSquare;
+    pos->halfmoveClock = undo->halfmoveClock;
+    pos->key = undo->key;
+    pos->pawnKey = undo->pawnKey;
+    pos->checkers = undo->checkers;
+    pos->pinned = undo->pinned;
+    pos->threats = undo->threats;
+}
+
+void MakeNullMove(Position *pos, UndoInfo *undo) {
+    undo->castling = pos->castling;
+    undo->epSquare = pos->epSquare;
+    undo->halfmoveClock = pos->halfmoveClock;
+    undo->key = pos->key;
+    undo->pawnKey = pos->pawnKey;
+    undo->checkers = pos->checkers;
+    undo->pinned = pos->pinned;
+    undo->threats = pos->threats;
+    undo->captured = NO_PIECE;
+
+    if (pos->epSquare != SQ_NONE) pos->key ^= zobristEp[SQUARE_FILE(pos->epSquare)];
+    pos->key ^= zobristSide;
+    pos->epSquare = SQ_NONE;
+    pos->halfmoveClock++;
+    pos->sideToMove ^= 1;
+
+    UpdateLegality(pos);
+}
+
+void UnmakeNullMove(Position *pos, const UndoInfo *undo) {
+    pos->sideToMove ^= 1;
+    pos->epSquare = undo->epSquare;
+    pos->halfmoveClock = undo->halfmoveClock;
+    pos->key = undo->key;
+    pos->checkers = undo->checkers;
+    pos->pinned = undo->pinned;
+    pos->threats = undo->threats;
+}
@@ -0,0 +1,134 @@
+#ifndef POSITION_H
+#define POSITION_H
+
+#include "bitboard.h"
+
+#define CASTLE_WHITE_KING 1
+#define CASTLE_WHITE_QUEEN 2
+#define CASTLE_BLACK_KING 4
+#define CASTLE_BLACK_QUEEN 8
+#define CASTLE_ALL 15
+
+// 16-bit move: bits 0-5 from, 6-11 to, 12-15 flags
+typedef uint16_t Move;
+
+#define MOVE_NONE 0
+
+#define MOVE_QUIET 0
+#define MOVE_DOUBLE_PUSH 1
+#define MOVE_KING_CASTLE 2
+#define MOVE_QUEEN_CASTLE 3
+#define MOVE_CAPTURE 4
+#define MOVE_EP_CAPTURE 5
+#define MOVE_PROMOTION 8          // + 0..3 for knight, bishop, rook, queen
+#define MOVE_PROMOTION_CAPTURE 12 // + 0..3 for knight, bishop, rook, queen
+
+#define MAKE_MOVE(from, to, flags) ((Move)((from) | ((to) << 6) | ((flags) << 12)))
+#define MOVE_FROM(m) ((m) & 63)
+#define MOVE_TO(m) (((m) >> 6) & 63)
+#define MOVE_FLAGS(m) ((m) >> 12)
+#define MOVE_IS_CAPTURE(m) ((MOVE_FLAGS(m) & MOVE_CAPTURE) != 0)
+#define MOVE_IS_PROMOTION(m) ((MOVE_FLAGS(m) & MOVE_PROMOTION) != 0)
+#define MOVE_IS_CASTLE(m) (MOVE_FLAGS(m) == MOVE_KING_CASTLE || MOVE_FLAGS(m) == MOVE_QUEEN_CASTLE)
+#define MOVE_PROMOTION_TYPE(m) (PIECE_KNIGHT + (MOVE_FLAGS(m) & 3))
+
+typedef struct Position {
+    Bitboard pieces[2][PIECE_TYPE_COUNT];   // one mask per side and piece type
+    Bitboard occupancy[3];                  // white, black, both
+    unsigned char squares[64];              // piece code per square, NO_PIECE if empty
+    int sideToMove;
+    int castling;                           // CASTLE_* rights still available
+    int epSquare;                           // square behind a double-pushed pawn or SQ_NONE
+    int halfmoveClock;
+    int fullmoveNumber;
+
+    // Zobrist keys, updated incrementally by MakeMove
+    uint64_t key;                           // full position identity
+    uint64_t pawnKey;                       // pawns of both sides only
+
+    // Material and piece-square sums from white's point of view and the game
+    // phase, kept up to date by every piece placement so evaluation reads them
+    int psqMg, psqEg;
+    int phase;                              // PHASE_MAX with all pieces on, may exceed it after promotions
+
+    // Legality masks for the side to move, refreshed by MakeMove and restored by UnmakeMove
+    Bitboard checkers;                      // enemy pieces giving check
+    Bitboard pinned;                        // own pieces pinned to the king
+    Bitboard threats;                       // squares the enemy attacks, own king removed
+} Position;
+
+// Everything MakeMove overwrites that cannot be recomputed from the move itself
+typedef struct UndoInfo {
+    int captured;
+    int castling;
+    int epSquare;
+    int halfmoveClock;
+    uint64_t key;
+    uint64_t pawnKey;
+    Bitboard checkers;
+    Bitboard pinned;
+    Bitboard threats;
+} UndoInfo;
+
+// Random keys XORed together for every feature of a position
+extern uint64_t zobristPieces[NO_PIECE][64];
+extern uint64_t zobristCastling[16];
+extern uint64_t zobristEp[8];               // by file
+extern uint64_t zobristSide;                // present when black is to move
+
+// Fills the keys, castling masks and piece-square tables. InitBitboards calls
+// it, on the main thread before any other thread uses positions.
+void InitPositionTables(void);
+
+#define START_FEN "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"
+
+// Builds a position from the UI board ('.' for empty, uppercase for white)
+void PositionFromBoard(Position *pos, const char board[8][8], int sideToMove, int castling);
+void PositionToBoard(const Position *pos, char board[8][8]);
+char PieceToChar(int piece);
+int CharToPiece(char c);
+
+// Builds a position from piece codes by square, NO_PIECE if empty. Returns
+// false and leaves pos untouched unless each side has one king and the en
+// passant square is SQ_NONE or follows a double push. Rights and the en
+// passant square are then cleaned up as PositionFromFen does. Clocks start at
+// 0 and 1.
+bool PositionFromSquares(Position *pos, const unsigned char squares[64], int sideToMove, int castling, int epSquare);
+
+// Returns false and leaves pos untouched if the FEN is malformed or its en
+// passant square does not follow a double push. Castling rights without their
+// king and rook at home are dropped, and so is an en passant square no pawn
+// can capture on, so the key matches the same position reached by moves.
+bool PositionFromFen(Position *pos, const char *fen);
+void PositionToFen(const Position *pos, char *fen, int size);
+
+// Computes both keys from scratch; MakeMove keeps them up to date afterwards
+void ComputeKeys(const Position *pos, uint64_t *key, uint64_t *pawnKey);
+
+// Long algebraic (UCI) notation, e.g. "e2e4" or "e7e8q"; buffer needs 6 bytes
+void MoveToString(Move move, char *buffer);
+
+Bitboard AttackersTo(const Position *pos, int sq, Bitboard occupied);
+bool IsSquareAttacked(const Position *pos, int sq, int bySide);
+
+static inline bool InCheck(const Position *pos) {
+    return pos->checkers != 0;
+}
+
+// Plays a legal move in place and records what UnmakeMove needs to roll it back
+void MakeMove(Position *pos, Move move, UndoInfo *undo);
+void UnmakeMove(Position *pos, Move move, const UndoInfo *undo);
+
+// Passes the turn, used by null-move pruning; never call while in check
+void MakeNullMove(Position *pos, UndoInfo *undo);
+void UnmakeNullMove(Position *pos, const UndoInfo *undo);
+
+static inline int KingSquare(const Position *pos, int side) {
+    return Lsb(pos->pieces[side][PIECE_KING]);
+}
+
+static inline int PieceOn(const Position *pos, int sq) {
+    return pos->squares[sq];
+}
+
+#endif
@@ -0,0 +1,304 @@
+#include "profile.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PROFILE_STATS_SECONDS 0.5f      // zone and counter stats are averaged over this long
+
+// Frame times, newest at frameNext - 1; only the render thread touches them
+static float frameHistory[PROFILE_FRAME_HISTORY];
+static int frameNext, frameCount;
+
+void RecordFrameTime(float seconds) {
+    frameHistory[frameNext] = seconds;
+    frameNext = (frameNext + 1) % PROFILE_FRAME_HISTORY;
+    if (frameCount < PROFILE_FRAME_HISTORY) frameCount++;
+}
+
+static int CompareFrameTimes(const void *a, const void *b) {
+    float x = *(const float *)a, y = *(const float *)b;
+    return (x > y) - (x < y);
+}
+
+void GetFrameTimeStats(FrameTimeStats *stats) {
+    float sorted[PROFILE_FRAME_HISTORY];
+    double total = 0.0;
+
+    memset(stats, 0, sizeof(*stats));
+    if (frameCount == 0) return;
+
+    memcpy(sorted, frameHistory, sizeof(float) * frameCount);
+    qsort(sorted, frameCount, sizeof(float), CompareFrameTimes);
+    for (int i = 0; i < frameCount; i++) total += sorted[i];
+
+    stats->frames = frameCount;
+    stats->average = (float)(total / frameCount);
+    stats->p50 = sorted[frameCount / 2];
+    stats->p95 = sorted[frameCount * 95 / 100];
+    stats->p99 = sorted[frameCount * 99 / 100];
+    stats->max = sorted[frameCount - 1];
+}
+
+#if defined(PROFILE_ENABLED)
+
+#if defined(_MSC_VER)
+#define PROFILE_THREAD_LOCAL __declspec(thread)
+#else
+#define PROFILE_THREAD_LOCAL __thread
+#endif
+
+#define PROFILE_EVENT_ZONE 0
+#define PROFILE_EVENT_COUNTER 1
+
+#define PROFILE_UNREGISTERED -1
+#define PROFILE_FULL -2                 // no slot left; the zone or counter is not recorded
+
+typedef struct ProfileEvent {
+    const char *name;
+    int64_t start;                      // microseconds
+    int64_t value;                      // duration of a zone, value of a counter
+    int type;                           // PROFILE_EVENT_*
+} ProfileEvent;
+
+// Written by its own thread only; the trace export reads it from another
+typedef struct ProfileThread {
+    ProfileEvent *events;
+    volatile int64_t written;           // events ever written, the ring holds the last PROFILE_RING_EVENTS
+    const char *name;
+} ProfileThread;
+
+static ProfileThread threads[PROFILE_MAX_THREADS];
+static volatile int threadCount;
+static PROFILE_THREAD_LOCAL ProfileThread *currentThread;
+static PROFILE_THREAD_LOCAL bool threadUnavailable;
+
+// Registration is rare, so one spin lock guards the names of threads, zones and counters
+static volatile int registryLock;
+
+static const char *zoneNames[PROFILE_MAX_ZONES];
+static volatile int zoneCount;
+static volatile int64_t zoneTime[PROFILE_MAX_ZONES];    // microseconds since the stats were last published
+static volatile int64_t zoneCalls[PROFILE_MAX_ZONES];
+
+static const char *counterNames[PROFILE_MAX_COUNTERS];
+static volatile int counterCount;
+static volatile int64_t counterFrame[PROFILE_MAX_COUNTERS];     // this frame
+static int64_t counterWindow[PROFILE_MAX_COUNTERS];             // frames since the stats were published
+
+// Published stats, per frame over the last window; render thread only
+static int statsFrames;
+static float statsSeconds;
+static ProfileZoneStats zoneStats[PROFILE_MAX_ZONES];
+static ProfileCounterStats counterStats[PROFILE_MAX_COUNTERS];
+static int zoneStatsCount, counterStatsCount;
+
+static void LockRegistry(void) {
+    while (!AtomicCompareExchange(&registryLock, 0, 1)) {}
+}
+
+static void UnlockRegistry(void) {
+    AtomicStore(&registryLock, 0);
+}
+
+// Two call sites of one name share an id
+static int RegisterName(const char **names, volatile int *count, int maxCount, const char *name) {
+    int id = PROFILE_FULL;
+
+    LockRegistry();
+    for (int i = 0; i < *count; i++) {
+        if (strcmp(names[i], name) == 0) id = i;
+    }
+    if (id == PROFILE_FULL && *count < maxCount) {
+        names[*count] = name;
+        id = *count;
+        AtomicStore(count, *count + 1);
+    }
+    UnlockRegistry();
+    return id;
+}
+
+// The calling thread's ring, allocated on its first event
+static ProfileThread *CurrentThread(void) {
+    if (currentThread || threadUnavailable) return currentThread;
+
+    ProfileEvent *events = malloc(sizeof(ProfileEvent) * PROFILE_RING_EVENTS);
+    LockRegistry();
+    if (events && threadCount < PROFILE_MAX_THREADS) {
+        currentThread = &threads[threadCount];
+        currentThread->events = events;
+        currentThread->written = 0;
+        currentThread->name = NULL;
+        AtomicStore(&threadCount, threadCount + 1);
+    }
+    UnlockRegistry();
+
+    if (!currentThread) {
+        free(events);
+        threadUnavailable = true;
+    }
+    return currentThread;
+}
+
+static void PushEvent(int type, const char *name, int64_t start, int64_t value) {
+    ProfileThread *thread = CurrentThread();
+    if (!thread) return;
+
+    thread->events[thread->written & (PROFILE_RING_EVENTS - 1)] = (ProfileEvent){ name, start, value, type };
+    AtomicAdd64(&thread->written, 1); // publishes the event to the trace export
+}
+
+void ProfileZone(int *id, const char *name, int64_t start) {
+    int64_t duration = GetMicroseconds() - start;
+
+    if (*id == PROFILE_UNREGISTERED) *id = RegisterName(zoneNames, &zoneCount, PROFILE_MAX_ZONES, name);
+    if (*id < 0) return;
+
+    AtomicAdd64(&zoneTime[*id], duration);
+    AtomicAdd64(&zoneCalls[*id], 1);
+    PushEvent(PROFILE_EVENT_ZONE, zoneNames[*id], start, duration);
+}
+
+void ProfileCount(int *id, const char *name, int64_t amount) {
+    if (*id == PROFILE_UNREGISTERED) *id = RegisterName(counterNames, &counterCount, PROFILE_MAX_COUNTERS, name);
+    if (*id < 0) return;
+
+    AtomicAdd64(&counterFrame[*id], amount);
+}
+
+void ProfileThreadName(const char *name) {
+    ProfileThread *thread = CurrentThread();
+    if (thread) thread->name = name;
+}
+
+// Turns the totals since the last call into per-frame averages
+static void PublishStats(void) {
+    zoneStatsCount = AtomicLoad(&zoneCount);
+    for (int i = 0; i < zoneStatsCount; i++) {
+        int64_t time = AtomicLoad64(&zoneTime[i]);
+        int64_t calls = AtomicLoad64(&zoneCalls[i]);
+
+        AtomicAdd64(&zoneTime[i], -time);
+        AtomicAdd64(&zoneCalls[i], -calls);
+        zoneStats[i].name = zoneNames[i];
+        zoneStats[i].milliseconds = time / 1000.0 / statsFrames;
+        zoneStats[i].calls = (int)((calls + statsFrames / 2) / statsFrames);
+    }
+
+    counterStatsCount = AtomicLoad(&counterCount);
+    for (int i = 0; i < counterStatsCount; i++) {
+        counterStats[i].name = counterNames[i];
+        counterStats[i].value = counterWindow[i] / statsFrames;
+        counterWindow[i] = 0;
+    }
+
+    statsFrames = 0;
+    statsSeconds = 0.0f;
+}
+
+void ProfileFrame(float seconds) {
+    int64_t now = GetMicroseconds();
+    int counters = AtomicLoad(&counterCount);
+
+    RecordFrameTime(seconds);
+
+    // Counters go to the trace once a frame, as Chrome counter tracks
+    for (int i = 0; i < counters; i++) {
+        int64_t value = AtomicLoad64(&counterFrame[i]);
+
+        AtomicAdd64(&counterFrame[i], -value);
+        counterWindow[i] += value;
+        PushEvent(PROFILE_EVENT_COUNTER, counterNames[i], now, value);
+    }
+    PushEvent(PROFILE_EVENT_COUNTER, "FrameMicroseconds", now, (int64_t)(seconds * 1000000.0f));
+
+    statsFrames++;
+    statsSeconds += seconds;
+    if (statsSeconds >= PROFILE_STATS_SECONDS) PublishStats();
+}
+
+int GetProfileZones(ProfileZoneStats *zones, int maxZones) {
+    int count = zoneStatsCount < maxZones ? zoneStatsCount : maxZones;
+    memcpy(zones, zoneStats, sizeof(ProfileZoneStats) * count);
+    return count;
+}
+
+int GetProfileCounters(ProfileCounterStats *counters, int maxCounters) {
+    int count = counterStatsCount < maxCounters ? counterStatsCount : maxCounters;
+    memcpy(counters, counterStats, sizeof(ProfileCounterStats) * count);
+    return count;
+}
+
+// Names are zone identifiers and string literals of this program, so they need no escaping
+int WriteProfileTrace(const char *path) {
+    ProfileEvent *events = malloc(sizeof(ProfileEvent) * PROFILE_RING_EVENTS);
+    FILE *file = events ? fopen(path, "w") : NULL;
+    int threadTotal = AtomicLoad(&threadCount);
+    int written = 0;
+
+    if (!file) {
+        free(events);
+        return -1;
+    }
+
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"3D Chess\"}}");
+
+    for (int t = 0; t < threadTotal; t++) {
+        ProfileThread *thread = &threads[t];
+        int64_t end = AtomicLoad64(&thread->written);
+        int64_t first = end > PROFILE_RING_EVENTS ? end - PROFILE_RING_EVENTS : 0;
+
+        for (int64_t i = first; i < end; i++) events[i - first] = thread->events[i & (PROFILE_RING_EVENTS - 1)];
+
+        // The thread kept writing meanwhile: events it may have overwritten are
+        // dropped, including the slot of an event it is writing but has not counted yet
+        int64_t after = AtomicLoad64(&thread->written);
+        int64_t valid = after + 1 > PROFILE_RING_EVENTS ? after + 1 - PROFILE_RING_EVENTS : 0;
+        if (valid < first) valid = first;
+
+        fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                t, thread->name ? thread->name : "Thread");
+        for (int64_t i = valid; i < end; i++) {
+            const ProfileEvent *event = &events[i - first];
+
+            if (event->type == PROFILE_EVENT_ZONE) {
+                fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%lld,\"dur\":%lld}",
+                        event->name, t, (long long)event->start, (long long)event->value);
+            } else {
+                fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"C\",\"pid\":1,\"tid\":%d,\"ts\":%lld,\"args\":{\"value\":%lld}}",
+                        event->name, t, (long long)event->start, (long long)event->value);
+            }
+            written++;
+        }
+    }
+
+    fprintf(file, "\n]}\n");
+    free(events);
+    return fclose(file) == 0 ? written : -1;
+}
+
+#else
+
+void ProfileFrame(float seconds) {
+    RecordFrameTime(seconds);
+}
+
+int GetProfileZones(ProfileZoneStats *zones, int maxZones) {
+    (void)zones;
+    (void)maxZones;
+    return 0;
+}
+
+int GetProfileCounters(ProfileCounterStats *counters, int maxCounters) {
+    (void)counters;
+    (void)maxCounters;
+    return 0;
+}
+
+int WriteProfileTrace(const char *path) {
+    (void)path;
+    return 0;
+}
+
+#endif
@@ -0,0 +1,84 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include "platform.h"
+
+#define PROFILE_MAX_THREADS 16
+#define PROFILE_MAX_ZONES 64
+#define PROFILE_MAX_COUNTERS 32
+#define PROFILE_RING_EVENTS 16384      // per thread, the oldest are overwritten; power of two
+#define PROFILE_FRAME_HISTORY 600      // frame times kept for the percentiles
+#define PROFILE_TRACE_FILE "chess_trace.json"
+
+// Hot-path timing in two parts. Frame times are always recorded: a slow
+// release build shows its percentiles without a profiler attached. Zones and
+// counters cost a clock read and a ring write each, so they only exist when
+// PROFILE_ENABLED is defined (the Debug configurations); otherwise the macros
+// compile to nothing.
+//
+// A zone is timed between PROFILE_BEGIN(name) and PROFILE_END(name) in the
+// same block, name being an identifier. Every thread writes its events to a
+// ring of its own, so threads never contend; totals per zone are summed over
+// the frame for the overlay, and the rings are what the trace export writes.
+
+typedef struct FrameTimeStats {
+    int frames;                     // frames the percentiles cover
+    float average, p50, p95, p99, max;  // seconds
+} FrameTimeStats;
+
+typedef struct ProfileZoneStats {
+    const char *name;
+    double milliseconds;            // per frame, all threads together
+    int calls;                      // per frame
+} ProfileZoneStats;
+
+typedef struct ProfileCounterStats {
+    const char *name;
+    int64_t value;                  // per frame
+} ProfileCounterStats;
+
+void RecordFrameTime(float seconds);
+void GetFrameTimeStats(FrameTimeStats *stats);
+
+#if defined(PROFILE_ENABLED)
+
+#define PROFILE_BEGIN(zone) \
+    static int profileZone_##zone = -1; \
+    int64_t profileStart_##zone = GetMicroseconds()
+#define PROFILE_END(zone) ProfileZone(&profileZone_##zone, #zone, profileStart_##zone)
+#define PROFILE_COUNT(counter, amount) do { \
+        static int profileCounter_ = -1; \
+        ProfileCount(&profileCounter_, counter, amount); \
+    } while (0)
+#define PROFILE_THREAD(name) ProfileThreadName(name)
+
+// Registers the zone on first use, then records one call that began at start
+void ProfileZone(int *id, const char *name, int64_t start);
+void ProfileCount(int *id, const char *name, int64_t amount);
+void ProfileThreadName(const char *name);
+
+#else
+
+#define PROFILE_BEGIN(zone) ((void)0)
+#define PROFILE_END(zone) ((void)0)
+#define PROFILE_COUNT(counter, amount) ((void)0)
+#define PROFILE_THREAD(name) ((void)0)
+
+#endif
+
+// Closes the frame: records its time and writes the counters to the calling
+// thread's ring for the trace. Every half second the zone and counter totals
+// become the stats below, as averages per frame.
+void ProfileFrame(float seconds);
+
+// Call from the thread that calls ProfileFrame. Both return 0 when profiling
+// is compiled out.
+int GetProfileZones(ProfileZoneStats *zones, int maxZones);
+int GetProfileCounters(ProfileCounterStats *counters, int maxCounters);
+
+// Chrome trace-event JSON of the events still in the rings, for chrome://tracing
+// or Perfetto. Returns the number of events written, -1 if the file could not
+// be written, and 0 without writing anything when profiling is compiled out.
+int WriteProfileTrace(const char *path);
+
+#endif
@@ -0,0 +1,20 @@
+#ifndef PSQT_H
+#define PSQT_H
+
+#include "bitboard.h"
+
+#define PHASE_MAX 24                // both sides' full set of pieces, pawns and kings excluded
+
+// Material plus piece-square value of every piece on every square, middlegame
+// and endgame, from white's point of view (black pieces are negative). The
+// position sums these up as pieces move, so evaluation never scans the board.
+extern int psqtMg[NO_PIECE][64];
+extern int psqtEg[NO_PIECE][64];
+
+// Game phase each piece type contributes, PHASE_MAX at the start
+extern const int phaseWeights[PIECE_TYPE_COUNT];
+
+// Builds the tables; position.c calls it before the first piece is placed
+void InitPsqt(void);
+
+#endif
@@ -0,0 +1,15 @@
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <stdint.h>
+
+// xorshift64*: fast, good enough for keys, magics and random play, and the
+// same sequence on every platform for a given seed. The state must not be 0.
+static inline uint64_t NextRandom(uint64_t *state) {
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return *state * 2685821657736338717ULL;
+}
+
+#endif
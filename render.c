@@ -0,0 +1,313 @@
+#include "render.h"
+#include "raymath.h"
+#include "rlgl.h"
+#include "profile.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SQUARE_THICKNESS 0.1f
+#define BOARD_VERTEX_COLOR_BUFFER 3   // rlgl's vertex buffer slot for colors
+#define PIECE_SCALE 0.4f
+#define PIECE_LIFT 0.5f
+#define LOD_MAX_ERROR_PIXELS 1.5f   // how far a simplified level may stray on screen
+#define INITIAL_INSTANCE_CAPACITY 64
+
+// raylib's default shader with the model matrix taken from a per-instance attribute
+static const char *instancingVertexShader =
+    "#version 330\n"
+    "in vec3 vertexPosition;\n"
+    "in vec2 vertexTexCoord;\n"
+    "in vec4 vertexColor;\n"
+    "in mat4 instanceTransform;\n"
+    "uniform mat4 mvp;\n"
+    "out vec2 fragTexCoord;\n"
+    "out vec4 fragColor;\n"
+    "void main() {\n"
+    "    fragTexCoord = vertexTexCoord;\n"
+    "    fragColor = vertexColor;\n"
+    "    gl_Position = mvp * instanceTransform * vec4(vertexPosition, 1.0);\n"
+    "}\n";
+
+static const char *instancingFragmentShader =
+    "#version 330\n"
+    "in vec2 fragTexCoord;\n"
+    "in vec4 fragColor;\n"
+    "uniform sampler2D texture0;\n"
+    "uniform vec4 colDiffuse;\n"
+    "out vec4 finalColor;\n"
+    "void main() {\n"
+    "    finalColor = texture(texture0, fragTexCoord) * colDiffuse * fragColor;\n"
+    "}\n";
+
+// One box per square, same size and placement as the DrawCube calls it replaces
+static Mesh GenBoardMesh(Vector3 boardPosition, float squareSize) {
+    // Corner signs and normal of each box face
+    static const float faces[6][4][3] = {
+        { { -1, 1, -1 }, { -1, 1, 1 }, { 1, 1, 1 }, { 1, 1, -1 } },         // top
+        { { -1, -1, 1 }, { -1, -1, -1 }, { 1, -1, -1 }, { 1, -1, 1 } },     // bottom
+        { { -1, -1, 1 }, { 1, -1, 1 }, { 1, 1, 1 }, { -1, 1, 1 } },         // front
+        { { 1, -1, -1 }, { -1, -1, -1 }, { -1, 1, -1 }, { 1, 1, -1 } },     // back
+        { { 1, -1, 1 }, { 1, -1, -1 }, { 1, 1, -1 }, { 1, 1, 1 } },         // right
+        { { -1, -1, -1 }, { -1, -1, 1 }, { -1, 1, 1 }, { -1, 1, -1 } },     // left
+    };
+    static const float normals[6][3] = {
+        { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 }, { 1, 0, 0 }, { -1, 0, 0 }
+    };
+    Mesh mesh = { 0 };
+    int v = 0, t = 0;
+
+    mesh.vertexCount = 64 * 24;
+    mesh.triangleCount = 64 * 12;
+    mesh.vertices = MemAlloc(mesh.vertexCount * 3 * sizeof(float));
+    mesh.normals = MemAlloc(mesh.vertexCount * 3 * sizeof(float));
+    mesh.texcoords = MemAlloc(mesh.vertexCount * 2 * sizeof(float));
+    mesh.colors = MemAlloc(mesh.vertexCount * 4);
+    mesh.indices = MemAlloc(mesh.triangleCount * 3 * sizeof(unsigned short));
+
+    for (int square = 0; square < 64; square++) {
+        Vector3 center = {
+            boardPosition.x + (square % 8) * squareSize,
+            boardPosition.y,
+            boardPosition.z + (square / 8) * squareSize
+        };
+        Vector3 half = { squareSize / 2.0f, SQUARE_THICKNESS / 2.0f, squareSize / 2.0f };
+
+        for (int face = 0; face < 6; face++) {
+            int base = v;
+            for (int corner = 0; corner < 4; corner++) {
+                mesh.vertices[v * 3 + 0] = center.x + faces[face][corner][0] * half.x;
+                mesh.vertices[v * 3 + 1] = center.y + faces[face][corner][1] * half.y;
+                mesh.vertices[v * 3 + 2] = center.z + faces[face][corner][2] * half.z;
+                memcpy(&mesh.normals[v * 3], normals[face], sizeof(normals[face]));
+                mesh.texcoords[v * 2 + 0] = (corner == 1 || corner == 2) ? 1.0f : 0.0f;
+                mesh.texcoords[v * 2 + 1] = corner >= 2 ? 1.0f : 0.0f;
+                v++;
+            }
+
+            unsigned short quad[6] = { 0, 1, 2, 0, 2, 3 };
+            for (int i = 0; i < 6; i++) mesh.indices[t++] = (unsigned short)(base + quad[i]);
+        }
+    }
+
+    memset(mesh.colors, 255, mesh.vertexCount * 4);
+    return mesh;
+}
+
+bool InitBoardRenderer(BoardRenderer *renderer, Vector3 boardPosition, float squareSize, const PieceSet *pieces) {
+    memset(renderer, 0, sizeof(*renderer));
+
+    renderer->boardMesh = GenBoardMesh(boardPosition, squareSize);
+    UploadMesh(&renderer->boardMesh, true); // dynamic, colors are rewritten on highlight changes
+    renderer->boardMaterial = LoadMaterialDefault();
+    renderer->colorsDirty = true;
+
+    // A shader that fails to compile or link comes back as the default shader,
+    // whose locations are shared and must not be changed
+    renderer->instancingShader = LoadShaderFromMemory(instancingVertexShader, instancingFragmentShader);
+    if (renderer->instancingShader.id == 0 || renderer->instancingShader.id == rlGetShaderIdDefault()) {
+        UnloadMaterial(renderer->boardMaterial);
+        UnloadMesh(renderer->boardMesh);
+        memset(renderer, 0, sizeof(*renderer));
+        return false;
+    }
+    renderer->instancingShader.locs[SHADER_LOC_MATRIX_MODEL] = GetShaderLocationAttrib(renderer->instancingShader, "instanceTransform");
+
+    // Plain boards take their square colors from the vertices, like the game board
+    renderer->plainBoardMesh = GenBoardMesh((Vector3){ 0.0f, 0.0f, 0.0f }, squareSize);
+    for (int square = 0; square < 64; square++) {
+        Color color = ((square / 8 + square % 8) % 2 == 0) ? LIGHTGRAY : DARKGRAY;
+        for (int i = 0; i < 24; i++) memcpy(&renderer->plainBoardMesh.colors[(square * 24 + i) * 4], &color, 4);
+    }
+    UploadMesh(&renderer->plainBoardMesh, false);
+    renderer->plainBoardMaterial = LoadMaterialDefault();
+    renderer->plainBoardMaterial.shader = renderer->instancingShader;
+
+    // Shares the maps of the piece materials, only the shader differs
+    renderer->pieces = pieces;
+    for (int side = 0; side < 2; side++) {
+        renderer->materials[side] = pieces->materials[side];
+        renderer->materials[side].shader = renderer->instancingShader;
+    }
+    return true;
+}
+
+void UnloadBoardRenderer(BoardRenderer *renderer) {
+    for (int piece = 0; piece < NO_PIECE; piece++) {
+        for (int lod = 0; lod < MAX_PIECE_LODS; lod++) free(renderer->batches[piece][lod].transforms);
+    }
+    free(renderer->boardTransforms);
+
+    // UnloadMaterial would also unload the shared instancing shader
+    MemFree(renderer->plainBoardMaterial.maps);
+    UnloadMesh(renderer->plainBoardMesh);
+    UnloadShader(renderer->instancingShader);
+    UnloadMaterial(renderer->boardMaterial);
+    UnloadMesh(renderer->boardMesh);
+    memset(renderer, 0, sizeof(*renderer));
+}
+
+void SetSquareColor(BoardRenderer *renderer, int row, int col, Color color) {
+    Color *current = &renderer->squareColors[row * 8 + col];
+    if (memcmp(current, &color, sizeof(color)) == 0) return;
+    *current = color;
+    renderer->colorsDirty = true;
+}
+
+// Expands the 64 square colors to the 24 vertices of each box and uploads them;
+// the mesh is laid out in the same row * 8 + col order
+static void UploadSquareColors(BoardRenderer *renderer) {
+    Mesh *mesh = &renderer->boardMesh;
+
+    for (int square = 0; square < 64; square++) {
+        Color color = renderer->squareColors[square];
+        for (int i = 0; i < 24; i++) memcpy(&mesh->colors[(square * 24 + i) * 4], &color, 4);
+    }
+    UpdateMeshBuffer(*mesh, BOARD_VERTEX_COLOR_BUFFER, mesh->colors, mesh->vertexCount * 4, 0);
+    renderer->colorsDirty = false;
+}
+
+void ClearRenderQueue(BoardRenderer *renderer, Camera camera) {
+    for (int piece = 0; piece < NO_PIECE; piece++) {
+        for (int lod = 0; lod < MAX_PIECE_LODS; lod++) renderer->batches[piece][lod].count = 0;
+    }
+    renderer->boardCount = 0;
+    renderer->gameBoardQueued = false;
+
+    // For an orthographic camera fovy is the height of the view in world units
+    renderer->cameraPosition = camera.position;
+    renderer->orthographic = camera.projection == CAMERA_ORTHOGRAPHIC;
+    renderer->pixelsPerUnit = renderer->orthographic
+        ? GetScreenHeight() / camera.fovy
+        : GetScreenHeight() / (2.0f * tanf(camera.fovy * 0.5f * DEG2RAD));
+}
+
+void AddGameBoard(BoardRenderer *renderer) {
+    renderer->gameBoardQueued = true;
+}
+
+// Doubles the capacity of a transform array; false when out of memory
+static bool GrowTransforms(Matrix **transforms, int *capacity) {
+    int newCapacity = *capacity ? *capacity * 2 : INITIAL_INSTANCE_CAPACITY;
+    Matrix *grown = realloc(*transforms, sizeof(Matrix) * newCapacity);
+
+    if (!grown) return false;
+    *transforms = grown;
+    *capacity = newCapacity;
+    return true;
+}
+
+void AddPlainBoard(BoardRenderer *renderer, Vector3 origin) {
+    if (renderer->boardCount == renderer->boardCapacity && !GrowTransforms(&renderer->boardTransforms, &renderer->boardCapacity)) return;
+    renderer->boardTransforms[renderer->boardCount++] = MatrixTranslate(origin.x, origin.y, origin.z);
+}
+
+// A level clustered on n cells moves vertices by up to extent / n, so pick the
+// coarsest level where that distance projects to no more than a pixel or so
+static int SelectLod(const BoardRenderer *renderer, int type, Vector3 position) {
+    const PieceSet *pieces = renderer->pieces;
+    float distance = renderer->orthographic ? 1.0f : Vector3Distance(renderer->cameraPosition, position);
+    float pixels = pieces->extent[type] * PIECE_SCALE * renderer->pixelsPerUnit / fmaxf(distance, 0.001f);
+
+    for (int lod = pieces->lodCount[type] - 1; lod > 0; lod--) {
+        if (pixels / pieceLodCells[lod] <= LOD_MAX_ERROR_PIXELS) return lod;
+    }
+    return 0;
+}
+
+Matrix PieceTransform(int piece, Vector3 position) {
+    Matrix scale = MatrixScale(PIECE_SCALE, PIECE_SCALE, PIECE_SCALE);
+    Matrix rotation = MatrixIdentity();
+    Matrix translation = MatrixTranslate(position.x, position.y + PIECE_LIFT, position.z);
+
+    // Knights are modeled facing sideways; turn them toward the opponent
+    if (piece == MAKE_PIECE(SIDE_WHITE, PIECE_KNIGHT)) rotation = MatrixRotateY(-90.0f * DEG2RAD);
+    if (piece == MAKE_PIECE(SIDE_BLACK, PIECE_KNIGHT)) rotation = MatrixRotateY(90.0f * DEG2RAD);
+
+    return MatrixMultiply(MatrixMultiply(scale, rotation), translation);
+}
+
+void AddPiece(BoardRenderer *renderer, int piece, Vector3 position) {
+    if (piece < 0 || piece >= NO_PIECE) return;
+    AddPieceInstance(renderer, piece, PieceTransform(piece, position), position);
+}
+
+void AddPieceInstance(BoardRenderer *renderer, int piece, Matrix transform, Vector3 position) {
+    if (piece < 0 || piece >= NO_PIECE) return;
+
+    PieceBatch *batch = &renderer->batches[piece][SelectLod(renderer, PIECE_TYPE(piece), position)];
+    if (batch->count == batch->capacity && !GrowTransforms(&batch->transforms, &batch->capacity)) return;
+
+    batch->transforms[batch->count++] = transform;
+}
+
+void DrawBoardRenderer(BoardRenderer *renderer) {
+    PROFILE_BEGIN(DrawBoardRenderer);
+    if (renderer->colorsDirty) UploadSquareColors(renderer);
+
+    renderer->drawCalls = 0;
+    renderer->pieceInstances = 0;
+
+    if (renderer->gameBoardQueued) {
+        DrawMesh(renderer->boardMesh, renderer->boardMaterial, MatrixIdentity());
+        renderer->drawCalls++;
+    }
+    if (renderer->boardCount > 0) {
+        DrawMeshInstanced(renderer->plainBoardMesh, renderer->plainBoardMaterial, renderer->boardTransforms, renderer->boardCount);
+        renderer->drawCalls++;
+    }
+
+    for (int piece = 0; piece < NO_PIECE; piece++) {
+        for (int lod = 0; lod < MAX_PIECE_LODS; lod++) {
+            PieceBatch *batch = &renderer->batches[piece][lod];
+            if (batch->count == 0) continue;
+
+            DrawMeshInstanced(renderer->pieces->meshes[PIECE_TYPE(piece)][lod], renderer->materials[PIECE_SIDE(piece)],
+                batch->transforms, batch->count);
+            renderer->drawCalls++;
+            renderer->pieceInstances += batch->count;
+        }
+    }
+    PROFILE_END(DrawBoardRenderer);
+}
+
+// Gribb and Hartmann: each clip plane is a sum or difference of rows of the
+// view-projection matrix. raylib's matrices hold rows in m0, m4, m8, m12 etc.
+Frustum GetCameraFrustum(Camera camera, float aspect) {
+    Matrix view = MatrixLookAt(camera.position, camera.target, camera.up);
+    Matrix projection;
+    Frustum frustum;
+
+    if (camera.projection == CAMERA_ORTHOGRAPHIC) {
+        double top = camera.fovy / 2.0;
+        double right = top * aspect;
+        projection = MatrixOrtho(-right, right, -top, top, 0.01, 1000.0);
+    } else {
+        projection = MatrixPerspective(camera.fovy * DEG2RAD, aspect, 0.01, 1000.0);
+    }
+
+    Matrix m = MatrixMultiply(view, projection);
+    Vector4 rowX = { m.m0, m.m4, m.m8, m.m12 };
+    Vector4 rowY = { m.m1, m.m5, m.m9, m.m13 };
+    Vector4 rowW = { m.m3, m.m7, m.m11, m.m15 };
+
+    frustum.planes[0] = (Vector4){ rowW.x + rowX.x, rowW.y + rowX.y, rowW.z + rowX.z, rowW.w + rowX.w };   // left
+    frustum.planes[1] = (Vector4){ rowW.x - rowX.x, rowW.y - rowX.y, rowW.z - rowX.z, rowW.w - rowX.w };   // right
+    frustum.planes[2] = (Vector4){ rowW.x + rowY.x, rowW.y + rowY.y, rowW.z + rowY.z, rowW.w + rowY.w };   // bottom
+    frustum.planes[3] = (Vector4){ rowW.x - rowY.x, rowW.y - rowY.y, rowW.z - rowY.z, rowW.w - rowY.w };   // top
+    return frustum;
+}
+
+// Conservative: a box is only rejected when its corner furthest along a
+// plane's normal is still outside that plane
+bool BoxInFrustum(const Frustum *frustum, BoundingBox box) {
+    for (int i = 0; i < 4; i++) {
+        Vector4 plane = frustum->planes[i];
+        float x = plane.x >= 0.0f ? box.max.x : box.min.x;
+        float y = plane.y >= 0.0f ? box.max.y : box.min.y;
+        float z = plane.z >= 0.0f ? box.max.z : box.min.z;
+        if (plane.x * x + plane.y * y + plane.z * z + plane.w < 0.0f) return false;
+    }
+    return true;
+}
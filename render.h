@@ -0,0 +1,81 @@
+#ifndef RENDER_H
+#define RENDER_H
+
+#include "raylib.h"
+#include "bitboard.h"
+#include "assets.h"
+
+// All pieces drawn with one mesh and material, collected during the frame
+// and submitted with a single instanced draw; grows with the grid view
+typedef struct PieceBatch {
+    Matrix *transforms;
+    int count;
+    int capacity;
+} PieceBatch;
+
+// Side planes of a camera's view volume as (normal, distance), normals
+// pointing inward. Near and far are left out: nothing on the boards gets close
+// to either.
+typedef struct Frustum {
+    Vector4 planes[4];
+} Frustum;
+
+// Board and pieces in a handful of draw calls: the 64 squares are one static
+// mesh whose vertex colors are rewritten only when a square changes color,
+// and every piece code is one DrawMeshInstanced per level of detail in use.
+// The grid view's boards, which never highlight, share one plain board mesh
+// drawn with a single DrawMeshInstanced.
+typedef struct BoardRenderer {
+    Mesh boardMesh;
+    Material boardMaterial;
+    Color squareColors[64];         // by row * 8 + col, as the UI board is indexed
+    bool colorsDirty;
+    bool gameBoardQueued;           // draw boardMesh this frame
+    Mesh plainBoardMesh;
+    Material plainBoardMaterial;
+    Matrix *boardTransforms;        // plain boards queued this frame
+    int boardCount;
+    int boardCapacity;
+    Shader instancingShader;
+    const PieceSet *pieces;
+    Material materials[2];          // the piece materials by side, using the instancing shader
+    PieceBatch batches[NO_PIECE][MAX_PIECE_LODS];   // by piece code and level of detail
+    Vector3 cameraPosition;         // of the frame being collected, for LOD selection
+    float pixelsPerUnit;            // screen pixels per world unit at distance 1
+    bool orthographic;
+    int drawCalls;                  // submitted by the last DrawBoardRenderer
+    int pieceInstances;             // pieces drawn by the last DrawBoardRenderer
+} BoardRenderer;
+
+// pieces must outlive the renderer
+bool InitBoardRenderer(BoardRenderer *renderer, Vector3 boardPosition, float squareSize, const PieceSet *pieces);
+void UnloadBoardRenderer(BoardRenderer *renderer);
+
+void SetSquareColor(BoardRenderer *renderer, int row, int col, Color color);
+
+// Starts collecting a new frame seen through camera. Each piece gets the
+// coarsest level of detail whose error stays under about a pixel.
+void ClearRenderQueue(BoardRenderer *renderer, Camera camera);
+
+// The highlightable board of the interactive game, at the renderer's board position
+void AddGameBoard(BoardRenderer *renderer);
+
+// A board in the default square colors with its a8 square centered at origin
+void AddPlainBoard(BoardRenderer *renderer, Vector3 origin);
+
+void AddPiece(BoardRenderer *renderer, int piece, Vector3 position);
+
+// Same with the PieceTransform already computed; position still drives the level of detail
+void AddPieceInstance(BoardRenderer *renderer, int piece, Matrix transform, Vector3 position);
+
+// Call between BeginMode3D and EndMode3D
+void DrawBoardRenderer(BoardRenderer *renderer);
+
+// Scale, facing and lift of a piece standing on the square centered at position
+Matrix PieceTransform(int piece, Vector3 position);
+
+// aspect is the viewport width over its height
+Frustum GetCameraFrustum(Camera camera, float aspect);
+bool BoxInFrustum(const Frustum *frustum, BoundingBox box);
+
+#endif
@@ -0,0 +1,28 @@
+#include "ring.h"
+
+#include <string.h>
+
+void InitRing(RingQueue *ring, void *storage, int elementSize, int capacity) {
+    memset(ring, 0, sizeof(*ring));
+    ring->storage = storage;
+    ring->elementSize = elementSize;
+    ring->mask = capacity - 1;
+}
+
+bool RingPush(RingQueue *ring, const void *element) {
+    int tail = ring->tail;
+    if ((unsigned)tail - (unsigned)AtomicLoad(&ring->head) > (unsigned)ring->mask) return false;
+
+    memcpy(ring->storage + (size_t)(tail & ring->mask) * ring->elementSize, element, ring->elementSize);
+    AtomicStore(&ring->tail, (int)((unsigned)tail + 1)); // publish only after the element is written
+    return true;
+}
+
+bool RingPop(RingQueue *ring, void *element) {
+    int head = ring->head;
+    if (head == AtomicLoad(&ring->tail)) return false;
+
+    memcpy(element, ring->storage + (size_t)(head & ring->mask) * ring->elementSize, ring->elementSize);
+    AtomicStore(&ring->head, (int)((unsigned)head + 1)); // hand the slot back only after it is read
+    return true;
+}
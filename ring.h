@@ -0,0 +1,26 @@
+#ifndef RING_H
+#define RING_H
+
+#include "platform.h"
+
+#include <stddef.h>
+
+// Single-producer single-consumer queue of fixed-size elements. Push and pop
+// never block or take a lock: each side only writes its own index, and the
+// other side reads it atomically. Capacity must be a power of two.
+typedef struct RingQueue {
+    unsigned char *storage;
+    int elementSize;
+    int mask;
+    volatile int head;          // next slot to read, written by the consumer only
+    char padding[60];           // keep the two indices on separate cache lines
+    volatile int tail;          // next slot to write, written by the producer only
+} RingQueue;
+
+void InitRing(RingQueue *ring, void *storage, int elementSize, int capacity);
+
+// False if the queue is full (push) or empty (pop)
+bool RingPush(RingQueue *ring, const void *element);
+bool RingPop(RingQueue *ring, void *element);
+
+#endif
@@ -0,0 +1,590 @@
+#include "search.h"
+#include "eval.h"
+#include "platform.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ASPIRATION_WINDOW 25
+
+static int reductions[64][64];
+static bool reductionsReady = false;
+
+static void InitReductions(void) {
+    for (int depth = 1; depth < 64; depth++) {
+        for (int moves = 1; moves < 64; moves++) {
+            reductions[depth][moves] = (int)(0.75 + log((double)depth) * log((double)moves) / 2.25);
+        }
+    }
+    reductionsReady = true;
+}
+
+void InitSearcher(Searcher *searcher) {
+    memset(searcher, 0, sizeof(*searcher));
+    if (!reductionsReady) InitReductions();
+}
+
+void SetSearchHistory(Searcher *searcher, const uint64_t *keys, int count) {
+    // Only the most recent positions can still repeat
+    if (count > MAX_HISTORY) {
+        keys += count - MAX_HISTORY;
+        count = MAX_HISTORY;
+    }
+    memcpy(searcher->keys, keys, sizeof(uint64_t) * count);
+    searcher->keyCount = count;
+}
+
+// Nodes of the whole search, all threads included
+static uint64_t SearchedNodes(const Searcher *s) {
+    if (!s->sharedNodes) return s->nodes;
+    return (uint64_t)AtomicLoad64(s->sharedNodes) + (s->nodes - s->flushedNodes);
+}
+
+// Polls the clock and shared state every 1024 nodes so the time budget is
+// respected within microseconds
+static bool CheckLimits(Searcher *s) {
+    if (!s->sharedNodes && s->limits.nodes && s->nodes >= s->limits.nodes) s->stopped = true;
+    if ((s->nodes & 1023) == 0) {
+        if (s->sharedNodes) {
+            uint64_t total = (uint64_t)AtomicAdd64(s->sharedNodes, (int64_t)(s->nodes - s->flushedNodes));
+            s->flushedNodes = s->nodes;
+            if (s->limits.nodes && total >= s->limits.nodes) s->stopped = true;
+        }
+        if (s->stop && AtomicLoad(s->stop)) s->stopped = true;
+        if (s->limits.timeMs && GetMicroseconds() - s->startTime >= s->limits.timeMs * 1000) s->stopped = true;
+    }
+    return s->stopped;
+}
+
+// Helper threads skip some iterations so they spread over different depths
+// instead of repeating the main thread's work
+static const int skipSize[16] = { 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4 };
+static const int skipPhase[16] = { 0, 1, 0, 1, 2, 3, 0, 1, 2, 3, 4, 5, 0, 1, 2, 3 };
+
+static bool SkipIteration(int threadId, int depth) {
+    int i = (threadId - 1) % 16;
+    return threadId > 0 && ((depth + skipPhase[i]) / skipSize[i]) % 2 != 0;
+}
+
+static bool HasNonPawnMaterial(const Position *pos, int side) {
+    const Bitboard *p = pos->pieces[side];
+    return (p[PIECE_KNIGHT] | p[PIECE_BISHOP] | p[PIECE_ROOK] | p[PIECE_QUEEN]) != 0;
+}
+
+static bool IsInsufficientMaterial(const Position *pos) {
+    const Bitboard (*p)[PIECE_TYPE_COUNT] = pos->pieces;
+    Bitboard heavy = p[SIDE_WHITE][PIECE_PAWN] | p[SIDE_BLACK][PIECE_PAWN]
+                   | p[SIDE_WHITE][PIECE_ROOK] | p[SIDE_BLACK][PIECE_ROOK]
+                   | p[SIDE_WHITE][PIECE_QUEEN] | p[SIDE_BLACK][PIECE_QUEEN];
+    Bitboard minors = p[SIDE_WHITE][PIECE_KNIGHT] | p[SIDE_BLACK][PIECE_KNIGHT]
+                    | p[SIDE_WHITE][PIECE_BISHOP] | p[SIDE_BLACK][PIECE_BISHOP];
+    return !heavy && !MoreThanOne(minors);
+}
+
+// A position seen before since the last irreversible move is scored as a draw
+static bool IsRepetition(const Searcher *s, int ply) {
+    const Position *pos = &s->pos;
+    int current = s->keyCount + ply;
+    int oldest = current - pos->halfmoveClock;
+
+    if (oldest < 0) oldest = 0;
+    for (int i = current - 4; i >= oldest; i -= 2) {
+        if (s->keys[i] == pos->key) return true;
+    }
+    return false;
+}
+
+// Mate scores are stored relative to the node, not the root, so they stay
+// correct when the same position is reached at another ply
+static int ScoreToTT(int score, int ply) {
+    if (score >= SCORE_MATE_IN_MAX) return score + ply;
+    if (score <= -SCORE_MATE_IN_MAX) return score - ply;
+    return score;
+}
+
+static int ScoreFromTT(int score, int ply) {
+    if (score >= SCORE_MATE_IN_MAX) return score - ply;
+    if (score <= -SCORE_MATE_IN_MAX) return score + ply;
+    return score;
+}
+
+// Mates beyond the search horizon score as a plain win, like a mate the search has not found yet
+static int TablebaseScore(const TbResult *result, int ply) {
+    if (result->wdl == TB_DRAW) return 0;
+    if (ply + result->plies >= MAX_PLY) return result->wdl == TB_WIN ? SCORE_MATE_IN_MAX - 1 : -SCORE_MATE_IN_MAX + 1;
+    return result->wdl == TB_WIN ? SCORE_MATE - ply - result->plies : -SCORE_MATE + ply + result->plies;
+}
+
+static bool TTCutoff(const TTData *entry, int depth, int alpha, int beta, int score) {
+    if (entry->depth < depth) return false;
+    return entry->bound == BOUND_EXACT
+        || (entry->bound == BOUND_LOWER && score >= beta)
+        || (entry->bound == BOUND_UPPER && score <= alpha);
+}
+
+// Higher scores are searched first: hash move, captures (MVV-LVA), promotions,
+// killers, then quiet moves by history
+static void ScoreMoves(const Searcher *s, const MoveList *list, int *scores, Move hashMove, int ply) {
+    const Position *pos = &s->pos;
+
+    for (int i = 0; i < list->count; i++) {
+        Move move = list->moves[i];
+        int from = MOVE_FROM(move), to = MOVE_TO(move);
+
+        if (move == hashMove) {
+            scores[i] = 1 << 30;
+        } else if (MOVE_IS_CAPTURE(move)) {
+            int victim = MOVE_FLAGS(move) == MOVE_EP_CAPTURE ? PIECE_PAWN : PIECE_TYPE(pos->squares[to]);
+            scores[i] = 1000000 + pieceValues[victim] * 10 - PIECE_TYPE(pos->squares[from]);
+        } else if (MOVE_IS_PROMOTION(move)) {
+            scores[i] = 900000 + MOVE_PROMOTION_TYPE(move);
+        } else if (move == s->killers[ply][0]) {
+            scores[i] = 800000;
+        } else if (move == s->killers[ply][1]) {
+            scores[i] = 700000;
+        } else {
+            scores[i] = s->history[pos->sideToMove][from][to];
+        }
+    }
+}
+
+// Selection sort step: brings the best remaining move to index i
+static Move PickMove(MoveList *list, int *scores, int i) {
+    int best = i;
+    for (int j = i + 1; j < list->count; j++) {
+        if (scores[j] > scores[best]) best = j;
+    }
+
+    Move move = list->moves[best];
+    int score = scores[best];
+    list->moves[best] = list->moves[i];
+    scores[best] = scores[i];
+    list->moves[i] = move;
+    scores[i] = score;
+    return move;
+}
+
+// Network evaluation when one is loaded, the hand-crafted one otherwise
+static int EvaluateNode(Searcher *s, int ply) {
+    if (!s->network) return Evaluate(&s->pos, &s->pawns);
+
+    int score = NnueEvaluate(s->network, s->accumulators, ply, &s->pos);
+    if (score >= SCORE_MATE_IN_MAX) return SCORE_MATE_IN_MAX - 1;
+    if (score <= -SCORE_MATE_IN_MAX) return -SCORE_MATE_IN_MAX + 1;
+    return score;
+}
+
+static bool IsExcludedRoot(const Searcher *s, Move move) {
+    for (int i = 0; i < s->excludedCount; i++) {
+        if (s->excluded[i] == move) return true;
+    }
+    return false;
+}
+
+static void UpdatePv(Searcher *s, int ply, Move move) {
+    s->pvTable[ply][0] = move;
+    memcpy(&s->pvTable[ply][1], s->pvTable[ply + 1], sizeof(Move) * s->pvLength[ply + 1]);
+    s->pvLength[ply] = s->pvLength[ply + 1] + 1;
+}
+
+static int Quiescence(Searcher *s, int alpha, int beta, int ply) {
+    Position *pos = &s->pos;
+    MoveList list;
+    UndoInfo undo;
+    int scores[MAX_MOVES];
+
+    s->nodes++;
+    if (CheckLimits(s)) return 0;
+    if (ply > s->selDepth) s->selDepth = ply;
+    if (ply >= MAX_PLY - 1) return EvaluateNode(s, ply);
+
+    bool inCheck = InCheck(pos);
+    int best = -SCORE_INFINITE;
+    int oldAlpha = alpha;
+    int eval = SCORE_NONE;
+    Move bestMove = MOVE_NONE;
+    TTData entry;
+
+    bool ttHit = s->tt && TTProbe(s->tt, pos->key, &entry, &s->ttStats);
+    if (ttHit) {
+        int ttScore = ScoreFromTT(entry.score, ply);
+        if (TTCutoff(&entry, 0, alpha, beta, ttScore)) return ttScore;
+        eval = entry.eval;
+    }
+
+    // Stand pat: the side to move may decline all captures, unless in check
+    if (!inCheck) {
+        if (eval == SCORE_NONE) eval = EvaluateNode(s, ply);
+        best = eval;
+        if (best >= beta) {
+            if (s->tt && !ttHit) TTStore(s->tt, pos->key, MOVE_NONE, ScoreToTT(best, ply), eval, 0, BOUND_LOWER, &s->ttStats);
+            return best;
+        }
+        if (best > alpha) alpha = best;
+    }
+
+    GenerateMoves(pos, &list, inCheck ? GEN_ALL : GEN_CAPTURES);
+    if (inCheck && list.count == 0) return -SCORE_MATE + ply;
+
+    ScoreMoves(s, &list, scores, ttHit ? entry.move : MOVE_NONE, ply);
+    for (int i = 0; i < list.count; i++) {
+        Move move = PickMove(&list, scores, i);
+
+        if (s->network) NnuePush(&s->accumulators[ply + 1], pos, move);
+        MakeMove(pos, move, &undo);
+        if (s->tt) TTPrefetch(s->tt, pos->key);
+        int score = -Quiescence(s, -beta, -alpha, ply + 1);
+        UnmakeMove(pos, move, &undo);
+
+        if (s->stopped) return 0;
+        if (score > best) {
+            best = score;
+            if (score > alpha) {
+                alpha = score;
+                bestMove = move;
+                if (score >= beta) break;
+            }
+        }
+    }
+
+    if (s->tt) {
+        int bound = best >= beta ? BOUND_LOWER : best > oldAlpha ? BOUND_EXACT : BOUND_UPPER;
+        TTStore(s->tt, pos->key, bestMove, ScoreToTT(best, ply), inCheck ? SCORE_NONE : eval, 0, bound, &s->ttStats);
+    }
+    return best;
+}
+
+static int AlphaBeta(Searcher *s, int depth, int alpha, int beta, int ply, bool allowNull) {
+    Position *pos = &s->pos;
+    MoveList list;
+    UndoInfo undo;
+    int scores[MAX_MOVES];
+    bool pvNode = beta - alpha > 1;
+    int oldAlpha = alpha;
+
+    s->pvLength[ply] = 0;
+    s->keys[s->keyCount + ply] = pos->key;
+
+    bool inCheck = InCheck(pos);
+    if (inCheck) depth++; // check extension
+    if (depth <= 0) return Quiescence(s, alpha, beta, ply);
+
+    s->nodes++;
+    if (CheckLimits(s)) return 0;
+    if (ply > s->selDepth) s->selDepth = ply;
+    if (ply >= MAX_PLY - 1) return EvaluateNode(s, ply);
+
+    if (ply > 0) {
+        if (pos->halfmoveClock >= 100 || IsInsufficientMaterial(pos) || IsRepetition(s, ply)) return 0;
+
+        // Mate distance pruning: no line from here can beat a shorter mate already found
+        if (alpha < -SCORE_MATE + ply) alpha = -SCORE_MATE + ply;
+        if (beta > SCORE_MATE - ply - 1) beta = SCORE_MATE - ply - 1;
+        if (alpha >= beta) return alpha;
+
+        // The tablebases know the exact outcome; the fifty-move rule is not part of it
+        TbResult tbResult;
+        if (s->tablebases && PopCount(pos->occupancy[SIDE_BOTH]) <= s->tablebases->maxPieces
+            && ProbeTablebase(s->tablebases, pos, &tbResult)) {
+            s->tbHits++;
+            return TablebaseScore(&tbResult, ply);
+        }
+    }
+
+    TTData entry;
+    Move ttMove = MOVE_NONE;
+    int eval = SCORE_NONE;
+
+    bool ttHit = s->tt && TTProbe(s->tt, pos->key, &entry, &s->ttStats);
+    if (ttHit) {
+        int ttScore = ScoreFromTT(entry.score, ply);
+        if (!pvNode && ply > 0 && TTCutoff(&entry, depth, alpha, beta, ttScore)) return ttScore;
+        ttMove = entry.move;
+        eval = entry.eval;
+    }
+    if (!inCheck && eval == SCORE_NONE) eval = EvaluateNode(s, ply);
+
+    // Null move pruning: if passing still fails high, the position is good enough
+    if (!pvNode && !inCheck && allowNull && depth >= 3 && HasNonPawnMaterial(pos, pos->sideToMove)
+        && eval >= beta) {
+        int reduction = 2 + depth / 4;
+
+        if (s->network) NnuePush(&s->accumulators[ply + 1], pos, MOVE_NONE);
+        MakeNullMove(pos, &undo);
+        int score = -AlphaBeta(s, depth - 1 - reduction, -beta, -beta + 1, ply + 1, false);
+        UnmakeNullMove(pos, &undo);
+
+        if (s->stopped) return 0;
+        if (score >= beta) return score >= SCORE_MATE_IN_MAX ? beta : score;
+    }
+
+    GenerateLegalMoves(pos, &list);
+    if (list.count == 0) return inCheck ? -SCORE_MATE + ply : 0;
+
+    // The previous iteration's best move leads at the root even if its entry was replaced
+    if (ply == 0 && s->pvTable[0][0] != MOVE_NONE) ttMove = s->pvTable[0][0];
+    if (ttMove != MOVE_NONE) {
+        bool legal = false;
+        for (int i = 0; i < list.count && !legal; i++) legal = list.moves[i] == ttMove;
+        if (!legal) {
+            s->ttStats.badMoves++;
+            ttMove = MOVE_NONE;
+        }
+    }
+
+    ScoreMoves(s, &list, scores, ttMove, ply);
+
+    int best = -SCORE_INFINITE;
+    Move bestMove = MOVE_NONE;
+    int searched = 0;
+
+    for (int i = 0; i < list.count; i++) {
+        Move move = PickMove(&list, scores, i);
+        bool quiet = !MOVE_IS_CAPTURE(move) && !MOVE_IS_PROMOTION(move);
+        int score;
+
+        if (ply == 0 && s->excludedCount && IsExcludedRoot(s, move)) continue;
+
+        if (s->network) NnuePush(&s->accumulators[ply + 1], pos, move);
+        MakeMove(pos, move, &undo);
+        if (s->tt) TTPrefetch(s->tt, pos->key);
+
+        if (searched == 0) {
+            score = -AlphaBeta(s, depth - 1, -beta, -alpha, ply + 1, true);
+        } else {
+            // Late move reductions for quiet moves ordered far down the list
+            int reduction = 0;
+            if (depth >= 3 && quiet && !inCheck && !InCheck(pos) && searched >= 3) {
+                reduction = reductions[depth < 64 ? depth : 63][searched < 64 ? searched : 63];
+                if (pvNode) reduction--;
+                if (reduction < 0) reduction = 0;
+                if (reduction > depth - 2) reduction = depth - 2;
+            }
+
+            score = -AlphaBeta(s, depth - 1 - reduction, -alpha - 1, -alpha, ply + 1, true);
+            if (score > alpha && reduction > 0) {
+                score = -AlphaBeta(s, depth - 1, -alpha - 1, -alpha, ply + 1, true);
+            }
+            if (score > alpha && score < beta) {
+                score = -AlphaBeta(s, depth - 1, -beta, -alpha, ply + 1, true);
+            }
+        }
+
+        UnmakeMove(pos, move, &undo);
+        if (s->stopped) return 0;
+        searched++;
+
+        if (score > best) {
+            best = score;
+            if (score > alpha) {
+                alpha = score;
+                bestMove = move;
+                UpdatePv(s, ply, move);
+
+                if (score >= beta) {
+                    if (quiet) {
+                        if (s->killers[ply][0] != move) {
+                            s->killers[ply][1] = s->killers[ply][0];
+                            s->killers[ply][0] = move;
+                        }
+                        int *h = &s->history[pos->sideToMove][MOVE_FROM(move)][MOVE_TO(move)];
+                        *h += depth * depth;
+                        if (*h > 400000) *h = 400000;
+                    }
+                    break;
+                }
+            }
+        }
+    }
+
+    // A root searched without some of its moves says nothing about the position itself
+    if (s->tt && !(ply == 0 && s->excludedCount)) {
+        int bound = best >= beta ? BOUND_LOWER : best > oldAlpha ? BOUND_EXACT : BOUND_UPPER;
+        TTStore(s->tt, pos->key, bestMove, ScoreToTT(best, ply), inCheck ? SCORE_NONE : eval, depth, bound, &s->ttStats);
+    }
+    return best;
+}
+
+static void FillInfo(const Searcher *s, SearchInfo *info, int depth, int score, int line) {
+    info->depth = depth;
+    info->selDepth = s->selDepth;
+    info->score = score;
+    info->multiPv = s->limits.multiPv > 1 ? line + 1 : 0;
+    info->nodes = SearchedNodes(s);
+    info->timeMs = (GetMicroseconds() - s->startTime) / 1000;
+    info->nps = info->timeMs > 0 ? info->nodes * 1000 / (uint64_t)info->timeMs : info->nodes * 1000;
+    info->hashfull = s->tt ? TTHashfull(s->tt) : 0;
+    info->tt = s->ttStats;
+    info->tbHits = s->tbHits;
+    info->pvLength = s->pvLength[0];
+    memcpy(info->pv, s->pvTable[0], sizeof(Move) * s->pvLength[0]);
+}
+
+// One root search of an iteration, in an aspiration window around the previous score
+static int AspirationSearch(Searcher *s, int depth, int previous) {
+    int alpha = -SCORE_INFINITE, beta = SCORE_INFINITE;
+    int window = ASPIRATION_WINDOW;
+    int value;
+
+    // Aspiration window around the previous score, widened on failure
+    if (depth >= 4) {
+        alpha = previous - window > -SCORE_INFINITE ? previous - window : -SCORE_INFINITE;
+        beta = previous + window < SCORE_INFINITE ? previous + window : SCORE_INFINITE;
+    }
+
+    for (;;) {
+        value = AlphaBeta(s, depth, alpha, beta, 0, true);
+        if (s->stopped) break;
+
+        if (value <= alpha) {
+            beta = (alpha + beta) / 2;
+            alpha = value - window > -SCORE_INFINITE ? value - window : -SCORE_INFINITE;
+        } else if (value >= beta) {
+            beta = value + window < SCORE_INFINITE ? value + window : SCORE_INFINITE;
+        } else {
+            break;
+        }
+        window *= 2;
+    }
+    return value;
+}
+
+Move Search(Searcher *s, const Position *pos, const SearchLimits *limits, SearchInfo *result) {
+    MoveList rootMoves;
+    SearchInfo info;
+    SearchInfo lineInfo[MAX_MULTI_PV];  // the lines of the last iteration, best first
+    int maxDepth = limits->depth > 0 && limits->depth < MAX_PLY ? limits->depth : MAX_PLY - 1;
+    int score = 0;
+
+    if (!reductionsReady) InitReductions();
+
+    s->pos = *pos;
+    s->limits = *limits;
+    s->startTime = GetMicroseconds();
+    s->nodes = 0;
+    s->flushedNodes = 0;
+    s->tbHits = 0;
+    s->stopped = false;
+    s->excludedCount = 0;
+    memset(&s->ttStats, 0, sizeof(s->ttStats));
+    if (s->tt && !s->sharedNodes) TTNewSearch(s->tt); // a pool ages its shared table once
+
+    if (s->network) NnueRefresh(s->network, pos, &s->accumulators[0]);
+    memset(s->killers, 0, sizeof(s->killers));
+    memset(s->pvLength, 0, sizeof(s->pvLength));
+    s->pvTable[0][0] = MOVE_NONE;
+
+    // Age history so old games do not dominate move ordering
+    for (int side = 0; side < 2; side++) {
+        for (int from = 0; from < 64; from++) {
+            for (int to = 0; to < 64; to++) s->history[side][from][to] /= 2;
+        }
+    }
+
+    memset(&info, 0, sizeof(info));
+    GenerateLegalMoves(pos, &rootMoves);
+    if (rootMoves.count == 0) {
+        if (result) *result = info;
+        return MOVE_NONE;
+    }
+
+    int lines = limits->multiPv > 1 ? limits->multiPv : 1;
+    if (lines > MAX_MULTI_PV) lines = MAX_MULTI_PV;
+    if (lines > rootMoves.count) lines = rootMoves.count;
+
+    // A position in the tablebases needs no search: report the table's move as one iteration
+    TbResult tbResult;
+    Move tbMove = s->tablebases && lines == 1 ? ProbeTablebaseRoot(s->tablebases, pos, &tbResult) : MOVE_NONE;
+    if (tbMove != MOVE_NONE) {
+        s->tbHits = 1;
+        s->pvTable[0][0] = tbMove;
+        s->pvLength[0] = 1;
+        FillInfo(s, &info, 1, TablebaseScore(&tbResult, 0), 0);
+        if (s->report) s->report(&info, s->reportData);
+        if (result) *result = info;
+        return tbMove;
+    }
+
+    // Fallback if even the first iteration runs out of budget
+    Move best = rootMoves.moves[0];
+
+    for (int depth = 1; depth <= maxDepth; depth++) {
+        if (SkipIteration(s->threadId, depth)) continue;
+        s->selDepth = 0;
+
+        if (lines > 1) {
+            // Line k is the best move left once the moves of the lines before it
+            // are taken out. Each starts from its move of the last iteration.
+            int found = 0;
+            for (int line = 0; line < lines; line++) {
+                if (depth > 1) s->pvTable[0][0] = lineInfo[line].pv[0];
+                int value = AspirationSearch(s, depth, depth > 1 ? lineInfo[line].score : 0);
+                if (s->stopped || s->pvLength[0] == 0) break;
+
+                FillInfo(s, &lineInfo[line], depth, value, line);
+                s->excluded[s->excludedCount++] = s->pvTable[0][0];
+                found++;
+            }
+            s->excludedCount = 0;
+            if (s->stopped) break;
+
+            // A later line can come out ahead of an earlier one; report them best first
+            for (int i = 1; i < found; i++) {
+                SearchInfo line = lineInfo[i];
+                int j = i;
+                for (; j > 0 && lineInfo[j - 1].score < line.score; j--) lineInfo[j] = lineInfo[j - 1];
+                lineInfo[j] = line;
+            }
+            for (int i = 0; i < found; i++) {
+                lineInfo[i].multiPv = i + 1;
+                if (s->report) s->report(&lineInfo[i], s->reportData);
+            }
+
+            info = lineInfo[0];
+            score = info.score;
+            best = info.pv[0];
+            lines = found;
+        } else {
+            int value = AspirationSearch(s, depth, score);
+            if (s->stopped) break;
+
+            score = value;
+            if (s->pvLength[0] > 0) best = s->pvTable[0][0];
+
+            FillInfo(s, &info, depth, score, 0);
+            if (s->report) s->report(&info, s->reportData);
+        }
+
+        // A forced mate is not going to get shorter with more depth
+        if ((score >= SCORE_MATE_IN_MAX || score <= -SCORE_MATE_IN_MAX) && depth > SCORE_MATE - abs(score)) break;
+
+        // Another iteration costs several times this one; do not start what cannot finish
+        if (s->limits.timeMs && info.timeMs * 2 > s->limits.timeMs) break;
+        if (s->limits.nodes && info.nodes * 2 > s->limits.nodes) break;
+    }
+
+    if (result) *result = info;
+    return best;
+}
+
+void PrintSearchInfo(const SearchInfo *info, void *userData) {
+    char text[6];
+    (void)userData;
+
+    printf("info depth %d seldepth %d ", info->depth, info->selDepth);
+    if (info->multiPv) printf("multipv %d ", info->multiPv);
+    printf("score ");
+    if (info->score >= SCORE_MATE_IN_MAX) printf("mate %d", (SCORE_MATE - info->score + 1) / 2);
+    else if (info->score <= -SCORE_MATE_IN_MAX) printf("mate %d", -(SCORE_MATE + info->score) / 2);
+    else printf("cp %d", info->score);
+    printf(" nodes %llu nps %llu hashfull %d tbhits %llu time %lld pv", (unsigned long long)info->nodes,
+           (unsigned long long)info->nps, info->hashfull, (unsigned long long)info->tbHits, (long long)info->timeMs);
+    for (int i = 0; i < info->pvLength; i++) {
+        MoveToString(info->pv[i], text);
+        printf(" %s", text);
+    }
+    printf("\n");
+    fflush(stdout);
+}
@@ -0,0 +1,91 @@
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#include "movegen.h"
+#include "tt.h"
+#include "eval.h"
+#include "nnue.h"
+#include "tablebase.h"
+
+#define MAX_PLY 128
+#define SCORE_INFINITE 32000
+#define SCORE_MATE 31000
+#define SCORE_MATE_IN_MAX (SCORE_MATE - MAX_PLY)
+#define SCORE_NONE 32001
+#define MAX_HISTORY 1024    // game positions kept for repetition detection
+#define MAX_MULTI_PV 32
+
+typedef struct SearchLimits {
+    int depth;              // deepest iteration, 0 for no limit
+    uint64_t nodes;         // node budget, 0 for no limit
+    int64_t timeMs;         // hard wall-clock budget, 0 for no limit
+    int multiPv;            // best lines to report per iteration, 0 or 1 for the usual single line
+} SearchLimits;
+
+// Summary of one completed iteration
+typedef struct SearchInfo {
+    int depth;
+    int selDepth;
+    int score;              // centipawns, or +-(SCORE_MATE - plies) for mates
+    int multiPv;            // 1 for the best line of a multi-PV search, 2 for the next; 0 in a single-line search
+    uint64_t nodes;
+    int64_t timeMs;
+    uint64_t nps;
+    int hashfull;           // permille of the transposition table used by this search
+    TTStats tt;
+    uint64_t tbHits;        // positions scored by the endgame tablebases
+    int pvLength;
+    Move pv[MAX_PLY];
+} SearchInfo;
+
+typedef void (*SearchReport)(const SearchInfo *info, void *userData);
+
+// All state of one search; nothing is global, so several can run at once
+typedef struct Searcher {
+    Position pos;
+    SearchLimits limits;
+    int64_t startTime;
+    uint64_t nodes;
+    int selDepth;
+    bool stopped;
+
+    // Set when the searcher runs as one thread of a SearchPool
+    int threadId;           // 0 is the thread that owns the clock and reports
+    volatile int *stop;     // shared abort flag, polled with the clock
+    volatile int64_t *sharedNodes;  // total over all threads, flushed every 1024 nodes
+    uint64_t flushedNodes;
+    TranspositionTable *tt; // may be shared with other searchers, NULL to search without one
+    TTStats ttStats;
+    uint64_t keys[MAX_HISTORY + MAX_PLY];   // game positions, then the current line
+    int keyCount;           // game positions before the root
+    Move killers[MAX_PLY][2];
+    int history[2][64][64];
+    PawnTable pawns;        // this thread's pawn structure cache
+    const Network *network; // evaluates instead of Evaluate when set; shared, read only
+    Accumulator accumulators[MAX_PLY + 1];  // by ply, filled lazily as nodes are evaluated
+    Tablebases *tablebases; // probed once few pieces are left when set; shared
+    uint64_t tbHits;
+    Move excluded[MAX_MULTI_PV];    // root moves of the lines already searched this iteration
+    int excludedCount;
+    Move pvTable[MAX_PLY][MAX_PLY];
+    int pvLength[MAX_PLY];
+    SearchReport report;    // called after every completed iteration, may be NULL
+    void *reportData;
+} Searcher;
+
+// Clears the move ordering tables; call once before the first search of a game
+void InitSearcher(Searcher *searcher);
+
+// Keys of the positions played before the root, oldest first, for repetition draws
+void SetSearchHistory(Searcher *searcher, const uint64_t *keys, int count);
+
+// Iterative deepening search; returns MOVE_NONE only if there is no legal move.
+// With limits->multiPv above 1, each iteration searches the root once per
+// line, every time without the moves of the lines before, and reports every
+// line. The result and the returned move are those of the first line.
+Move Search(Searcher *searcher, const Position *pos, const SearchLimits *limits, SearchInfo *result);
+
+// SearchReport that prints a UCI style "info" line to stdout
+void PrintSearchInfo(const SearchInfo *info, void *userData);
+
+#endif
@@ -0,0 +1,808 @@
+// chess_server: the engine as a long-running analysis service, so that every
+// client shares one warm transposition table and thread pool instead of
+// starting an engine per question.
+//
+//   chess_server [--socket PATH] [--threads N] [--hash MB] [--net FILE]
+//                [--tb DIR] [--tb-cache MB]
+//   chess_server --connect [PATH]
+//
+// The server listens on a local socket at PATH (default chess_server.sock)
+// and reads one JSON request per line from each client:
+//
+//   {"id":"q1","fens":["<fen>",...],"multipv":3,"depth":12,"nodes":0,"movetime":0}
+//
+// "fen" takes a single position instead of "fens". "id" may be any JSON value
+// and is echoed as given. The limits apply to each position; without any, a
+// position is searched to SERVER_DEFAULT_DEPTH. Positions are searched one at
+// a time on every thread, in the order they arrive from all clients.
+//
+// Answers stream back as JSON lines: one per line of the PV each time a depth
+// completes,
+//
+//   {"id":"q1","index":0,"depth":12,"multipv":1,"score":{"cp":31},"nodes":N,
+//    "nps":N,"tbhits":N,"time":MS,"pv":["e2e4","e7e5",...]}
+//
+// then {"id":"q1","index":0,"bestmove":"e2e4"} once the position is done
+// (null in mate or stalemate), and {"id":"q1","done":true,"positions":N}
+// after the last position of the request. A position that cannot be searched
+// gets {"id":..,"index":..,"error":".."} in its place; a line that is not a
+// request gets {"id":..,"error":".."}.
+//
+// {"stop":true} drops the client's queued positions and ends its running
+// search. It is answered by {"stopped":true}, after which nothing more comes
+// of the requests it cut short. A client can shut down its sending side and
+// still read the answers: the connection closes after the last one. Answers
+// wait in a queue for each client's own writer thread, so a client that reads
+// slowly never holds up the search; one that falls SERVER_MAX_OUTPUT behind
+// is dropped.
+//
+// --connect is a client for scripts and testing: it sends stdin to the server
+// at PATH and copies the answers to stdout until the server closes.
+
+#include "smp.h"
+
+#include <signal.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SERVER_DEFAULT_SOCKET "chess_server.sock"
+#define SERVER_DEFAULT_DEPTH 12
+#define SERVER_MAX_CLIENTS 64
+#define SERVER_MAX_LINE (1 << 20)       // bytes per request line
+#define SERVER_MAX_BATCH 4096           // positions per request
+#define SERVER_MAX_FEN 128
+#define SERVER_MAX_ID 128               // bytes of the id as JSON text
+#define SERVER_MAX_NESTING 32
+#define SERVER_MAX_REPLY 4096
+#define SERVER_MAX_OUTPUT (16 << 20)    // answers queued for a client that is not reading; past this it is dropped
+
+typedef struct ServerClient {
+    LocalSocket *socket;
+    int number;                     // for the log
+    volatile int64_t refs;          // the reader thread and every queued or running job
+    volatile int64_t searched;      // positions answered
+    volatile int outputLock;        // answers come from the reader and the analysis thread
+    char *output;                   // answers the writer thread has not taken yet
+    int outputLength, outputCapacity;
+    PlatformSignal *outputReady;
+    volatile int closing;           // no more answers: the writer sends the rest and closes
+    volatile int failed;            // a write failed or the client fell too far behind
+    volatile int *finished;         // the connection slot, set as the writer thread ends
+} ServerClient;
+
+// One position of a request
+typedef struct ServerJob {
+    struct ServerJob *next;
+    ServerClient *client;
+    char id[SERVER_MAX_ID];
+    int index;
+    int positions;                  // on the request's last job, its position count; 0 on the others
+    const char *error;              // answered instead of searching when set
+    Position pos;
+    SearchLimits limits;
+    volatile int cancelled;         // by a stop request
+} ServerJob;
+
+typedef struct ServerRequest {
+    char id[SERVER_MAX_ID];         // "null" until the request names one
+    bool stop;
+    int multiPv;
+    double depth, nodes, movetime;
+    int fenCount;
+    char (*fens)[SERVER_MAX_FEN];   // SERVER_MAX_BATCH of them
+    bool fenTooLong[SERVER_MAX_BATCH];
+} ServerRequest;
+
+typedef struct ServerConnection {
+    ServerClient *client;           // NULL for a free slot
+    PlatformThread *reader, *writer;
+    volatile int finished;          // the writer has closed the connection
+} ServerConnection;
+
+typedef struct ReplyLine {
+    char text[SERVER_MAX_REPLY];
+    int length;
+} ReplyLine;
+
+// One pool searches for every client. The lock guards the queue and the job
+// being searched, so a stop request sees each job either queued or running.
+static struct {
+    SearchPool pool;
+    TranspositionTable tt;
+    volatile int lock;
+    ServerJob *head, *tail;
+    ServerJob *current;
+    PlatformSignal *work;
+} server;
+
+static void Lock(volatile int *lock) {
+    while (!AtomicCompareExchange(lock, 0, 1)) {}
+}
+
+static void Unlock(volatile int *lock) {
+    AtomicStore(lock, 0);
+}
+
+// The last reference lets the writer thread send what is left and close
+static void ReleaseClient(ServerClient *client) {
+    if (AtomicAdd64(&client->refs, -1) > 0) return;
+    AtomicStore(&client->closing, 1);
+    SetSignal(client->outputReady);
+}
+
+// Text past the end of the buffer is cut; no answer comes near its size
+static void Append(ReplyLine *line, const char *format, ...) {
+    va_list args;
+    int room = SERVER_MAX_REPLY - line->length;
+
+    va_start(args, format);
+    int written = vsnprintf(line->text + line->length, room, format, args);
+    va_end(args);
+    if (written > 0) line->length += written < room ? written : room - 1;
+}
+
+// Queues the line for the client's writer thread, so a client that reads
+// slowly never holds up the search; false once the client is gone
+static bool SendReply(ServerClient *client, ReplyLine *line) {
+    bool queued = true;
+
+    if (AtomicLoad(&client->failed)) return false;
+    if (line->length >= SERVER_MAX_REPLY - 1) line->length = SERVER_MAX_REPLY - 2;
+    line->text[line->length++] = '\n';
+
+    Lock(&client->outputLock);
+    int needed = client->outputLength + line->length;
+    if (needed > SERVER_MAX_OUTPUT) {
+        queued = false;
+    } else if (needed > client->outputCapacity) {
+        int capacity = client->outputCapacity ? client->outputCapacity : SERVER_MAX_REPLY;
+        while (capacity < needed) capacity *= 2;
+        char *grown = realloc(client->output, capacity);
+        if (grown) {
+            client->output = grown;
+            client->outputCapacity = capacity;
+        } else {
+            queued = false;
+        }
+    }
+    if (queued) {
+        memcpy(client->output + client->outputLength, line->text, line->length);
+        client->outputLength = needed;
+    }
+    Unlock(&client->outputLock);
+
+    if (!queued && AtomicCompareExchange(&client->failed, 0, 1)) {
+        fprintf(stderr, "client %d does not read its answers, dropped\n", client->number);
+    }
+    SetSignal(client->outputReady);
+    return queued;
+}
+
+// Error messages are string literals of this file, so they need no escaping
+static void SendError(ServerClient *client, const char *id, int index, const char *error) {
+    ReplyLine line = { .length = 0 };
+
+    Append(&line, "{\"id\":%s", id);
+    if (index >= 0) Append(&line, ",\"index\":%d", index);
+    Append(&line, ",\"error\":\"%s\"}", error);
+    SendReply(client, &line);
+}
+
+static void SendStopped(ServerClient *client) {
+    ReplyLine line = { .length = 0 };
+
+    Append(&line, "{\"stopped\":true}");
+    SendReply(client, &line);
+}
+
+// JSON, read leniently: just enough for the requests above
+
+static const char *SkipSpace(const char *p) {
+    while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') p++;
+    return p;
+}
+
+// The string at p into out, or skipped with out NULL; returns the text after
+// it, NULL if it is malformed. A string longer than size - 1 is cut and sets
+// *tooLong.
+static const char *ParseString(const char *p, char *out, int size, bool *tooLong) {
+    int length = 0;
+
+    if (*p++ != '"') return NULL;
+    if (tooLong) *tooLong = false;
+    for (;;) {
+        char c = *p++;
+
+        if (c == '\0') return NULL;
+        if (c == '"') break;
+        if (c == '\\') {
+            c = *p++;
+            switch (c) {
+            case '"': case '\\': case '/': break;
+            case 'b': c = '\b'; break;
+            case 'f': c = '\f'; break;
+            case 'n': c = '\n'; break;
+            case 'r': c = '\r'; break;
+            case 't': c = '\t'; break;
+            case 'u': {
+                unsigned code = 0;
+                for (int i = 0; i < 4; i++, p++) {
+                    char h = *p;
+                    if (h >= '0' && h <= '9') code = code * 16 + (unsigned)(h - '0');
+                    else if (h >= 'a' && h <= 'f') code = code * 16 + (unsigned)(h - 'a' + 10);
+                    else if (h >= 'A' && h <= 'F') code = code * 16 + (unsigned)(h - 'A' + 10);
+                    else return NULL;
+                }
+                c = code < 128 ? (char)code : '?';  // FENs and move names are ASCII
+                break;
+            }
+            default: return NULL;
+            }
+        }
+        if (!out) continue;
+        if (length + 1 < size) out[length++] = c;
+        else if (tooLong) *tooLong = true;
+    }
+    if (out) out[length] = '\0';
+    return p;
+}
+
+static const char *SkipValue(const char *p, int nesting) {
+    p = SkipSpace(p);
+    if (*p == '"') return ParseString(p, NULL, 0, NULL);
+
+    if (*p == '[' || *p == '{') {
+        char close = *p == '[' ? ']' : '}';
+
+        if (nesting >= SERVER_MAX_NESTING) return NULL;
+        p = SkipSpace(p + 1);
+        if (*p == close) return p + 1;
+        for (;;) {
+            if (close == '}') {
+                p = ParseString(SkipSpace(p), NULL, 0, NULL);
+                if (!p || *(p = SkipSpace(p)) != ':') return NULL;
+                p++;
+            }
+            if (!(p = SkipValue(p, nesting + 1))) return NULL;
+            p = SkipSpace(p);
+            if (*p == close) return p + 1;
+            if (*p++ != ',') return NULL;
+        }
+    }
+
+    // Numbers, true, false and null
+    const char *start = p;
+    while (*p && strchr("+-.0123456789eEaflnrstu", *p)) p++;
+    return p > start ? p : NULL;
+}
+
+static const char *ParseNumber(const char *p, double *value) {
+    char *end;
+
+    *value = strtod(p, &end);
+    return end > p ? end : NULL;
+}
+
+static bool KeyIs(const char *start, const char *end, const char *name) {
+    size_t length = strlen(name);
+    return (size_t)(end - start) == length + 2 && strncmp(start + 1, name, length) == 0;
+}
+
+// Fills in the request; returns an error message, or NULL if the line is a request
+static const char *ParseRequest(const char *p, ServerRequest *request) {
+    strcpy(request->id, "null");
+    request->stop = false;
+    request->multiPv = 1;
+    request->depth = request->nodes = request->movetime = 0.0;
+    request->fenCount = 0;
+
+    p = SkipSpace(p);
+    if (*p++ != '{') return "expected a JSON object";
+    p = SkipSpace(p);
+    if (*p == '}') return "no positions";
+
+    for (;;) {
+        const char *key = SkipSpace(p), *keyEnd, *value;
+        double number;
+
+        if (!(keyEnd = ParseString(key, NULL, 0, NULL))) return "malformed JSON";
+        p = SkipSpace(keyEnd);
+        if (*p++ != ':') return "malformed JSON";
+        value = SkipSpace(p);
+
+        if (KeyIs(key, keyEnd, "id")) {
+            if (!(p = SkipValue(value, 0))) return "malformed JSON";
+            if (p - value >= SERVER_MAX_ID) return "id too long";
+            memcpy(request->id, value, p - value);
+            request->id[p - value] = '\0';
+        } else if (KeyIs(key, keyEnd, "fen")) {
+            if (!(p = ParseString(value, request->fens[0], SERVER_MAX_FEN, &request->fenTooLong[0]))) return "fen must be a string";
+            request->fenCount = 1;
+        } else if (KeyIs(key, keyEnd, "fens")) {
+            if (*value != '[') return "fens must be an array of strings";
+            request->fenCount = 0;
+            p = SkipSpace(value + 1);
+            if (*p == ']') p++;
+            else for (;;) {
+                if (request->fenCount == SERVER_MAX_BATCH) return "too many positions";
+                int n = request->fenCount++;
+                if (!(p = ParseString(SkipSpace(p), request->fens[n], SERVER_MAX_FEN, &request->fenTooLong[n]))) {
+                    return "fens must be an array of strings";
+                }
+                p = SkipSpace(p);
+                if (*p == ']') {
+                    p++;
+                    break;
+                }
+                if (*p++ != ',') return "malformed JSON";
+            }
+        } else if (KeyIs(key, keyEnd, "multipv")) {
+            if (!(p = ParseNumber(value, &number))) return "multipv must be a number";
+            request->multiPv = number < 1 ? 1 : number > MAX_MULTI_PV ? MAX_MULTI_PV : (int)number;
+        } else if (KeyIs(key, keyEnd, "depth")) {
+            if (!(p = ParseNumber(value, &request->depth))) return "depth must be a number";
+        } else if (KeyIs(key, keyEnd, "nodes")) {
+            if (!(p = ParseNumber(value, &request->nodes))) return "nodes must be a number";
+        } else if (KeyIs(key, keyEnd, "movetime")) {
+            if (!(p = ParseNumber(value, &request->movetime))) return "movetime must be a number";
+        } else {
+            if (KeyIs(key, keyEnd, "stop")) request->stop = strncmp(value, "true", 4) == 0;
+            if (!(p = SkipValue(value, 0))) return "malformed JSON";
+        }
+
+        p = SkipSpace(p);
+        if (*p == '}') break;
+        if (*p++ != ',') return "malformed JSON";
+    }
+    if (*SkipSpace(p + 1) != '\0') return "one request per line";
+    if (!request->stop && request->fenCount == 0) return "no positions";
+    return NULL;
+}
+
+// Limits from a request, each clamped to what the search takes
+static SearchLimits RequestLimits(const ServerRequest *request) {
+    SearchLimits limits = { 0, 0, 0, request->multiPv };
+
+    if (request->depth >= 1.0) limits.depth = request->depth < MAX_PLY - 1 ? (int)request->depth : MAX_PLY - 1;
+    if (request->nodes >= 1.0) limits.nodes = request->nodes < 1e18 ? (uint64_t)request->nodes : UINT64_MAX;
+    if (request->movetime >= 1.0) limits.timeMs = request->movetime < 1e12 ? (int64_t)request->movetime : INT64_MAX;
+    if (!limits.depth && !limits.nodes && !limits.timeMs) limits.depth = SERVER_DEFAULT_DEPTH;
+    return limits;
+}
+
+// Drops the client's queued jobs and cancels its running one, which then
+// answers the stop itself, after its last line
+static void StopClient(ServerClient *client) {
+    ServerJob *dropped = NULL, **link = &server.head;
+    bool running = false;
+
+    Lock(&server.lock);
+    server.tail = NULL;
+    while (*link) {
+        ServerJob *job = *link;
+        if (job->client == client) {
+            *link = job->next;
+            job->next = dropped;
+            dropped = job;
+        } else {
+            server.tail = job;
+            link = &job->next;
+        }
+    }
+    if (server.current && server.current->client == client) {
+        AtomicStore(&server.current->cancelled, 1);
+        StopPoolSearch(&server.pool);
+        running = true;
+    }
+    Unlock(&server.lock);
+
+    // The reader thread holds a reference of its own, so this never frees the client
+    while (dropped) {
+        ServerJob *next = dropped->next;
+        ReleaseClient(client);
+        free(dropped);
+        dropped = next;
+    }
+    if (!running) SendStopped(client);
+}
+
+// Queues one job per position, the bad ones carrying their error so every
+// answer of a request comes in order
+static void QueueRequest(ServerClient *client, const ServerRequest *request) {
+    ServerJob *first = NULL, *last = NULL;
+    SearchLimits limits = RequestLimits(request);
+
+    for (int i = 0; i < request->fenCount; i++) {
+        ServerJob *job = malloc(sizeof(ServerJob));
+        if (!job) {
+            while (first) {
+                ServerJob *next = first->next;
+                ReleaseClient(client);
+                free(first);
+                first = next;
+            }
+            SendError(client, request->id, -1, "out of memory");
+            return;
+        }
+
+        job->next = NULL;
+        job->client = client;
+        strcpy(job->id, request->id);
+        job->index = i;
+        job->positions = i == request->fenCount - 1 ? request->fenCount : 0;
+        job->error = NULL;
+        job->limits = limits;
+        job->cancelled = 0;
+        if (request->fenTooLong[i] || !PositionFromFen(&job->pos, request->fens[i])) job->error = "invalid fen";
+
+        AtomicAdd64(&client->refs, 1);
+        if (last) last->next = job;
+        else first = job;
+        last = job;
+    }
+
+    Lock(&server.lock);
+    if (server.tail) server.tail->next = first;
+    else server.head = first;
+    server.tail = last;
+    Unlock(&server.lock);
+    SetSignal(server.work);
+}
+
+static void HandleLine(ServerClient *client, const char *line, ServerRequest *request) {
+    if (*SkipSpace(line) == '\0') return;
+
+    const char *error = ParseRequest(line, request);
+    if (error) SendError(client, request->id, -1, error);
+    else if (request->stop) StopClient(client);
+    else QueueRequest(client, request);
+}
+
+// Reads the client's requests until it finishes writing or goes away
+static void ClientMain(void *arg) {
+    ServerClient *client = arg;
+    ServerRequest *request = malloc(sizeof(ServerRequest));
+    char *buffer = malloc(SERVER_MAX_LINE + 1);
+    int length = 0, received;
+    bool overlong = false;          // the rest of a line that did not fit is skipped
+
+    if (request) request->fens = malloc(sizeof(*request->fens) * SERVER_MAX_BATCH);
+    if (!request || !request->fens || !buffer) {
+        fprintf(stderr, "client %d: out of memory\n", client->number);
+        length = -1;
+    }
+
+    while (length >= 0 && (received = ReadLocalSocket(client->socket, buffer + length, SERVER_MAX_LINE - length)) > 0) {
+        int start = 0;
+
+        for (int i = length; i < length + received; i++) {
+            if (buffer[i] != '\n') continue;
+            buffer[i] = '\0';
+            if (!overlong) HandleLine(client, buffer + start, request);
+            overlong = false;
+            start = i + 1;
+        }
+        length += received - start;
+        memmove(buffer, buffer + start, length);
+
+        if (length == SERVER_MAX_LINE) {
+            if (!overlong) SendError(client, "null", -1, "line too long");
+            overlong = true;
+            length = 0;
+        }
+    }
+    if (length > 0 && !overlong) {
+        buffer[length] = '\0';
+        HandleLine(client, buffer, request);
+    }
+
+    if (request) free(request->fens);
+    free(request);
+    free(buffer);
+    ReleaseClient(client);
+}
+
+// Sends the client's answers as they are queued; the only thread that waits
+// on the client's socket. Swaps buffers with the queue, so neither side
+// copies or allocates once both have grown.
+static void WriterMain(void *arg) {
+    ServerClient *client = arg;
+    char *sending = NULL;
+    int capacity = 0;
+
+    for (;;) {
+        // Read before taking the output, so nothing queued before the close is left behind
+        bool closing = AtomicLoad(&client->closing);
+
+        Lock(&client->outputLock);
+        char *taken = client->output;
+        int length = client->outputLength, takenCapacity = client->outputCapacity;
+        client->output = sending;
+        client->outputCapacity = capacity;
+        client->outputLength = 0;
+        Unlock(&client->outputLock);
+        sending = taken;
+        capacity = takenCapacity;
+
+        if (length > 0 && !AtomicLoad(&client->failed) && !WriteLocalSocket(client->socket, sending, length)) {
+            AtomicStore(&client->failed, 1);
+        }
+        if (length > 0) continue;
+        if (closing) break;
+        WaitSignal(client->outputReady);
+    }
+
+    fprintf(stderr, "client %d closed, %lld positions\n", client->number, (long long)client->searched);
+    free(sending);
+    CloseLocalSocket(client->socket);
+    AtomicStore(client->finished, 1);
+}
+
+// Once both of its threads are joined
+static void FreeClient(ServerClient *client) {
+    free(client->output);
+    DestroySignal(client->outputReady);
+    free(client);
+}
+
+static void SendScore(ReplyLine *line, int score) {
+    if (score >= SCORE_MATE_IN_MAX) Append(line, "{\"mate\":%d}", (SCORE_MATE - score + 1) / 2);
+    else if (score <= -SCORE_MATE_IN_MAX) Append(line, "{\"mate\":%d}", -(SCORE_MATE + score) / 2);
+    else Append(line, "{\"cp\":%d}", score);
+}
+
+// SearchReport of the job being searched, on the analysis thread
+static void ReportLine(const SearchInfo *info, void *userData) {
+    ServerJob *job = userData;
+    ReplyLine line = { .length = 0 };
+    char move[6];
+
+    // Also catches a stop that came just before the search began
+    if (AtomicLoad(&job->cancelled)) {
+        StopPoolSearch(&server.pool);
+        return;
+    }
+
+    Append(&line, "{\"id\":%s,\"index\":%d,\"depth\":%d,\"multipv\":%d,\"score\":", job->id, job->index, info->depth,
+           info->multiPv ? info->multiPv : 1);
+    SendScore(&line, info->score);
+    Append(&line, ",\"nodes\":%llu,\"nps\":%llu,\"tbhits\":%llu,\"time\":%lld,\"pv\":[", (unsigned long long)info->nodes,
+           (unsigned long long)info->nps, (unsigned long long)info->tbHits, (long long)info->timeMs);
+    for (int i = 0; i < info->pvLength; i++) {
+        MoveToString(info->pv[i], move);
+        Append(&line, i ? ",\"%s\"" : "\"%s\"", move);
+    }
+    Append(&line, "]}");
+
+    if (!SendReply(job->client, &line)) StopPoolSearch(&server.pool);
+}
+
+static void RunJob(ServerJob *job) {
+    ServerClient *client = job->client;
+    ReplyLine line = { .length = 0 };
+    MoveList moves;
+    char move[6];
+
+    if (AtomicLoad(&client->failed)) return;
+    if (job->error) {
+        SendError(client, job->id, job->index, job->error);
+    } else {
+        Move best = MOVE_NONE;
+
+        GenerateLegalMoves(&job->pos, &moves);
+        if (moves.count > 0) {
+            server.pool.reportData = job;
+            best = PoolSearch(&server.pool, &job->pos, &job->limits, NULL);
+        }
+        if (AtomicLoad(&job->cancelled)) return;
+
+        Append(&line, "{\"id\":%s,\"index\":%d,\"bestmove\":", job->id, job->index);
+        if (best != MOVE_NONE) {
+            MoveToString(best, move);
+            Append(&line, "\"%s\"}", move);
+        } else {
+            Append(&line, "null}");
+        }
+        SendReply(client, &line);
+        AtomicAdd64(&client->searched, 1);
+    }
+
+    if (job->positions && !AtomicLoad(&job->cancelled)) {
+        line.length = 0;
+        Append(&line, "{\"id\":%s,\"done\":true,\"positions\":%d}", job->id, job->positions);
+        SendReply(client, &line);
+    }
+}
+
+// Searches the queued positions one after another, for as long as the server runs
+static void AnalysisMain(void *arg) {
+    (void)arg;
+
+    for (;;) {
+        Lock(&server.lock);
+        ServerJob *job = server.head;
+        if (job) {
+            server.head = job->next;
+            if (!server.head) server.tail = NULL;
+        }
+        server.current = job;
+        Unlock(&server.lock);
+
+        if (!job) {
+            WaitSignal(server.work);
+            continue;
+        }
+
+        RunJob(job);
+
+        Lock(&server.lock);
+        server.current = NULL;
+        bool cancelled = AtomicLoad(&job->cancelled);
+        Unlock(&server.lock);
+
+        if (cancelled) SendStopped(job->client);
+        ReleaseClient(job->client);
+        free(job);
+    }
+}
+
+static void CopyReplies(void *arg) {
+    LocalSocket *socket = arg;
+    char buffer[4096];
+    int received;
+
+    while ((received = ReadLocalSocket(socket, buffer, sizeof(buffer))) > 0) {
+        fwrite(buffer, 1, received, stdout);
+        fflush(stdout);
+    }
+}
+
+static int RunClient(const char *path) {
+    static char line[65536];
+    LocalSocket *socket = ConnectLocalSocket(path);
+
+    if (!socket) {
+        fprintf(stderr, "cannot connect to %s\n", path);
+        return 1;
+    }
+    PlatformThread *reader = StartThread(CopyReplies, socket);
+    if (!reader) {
+        fprintf(stderr, "cannot start a thread\n");
+        CloseLocalSocket(socket);
+        return 1;
+    }
+
+    // Lines longer than the buffer simply go out in pieces
+    while (fgets(line, sizeof(line), stdin)) {
+        if (!WriteLocalSocket(socket, line, (int)strlen(line))) break;
+    }
+    FinishLocalSocket(socket);
+    JoinThread(reader);
+    CloseLocalSocket(socket);
+    return 0;
+}
+
+static void PrintUsage(void) {
+    fprintf(stderr, "usage: chess_server [--socket PATH] [--threads N] [--hash MB] [--net FILE] [--tb DIR] [--tb-cache MB]\n"
+                    "       chess_server --connect [PATH]\n");
+}
+
+int main(int argc, char **argv) {
+    static ServerConnection connections[SERVER_MAX_CLIENTS];
+    static Network network;
+    static Tablebases tablebases;
+    const char *socketPath = SERVER_DEFAULT_SOCKET, *netPath = NULL, *tbPath = NULL;
+    int threads = 0, hashMb = 64, tbCacheMb = TB_DEFAULT_CACHE_MB, clientCount = 0;
+    bool clientMode = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--socket") == 0 && i + 1 < argc) socketPath = argv[++i];
+        else if (strcmp(argv[i], "--connect") == 0) {
+            clientMode = true;
+            if (i + 1 < argc && argv[i + 1][0] != '-') socketPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) threads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--hash") == 0 && i + 1 < argc) hashMb = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--net") == 0 && i + 1 < argc) netPath = argv[++i];
+        else if (strcmp(argv[i], "--tb") == 0 && i + 1 < argc) tbPath = argv[++i];
+        else if (strcmp(argv[i], "--tb-cache") == 0 && i + 1 < argc) tbCacheMb = atoi(argv[++i]);
+        else {
+            PrintUsage();
+            return 2;
+        }
+    }
+
+#if defined(SIGPIPE)
+    // Writes to a client that hung up fail instead of ending the server
+    signal(SIGPIPE, SIG_IGN);
+#endif
+    if (clientMode) return RunClient(socketPath);
+
+    InitBitboards();
+    if (!TTInit(&server.tt, (size_t)(hashMb > 0 ? hashMb : 1)) || !InitSearchPool(&server.pool, threads, &server.tt)) {
+        fprintf(stderr, "cannot allocate the search\n");
+        return 1;
+    }
+    if (netPath) {
+        if (!LoadNetwork(&network, netPath)) {
+            fprintf(stderr, "%s is not a usable network\n", netPath);
+            return 1;
+        }
+        SetPoolNetwork(&server.pool, &network);
+    }
+    if (tbPath) {
+        if (!LoadTablebases(&tablebases, tbPath, (size_t)(tbCacheMb > 0 ? tbCacheMb : 1))) {
+            fprintf(stderr, "no tablebases in %s\n", tbPath);
+            return 1;
+        }
+        SetPoolTablebases(&server.pool, &tablebases);
+    }
+    server.pool.report = ReportLine;
+
+    bool inUse;
+    LocalSocket *listener = ListenLocalSocket(socketPath, &inUse);
+    server.work = CreateSignal();
+    if (!listener || !server.work || !StartThread(AnalysisMain, NULL)) {
+        fprintf(stderr, "cannot listen on %s%s\n", socketPath, inUse ? ": address in use" : "");
+        return 1;
+    }
+    fprintf(stderr, "listening on %s, %d threads, %d MB hash\n", socketPath, server.pool.threadCount, hashMb);
+
+    // Serves until the process is ended
+    for (;;) {
+        LocalSocket *socket = AcceptLocalSocket(listener);
+        if (!socket) {
+            fprintf(stderr, "accepting clients failed\n");
+            CloseLocalSocket(listener);
+            return 1;
+        }
+
+        // Clients whose connection has closed are joined and freed here
+        int slot = -1;
+        for (int i = 0; i < SERVER_MAX_CLIENTS; i++) {
+            ServerConnection *connection = &connections[i];
+            if (connection->client && AtomicLoad(&connection->finished)) {
+                if (connection->reader) JoinThread(connection->reader);
+                JoinThread(connection->writer);
+                FreeClient(connection->client);
+                connection->client = NULL;
+            }
+            if (!connection->client && slot < 0) slot = i;
+        }
+
+        ServerClient *client = slot >= 0 ? calloc(1, sizeof(ServerClient)) : NULL;
+        PlatformSignal *outputReady = client ? CreateSignal() : NULL;
+        if (!outputReady) {
+            static const char busy[] = "{\"id\":null,\"error\":\"too many clients\"}\n";
+            WriteLocalSocket(socket, busy, (int)sizeof(busy) - 1);
+            CloseLocalSocket(socket);
+            free(client);
+            continue;
+        }
+
+        ServerConnection *connection = &connections[slot];
+        client->socket = socket;
+        client->number = ++clientCount;
+        client->refs = 1;
+        client->outputReady = outputReady;
+        client->finished = &connection->finished;
+        connection->finished = 0;
+        fprintf(stderr, "client %d connected\n", client->number);
+
+        connection->writer = StartThread(WriterMain, client);
+        if (!connection->writer) {
+            fprintf(stderr, "client %d: cannot start a thread\n", client->number);
+            CloseLocalSocket(socket);
+            FreeClient(client);
+            continue;
+        }
+        connection->client = client;
+        connection->reader = StartThread(ClientMain, client);
+        if (!connection->reader) {
+            fprintf(stderr, "client %d: cannot start a thread\n", client->number);
+            ReleaseClient(client);  // the writer closes the connection
+        }
+    }
+}
@@ -0,0 +1,162 @@
+#include "smp.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static void WorkerMain(void *arg) {
+    SearchWorker *worker = arg;
+    SearchPool *pool = worker->pool;
+
+    if (pool->lowPriority) LowerThreadPriority();
+
+    for (;;) {
+        WaitSignal(worker->start);
+        if (AtomicLoad(&pool->quit)) break;
+
+        worker->bestMove = Search(&worker->searcher, &pool->root, &pool->helperLimits, &worker->result);
+        SetSignal(worker->done);
+    }
+}
+
+static SearchWorker *CreateWorker(SearchPool *pool, int id) {
+    SearchWorker *worker = malloc(sizeof(*worker));
+    if (!worker) return NULL;
+
+    memset(worker, 0, sizeof(*worker));
+    InitSearcher(&worker->searcher);
+    worker->pool = pool;
+    worker->searcher.threadId = id;
+    worker->searcher.tt = pool->tt;
+    worker->searcher.network = pool->network;
+    worker->searcher.tablebases = pool->tablebases;
+    worker->searcher.stop = &pool->stop;
+    worker->searcher.sharedNodes = &pool->nodes;
+    if (id == 0) return worker;
+
+    worker->start = CreateSignal();
+    worker->done = CreateSignal();
+    if (worker->start && worker->done) worker->thread = StartThread(WorkerMain, worker);
+    if (!worker->thread) {
+        DestroySignal(worker->start);
+        DestroySignal(worker->done);
+        free(worker);
+        return NULL;
+    }
+    return worker;
+}
+
+static void StopWorkers(SearchPool *pool) {
+    AtomicStore(&pool->quit, 1);
+    for (int i = 1; i < pool->threadCount; i++) {
+        SearchWorker *worker = pool->workers[i];
+        SetSignal(worker->start);
+        JoinThread(worker->thread);
+        DestroySignal(worker->start);
+        DestroySignal(worker->done);
+        free(worker);
+        pool->workers[i] = NULL;
+    }
+    pool->threadCount = pool->workers[0] ? 1 : 0;
+    AtomicStore(&pool->quit, 0);
+}
+
+bool InitSearchPool(SearchPool *pool, int threads, TranspositionTable *tt) {
+    memset(pool, 0, sizeof(*pool));
+    pool->tt = tt;
+    pool->workers[0] = CreateWorker(pool, 0);
+    if (!pool->workers[0]) return false;
+    pool->threadCount = 1;
+    return SetPoolThreads(pool, threads);
+}
+
+void FreeSearchPool(SearchPool *pool) {
+    StopWorkers(pool);
+    free(pool->workers[0]);
+    memset(pool, 0, sizeof(*pool));
+}
+
+bool SetPoolThreads(SearchPool *pool, int threads) {
+    if (threads <= 0) threads = GetProcessorCount();
+    if (threads > MAX_SEARCH_THREADS) threads = MAX_SEARCH_THREADS;
+
+    StopWorkers(pool);
+    while (pool->threadCount < threads) {
+        SearchWorker *worker = CreateWorker(pool, pool->threadCount);
+        if (!worker) break;
+        pool->workers[pool->threadCount++] = worker;
+    }
+    return pool->threadCount == threads;
+}
+
+void SetPoolHistory(SearchPool *pool, const uint64_t *keys, int count) {
+    for (int i = 0; i < pool->threadCount; i++) SetSearchHistory(&pool->workers[i]->searcher, keys, count);
+}
+
+void SetPoolNetwork(SearchPool *pool, const Network *network) {
+    pool->network = network;
+    for (int i = 0; i < pool->threadCount; i++) pool->workers[i]->searcher.network = network;
+}
+
+void SetPoolTablebases(SearchPool *pool, Tablebases *tablebases) {
+    pool->tablebases = tablebases;
+    for (int i = 0; i < pool->threadCount; i++) pool->workers[i]->searcher.tablebases = tablebases;
+}
+
+void ClearPool(SearchPool *pool) {
+    for (int i = 0; i < pool->threadCount; i++) {
+        Searcher *searcher = &pool->workers[i]->searcher;
+        memset(searcher->history, 0, sizeof(searcher->history));
+    }
+}
+
+void StopPoolSearch(SearchPool *pool) {
+    AtomicStore(&pool->stop, 1);
+}
+
+Move PoolSearch(SearchPool *pool, const Position *pos, const SearchLimits *limits, SearchInfo *result) {
+    SearchWorker *lead = pool->workers[0];
+
+    pool->root = *pos;
+    AtomicStore(&pool->stop, 0);
+    pool->nodes = 0;
+    if (pool->tt) TTNewSearch(pool->tt);
+
+    // Helpers have no clock or depth of their own; the main thread stops them
+    pool->helperLimits.depth = 0;
+    pool->helperLimits.nodes = limits->nodes;
+    pool->helperLimits.timeMs = 0;
+    pool->helperLimits.multiPv = 0;     // one line is enough to fill the table
+
+    for (int i = 1; i < pool->threadCount; i++) SetSignal(pool->workers[i]->start);
+
+    lead->searcher.report = pool->report;
+    lead->searcher.reportData = pool->reportData;
+    lead->bestMove = Search(&lead->searcher, pos, limits, &lead->result);
+
+    AtomicStore(&pool->stop, 1);
+    for (int i = 1; i < pool->threadCount; i++) WaitSignal(pool->workers[i]->done);
+
+    // A helper that completed a deeper iteration with a better score outvotes
+    // the main thread, unless the main thread's lines are what was asked for
+    SearchWorker *best = lead;
+    for (int i = 1; i < pool->threadCount && limits->multiPv <= 1; i++) {
+        SearchWorker *worker = pool->workers[i];
+        if (worker->bestMove != MOVE_NONE && worker->result.depth > best->result.depth
+            && worker->result.score > best->result.score && worker->result.score < SCORE_MATE_IN_MAX) {
+            best = worker;
+        }
+    }
+
+    if (result) {
+        *result = best->result;
+        result->nodes = 0;
+        for (int i = 0; i < pool->threadCount; i++) result->nodes += pool->workers[i]->searcher.nodes;
+        result->timeMs = (GetMicroseconds() - lead->searcher.startTime) / 1000;
+        result->nps = result->timeMs > 0 ? result->nodes * 1000 / (uint64_t)result->timeMs : result->nodes * 1000;
+        memset(&result->tt, 0, sizeof(result->tt));
+        for (int i = 0; i < pool->threadCount; i++) TTAddStats(&result->tt, &pool->workers[i]->searcher.ttStats);
+        result->tbHits = 0;
+        for (int i = 0; i < pool->threadCount; i++) result->tbHits += pool->workers[i]->searcher.tbHits;
+    }
+    return best->bestMove;
+}
@@ -0,0 +1,64 @@
+#ifndef SMP_H
+#define SMP_H
+
+#include "search.h"
+#include "platform.h"
+
+#define MAX_SEARCH_THREADS 256
+
+typedef struct SearchWorker {
+    Searcher searcher;
+    SearchInfo result;
+    Move bestMove;
+    PlatformThread *thread;
+    PlatformSignal *start;
+    PlatformSignal *done;
+    struct SearchPool *pool;
+} SearchWorker;
+
+// Lazy SMP: every thread runs the ordinary iterative deepening search on the
+// same root, and they cooperate only through the shared transposition table.
+// Worker 0 runs on the calling thread and owns the clock; the helpers are
+// persistent threads that sleep between searches.
+typedef struct SearchPool {
+    SearchWorker *workers[MAX_SEARCH_THREADS];
+    int threadCount;
+    TranspositionTable *tt;
+    const Network *network; // NULL for the hand-crafted evaluation
+    Tablebases *tablebases; // NULL to search without them
+    Position root;
+    SearchLimits helperLimits;
+    volatile int stop;
+    volatile int quit;
+    volatile int64_t nodes;
+    bool lowPriority;       // helpers yield to other threads; applies to helpers started afterwards
+    SearchReport report;
+    void *reportData;
+} SearchPool;
+
+// threads <= 0 uses every processor; false if no thread could be created
+bool InitSearchPool(SearchPool *pool, int threads, TranspositionTable *tt);
+void FreeSearchPool(SearchPool *pool);
+
+// Stops and joins the current helpers, then starts the new count
+bool SetPoolThreads(SearchPool *pool, int threads);
+
+// Same as SetSearchHistory, for every thread of the pool
+void SetPoolHistory(SearchPool *pool, const uint64_t *keys, int count);
+
+// Blocking search on the calling thread plus threadCount - 1 helpers
+Move PoolSearch(SearchPool *pool, const Position *pos, const SearchLimits *limits, SearchInfo *result);
+
+// Makes a running PoolSearch return as soon as possible; safe from any thread
+void StopPoolSearch(SearchPool *pool);
+
+// Evaluator of every thread, current and future; call between searches
+void SetPoolNetwork(SearchPool *pool, const Network *network);
+
+// Tablebases of every thread, current and future; call between searches
+void SetPoolTablebases(SearchPool *pool, Tablebases *tablebases);
+
+// Resets move ordering tables of every thread, e.g. for a new game
+void ClearPool(SearchPool *pool);
+
+#endif
@@ -0,0 +1,413 @@
+#include "tablebase.h"
+#include "movegen.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Table letters in index order; the index into this string is 4 - piece type
+static const char materialLetters[] = "QRBNP";
+
+// Piece counts of one side, queen first, compared as a whole to find the stronger side
+typedef struct SideMaterial {
+    int counts[5];
+} SideMaterial;
+
+static int CompareSides(const SideMaterial *a, const SideMaterial *b) {
+    for (int i = 0; i < 5; i++) {
+        if (a->counts[i] != b->counts[i]) return a->counts[i] - b->counts[i];
+    }
+    return 0;
+}
+
+static int SideTotal(const SideMaterial *side) {
+    return side->counts[0] + side->counts[1] + side->counts[2] + side->counts[3] + side->counts[4];
+}
+
+static uint64_t MaterialCode(const SideMaterial *strong, const SideMaterial *weak) {
+    uint64_t code = 0;
+    for (int i = 0; i < 5; i++) code |= (uint64_t)strong->counts[i] << (4 * i) | (uint64_t)weak->counts[i] << (4 * (i + 5));
+    return code;
+}
+
+static void BuildMaterial(const SideMaterial *strong, const SideMaterial *weak, TbMaterial *material) {
+    const SideMaterial *sides[2] = { strong, weak };
+    char *name = material->name;
+
+    material->count = 0;
+    for (int side = 0; side < 2; side++) {
+        if (side == 1) *name++ = 'v';
+        *name++ = 'K';
+        material->pieces[material->count++] = MAKE_PIECE(side, PIECE_KING);
+        for (int i = 0; i < 5; i++) {
+            for (int n = 0; n < sides[side]->counts[i]; n++) {
+                *name++ = materialLetters[i];
+                material->pieces[material->count++] = (unsigned char)MAKE_PIECE(side, PIECE_QUEEN - i);
+            }
+        }
+    }
+    *name = '\0';
+    material->code = MaterialCode(strong, weak);
+}
+
+static void CountSide(const Position *pos, int side, SideMaterial *material) {
+    for (int i = 0; i < 5; i++) material->counts[i] = PopCount(pos->pieces[side][PIECE_QUEEN - i]);
+}
+
+bool MaterialFromName(const char *name, TbMaterial *material) {
+    SideMaterial sides[2];
+    const char *p = name;
+
+    memset(sides, 0, sizeof(sides));
+    for (int side = 0; side < 2; side++) {
+        if (*p++ != 'K') return false;
+        while (*p && *p != 'v') {
+            const char *letter = strchr(materialLetters, *p++);
+            if (!letter || !*letter) return false;
+            sides[side].counts[letter - materialLetters]++;
+        }
+        if (side == 0 && *p++ != 'v') return false;
+    }
+
+    int total = 2 + SideTotal(&sides[0]) + SideTotal(&sides[1]);
+    if (total < 3 || total > TB_MAX_PIECES || CompareSides(&sides[0], &sides[1]) < 0) return false;
+    BuildMaterial(&sides[0], &sides[1], material);
+    return true;
+}
+
+uint64_t TablebaseEntryCount(const TbMaterial *material) {
+    return 2ULL << (6 * material->count);
+}
+
+uint64_t TablebaseIndex(const TbMaterial *material, const Position *pos, bool mirrored) {
+    uint64_t index = 0;
+
+    for (int i = 0; i < material->count;) {
+        int piece = material->pieces[i];
+        int side = mirrored ? PIECE_SIDE(piece) ^ 1 : PIECE_SIDE(piece);
+        Bitboard pieces = pos->pieces[side][PIECE_TYPE(piece)];
+        int squares[TB_MAX_PIECES], n = 0;
+
+        // Mirroring flips the ranks, so equal pieces are sorted again
+        while (pieces) {
+            int sq = PopLsb(&pieces) ^ (mirrored ? 56 : 0);
+            int j = n++;
+            while (j > 0 && squares[j - 1] > sq) {
+                squares[j] = squares[j - 1];
+                j--;
+            }
+            squares[j] = sq;
+        }
+        for (int j = 0; j < n; j++) index = index * 64 + (uint64_t)squares[j];
+        i += n;
+    }
+    return ((uint64_t)(pos->sideToMove ^ (mirrored ? 1 : 0)) << (6 * material->count)) + index;
+}
+
+bool TablebasePosition(const TbMaterial *material, uint64_t index, Position *pos) {
+    unsigned char squares[64];
+    int placed[TB_MAX_PIECES];
+    int side = (int)(index >> (6 * material->count));
+
+    for (int i = material->count - 1; i >= 0; i--) {
+        placed[i] = (int)(index & 63);
+        index >>= 6;
+    }
+
+    memset(squares, NO_PIECE, sizeof(squares));
+    for (int i = 0; i < material->count; i++) {
+        int piece = material->pieces[i];
+        int sq = placed[i];
+
+        if (squares[sq] != NO_PIECE) return false;
+        if (i > 0 && material->pieces[i - 1] == piece && placed[i - 1] > sq) return false;
+        if (PIECE_TYPE(piece) == PIECE_PAWN && (SQUARE_RANK(sq) == 0 || SQUARE_RANK(sq) == 7)) return false;
+        squares[sq] = (unsigned char)piece;
+    }
+
+    if (!PositionFromSquares(pos, squares, side, 0, SQ_NONE)) return false;
+    return !IsSquareAttacked(pos, KingSquare(pos, side ^ 1), side);
+}
+
+// Sides with at most maxOther pieces besides the king, in a fixed order
+static int ListSides(int maxOther, SideMaterial *sides) {
+    int count = 0;
+    for (int q = 0; q <= maxOther; q++)
+        for (int r = 0; q + r <= maxOther; r++)
+            for (int b = 0; q + r + b <= maxOther; b++)
+                for (int n = 0; q + r + b + n <= maxOther; n++)
+                    for (int p = 0; q + r + b + n + p <= maxOther; p++) sides[count++] = (SideMaterial){ { q, r, b, n, p } };
+    return count;
+}
+
+typedef struct NamedTable {
+    int pieces, pawns, order;
+    char name[16];
+} NamedTable;
+
+static int CompareNamedTables(const void *a, const void *b) {
+    const NamedTable *x = a, *y = b;
+    if (x->pieces != y->pieces) return x->pieces - y->pieces;
+    if (x->pawns != y->pawns) return x->pawns - y->pawns;
+    return x->order - y->order;
+}
+
+int ListTablebaseNames(int maxPieces, char names[][16], int capacity) {
+    SideMaterial sides[256];
+    NamedTable tables[TB_MAX_TABLES];
+    int tableCount = 0;
+
+    if (maxPieces > TB_MAX_PIECES) maxPieces = TB_MAX_PIECES;
+    int sideCount = ListSides(maxPieces - 2, sides);
+    for (int a = 0; a < sideCount; a++) {
+        for (int b = 0; b < sideCount; b++) {
+            int others = SideTotal(&sides[a]) + SideTotal(&sides[b]);
+            if (others == 0 || others > maxPieces - 2 || CompareSides(&sides[a], &sides[b]) < 0) continue;
+            if (tableCount == TB_MAX_TABLES) break;
+
+            TbMaterial material;
+            BuildMaterial(&sides[a], &sides[b], &material);
+            tables[tableCount] = (NamedTable){ others + 2, sides[a].counts[4] + sides[b].counts[4], tableCount, "" };
+            strcpy(tables[tableCount++].name, material.name);
+        }
+    }
+
+    // Captures lead to fewer pieces and promotions to fewer pawns
+    qsort(tables, (size_t)tableCount, sizeof(NamedTable), CompareNamedTables);
+    if (tableCount > capacity) tableCount = capacity;
+    for (int i = 0; i < tableCount; i++) strcpy(names[i], tables[i].name);
+    return tableCount;
+}
+
+static int LookupSlot(uint64_t code) {
+    return (int)((code * 0x9E3779B97F4A7C15ULL) >> 54) & (TB_MAX_TABLES * 2 - 1);
+}
+
+static int FindTable(const Tablebases *tb, uint64_t code) {
+    for (int slot = LookupSlot(code);; slot = (slot + 1) & (TB_MAX_TABLES * 2 - 1)) {
+        int table = tb->lookup[slot];
+        if (table < 0 || tb->tables[table].material.code == code) return table;
+    }
+}
+
+bool AddTablebase(Tablebases *tb, const char *path) {
+    TbTable *table = &tb->tables[tb->tableCount];
+    TbHeader header;
+
+    if (tb->tableCount == TB_MAX_TABLES || !MapFile(&table->file, path)) return false;
+
+    const unsigned char *data = table->file.data;
+    size_t size = table->file.size;
+    bool valid = size >= sizeof(header);
+    if (valid) {
+        memcpy(&header, data, sizeof(header));
+        header.name[sizeof(header.name) - 1] = '\0';
+        valid = header.magic == TB_MAGIC && header.version == TB_VERSION && header.blockEntries == TB_BLOCK_ENTRIES &&
+                MaterialFromName(header.name, &table->material) && FindTable(tb, table->material.code) < 0 &&
+                header.entryCount == TablebaseEntryCount(&table->material) &&
+                header.blockCount == (header.entryCount + TB_BLOCK_ENTRIES - 1) / TB_BLOCK_ENTRIES &&
+                (size - sizeof(header)) / sizeof(uint32_t) > header.blockCount;
+    }
+    if (valid) {
+        table->offsets = (const uint32_t *)(data + sizeof(header));
+        table->blocks = (const unsigned char *)(table->offsets + header.blockCount + 1);
+        valid = table->offsets[header.blockCount] <= size - (size_t)(table->blocks - data);
+
+        // DecodeBlock reads from one offset to the next, so each must stay in the file
+        for (uint32_t block = 0; valid && block < header.blockCount; block++) {
+            valid = table->offsets[block] <= table->offsets[block + 1];
+        }
+    }
+    if (!valid) {
+        UnmapFile(&table->file);
+        return false;
+    }
+
+    table->entryCount = header.entryCount;
+    table->blockCount = header.blockCount;
+
+    int slot = LookupSlot(table->material.code);
+    while (tb->lookup[slot] >= 0) slot = (slot + 1) & (TB_MAX_TABLES * 2 - 1);
+    tb->lookup[slot] = tb->tableCount++;
+    if (table->material.count > tb->maxPieces) tb->maxPieces = table->material.count;
+    return true;
+}
+
+int LoadTablebases(Tablebases *tb, const char *directory, size_t cacheMb) {
+    static char names[TB_MAX_TABLES][16];
+    char path[1024];
+
+    memset(tb, 0, sizeof(*tb));
+    memset(tb->lookup, -1, sizeof(tb->lookup));
+
+    // Slots start out unused, linked newest to oldest
+    tb->slotCount = (int)(cacheMb * 1024 * 1024 / TB_BLOCK_ENTRIES);
+    if (tb->slotCount < 1) tb->slotCount = 1;
+    for (tb->bucketMask = 1; tb->bucketMask < tb->slotCount * 2; tb->bucketMask *= 2) {}
+    tb->cacheData = malloc((size_t)tb->slotCount * TB_BLOCK_ENTRIES);
+    tb->slots = malloc(sizeof(TbCacheSlot) * (size_t)tb->slotCount);
+    tb->buckets = malloc(sizeof(int) * (size_t)tb->bucketMask);
+    if (!tb->cacheData || !tb->slots || !tb->buckets) {
+        UnloadTablebases(tb);
+        return 0;
+    }
+    memset(tb->buckets, -1, sizeof(int) * (size_t)tb->bucketMask);
+    tb->bucketMask--;
+    for (int i = 0; i < tb->slotCount; i++) tb->slots[i] = (TbCacheSlot){ -1, 0, i - 1, i + 1, -1 };
+    tb->slots[tb->slotCount - 1].older = -1;
+    tb->newest = 0;
+    tb->oldest = tb->slotCount - 1;
+
+    int count = ListTablebaseNames(TB_MAX_PIECES, names, TB_MAX_TABLES);
+    for (int i = 0; i < count; i++) {
+        // A directory whose paths do not fit has no tables to offer
+        if (snprintf(path, sizeof(path), "%s/%s.ctb", directory, names[i]) >= (int)sizeof(path)) break;
+        AddTablebase(tb, path);
+    }
+    return tb->tableCount;
+}
+
+void UnloadTablebases(Tablebases *tb) {
+    for (int i = 0; i < tb->tableCount; i++) UnmapFile(&tb->tables[i].file);
+    free(tb->cacheData);
+    free(tb->slots);
+    free(tb->buckets);
+    tb->cacheData = NULL;
+    tb->slots = NULL;
+    tb->buckets = NULL;
+    tb->tableCount = 0;
+    tb->maxPieces = 0;
+}
+
+static void DecodeBlock(const TbTable *table, uint32_t block, unsigned char *out) {
+    const unsigned char *p = table->blocks + table->offsets[block];
+    const unsigned char *end = table->blocks + table->offsets[block + 1];
+    int filled = 0;
+
+    while (p + 1 < end && filled < TB_BLOCK_ENTRIES) {
+        int run = p[0] + 1;
+        if (run > TB_BLOCK_ENTRIES - filled) run = TB_BLOCK_ENTRIES - filled;
+        memset(out + filled, p[1], (size_t)run);
+        filled += run;
+        p += 2;
+    }
+    memset(out + filled, 0, (size_t)(TB_BLOCK_ENTRIES - filled));
+}
+
+static unsigned BlockHash(const Tablebases *tb, int table, uint32_t block) {
+    return (unsigned)((((uint64_t)table << 32 | block) * 0x9E3779B97F4A7C15ULL) >> 40) & (unsigned)tb->bucketMask;
+}
+
+static void UnlinkSlot(Tablebases *tb, int slot) {
+    TbCacheSlot *s = &tb->slots[slot];
+    if (s->newer >= 0) tb->slots[s->newer].older = s->older;
+    else tb->newest = s->older;
+    if (s->older >= 0) tb->slots[s->older].newer = s->newer;
+    else tb->oldest = s->newer;
+}
+
+static void MakeNewest(Tablebases *tb, int slot) {
+    UnlinkSlot(tb, slot);
+    tb->slots[slot].newer = -1;
+    tb->slots[slot].older = tb->newest;
+    if (tb->newest >= 0) tb->slots[tb->newest].newer = slot;
+    tb->newest = slot;
+    if (tb->oldest < 0) tb->oldest = slot;
+}
+
+// The entry byte, decoding its block into the least recently used slot on a miss
+static int ReadEntry(Tablebases *tb, int table, uint64_t index) {
+    uint32_t block = (uint32_t)(index / TB_BLOCK_ENTRIES);
+    unsigned bucket = BlockHash(tb, table, block);
+    int slot;
+
+    while (!AtomicCompareExchange(&tb->lock, 0, 1)) {}
+
+    for (slot = tb->buckets[bucket]; slot >= 0; slot = tb->slots[slot].next) {
+        if (tb->slots[slot].table == table && tb->slots[slot].block == block) break;
+    }
+
+    if (slot >= 0) {
+        AtomicAdd64(&tb->blockHits, 1);
+    } else {
+        AtomicAdd64(&tb->blockMisses, 1);
+        slot = tb->oldest;
+
+        // Take the evicted block out of its hash chain
+        TbCacheSlot *evicted = &tb->slots[slot];
+        if (evicted->table >= 0) {
+            int *link = &tb->buckets[BlockHash(tb, evicted->table, evicted->block)];
+            while (*link != slot) link = &tb->slots[*link].next;
+            *link = evicted->next;
+        }
+
+        evicted->table = table;
+        evicted->block = block;
+        evicted->next = tb->buckets[bucket];
+        tb->buckets[bucket] = slot;
+        DecodeBlock(&tb->tables[table], block, tb->cacheData + (size_t)slot * TB_BLOCK_ENTRIES);
+    }
+
+    MakeNewest(tb, slot);
+    int entry = tb->cacheData[(size_t)slot * TB_BLOCK_ENTRIES + index % TB_BLOCK_ENTRIES];
+    AtomicStore(&tb->lock, 0);
+    return entry;
+}
+
+bool ProbeTablebase(Tablebases *tb, const Position *pos, TbResult *result) {
+    int pieces = PopCount(pos->occupancy[SIDE_BOTH]);
+
+    if (pieces == 2) {
+        *result = (TbResult){ TB_DRAW, 0 };
+        return true;
+    }
+    if (pieces > tb->maxPieces || pos->castling || pos->epSquare != SQ_NONE) return false;
+
+    SideMaterial white, black;
+    CountSide(pos, SIDE_WHITE, &white);
+    CountSide(pos, SIDE_BLACK, &black);
+    bool mirrored = CompareSides(&white, &black) < 0;
+    int table = FindTable(tb, mirrored ? MaterialCode(&black, &white) : MaterialCode(&white, &black));
+    if (table < 0) return false;
+
+    AtomicAdd64(&tb->probes, 1);
+    int entry = ReadEntry(tb, table, TablebaseIndex(&tb->tables[table].material, pos, mirrored));
+    if (entry == 0) *result = (TbResult){ TB_DRAW, 0 };
+    else if (entry < TB_ENTRY_LOSS) *result = (TbResult){ TB_WIN, 2 * entry - 1 };
+    else *result = (TbResult){ TB_LOSS, 2 * (entry - TB_ENTRY_LOSS) };
+    return true;
+}
+
+Move ProbeTablebaseRoot(Tablebases *tb, const Position *pos, TbResult *result) {
+    MoveList list;
+    Move best = MOVE_NONE;
+    int bestRank = 0;
+
+    if (!ProbeTablebase(tb, pos, result)) return MOVE_NONE;
+
+    // Rank moves so that a higher number is better: quick wins, then draws, then long losses
+    GenerateLegalMoves(pos, &list);
+    for (int i = 0; i < list.count; i++) {
+        Position child = *pos;
+        UndoInfo undo;
+        TbResult reply;
+
+        MakeMove(&child, list.moves[i], &undo);
+        if (!ProbeTablebase(tb, &child, &reply)) return MOVE_NONE;
+
+        int rank = reply.wdl == TB_LOSS ? 2000 - reply.plies : reply.wdl == TB_DRAW ? 1000 : reply.plies;
+        if (best == MOVE_NONE || rank > bestRank) {
+            best = list.moves[i];
+            bestRank = rank;
+        }
+    }
+    return best;
+}
+
+TablebaseStats GetTablebaseStats(Tablebases *tb) {
+    TablebaseStats stats;
+    stats.probes = AtomicLoad64(&tb->probes);
+    stats.blockHits = AtomicLoad64(&tb->blockHits);
+    stats.blockMisses = AtomicLoad64(&tb->blockMisses);
+    return stats;
+}
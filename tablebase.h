@@ -0,0 +1,143 @@
+#ifndef TABLEBASE_H
+#define TABLEBASE_H
+
+#include "position.h"
+#include "platform.h"
+
+// Endgame tablebases: the exact outcome and distance to mate of every
+// position with few pieces, generated by chess_tbgen. One file per material
+// signature, named like "KRvK.ctb", is memory-mapped on load. Files are
+// split into run-length coded blocks; decoded blocks live in a shared LRU
+// cache with a fixed memory budget, so a probe that hits the cache costs a
+// hash lookup and a byte read.
+//
+// Positions with castling rights or an en passant capture are not covered,
+// and generation ignores en passant replies to double pushes, which only
+// matters with pawns on both sides.
+
+#define TB_MAX_PIECES 4
+#define TB_MAX_TABLES 512
+#define TB_MAGIC 0x42543343u        // "C3TB" read as little endian
+#define TB_VERSION 1
+#define TB_BLOCK_ENTRIES 32768      // positions per block, one byte each decoded
+#define TB_DEFAULT_DIR "tablebases"
+#define TB_DEFAULT_CACHE_MB 16
+
+#define TB_LOSS -1
+#define TB_DRAW 0
+#define TB_WIN 1
+#define TB_UNKNOWN 2                // not in the tablebases, for per-move outcomes
+
+// Entry byte: 0 draw (or an impossible position), 1..127 win in that many
+// moves, 128 + n lost in n moves, 128 itself being checkmated
+#define TB_ENTRY_LOSS 128
+
+// File layout, little endian: TbHeader (48 bytes), uint32 offsets[blockCount + 1]
+// of each block from the end of the offsets, then the blocks as pairs of
+// (run length - 1, entry byte). Runs never cross a block.
+typedef struct TbHeader {
+    uint32_t magic;
+    uint32_t version;
+    char name[16];
+    uint64_t entryCount;
+    uint32_t blockEntries;
+    uint32_t blockCount;
+    uint32_t reserved[2];
+} TbHeader;
+
+// The pieces of a table in index order: the stronger side's king, then its
+// other pieces from queen to pawn, then the same for the weaker side. The
+// stronger side plays white in the table; positions where it is black are
+// looked up mirrored.
+typedef struct TbMaterial {
+    int count;
+    unsigned char pieces[TB_MAX_PIECES];
+    char name[16];
+    uint64_t code;                  // piece counts of both sides, for lookups
+} TbMaterial;
+
+// Outcome for the side to move, and plies to mate with best play (0 for draws)
+typedef struct TbResult {
+    int wdl;
+    int plies;
+} TbResult;
+
+typedef struct TbTable {
+    MappedFile file;
+    TbMaterial material;
+    uint64_t entryCount;
+    uint32_t blockCount;
+    const uint32_t *offsets;
+    const unsigned char *blocks;
+} TbTable;
+
+typedef struct TbCacheSlot {
+    int table;                      // -1 while unused
+    uint32_t block;
+    int newer, older;               // LRU list
+    int next;                       // hash chain
+} TbCacheSlot;
+
+typedef struct TablebaseStats {
+    int64_t probes;                 // positions looked up in a table
+    int64_t blockHits;              // found their block decoded in the cache
+    int64_t blockMisses;            // had to decode it
+} TablebaseStats;
+
+// Tables and block cache, shared by every search thread. Probes take a spin
+// lock for the cache lookup; statistics are kept with atomics.
+typedef struct Tablebases {
+    TbTable tables[TB_MAX_TABLES];
+    int tableCount;
+    int maxPieces;                  // most pieces of any loaded table, 0 if none
+    int lookup[TB_MAX_TABLES * 2];  // material code hash, table index or -1
+
+    unsigned char *cacheData;       // slotCount blocks
+    TbCacheSlot *slots;
+    int *buckets;
+    int slotCount, bucketMask;
+    int newest, oldest;
+    volatile int lock;
+
+    volatile int64_t probes, blockHits, blockMisses;
+} Tablebases;
+
+// Maps every table of up to TB_MAX_PIECES pieces found in directory and sets
+// up a block cache of cacheMb. Returns how many tables were found.
+int LoadTablebases(Tablebases *tb, const char *directory, size_t cacheMb);
+void UnloadTablebases(Tablebases *tb);
+
+// Adds one table file; false if it is missing or not a table of this version
+bool AddTablebase(Tablebases *tb, const char *path);
+
+// False when the position is not covered; bare kings are a draw without any table
+bool ProbeTablebase(Tablebases *tb, const Position *pos, TbResult *result);
+
+// The best move by the tables: the fastest win, a draw, or the longest
+// resistance. MOVE_NONE when the position or one of its children is not covered.
+Move ProbeTablebaseRoot(Tablebases *tb, const Position *pos, TbResult *result);
+
+TablebaseStats GetTablebaseStats(Tablebases *tb);
+
+// Table names up to maxPieces pieces, ordered so that every table comes after
+// the ones its captures and promotions lead to. Returns how many were written.
+int ListTablebaseNames(int maxPieces, char names[][16], int capacity);
+
+bool MaterialFromName(const char *name, TbMaterial *material);
+
+// Entries in a table: side to move times 64 squares per piece. The side to
+// move is the top of the index, so neighbouring entries differ in the last
+// piece's square and runs of equal outcomes are long.
+uint64_t TablebaseEntryCount(const TbMaterial *material);
+
+// Index of a position with the table's material; mirrored when the stronger
+// side is black. Equal pieces are ordered by square, so each position has
+// one index.
+uint64_t TablebaseIndex(const TbMaterial *material, const Position *pos, bool mirrored);
+
+// The position of an index, false unless it is the index of a legal position
+// (kings apart, no pawn on the first or last rank, the side not to move not
+// in check, equal pieces in square order)
+bool TablebasePosition(const TbMaterial *material, uint64_t index, Position *pos);
+
+#endif
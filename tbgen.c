@@ -0,0 +1,392 @@
+// chess_tbgen: generates the endgame tablebases the engine probes.
+//
+//   chess_tbgen [--dir DIR] [--pieces N] [--threads N] [--only NAME]
+//       writes every table of up to --pieces pieces (default 3, at most 4)
+//       to DIR (default tablebases), smallest first, skipping the ones that
+//       are already there. --only generates a single table; the tables its
+//       captures and promotions lead to must exist.
+//
+// Generation is retrograde. A first pass, split over the threads, looks at
+// every position of the table: mates and stalemates are final, and moves
+// that leave the table (captures and promotions) are looked up in the
+// smaller tables written before. Then the results spread backwards one ply
+// at a time: a position with a move to a lost position is won one ply later,
+// and a position whose every move reaches a won one is lost once its last
+// move is accounted for. Whatever remains is a draw.
+
+#include "tablebase.h"
+#include "movegen.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TBGEN_MAX_THREADS 64
+#define TBGEN_DRAW_ESCAPE 128       // added to the move count of a position that can reach a draw
+
+#define KIND_UNKNOWN 0
+#define KIND_WIN 1
+#define KIND_LOSS 2
+#define KIND_FINAL 4                // value known; alone it means a draw
+#define KIND_INVALID 8              // with KIND_FINAL: the index is not a legal position
+
+// Per-position state while a table is generated, one byte each
+typedef struct TbGenerator {
+    Tablebases *tb;
+    TbMaterial material;
+    uint64_t entryCount;
+    unsigned char *kind;            // KIND_* flags
+    unsigned char *plies;           // plies to mate of a win or loss, final or not yet
+    unsigned char *moves;           // moves inside the table not yet seen to lose
+    unsigned char *floor;           // longest loss through moves that leave the table
+} TbGenerator;
+
+typedef struct TbGenJob {
+    TbGenerator *gen;
+    uint64_t begin, end;
+} TbGenJob;
+
+// Marks a win unless a faster one is known
+static void SetWin(TbGenerator *gen, uint64_t index, int plies) {
+    if (gen->kind[index] & KIND_FINAL) return;
+    if (gen->kind[index] == KIND_WIN && gen->plies[index] <= plies) return;
+    gen->kind[index] = KIND_WIN;
+    gen->plies[index] = (unsigned char)plies;
+}
+
+static void InitialPass(void *arg) {
+    TbGenJob *job = arg;
+    TbGenerator *gen = job->gen;
+
+    for (uint64_t index = job->begin; index < job->end; index++) {
+        Position pos;
+        MoveList list;
+        int win = -1, inside = 0, loss = 0;
+        bool drawn = false;
+
+        if (!TablebasePosition(&gen->material, index, &pos)) {
+            gen->kind[index] = KIND_FINAL | KIND_INVALID;
+            continue;
+        }
+
+        GenerateLegalMoves(&pos, &list);
+        if (list.count == 0) {
+            gen->kind[index] = InCheck(&pos) ? KIND_LOSS : KIND_FINAL;
+            continue;
+        }
+
+        for (int i = 0; i < list.count; i++) {
+            Move move = list.moves[i];
+            Position child = pos;
+            UndoInfo undo;
+            TbResult result;
+
+            if (!MOVE_IS_CAPTURE(move) && !MOVE_IS_PROMOTION(move)) {
+                inside++;
+                continue;
+            }
+
+            MakeMove(&child, move, &undo);
+            if (!ProbeTablebase(gen->tb, &child, &result)) {
+                fprintf(stderr, "%s: a capture or promotion leads to a missing table\n", gen->material.name);
+                exit(1);
+            }
+            if (result.wdl == TB_LOSS && (win < 0 || result.plies + 1 < win)) win = result.plies + 1;
+            if (result.wdl == TB_DRAW) drawn = true;
+            if (result.wdl == TB_WIN && result.plies + 1 > loss) loss = result.plies + 1;
+        }
+
+        gen->moves[index] = (unsigned char)(inside + (drawn ? TBGEN_DRAW_ESCAPE : 0));
+        gen->floor[index] = (unsigned char)loss;
+        if (win >= 0) {
+            gen->kind[index] = KIND_WIN;
+            gen->plies[index] = (unsigned char)win;
+        } else if (inside == 0) {
+            gen->kind[index] = drawn ? KIND_FINAL : KIND_LOSS;
+            gen->plies[index] = (unsigned char)loss;
+        }
+    }
+}
+
+static uint64_t IndexOfSquares(const TbGenerator *gen, const int *squares, int side) {
+    uint64_t index = 0;
+    for (int i = 0; i < gen->material.count; i++) index = index * 64 + (uint64_t)squares[i];
+    return ((uint64_t)side << (6 * gen->material.count)) + index;
+}
+
+// Counts a move of the parent that reaches a position lost or won at plies
+static void UpdateParent(TbGenerator *gen, const int *squares, int moved, int side, bool childLost, int plies) {
+    const unsigned char *pieces = gen->material.pieces;
+    int parent[TB_MAX_PIECES];
+
+    // Equal pieces stay in square order
+    memcpy(parent, squares, sizeof(int) * (size_t)gen->material.count);
+    while (moved > 0 && pieces[moved - 1] == pieces[moved] && parent[moved - 1] > parent[moved]) {
+        int sq = parent[moved];
+        parent[moved] = parent[moved - 1];
+        parent[--moved] = sq;
+    }
+    while (moved + 1 < gen->material.count && pieces[moved + 1] == pieces[moved] && parent[moved + 1] < parent[moved]) {
+        int sq = parent[moved];
+        parent[moved] = parent[moved + 1];
+        parent[++moved] = sq;
+    }
+
+    uint64_t index = IndexOfSquares(gen, parent, side);
+    if (gen->kind[index] & KIND_FINAL) return;
+    if (childLost) {
+        SetWin(gen, index, plies + 1);
+    } else if (gen->kind[index] != KIND_WIN && --gen->moves[index] == 0) {
+        gen->kind[index] = KIND_LOSS;
+        gen->plies[index] = (unsigned char)(gen->floor[index] > plies + 1 ? gen->floor[index] : plies + 1);
+    }
+}
+
+// Walks every move that could have led to the position at index: the side
+// not to move takes back a quiet move of one of its pieces
+static void VisitParents(TbGenerator *gen, uint64_t index) {
+    const unsigned char *pieces = gen->material.pieces;
+    int count = gen->material.count;
+    int squares[TB_MAX_PIECES];
+    int side = (int)(index >> (6 * count)) ^ 1;
+    bool childLost = (gen->kind[index] & ~KIND_FINAL) == KIND_LOSS;
+    Bitboard occupied = 0;
+    uint64_t rest = index;
+
+    for (int i = count - 1; i >= 0; i--) {
+        squares[i] = (int)(rest & 63);
+        rest >>= 6;
+        occupied |= BB(squares[i]);
+    }
+
+    for (int i = 0; i < count; i++) {
+        int piece = pieces[i];
+        int sq = squares[i];
+        Bitboard origins;
+
+        if (PIECE_SIDE(piece) != side) continue;
+        switch (PIECE_TYPE(piece)) {
+            case PIECE_PAWN: {
+                int back = side == SIDE_WHITE ? -8 : 8;
+                int startRank = side == SIDE_WHITE ? 1 : 6;
+                origins = 0;
+                if (!(occupied & BB(sq + back)) && SQUARE_RANK(sq + back) != (side == SIDE_WHITE ? 0 : 7)) {
+                    origins |= BB(sq + back);
+                    if (SQUARE_RANK(sq + 2 * back) == startRank && !(occupied & BB(sq + 2 * back))) origins |= BB(sq + 2 * back);
+                }
+                break;
+            }
+            case PIECE_KNIGHT: origins = knightAttacks[sq]; break;
+            case PIECE_BISHOP: origins = BishopAttacks(sq, occupied); break;
+            case PIECE_ROOK: origins = RookAttacks(sq, occupied); break;
+            case PIECE_QUEEN: origins = QueenAttacks(sq, occupied); break;
+            default: origins = kingAttacks[sq]; break;
+        }
+
+        origins &= ~occupied;
+        while (origins) {
+            squares[i] = PopLsb(&origins);
+            UpdateParent(gen, squares, i, side, childLost, gen->plies[index]);
+        }
+        squares[i] = sq;
+    }
+}
+
+// Entry byte of a position; an index that is not a position is never probed,
+// so it repeats the previous entry to lengthen the run
+static int EncodeEntry(const TbGenerator *gen, uint64_t index, int previous) {
+    int plies = gen->plies[index];
+    int kind = gen->kind[index] & ~KIND_FINAL;
+
+    if (kind == KIND_WIN) return (plies + 1) / 2;
+    if (kind == KIND_LOSS) return TB_ENTRY_LOSS + plies / 2;
+    return kind == KIND_INVALID ? previous : 0;
+}
+
+static bool WriteTable(const TbGenerator *gen, const char *path, uint64_t *compressed) {
+    uint32_t blockCount = (uint32_t)((gen->entryCount + TB_BLOCK_ENTRIES - 1) / TB_BLOCK_ENTRIES);
+    uint32_t *offsets = malloc(sizeof(uint32_t) * ((size_t)blockCount + 1));
+    unsigned char *data = malloc((size_t)gen->entryCount * 2);
+    uint32_t size = 0;
+
+    if (!offsets || !data) {
+        free(offsets);
+        free(data);
+        return false;
+    }
+
+    // Runs never cross a block, so any block decodes on its own
+    for (uint32_t block = 0; block < blockCount; block++) {
+        uint64_t index = (uint64_t)block * TB_BLOCK_ENTRIES;
+        uint64_t end = index + TB_BLOCK_ENTRIES < gen->entryCount ? index + TB_BLOCK_ENTRIES : gen->entryCount;
+
+        offsets[block] = size;
+        while (index < end) {
+            int value = EncodeEntry(gen, index, 0);
+            int run = 1;
+            while (index + (uint64_t)run < end && run < 256 && EncodeEntry(gen, index + (uint64_t)run, value) == value) run++;
+            data[size++] = (unsigned char)(run - 1);
+            data[size++] = (unsigned char)value;
+            index += (uint64_t)run;
+        }
+    }
+    offsets[blockCount] = size;
+
+    TbHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = TB_MAGIC;
+    header.version = TB_VERSION;
+    strcpy(header.name, gen->material.name);
+    header.entryCount = gen->entryCount;
+    header.blockEntries = TB_BLOCK_ENTRIES;
+    header.blockCount = blockCount;
+
+    FILE *out = fopen(path, "wb");
+    bool ok = out && fwrite(&header, sizeof(header), 1, out) == 1 &&
+              fwrite(offsets, sizeof(uint32_t), (size_t)blockCount + 1, out) == (size_t)blockCount + 1 &&
+              fwrite(data, 1, size, out) == size;
+    if (out && fclose(out) != 0) ok = false;
+
+    *compressed = sizeof(header) + sizeof(uint32_t) * ((uint64_t)blockCount + 1) + size;
+    free(offsets);
+    free(data);
+    return ok;
+}
+
+static bool GenerateTable(Tablebases *tb, const char *name, const char *dir, int threadCount) {
+    TbGenerator gen;
+    TbGenJob jobs[TBGEN_MAX_THREADS];
+    PlatformThread *threads[TBGEN_MAX_THREADS];
+    char path[1024];
+    int64_t start = GetMicroseconds();
+
+    memset(&gen, 0, sizeof(gen));
+    gen.tb = tb;
+    if (!MaterialFromName(name, &gen.material)) return false;
+    gen.entryCount = TablebaseEntryCount(&gen.material);
+    gen.kind = calloc((size_t)gen.entryCount, 4);
+    if (!gen.kind) {
+        fprintf(stderr, "%s: out of memory\n", name);
+        return false;
+    }
+    gen.plies = gen.kind + gen.entryCount;
+    gen.moves = gen.plies + gen.entryCount;
+    gen.floor = gen.moves + gen.entryCount;
+
+    for (int i = 0; i < threadCount; i++) {
+        jobs[i] = (TbGenJob){ &gen, gen.entryCount * (uint64_t)i / (uint64_t)threadCount,
+                              gen.entryCount * (uint64_t)(i + 1) / (uint64_t)threadCount };
+        threads[i] = i > 0 ? StartThread(InitialPass, &jobs[i]) : NULL;
+    }
+    InitialPass(&jobs[0]);
+    for (int i = 1; i < threadCount; i++) JoinThread(threads[i]);
+
+    // Each ply's results are final once every shorter one has been spread
+    int longest = 0;
+    for (int plies = 0; plies < 256; plies++) {
+        bool pending = false;
+
+        for (uint64_t index = 0; index < gen.entryCount; index++) {
+            int kind = gen.kind[index];
+            if (kind == KIND_UNKNOWN || (kind & KIND_FINAL)) continue;
+            if (gen.plies[index] != plies) {
+                pending = true;
+                continue;
+            }
+            gen.kind[index] |= KIND_FINAL;
+            longest = plies;
+            VisitParents(&gen, index);
+        }
+        if (!pending && plies > longest) break;
+    }
+
+    uint64_t wins = 0, losses = 0, draws = 0;
+    for (uint64_t index = 0; index < gen.entryCount; index++) {
+        int kind = gen.kind[index] & ~KIND_FINAL;
+        if (kind == KIND_WIN) wins++;
+        else if (kind == KIND_LOSS) losses++;
+        else if (kind != KIND_INVALID) draws++;
+    }
+
+    uint64_t compressed;
+    if (snprintf(path, sizeof(path), "%s/%s.ctb", dir, name) >= (int)sizeof(path)) {
+        fprintf(stderr, "path too long: %s/%s.ctb\n", dir, name);
+        free(gen.kind);
+        return false;
+    }
+    bool ok = WriteTable(&gen, path, &compressed) && AddTablebase(tb, path);
+    free(gen.kind);
+    if (!ok) {
+        fprintf(stderr, "cannot write %s\n", path);
+        return false;
+    }
+
+    printf("%-8s %11llu positions: %llu won, %llu lost, %llu drawn, longest mate %d plies, %llu KB, %.2f s\n", name,
+           (unsigned long long)(wins + losses + draws), (unsigned long long)wins, (unsigned long long)losses,
+           (unsigned long long)draws, longest, (unsigned long long)(compressed / 1024),
+           (GetMicroseconds() - start) / 1e6);
+    fflush(stdout);
+    return true;
+}
+
+static void PrintUsage(void) {
+    fprintf(stderr, "usage: chess_tbgen [--dir DIR] [--pieces N] [--threads N] [--only NAME]\n");
+}
+
+int main(int argc, char **argv) {
+    static Tablebases tb;
+    static char names[TB_MAX_TABLES][16];
+    const char *dir = TB_DEFAULT_DIR;
+    const char *only = NULL;
+    int pieces = 3;
+    int threadCount = GetProcessorCount();
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--dir") == 0 && i + 1 < argc) dir = argv[++i];
+        else if (strcmp(argv[i], "--pieces") == 0 && i + 1 < argc) pieces = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) threadCount = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--only") == 0 && i + 1 < argc) only = argv[++i];
+        else {
+            PrintUsage();
+            return 1;
+        }
+    }
+    if (pieces < 3) pieces = 3;
+    if (pieces > TB_MAX_PIECES) pieces = TB_MAX_PIECES;
+    if (threadCount < 1) threadCount = 1;
+    if (threadCount > TBGEN_MAX_THREADS) threadCount = TBGEN_MAX_THREADS;
+
+    InitBitboards();
+    MakeDirectory(dir);
+    LoadTablebases(&tb, dir, TB_DEFAULT_CACHE_MB);
+
+    TbMaterial material;
+    if (only && !MaterialFromName(only, &material)) {
+        fprintf(stderr, "not a table name: %s\n", only);
+        return 1;
+    }
+
+    int64_t start = GetMicroseconds();
+    int count = ListTablebaseNames(only ? material.count : pieces, names, TB_MAX_TABLES);
+    int generated = 0;
+    for (int i = 0; i < count; i++) {
+        char path[1024];
+        MappedFile existing;
+
+        if (only ? strcmp(names[i], material.name) != 0 : false) continue;
+        if (snprintf(path, sizeof(path), "%s/%s.ctb", dir, names[i]) >= (int)sizeof(path)) {
+            fprintf(stderr, "path too long: %s/%s.ctb\n", dir, names[i]);
+            return 1;
+        }
+        if (!only && MapFile(&existing, path)) {
+            UnmapFile(&existing);
+            continue;
+        }
+        if (!GenerateTable(&tb, names[i], dir, threadCount)) return 1;
+        generated++;
+    }
+
+    printf("%d tables generated in %s, %.2f s\n", generated, dir, (GetMicroseconds() - start) / 1e6);
+    UnloadTablebases(&tb);
+    return 0;
+}
@@ -0,0 +1,188 @@
+#include "tt.h"
+
+#include <stdlib.h>
+#include <string.h>
+#if defined(_MSC_VER)
+#include <malloc.h>
+#endif
+
+// data word: move 0-15, score 16-31, eval 32-47, depth 48-55, bound 56-57, generation 58-63
+#define GENERATION_MASK 63
+
+static inline uint64_t PackData(Move move, int score, int eval, int depth, int bound, int generation) {
+    return (uint64_t)move
+         | (uint64_t)(uint16_t)(int16_t)score << 16
+         | (uint64_t)(uint16_t)(int16_t)eval << 32
+         | (uint64_t)(uint8_t)(int8_t)depth << 48
+         | (uint64_t)bound << 56
+         | (uint64_t)(generation & GENERATION_MASK) << 58;
+}
+
+static inline int DataDepth(uint64_t data) { return (int8_t)(uint8_t)(data >> 48); }
+static inline int DataBound(uint64_t data) { return (int)(data >> 56) & 3; }
+static inline int DataGeneration(uint64_t data) { return (int)(data >> 58); }
+
+// Entries are shared between search threads. Aligned 64-bit loads and stores
+// are single instructions on the targets we build for; relaxed atomics (or
+// volatile on MSVC) keep the compiler from splitting or caching them, and the
+// XOR check catches entries that another thread is halfway through writing.
+static inline uint64_t LoadWord(const uint64_t *word) {
+#if defined(_MSC_VER)
+    return *(const volatile uint64_t *)word;
+#else
+    return __atomic_load_n(word, __ATOMIC_RELAXED);
+#endif
+}
+
+static inline void StoreWord(uint64_t *word, uint64_t value) {
+#if defined(_MSC_VER)
+    *(volatile uint64_t *)word = value;
+#else
+    __atomic_store_n(word, value, __ATOMIC_RELAXED);
+#endif
+}
+
+static void *AllocateAligned(size_t size) {
+#if defined(_MSC_VER)
+    return _aligned_malloc(size, 64);
+#else
+    void *memory = NULL;
+    return posix_memalign(&memory, 64, size) == 0 ? memory : NULL;
+#endif
+}
+
+static void FreeAligned(void *memory) {
+#if defined(_MSC_VER)
+    _aligned_free(memory);
+#else
+    free(memory);
+#endif
+}
+
+bool TTInit(TranspositionTable *tt, size_t megabytes) {
+    uint64_t count = 1;
+
+    TTFree(tt);
+    if (megabytes == 0) megabytes = 1;
+    while (count * 2 * sizeof(TTBucket) <= (uint64_t)megabytes << 20) count *= 2;
+
+    tt->buckets = AllocateAligned((size_t)count * sizeof(TTBucket));
+    if (!tt->buckets) return false;
+
+    tt->bucketMask = count - 1;
+    tt->sizeMb = megabytes;
+    TTClear(tt);
+    return true;
+}
+
+void TTFree(TranspositionTable *tt) {
+    if (tt->buckets) FreeAligned(tt->buckets);
+    memset(tt, 0, sizeof(*tt));
+}
+
+void TTClear(TranspositionTable *tt) {
+    if (tt->buckets) memset(tt->buckets, 0, (size_t)(tt->bucketMask + 1) * sizeof(TTBucket));
+    tt->generation = 0;
+}
+
+void TTNewSearch(TranspositionTable *tt) {
+    tt->generation = (uint8_t)((tt->generation + 1) & GENERATION_MASK);
+}
+
+bool TTProbe(const TranspositionTable *tt, uint64_t key, TTData *data, TTStats *stats) {
+    const TTBucket *bucket = &tt->buckets[key & tt->bucketMask];
+    int occupied = 0;
+
+    stats->probes++;
+
+    for (int i = 0; i < TT_BUCKET_ENTRIES; i++) {
+        uint64_t word = LoadWord(&bucket->entries[i].data);
+        uint64_t check = LoadWord(&bucket->entries[i].check);
+
+        if (!word) continue;
+        occupied++;
+        if ((check ^ word) != key) continue;
+
+        data->move = (Move)word;
+        data->score = (int16_t)(uint16_t)(word >> 16);
+        data->eval = (int16_t)(uint16_t)(word >> 32);
+        data->depth = DataDepth(word);
+        data->bound = DataBound(word);
+        stats->hits++;
+        return true;
+    }
+
+    if (occupied == TT_BUCKET_ENTRIES) stats->collisions++;
+    return false;
+}
+
+// Relative age of an entry in searches, with the generation counter wrapping
+static inline int EntryAge(const TranspositionTable *tt, uint64_t word) {
+    return (tt->generation - DataGeneration(word)) & GENERATION_MASK;
+}
+
+void TTStore(TranspositionTable *tt, uint64_t key, Move move, int score, int eval, int depth, int bound, TTStats *stats) {
+    TTBucket *bucket = &tt->buckets[key & tt->bucketMask];
+    TTEntry *target = NULL;
+    uint64_t targetWord = 0;
+    int worst = 1 << 30;
+
+    for (int i = 0; i < TT_BUCKET_ENTRIES; i++) {
+        TTEntry *entry = &bucket->entries[i];
+        uint64_t word = LoadWord(&entry->data);
+
+        if (!word || (LoadWord(&entry->check) ^ word) == key) {
+            target = entry;
+            targetWord = word;
+            break;
+        }
+
+        // Evict the shallowest entry, treating each search of age as 8 plies
+        int value = DataDepth(word) - 8 * EntryAge(tt, word);
+        if (value < worst) {
+            worst = value;
+            target = entry;
+            targetWord = word;
+        }
+    }
+
+    bool samePosition = targetWord && (LoadWord(&target->check) ^ targetWord) == key;
+    if (samePosition) {
+        // Keep a deeper result from this search unless the new one is exact
+        if (bound != BOUND_EXACT && EntryAge(tt, targetWord) == 0 && depth + 3 < DataDepth(targetWord)) return;
+        if (move == MOVE_NONE) move = (Move)targetWord;
+    } else if (targetWord) {
+        stats->replacements++;
+    }
+
+    uint64_t word = PackData(move, score, eval, depth, bound, tt->generation);
+    StoreWord(&target->check, key ^ word);
+    StoreWord(&target->data, word);
+    stats->stores++;
+}
+
+int TTHashfull(const TranspositionTable *tt) {
+    int used = 0;
+
+    if (!tt->buckets) return 0;
+    for (int i = 0; i < 250; i++) {
+        for (int j = 0; j < TT_BUCKET_ENTRIES; j++) {
+            uint64_t word = LoadWord(&tt->buckets[i & tt->bucketMask].entries[j].data);
+            if (word && EntryAge(tt, word) == 0) used++;
+        }
+    }
+    return used;
+}
+
+void TTAddStats(TTStats *total, const TTStats *stats) {
+    total->probes += stats->probes;
+    total->hits += stats->hits;
+    total->collisions += stats->collisions;
+    total->stores += stats->stores;
+    total->replacements += stats->replacements;
+    total->badMoves += stats->badMoves;
+}
+
+double TTHitRate(const TTStats *stats) {
+    return stats->probes ? (double)stats->hits / (double)stats->probes : 0.0;
+}
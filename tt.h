@@ -0,0 +1,79 @@
+#ifndef TT_H
+#define TT_H
+
+#include "position.h"
+
+#include <stddef.h>
+
+#define TT_BUCKET_ENTRIES 4
+#define TT_DEFAULT_MB 16
+
+#define BOUND_NONE 0
+#define BOUND_UPPER 1   // fail low, score is at most this
+#define BOUND_LOWER 2   // fail high, score is at least this
+#define BOUND_EXACT 3
+
+// Two words per entry. The stored check word is key ^ data, so a reader that
+// sees half of an entry written by another thread fails verification instead
+// of using a mixed result; no locks are needed.
+typedef struct TTEntry {
+    uint64_t check;
+    uint64_t data;
+} TTEntry;
+
+// Exactly one 64-byte cache line
+typedef struct TTBucket {
+    TTEntry entries[TT_BUCKET_ENTRIES];
+} TTBucket;
+
+// Unpacked contents of an entry
+typedef struct TTData {
+    Move move;
+    int score;
+    int eval;
+    int depth;
+    int bound;
+} TTData;
+
+// Per-thread counters, kept outside the shared table so threads do not fight
+// over one cache line
+typedef struct TTStats {
+    uint64_t probes;
+    uint64_t hits;
+    uint64_t collisions;    // probe missed with every slot of the bucket holding another position
+    uint64_t stores;
+    uint64_t replacements;  // store evicted a different position
+    uint64_t badMoves;      // hit whose move is not legal: a key alias or a torn write
+} TTStats;
+
+typedef struct TranspositionTable {
+    TTBucket *buckets;
+    uint64_t bucketMask;    // bucket count is a power of two
+    size_t sizeMb;
+    uint8_t generation;     // advanced once per search so old entries are replaced first
+} TranspositionTable;
+
+// Allocates the largest power-of-two bucket count that fits the budget; false on failure
+bool TTInit(TranspositionTable *tt, size_t megabytes);
+void TTFree(TranspositionTable *tt);
+void TTClear(TranspositionTable *tt);
+void TTNewSearch(TranspositionTable *tt);
+
+bool TTProbe(const TranspositionTable *tt, uint64_t key, TTData *data, TTStats *stats);
+void TTStore(TranspositionTable *tt, uint64_t key, Move move, int score, int eval, int depth, int bound, TTStats *stats);
+
+// Permille of sampled entries written during the current search, as UCI reports it
+int TTHashfull(const TranspositionTable *tt);
+
+void TTAddStats(TTStats *total, const TTStats *stats);
+double TTHitRate(const TTStats *stats);
+
+static inline void TTPrefetch(const TranspositionTable *tt, uint64_t key) {
+#if defined(_MSC_VER)
+    _mm_prefetch((const char *)&tt->buckets[key & tt->bucketMask], _MM_HINT_T0);
+#else
+    __builtin_prefetch(&tt->buckets[key & tt->bucketMask]);
+#endif
+}
+
+#endif
@@ -0,0 +1,360 @@
+// chess_uci: the rules and search core as a UCI engine, no window or raylib.
+//
+//   chess_uci        reads UCI commands on stdin, answers on stdout
+//
+// Supported: uci, isready, ucinewgame, setoption (Hash, Threads, MultiPV,
+// EvalFile, OwnBook, BookFile, TablebasePath, TablebaseCache),
+// position startpos|fen ... [moves ...], go (depth, nodes, movetime,
+// wtime/btime/winc/binc/movestogo, infinite), stop, quit, and d to print
+// the current position and tablebase statistics. The search runs on its own
+// thread so stop and isready are answered while it thinks.
+
+#include "smp.h"
+#include "book.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define UCI_MAX_LINE 65536          // a long game in "position ... moves" fits easily
+#define UCI_MAX_HASH_MB 65536
+#define UCI_MAX_TABLEBASE_CACHE_MB 4096
+#define UCI_MOVE_OVERHEAD_MS 30     // kept back from the clock for I/O and the GUI
+
+typedef struct UciEngine {
+    SearchPool pool;
+    TranspositionTable tt;
+    Network network;
+    char evalFile[1024];
+    int hashMb;
+    Book book;
+    bool ownBook;
+    uint64_t random;
+    Tablebases tablebases;
+    char tablebasePath[1024];
+    int tablebaseCacheMb;
+    int multiPv;
+
+    Position pos;
+    uint64_t history[MAX_HISTORY];  // keys of the positions before pos, oldest first
+    int historyCount;
+
+    // The search in progress, if any
+    PlatformThread *thread;
+    SearchLimits limits;
+    volatile int finished;
+} UciEngine;
+
+static UciEngine uci;
+
+static void SearchMain(void *arg) {
+    UciEngine *engine = arg;
+    SearchInfo info;
+    char text[6] = "0000";
+
+    Move best = PoolSearch(&engine->pool, &engine->pos, &engine->limits, &info);
+    if (best != MOVE_NONE) MoveToString(best, text);
+    printf("bestmove %s\n", text);
+    fflush(stdout);
+    AtomicStore(&engine->finished, 1);
+}
+
+// Stops the search if one is running and waits for its bestmove. The stop
+// flag is raised until the search has ended, because a search that is just
+// starting clears it once.
+static void FinishSearch(UciEngine *engine, bool stop) {
+    if (!engine->thread) return;
+
+    while (stop && !AtomicLoad(&engine->finished)) {
+        StopPoolSearch(&engine->pool);
+        SleepMilliseconds(1);
+    }
+    JoinThread(engine->thread);
+    engine->thread = NULL;
+}
+
+static void PushHistory(UciEngine *engine, uint64_t key) {
+    if (engine->historyCount == MAX_HISTORY) {
+        memmove(engine->history, engine->history + 1, sizeof(uint64_t) * (MAX_HISTORY - 1));
+        engine->historyCount--;
+    }
+    engine->history[engine->historyCount++] = key;
+}
+
+// position startpos|fen <fen> [moves <move> ...]; tokens follow "position"
+static void SetPosition(UciEngine *engine, char *args) {
+    char fen[256] = START_FEN;
+    char *moves = strstr(args, "moves");
+    Position pos;
+
+    if (moves) *moves = '\0';
+    if (strncmp(args, "fen", 3) == 0) {
+        snprintf(fen, sizeof(fen), "%s", args + 3 + strspn(args + 3, " \t"));
+    } else if (strncmp(args, "startpos", 8) != 0) {
+        return;
+    }
+    if (!PositionFromFen(&pos, fen)) {
+        printf("info string invalid fen\n");
+        return;
+    }
+
+    engine->pos = pos;
+    engine->historyCount = 0;
+    if (!moves) return;
+
+    for (char *token = strtok(moves + 5, " \t"); token; token = strtok(NULL, " \t")) {
+        Move move = ParseMove(&engine->pos, token);
+        UndoInfo undo;
+
+        if (move == MOVE_NONE) {
+            printf("info string illegal move %s\n", token);
+            break;
+        }
+        PushHistory(engine, engine->pos.key);
+        MakeMove(&engine->pos, move, &undo);
+    }
+}
+
+// The hard budget for one move from the clock: an even share of the time
+// left plus most of the increment, never more than the clock allows
+static int64_t MoveBudget(int64_t timeLeft, int64_t increment, int movesToGo) {
+    int64_t budget = timeLeft / (movesToGo > 0 ? movesToGo : 30) + increment * 3 / 4;
+    int64_t ceiling = timeLeft - UCI_MOVE_OVERHEAD_MS;
+
+    if (budget > ceiling) budget = ceiling;
+    return budget > 1 ? budget : 1;
+}
+
+static void Go(UciEngine *engine, char *args) {
+    SearchLimits limits = { 0, 0, 0, 0 };
+    int64_t time[2] = { 0, 0 }, increment[2] = { 0, 0 };
+    int movesToGo = 0;
+    bool analysis = false;
+
+    for (char *token = strtok(args, " \t"); token; token = strtok(NULL, " \t")) {
+        // Flags without a value; the search runs until stop anyway when no limit is given
+        if (strcmp(token, "infinite") == 0 || strcmp(token, "ponder") == 0) {
+            analysis = true;
+            continue;
+        }
+
+        char *value = strtok(NULL, " \t");
+        if (!value) break;
+
+        if (strcmp(token, "depth") == 0) limits.depth = atoi(value);
+        else if (strcmp(token, "nodes") == 0) limits.nodes = strtoull(value, NULL, 10);
+        else if (strcmp(token, "movetime") == 0) limits.timeMs = atoll(value);
+        else if (strcmp(token, "wtime") == 0) time[SIDE_WHITE] = atoll(value);
+        else if (strcmp(token, "btime") == 0) time[SIDE_BLACK] = atoll(value);
+        else if (strcmp(token, "winc") == 0) increment[SIDE_WHITE] = atoll(value);
+        else if (strcmp(token, "binc") == 0) increment[SIDE_BLACK] = atoll(value);
+        else if (strcmp(token, "movestogo") == 0) movesToGo = atoi(value);
+    }
+
+    // Book moves are played without a search, except when the GUI waits for stop
+    Move bookMove = engine->ownBook && !analysis ? PickBookMove(&engine->book, &engine->pos, &engine->random) : MOVE_NONE;
+    if (bookMove != MOVE_NONE) {
+        char text[6];
+        MoveToString(bookMove, text);
+        printf("info string book move\nbestmove %s\n", text);
+        return;
+    }
+
+    int us = engine->pos.sideToMove;
+    if (limits.timeMs == 0 && time[us] > 0) limits.timeMs = MoveBudget(time[us], increment[us], movesToGo);
+    limits.multiPv = engine->multiPv;
+
+    engine->limits = limits;
+    engine->finished = 0;
+    SetPoolHistory(&engine->pool, engine->history, engine->historyCount);
+    engine->thread = StartThread(SearchMain, engine);
+    if (!engine->thread) printf("bestmove 0000\n");
+}
+
+// An empty or missing file switches back to the hand-crafted evaluation
+static void SetEvalFile(UciEngine *engine, const char *path) {
+    SetPoolNetwork(&engine->pool, NULL);
+    UnloadNetwork(&engine->network);
+    snprintf(engine->evalFile, sizeof(engine->evalFile), "%s", path);
+
+    if (*path && strcmp(path, "<empty>") != 0 && LoadNetwork(&engine->network, path)) {
+        SetPoolNetwork(&engine->pool, &engine->network);
+        printf("info string evaluating with %s (%s kernels)\n", path, NnueSimdName(NnueActiveSimd()));
+    } else {
+        printf("info string hand-crafted evaluation\n");
+    }
+}
+
+// A missing file leaves the engine without a book
+static void SetBookFile(UciEngine *engine, const char *path) {
+    UnloadBook(&engine->book);
+    if (*path && strcmp(path, "<empty>") != 0 && LoadBook(&engine->book, path)) {
+        printf("info string book %s, %llu entries\n", path, (unsigned long long)engine->book.count);
+    } else {
+        printf("info string no book\n");
+    }
+}
+
+// setoption name <name> value <value>
+// Reloads the tables from tablebasePath with the current cache size; an empty path turns them off
+static void SetTablebases(UciEngine *engine, bool verbose) {
+    const char *path = engine->tablebasePath;
+
+    SetPoolTablebases(&engine->pool, NULL);
+    UnloadTablebases(&engine->tablebases);
+    if (*path && strcmp(path, "<empty>") != 0 && LoadTablebases(&engine->tablebases, path, (size_t)engine->tablebaseCacheMb)) {
+        SetPoolTablebases(&engine->pool, &engine->tablebases);
+        if (verbose) {
+            printf("info string tablebases %s, %d tables up to %d pieces\n", path, engine->tablebases.tableCount,
+                   engine->tablebases.maxPieces);
+        }
+    } else if (verbose) {
+        printf("info string no tablebases\n");
+    }
+}
+
+static void SetOption(UciEngine *engine, char *args) {
+    char *name = strstr(args, "name ");
+    char *value = strstr(args, " value ");
+
+    if (!name) return;
+    name += 5;
+    if (value) {
+        *value = '\0';
+        value += 7;
+    } else {
+        value = "";
+    }
+    value[strcspn(value, "\r\n")] = '\0';
+
+    if (strcmp(name, "Hash") == 0) {
+        int megabytes = atoi(value);
+        if (megabytes < 1) megabytes = 1;
+        if (megabytes > UCI_MAX_HASH_MB) megabytes = UCI_MAX_HASH_MB;
+
+        TTFree(&engine->tt);
+        if (!TTInit(&engine->tt, (size_t)megabytes)) {
+            printf("info string not enough memory for %d MB, using %d MB\n", megabytes, TT_DEFAULT_MB);
+            megabytes = TT_DEFAULT_MB;
+            TTInit(&engine->tt, (size_t)megabytes);
+        }
+        engine->hashMb = megabytes;
+    } else if (strcmp(name, "Threads") == 0) {
+        int threads = atoi(value);
+        if (!SetPoolThreads(&engine->pool, threads > 0 ? threads : 1)) {
+            printf("info string only %d threads could be started\n", engine->pool.threadCount);
+        }
+    } else if (strcmp(name, "MultiPV") == 0) {
+        int lines = atoi(value);
+        engine->multiPv = lines < 1 ? 1 : lines > MAX_MULTI_PV ? MAX_MULTI_PV : lines;
+    } else if (strcmp(name, "EvalFile") == 0) {
+        SetEvalFile(engine, value);
+    } else if (strcmp(name, "OwnBook") == 0) {
+        engine->ownBook = strcmp(value, "true") == 0;
+    } else if (strcmp(name, "BookFile") == 0) {
+        SetBookFile(engine, value);
+    } else if (strcmp(name, "TablebasePath") == 0) {
+        snprintf(engine->tablebasePath, sizeof(engine->tablebasePath), "%s", value);
+        SetTablebases(engine, true);
+    } else if (strcmp(name, "TablebaseCache") == 0) {
+        int megabytes = atoi(value);
+        engine->tablebaseCacheMb = megabytes < 1 ? 1 : megabytes > UCI_MAX_TABLEBASE_CACHE_MB ? UCI_MAX_TABLEBASE_CACHE_MB : megabytes;
+        SetTablebases(engine, true);
+    } else {
+        printf("info string unknown option %s\n", name);
+    }
+}
+
+static void PrintPosition(UciEngine *engine) {
+    char fen[128];
+    char board[8][8];
+
+    PositionToBoard(&engine->pos, board);
+    for (int row = 0; row < 8; row++) printf("%.8s\n", board[row]);
+    PositionToFen(&engine->pos, fen, sizeof(fen));
+    printf("fen %s\nkey %016llx\n", fen, (unsigned long long)engine->pos.key);
+
+    TablebaseStats stats = GetTablebaseStats(&engine->tablebases);
+    int64_t lookups = stats.blockHits + stats.blockMisses;
+    printf("tablebases %d tables, %lld probes, %.1f%% cache hits\n", engine->tablebases.tableCount,
+           (long long)stats.probes, lookups ? stats.blockHits * 100.0 / (double)lookups : 0.0);
+}
+
+int main(void) {
+    static char line[UCI_MAX_LINE];
+
+    InitBitboards();
+    PositionFromFen(&uci.pos, START_FEN);
+    uci.hashMb = TT_DEFAULT_MB;
+    if (!TTInit(&uci.tt, (size_t)uci.hashMb) || !InitSearchPool(&uci.pool, 1, &uci.tt)) {
+        printf("info string out of memory\n");
+        return 1;
+    }
+    uci.pool.report = PrintSearchInfo;
+    snprintf(uci.evalFile, sizeof(uci.evalFile), "%s", NNUE_DEFAULT_FILE);
+    if (LoadNetwork(&uci.network, uci.evalFile)) SetPoolNetwork(&uci.pool, &uci.network);
+    uci.ownBook = false; // UCI convention: the GUI opts in to the engine's book
+    uci.random = (uint64_t)GetMicroseconds() | 1;
+    LoadBook(&uci.book, BOOK_DEFAULT_FILE);
+    snprintf(uci.tablebasePath, sizeof(uci.tablebasePath), "%s", TB_DEFAULT_DIR);
+    uci.tablebaseCacheMb = TB_DEFAULT_CACHE_MB;
+    uci.multiPv = 1;
+    SetTablebases(&uci, false);
+
+    while (fgets(line, sizeof(line), stdin)) {
+        char *command = line + strspn(line, " \t");
+        char *args;
+
+        command[strcspn(command, "\r\n")] = '\0';
+        args = command + strcspn(command, " \t");
+        if (*args) *args++ = '\0';
+        args += strspn(args, " \t");
+
+        if (strcmp(command, "uci") == 0) {
+            printf("id name 3D Chess in C\n");
+            printf("id author 3D Chess in C contributors\n");
+            printf("option name Hash type spin default %d min 1 max %d\n", TT_DEFAULT_MB, UCI_MAX_HASH_MB);
+            printf("option name Threads type spin default 1 min 1 max %d\n", MAX_SEARCH_THREADS);
+            printf("option name MultiPV type spin default 1 min 1 max %d\n", MAX_MULTI_PV);
+            printf("option name EvalFile type string default %s\n", NNUE_DEFAULT_FILE);
+            printf("option name OwnBook type check default false\n");
+            printf("option name BookFile type string default %s\n", BOOK_DEFAULT_FILE);
+            printf("option name TablebasePath type string default %s\n", TB_DEFAULT_DIR);
+            printf("option name TablebaseCache type spin default %d min 1 max %d\n", TB_DEFAULT_CACHE_MB,
+                   UCI_MAX_TABLEBASE_CACHE_MB);
+            printf("uciok\n");
+        } else if (strcmp(command, "isready") == 0) {
+            printf("readyok\n");
+        } else if (strcmp(command, "ucinewgame") == 0) {
+            FinishSearch(&uci, true);
+            TTClear(&uci.tt);
+            ClearPool(&uci.pool);
+        } else if (strcmp(command, "setoption") == 0) {
+            FinishSearch(&uci, true);
+            SetOption(&uci, args);
+        } else if (strcmp(command, "position") == 0) {
+            FinishSearch(&uci, true);
+            SetPosition(&uci, args);
+        } else if (strcmp(command, "go") == 0) {
+            FinishSearch(&uci, true);
+            Go(&uci, args);
+        } else if (strcmp(command, "stop") == 0) {
+            FinishSearch(&uci, true);
+        } else if (strcmp(command, "d") == 0) {
+            PrintPosition(&uci); // a running search only reads the position
+        } else if (strcmp(command, "quit") == 0) {
+            break;
+        } else if (*command) {
+            printf("info string unknown command %s\n", command);
+        }
+        fflush(stdout);
+    }
+
+    FinishSearch(&uci, true);
+    FreeSearchPool(&uci.pool);
+    TTFree(&uci.tt);
+    UnloadNetwork(&uci.network);
+    UnloadBook(&uci.book);
+    UnloadTablebases(&uci.tablebases);
+    return 0;
+}